@@ -0,0 +1,344 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "alu.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+
+static const UINT s_AluThreadGroupSize = 256;
+static const UINT s_AluThreadGroupCount = 4096;
+
+// Root parameter slots of `Alu::rootSignature`.
+static const UINT s_AluRootParamConstants = 0;
+static const UINT s_AluRootParamOutput = 1;
+static const UINT s_AluRootParamCount = 2;
+
+// Matches `AluConstants` in alu.hlsl.
+struct AluConstants
+{
+    UINT iterations;
+    UINT seed;
+    UINT padding[2];
+};
+
+// Operations of one accumulator step, per accumulator: four lanes, and two
+// for a multiply-add.
+static double GetAluOpsPerStep(AluOp op)
+{
+    return (op == AluOp::Transcendental) ? 4.0 : 8.0;
+}
+
+static const char* GetAluOpsUnit(AluOp op)
+{
+    return (op == AluOp::Fma) ? "TFLOPS" : "Tops/s";
+}
+
+static double GetAluThreadCount(Pipeline* pPipeline, AluStage stage)
+{
+    if (stage == AluStage::Pixel)
+    {
+        return (double)pPipeline->viewport.Width * pPipeline->viewport.Height;
+    }
+
+    return (double)s_AluThreadGroupCount * s_AluThreadGroupSize;
+}
+
+static void CreateAluPipelineStates(Pipeline* pPipeline, AluOp op, UINT registerIndex)
+{
+    Alu* pAlu = &pPipeline->alu;
+
+    char opValue[16];
+    char registersValue[16];
+    snprintf(opValue, sizeof(opValue), "%u", (UINT)op);
+    snprintf(registersValue, sizeof(registersValue), "%u", s_AluRegisterCounts[registerIndex]);
+    const D3D_SHADER_MACRO defines[] =
+    {
+        { "ALU_OP", opValue },
+        { "ALU_REGISTERS", registersValue },
+        { nullptr, nullptr },
+    };
+
+    ComPtr<ID3DBlob> computeShader;
+    CompileShader(L"alu.hlsl", "CSMain", "cs_5_0", defines, &computeShader);
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc = {};
+    computeDesc.pRootSignature = pAlu->rootSignature.Get();
+    computeDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+    CreateComputePipelineState(
+        pPipeline,
+        L"alu",
+        computeDesc,
+        &pAlu->pipelineStates[(UINT)op][(UINT)AluStage::Compute][registerIndex]);
+
+    // The vertex shader doesn't depend on the defines; the shader cache
+    // compiles it once.
+    ComPtr<ID3DBlob> vertexShader;
+    ComPtr<ID3DBlob> pixelShader;
+    CompileShader(L"alu.hlsl", "VSMain", "vs_5_0", nullptr, &vertexShader);
+    CompileShader(L"alu.hlsl", "PSMain", "ps_5_0", defines, &pixelShader);
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc = {};
+    graphicsDesc.pRootSignature = pAlu->rootSignature.Get();
+    graphicsDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+    graphicsDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+    graphicsDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    graphicsDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    graphicsDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    graphicsDesc.DepthStencilState.DepthEnable = FALSE;
+    graphicsDesc.DepthStencilState.StencilEnable = FALSE;
+    graphicsDesc.SampleMask = UINT_MAX;
+    graphicsDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    graphicsDesc.NumRenderTargets = 1;
+    graphicsDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    graphicsDesc.SampleDesc.Count = 1;
+    CreateGraphicsPipelineState(
+        pPipeline,
+        L"alu",
+        graphicsDesc,
+        &pAlu->pipelineStates[(UINT)op][(UINT)AluStage::Pixel][registerIndex]);
+}
+
+void CreateAlu(Pipeline* pPipeline)
+{
+    Alu* pAlu = &pPipeline->alu;
+
+    // Create the root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_AluRootParamCount] = {};
+        rootParameters[s_AluRootParamConstants].InitAsConstants(sizeof(AluConstants) / 4, 0);
+        rootParameters[s_AluRootParamOutput].InitAsUnorderedAccessView(0);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pAlu->rootSignature);
+    }
+
+    const UINT64 startTicks = GetCpuTicks();
+
+    for (UINT i = 0; i < s_AluOpCount; ++i)
+    {
+        for (UINT j = 0; j < s_AluRegisterVariantCount; ++j)
+        {
+            CreateAluPipelineStates(pPipeline, (AluOp)i, j);
+
+            if (s_AluRegisterCounts[j] == pPipeline->options.aluRegisters)
+            {
+                pAlu->frameRegisterIndex = j;
+            }
+        }
+    }
+
+    // Mostly compilation on the first run, cache hits after.
+    LogMessage(
+        "alu: %u permutations in %.1f ms\n",
+        s_AluOpCount * s_AluStageCount * s_AluRegisterVariantCount,
+        CpuTicksToMs(GetCpuTicks() - startTicks));
+
+    // One uint4 per compute thread; pixels never write it.
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC outputDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)s_AluThreadGroupCount * s_AluThreadGroupSize * 16,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &outputDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pAlu->outputBuffer)));
+}
+
+static void SetAluRootArguments(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, AluStage stage)
+{
+    Alu* pAlu = &pPipeline->alu;
+    const D3D12_GPU_VIRTUAL_ADDRESS outputAddress = pAlu->outputBuffer->GetGPUVirtualAddress();
+
+    if (stage == AluStage::Pixel)
+    {
+        pCmdList->SetGraphicsRootSignature(pAlu->rootSignature.Get());
+        pCmdList->SetGraphicsRootUnorderedAccessView(s_AluRootParamOutput, outputAddress);
+        pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+    else
+    {
+        pCmdList->SetComputeRootSignature(pAlu->rootSignature.Get());
+        pCmdList->SetComputeRootUnorderedAccessView(s_AluRootParamOutput, outputAddress);
+    }
+}
+
+static void RecordAluWork(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    AluStage stage,
+    ID3D12PipelineState* pPipelineState,
+    UINT seed)
+{
+    AluConstants constants = {};
+    constants.iterations = pPipeline->options.aluIterations;
+    constants.seed = seed;
+
+    pCmdList->SetPipelineState(pPipelineState);
+
+    if (stage == AluStage::Pixel)
+    {
+        pCmdList->SetGraphicsRoot32BitConstants(
+            s_AluRootParamConstants,
+            sizeof(AluConstants) / 4,
+            &constants,
+            0);
+        pCmdList->DrawInstanced(3, 1, 0, 0);
+    }
+    else
+    {
+        pCmdList->SetComputeRoot32BitConstants(
+            s_AluRootParamConstants,
+            sizeof(AluConstants) / 4,
+            &constants,
+            0);
+        pCmdList->Dispatch(s_AluThreadGroupCount, 1, 1);
+    }
+}
+
+void RecordAlu(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    Alu* pAlu = &pPipeline->alu;
+    const AluStage stage = pPipeline->options.aluStage;
+    ID3D12PipelineState* pPipelineState =
+        pAlu->pipelineStates[(UINT)pPipeline->options.aluOp][(UINT)stage][pAlu->frameRegisterIndex].Get();
+
+    SetAluRootArguments(pPipeline, pCmdList, stage);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordAluWork(pPipeline, pCmdList, stage, pPipelineState, seed);
+    }
+}
+
+void RunAluSweep(Pipeline* pPipeline)
+{
+    Alu* pAlu = &pPipeline->alu;
+
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    const UINT iterations = pPipeline->options.aluSweepIterations;
+    const double peakTflops = pPipeline->options.peakTflops;
+    ID3D12Resource* pRenderTarget = pPipeline->renderTargets[pPipeline->backBufferIndex].Get();
+
+    for (UINT i = 0; i < s_AluOpCount; ++i)
+    {
+        const AluOp op = (AluOp)i;
+
+        for (UINT j = 0; j < s_AluStageCount; ++j)
+        {
+            const AluStage stage = (AluStage)j;
+
+            for (UINT k = 0; k < s_AluRegisterVariantCount; ++k)
+            {
+                const UINT registers = s_AluRegisterCounts[k];
+                ID3D12PipelineState* pPipelineState = pAlu->pipelineStates[i][j][k].Get();
+
+                ThrowIfFailed(cmdAlloc->Reset());
+                ThrowIfFailed(cmdList->Reset(cmdAlloc.Get(), nullptr));
+
+                // Draw into the current back buffer, it isn't presented
+                // before the frame loop renders over it.
+                if (stage == AluStage::Pixel)
+                {
+                    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                        pRenderTarget,
+                        D3D12_RESOURCE_STATE_PRESENT,
+                        D3D12_RESOURCE_STATE_RENDER_TARGET);
+                    cmdList->ResourceBarrier(1, &barrier);
+                    SetDrawState(pPipeline, cmdList.Get());
+                }
+
+                SetAluRootArguments(pPipeline, cmdList.Get(), stage);
+                BeginGpuMeasurement(pPipeline, cmdList.Get());
+                for (UINT iteration = 0; iteration < iterations; ++iteration)
+                {
+                    RecordAluWork(pPipeline, cmdList.Get(), stage, pPipelineState, iteration);
+                }
+                EndGpuMeasurement(pPipeline, cmdList.Get());
+
+                if (stage == AluStage::Pixel)
+                {
+                    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                        pRenderTarget,
+                        D3D12_RESOURCE_STATE_RENDER_TARGET,
+                        D3D12_RESOURCE_STATE_PRESENT);
+                    cmdList->ResourceBarrier(1, &barrier);
+                }
+                ThrowIfFailed(cmdList->Close());
+
+                const double elapsedMs = ExecuteTimedSweepList(pPipeline, cmdList.Get());
+
+                const double ops = GetAluThreadCount(pPipeline, stage) * pPipeline->options.aluIterations *
+                    registers * GetAluOpsPerStep(op) * iterations;
+                const double teraOpsPerSecond = GetRate(ops, elapsedMs, 1.0e12);
+
+                char name[64];
+                snprintf(
+                    name,
+                    sizeof(name),
+                    "alu %s %s r%u",
+                    GetAluStageName(stage),
+                    GetAluOpName(op),
+                    registers);
+
+                // The peak is the FP32 FMA rate, the other ops have their own.
+                if (peakTflops > 0.0 && op == AluOp::Fma)
+                {
+                    LogMessage(
+                        "%s: %.2f %s, %.1f%% of %.1f TFLOPS peak (%.3f ms)\n",
+                        name,
+                        teraOpsPerSecond,
+                        GetAluOpsUnit(op),
+                        100.0 * teraOpsPerSecond / peakTflops,
+                        peakTflops,
+                        elapsedMs);
+                }
+                else
+                {
+                    LogMessage(
+                        "%s: %.2f %s (%.3f ms)\n",
+                        name,
+                        teraOpsPerSecond,
+                        GetAluOpsUnit(op),
+                        elapsedMs);
+                }
+
+                ReportSweepResult(pPipeline, name, teraOpsPerSecond, GetAluOpsUnit(op), elapsedMs);
+                if (peakTflops > 0.0 && op == AluOp::Fma)
+                {
+                    char peakName[80];
+                    snprintf(peakName, sizeof(peakName), "%s of peak", name);
+                    ReportSweepResult(pPipeline, peakName, 100.0 * teraOpsPerSecond / peakTflops, "%", elapsedMs);
+                }
+            }
+        }
+    }
+}
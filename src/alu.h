@@ -0,0 +1,43 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// ALU saturation kernels, see alu.hlsl. The op, and the accumulators each
+// thread keeps live, are compile-time defines: a PSO per op, register count
+// and stage, compiled up front so the shader cache and the pipeline library
+// have them all from the second run on. Sweeping the register counts trades
+// latency hiding for occupancy.
+struct Alu
+{
+    // Root constants at b0, the output buffer as a root UAV at u0; for the
+    // compute and the pixel kernels alike.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStates[s_AluOpCount][s_AluStageCount][s_AluRegisterVariantCount];
+    Microsoft::WRL::ComPtr<ID3D12Resource> outputBuffer;
+    // Index into `s_AluRegisterCounts` of `Options::aluRegisters`.
+    UINT frameRegisterIndex;
+};
+
+// Create the root signature, every permutation's PSO and the output buffer.
+void CreateAlu(Pipeline* pPipeline);
+
+// Record dispatches or full screen draws [firstDraw, firstDraw + drawCount)
+// of `Options::aluOp` with `Options::aluRegisters` accumulators, in
+// `Options::aluStage`. Draws need the frame's render target bound.
+void RecordAlu(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time every permutation in isolation and log its throughput, against
+// `Options::peakTflops` when it is known. The GPU must be idle; returns with
+// the GPU idle.
+void RunAluSweep(Pipeline* pPipeline);
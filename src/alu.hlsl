@@ -0,0 +1,118 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// ALU bound kernels for the alu workload. Every thread, or pixel, keeps
+// ALU_REGISTERS accumulators live and steps each of them `iterations` times
+// with the op ALU_OP selects:
+//   0: a float4 multiply-add,
+//   1: a float4 exp2(),
+//   2: a uint4 multiply-add.
+// The accumulators are independent chains, so more of them hide more latency
+// but take more registers, and fewer waves fit on a SIMD.
+//
+// Both are compile-time defines, so every permutation is its own shader.
+
+#if !defined(ALU_OP)
+#define ALU_OP 0
+#endif
+
+#if !defined(ALU_REGISTERS)
+#define ALU_REGISTERS 8
+#endif
+
+#if ALU_OP == 2
+#define ALU_TYPE uint4
+#else
+#define ALU_TYPE float4
+#endif
+
+cbuffer AluConstants : register(b0)
+{
+    // Loop iterations per thread.
+    uint iterations;
+    // Changes every dispatch so the loops can't be hoisted.
+    uint seed;
+    uint2 padding;
+};
+
+RWStructuredBuffer<uint4> output : register(u0);
+
+ALU_TYPE Step(ALU_TYPE value)
+{
+#if ALU_OP == 0
+    // Converges towards 1, so the values stay finite.
+    return mad(value, 0.999f, 0.001f);
+#elif ALU_OP == 1
+    // Stays within [0.5, 1] for values in [0, 1].
+    return exp2(-value);
+#else
+    return value * 1664525u + 1013904223u;
+#endif
+}
+
+uint4 RunChains(uint threadId)
+{
+    ALU_TYPE accumulators[ALU_REGISTERS];
+
+    // Every chain starts elsewhere, so none of them can be merged.
+    [unroll]
+    for (uint r = 0; r < ALU_REGISTERS; ++r)
+    {
+        const uint4 bits = uint4(threadId, seed, threadId ^ seed, seed >> 8) + r * 0x9e3779b9u;
+#if ALU_OP == 2
+        accumulators[r] = bits;
+#else
+        accumulators[r] = float4(bits & 0xff) * (1.0f / 256.0f);
+#endif
+    }
+
+    [loop]
+    for (uint i = 0; i < iterations; ++i)
+    {
+        [unroll]
+        for (uint j = 0; j < ALU_REGISTERS; ++j)
+        {
+            accumulators[j] = Step(accumulators[j]);
+        }
+    }
+
+    ALU_TYPE sum = accumulators[0];
+    [unroll]
+    for (uint k = 1; k < ALU_REGISTERS; ++k)
+    {
+        sum += accumulators[k];
+    }
+
+#if ALU_OP == 2
+    return sum;
+#else
+    return asuint(sum);
+#endif
+}
+
+[numthreads(256, 1, 1)]
+void CSMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint4 value = RunChains(dispatchThreadId.x);
+
+    // Keep the result alive without paying for a write per thread: the
+    // condition is never true in practice, but the compiler can't prove it.
+    if (all(value == uint4(seed, seed, seed, seed)))
+    {
+        output[dispatchThreadId.x] = value;
+    }
+}
+
+// A triangle covering the whole viewport.
+float4 VSMain(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    const float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+
+// The output is what keeps the pixel's chains alive.
+float4 PSMain(float4 position : SV_POSITION) : SV_TARGET
+{
+    const uint2 pixel = (uint2)position.xy;
+    const uint4 value = RunChains(pixel.y * 65536 + pixel.x);
+    return float4(value & 0xff) * (1.0f / 255.0f);
+}
@@ -0,0 +1,372 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "async-compute.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+
+static const UINT s_AsyncThreadGroupSize = 256;
+static const UINT s_AsyncThreadGroupCount = 1024;
+
+// Root parameter slots of `AsyncCompute::rootSignature`.
+static const UINT s_AsyncRootParamConstants = 0;
+static const UINT s_AsyncRootParamOutput = 1;
+static const UINT s_AsyncRootParamCount = 2;
+
+// Matches `AsyncConstants` in async-compute.hlsl.
+struct AsyncConstants
+{
+    UINT iterations;
+    UINT seed;
+    UINT padding[2];
+};
+
+static void CreateAsyncQueue(
+    Pipeline* pPipeline,
+    D3D12_COMMAND_LIST_TYPE type,
+    ComPtr<ID3D12CommandQueue>* pQueue,
+    ComPtr<ID3D12Fence>* pFence,
+    ComPtr<ID3D12CommandAllocator>* pCmdAllocs,
+    ComPtr<ID3D12GraphicsCommandList>* pCmdList)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queueDesc.Type = type;
+    ThrowIfFailed(pPipeline->device->CreateCommandQueue(
+        &queueDesc,
+        IID_PPV_ARGS(pQueue->ReleaseAndGetAddressOf())));
+
+    ThrowIfFailed(pPipeline->device->CreateFence(
+        0,
+        D3D12_FENCE_FLAG_NONE,
+        IID_PPV_ARGS(pFence->ReleaseAndGetAddressOf())));
+
+    for (UINT i = 0; i < pPipeline->options.frameCount; ++i)
+    {
+        ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+            type,
+            IID_PPV_ARGS(pCmdAllocs[i].ReleaseAndGetAddressOf())));
+    }
+
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        type,
+        pCmdAllocs[0].Get(),
+        nullptr,
+        IID_PPV_ARGS(pCmdList->ReleaseAndGetAddressOf())));
+    ThrowIfFailed((*pCmdList)->Close());
+}
+
+static void CreateComputeResources(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    CreateAsyncQueue(
+        pPipeline,
+        D3D12_COMMAND_LIST_TYPE_COMPUTE,
+        &pAsync->computeQueue,
+        &pAsync->computeFence,
+        pAsync->computeCmdAllocs,
+        &pAsync->computeCmdList);
+
+    // Create the compute root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_AsyncRootParamCount] = {};
+        rootParameters[s_AsyncRootParamConstants].InitAsConstants(
+            sizeof(AsyncConstants) / 4,
+            0);
+        rootParameters[s_AsyncRootParamOutput].InitAsUnorderedAccessView(0);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pAsync->rootSignature);
+    }
+
+    {
+        ComPtr<ID3DBlob> computeShader;
+        CompileShader(L"async-compute.hlsl", "CSMain", "cs_5_0", nullptr, &computeShader);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pAsync->rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+        CreateComputePipelineState(pPipeline, L"async-compute", psoDesc, &pAsync->pipelineState);
+    }
+
+    // One float4 per thread.
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC outputDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)s_AsyncThreadGroupCount * s_AsyncThreadGroupSize * 16,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &outputDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pAsync->outputBuffer)));
+}
+
+static void CreateCopyResources(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    CreateAsyncQueue(
+        pPipeline,
+        D3D12_COMMAND_LIST_TYPE_COPY,
+        &pAsync->copyQueue,
+        &pAsync->copyFence,
+        pAsync->copyCmdAllocs,
+        &pAsync->copyCmdList);
+
+    // Copy queues only take resources in the common state; buffers promote
+    // to copy source/destination and decay back at the end of every list.
+    const UINT64 bufferSize = (UINT64)pPipeline->options.asyncCopyMB * 1024 * 1024;
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
+
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&pAsync->copySrcBuffer)));
+
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&pAsync->copyDstBuffer)));
+}
+
+void CreateAsyncCompute(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    if (pPipeline->options.asyncCompute)
+    {
+        CreateComputeResources(pPipeline);
+        pAsync->computeEnabled = true;
+    }
+
+    if (pPipeline->options.asyncCopy)
+    {
+        CreateCopyResources(pPipeline);
+        pAsync->copyEnabled = true;
+    }
+}
+
+static void RecordComputeWork(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+    ID3D12CommandAllocator* pCmdAlloc = pAsync->computeCmdAllocs[pPipeline->frameResourceIndex].Get();
+    ID3D12GraphicsCommandList* pCmdList = pAsync->computeCmdList.Get();
+
+    // The frame ring has waited for this frame resource, and the direct
+    // queue waited for the compute queue before that frame's fence.
+    ThrowIfFailed(pCmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pCmdAlloc, pAsync->pipelineState.Get()));
+
+    pCmdList->SetComputeRootSignature(pAsync->rootSignature.Get());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_AsyncRootParamOutput,
+        pAsync->outputBuffer->GetGPUVirtualAddress());
+
+    // No UAV barriers between the dispatches: they all write the same
+    // values, and back to back dispatches fill the queue better.
+    for (UINT i = 0; i < pPipeline->options.asyncDispatchCount; ++i)
+    {
+        AsyncConstants constants = {};
+        constants.iterations = pPipeline->options.asyncIterations;
+        constants.seed = GetDrawSeed(pPipeline, i);
+
+        pCmdList->SetComputeRoot32BitConstants(
+            s_AsyncRootParamConstants,
+            sizeof(AsyncConstants) / 4,
+            &constants,
+            0);
+        pCmdList->Dispatch(s_AsyncThreadGroupCount, 1, 1);
+    }
+
+    ThrowIfFailed(pCmdList->Close());
+}
+
+static void RecordCopyWork(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+    ID3D12CommandAllocator* pCmdAlloc = pAsync->copyCmdAllocs[pPipeline->frameResourceIndex].Get();
+    ID3D12GraphicsCommandList* pCmdList = pAsync->copyCmdList.Get();
+
+    ThrowIfFailed(pCmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pCmdAlloc, nullptr));
+
+    pCmdList->CopyResource(pAsync->copyDstBuffer.Get(), pAsync->copySrcBuffer.Get());
+
+    ThrowIfFailed(pCmdList->Close());
+}
+
+static void SubmitComputeWork(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    ID3D12CommandList* ppCommandLists[] = { pAsync->computeCmdList.Get() };
+    pAsync->computeQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+    pAsync->computeFenceValue += 1;
+    ThrowIfFailed(pAsync->computeQueue->Signal(pAsync->computeFence.Get(), pAsync->computeFenceValue));
+}
+
+static void SubmitCopyWork(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    ID3D12CommandList* ppCommandLists[] = { pAsync->copyCmdList.Get() };
+    pAsync->copyQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+    pAsync->copyFenceValue += 1;
+    ThrowIfFailed(pAsync->copyQueue->Signal(pAsync->copyFence.Get(), pAsync->copyFenceValue));
+}
+
+void BeginAsyncWork(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    if (pAsync->computeEnabled)
+    {
+        RecordComputeWork(pPipeline);
+    }
+
+    if (pAsync->copyEnabled)
+    {
+        RecordCopyWork(pPipeline);
+    }
+
+    if (pAsync->serialized)
+    {
+        return;
+    }
+
+    if (pAsync->computeEnabled)
+    {
+        SubmitComputeWork(pPipeline);
+    }
+
+    if (pAsync->copyEnabled)
+    {
+        SubmitCopyWork(pPipeline);
+    }
+}
+
+void EndAsyncWork(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    if (pAsync->serialized)
+    {
+        // Chain the queues: each one starts once the previous one is done.
+        ID3D12Fence* pPreviousFence = pPipeline->fence.Get();
+        UINT64 previousFenceValue = SignalFence(pPipeline);
+
+        if (pAsync->computeEnabled)
+        {
+            ThrowIfFailed(pAsync->computeQueue->Wait(pPreviousFence, previousFenceValue));
+            SubmitComputeWork(pPipeline);
+
+            pPreviousFence = pAsync->computeFence.Get();
+            previousFenceValue = pAsync->computeFenceValue;
+        }
+
+        if (pAsync->copyEnabled)
+        {
+            ThrowIfFailed(pAsync->copyQueue->Wait(pPreviousFence, previousFenceValue));
+            SubmitCopyWork(pPipeline);
+        }
+    }
+
+    // The frame is done once every queue is; the frame fence is signaled on
+    // the direct queue after this.
+    if (pAsync->computeEnabled)
+    {
+        ThrowIfFailed(pPipeline->cmdQueue->Wait(pAsync->computeFence.Get(), pAsync->computeFenceValue));
+    }
+
+    if (pAsync->copyEnabled)
+    {
+        ThrowIfFailed(pPipeline->cmdQueue->Wait(pAsync->copyFence.Get(), pAsync->copyFenceValue));
+    }
+}
+
+// Average wall time of a frame with the given queues busy. The frames aren't
+// presented, so they run as fast as the slowest queue allows.
+static double MeasureAsyncPhase(Pipeline* pPipeline, bool graphics, bool async, bool serialized)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+    const UINT frameCount = pPipeline->options.asyncSweepFrames;
+    const UINT drawCount = pPipeline->options.drawCount;
+
+    // Without graphics the frame still clears, which is negligible next to
+    // the draws.
+    pPipeline->options.drawCount = graphics ? drawCount : 0;
+    pAsync->computeEnabled = async && pPipeline->options.asyncCompute;
+    pAsync->copyEnabled = async && pPipeline->options.asyncCopy;
+    pAsync->serialized = serialized;
+
+    // Warm up so the first frames' costs stay out of the measurement.
+    RenderFrames(pPipeline, pPipeline->options.frameCount);
+
+    const UINT64 startTicks = GetCpuTicks();
+    RenderFrames(pPipeline, frameCount);
+    const double elapsedMs = CpuTicksToMs(GetCpuTicks() - startTicks);
+
+    pPipeline->options.drawCount = drawCount;
+
+    return elapsedMs / frameCount;
+}
+
+void RunAsyncComputeSweep(Pipeline* pPipeline)
+{
+    AsyncCompute* pAsync = &pPipeline->asyncCompute;
+
+    const double graphicsMs = MeasureAsyncPhase(pPipeline, true, false, false);
+    const double asyncMs = MeasureAsyncPhase(pPipeline, false, true, false);
+    const double serializedMs = MeasureAsyncPhase(pPipeline, true, true, true);
+    const double concurrentMs = MeasureAsyncPhase(pPipeline, true, true, false);
+
+    // Restore the frame loop's configuration.
+    pAsync->computeEnabled = pPipeline->options.asyncCompute;
+    pAsync->copyEnabled = pPipeline->options.asyncCopy;
+    pAsync->serialized = false;
+
+    // The share of the shorter side hidden by overlap: 100% when concurrent
+    // frames take as long as the longer side alone, 0% or less when overlap
+    // gains nothing over serialized execution.
+    const double hideableMs = min(graphicsMs, asyncMs);
+    const double overlap = (hideableMs > 0.0) ? (serializedMs - concurrentMs) / hideableMs : 0.0;
+    const double speedup = (concurrentMs > 0.0) ? serializedMs / concurrentMs : 0.0;
+
+    LogMessage(
+        "async: graphics %.3f ms, async %.3f ms, serialized %.3f ms, concurrent %.3f ms per frame\n",
+        graphicsMs,
+        asyncMs,
+        serializedMs,
+        concurrentMs);
+    LogMessage(
+        "async: %.2fx over serialized, %.0f%% of the shorter side hidden\n",
+        speedup,
+        100.0 * overlap);
+
+    ReportSweepResult(pPipeline, "async graphics", graphicsMs, "ms/frame", graphicsMs);
+    ReportSweepResult(pPipeline, "async work", asyncMs, "ms/frame", asyncMs);
+    ReportSweepResult(pPipeline, "async serialized", serializedMs, "ms/frame", serializedMs);
+    ReportSweepResult(pPipeline, "async concurrent", concurrentMs, "ms/frame", concurrentMs);
+    ReportSweepResult(pPipeline, "async speedup", speedup, "x", concurrentMs);
+    ReportSweepResult(pPipeline, "async overlap", 100.0 * overlap, "%", concurrentMs);
+}
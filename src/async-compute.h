@@ -0,0 +1,69 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Work submitted to a compute queue and a copy queue every frame, next to the
+// frame's graphics work on the direct queue. The direct queue waits on the
+// async queues' fences before the frame's fence is signaled, so the frame
+// ring also covers the async queues' allocators.
+//
+// Concurrent: the async work is submitted before the graphics work and the
+// queues run side by side. Serialized: every queue waits for the previous
+// one, direct -> compute -> copy, to give the baseline overlap is measured
+// against.
+struct AsyncCompute
+{
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> computeQueue;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue;
+
+    // One fence per queue, as a fence's values must increase in the order
+    // they are signaled.
+    Microsoft::WRL::ComPtr<ID3D12Fence> computeFence;
+    Microsoft::WRL::ComPtr<ID3D12Fence> copyFence;
+    UINT64 computeFenceValue;
+    UINT64 copyFenceValue;
+
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> computeCmdAllocs[s_MaxFrameCount];
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> copyCmdAllocs[s_MaxFrameCount];
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> computeCmdList;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> copyCmdList;
+
+    // FMA kernel, see async-compute.hlsl. Root constants at b0, the output
+    // buffer as a root UAV at u0.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+    Microsoft::WRL::ComPtr<ID3D12Resource> outputBuffer;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> copySrcBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> copyDstBuffer;
+
+    // Which queues get work this frame; the sweep toggles them.
+    bool computeEnabled;
+    bool copyEnabled;
+    bool serialized;
+};
+
+// Create the queues and resources `Options::asyncCompute` and
+// `Options::asyncCopy` ask for.
+void CreateAsyncCompute(Pipeline* pPipeline);
+
+// Record the current frame's async work, and in concurrent mode submit it.
+// Call before the frame's graphics lists are executed.
+void BeginAsyncWork(Pipeline* pPipeline);
+
+// In serialized mode submit the async work after the graphics work. Then make
+// the direct queue wait for the async queues. Call right after the frame's
+// graphics lists are executed.
+void EndAsyncWork(Pipeline* pPipeline);
+
+// Time `Options::asyncSweepFrames` frames of graphics alone, async work alone,
+// both serialized and both concurrent, and log how much overlap gains. The
+// GPU must be idle; returns with the GPU idle.
+void RunAsyncComputeSweep(Pipeline* pPipeline);
@@ -0,0 +1,30 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// ALU-bound kernel for the async compute queue. It barely touches memory, so
+// it can fill the shader cores the graphics work leaves idle.
+
+cbuffer AsyncConstants : register(b0)
+{
+    // FMA loop iterations per thread.
+    uint iterations;
+    // Changes every dispatch so the loop can't be hoisted.
+    uint seed;
+    uint2 padding;
+};
+
+RWStructuredBuffer<float4> output : register(u0);
+
+[numthreads(256, 1, 1)]
+void CSMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    // Four independent chains so the loop isn't latency bound. Each converges
+    // towards 1, so the values stay finite for any iteration count.
+    float4 value = float4(dispatchThreadId.x, seed, dispatchThreadId.x ^ seed, 1.0f) * 1.0e-6f;
+
+    for (uint i = 0; i < iterations; ++i)
+    {
+        value = mad(value, 0.999f, 0.001f);
+    }
+
+    output[dispatchThreadId.x] = value;
+}
@@ -0,0 +1,290 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "bandwidth.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+
+// Upper bound of thread groups per dispatch; the kernels loop over whatever
+// exceeds them.
+static const UINT s_BandwidthThreadGroupSize = 256;
+static const UINT s_BandwidthMaxThreadGroupCount = 4096;
+
+// Root parameter slots of `Bandwidth::rootSignature`.
+static const UINT s_BandwidthRootParamConstants = 0;
+static const UINT s_BandwidthRootParamSrc = 1;
+static const UINT s_BandwidthRootParamDst = 2;
+static const UINT s_BandwidthRootParamDstCounters = 3;
+static const UINT s_BandwidthRootParamCount = 4;
+
+// Keep some dedicated video memory for everything else.
+static const UINT64 s_BandwidthVideoMemoryReserve = 256ull * 1024 * 1024;
+
+// Matches `BandwidthConstants` in bandwidth.hlsl.
+struct BandwidthConstants
+{
+    UINT elementCount;
+    UINT threadCount;
+    UINT stride;
+    UINT strideRowCount;
+    UINT atomicCount;
+    UINT seed;
+    UINT padding[2];
+};
+
+static const char* s_BandwidthKernelEntryPoints[s_BandwidthKernelCount] =
+{
+    "CSCopy",
+    "CSStridedRead",
+    "CSRandomGather",
+    "CSAtomic",
+};
+
+static UINT GetElementCount(Pipeline* pPipeline)
+{
+    return (UINT)(pPipeline->bandwidth.bufferSize / 16);
+}
+
+static UINT GetThreadGroupCount(Pipeline* pPipeline)
+{
+    const UINT elementCount = GetElementCount(pPipeline);
+    const UINT groupCount = (elementCount + s_BandwidthThreadGroupSize - 1) / s_BandwidthThreadGroupSize;
+    return min(groupCount, s_BandwidthMaxThreadGroupCount);
+}
+
+// Bytes a dispatch of `kernel` moves between the shader cores and memory,
+// counting only the bytes the kernel asks for, not whole cache lines.
+static double GetBytesPerDispatch(Pipeline* pPipeline, BandwidthKernel kernel)
+{
+    const double elementCount = (double)GetElementCount(pPipeline);
+    const UINT stride = pPipeline->options.bandwidthStride;
+
+    switch (kernel)
+    {
+    case BandwidthKernel::Copy:
+        return 2.0 * elementCount * 16.0;
+
+    case BandwidthKernel::StridedRead:
+        return (double)((GetElementCount(pPipeline) / stride) * stride) * 16.0;
+
+    case BandwidthKernel::RandomGather:
+        return elementCount * 16.0;
+
+    case BandwidthKernel::Atomic:
+        // A read and a write of 4 bytes per add.
+        return elementCount * 8.0;
+
+    default:
+        return 0.0;
+    }
+}
+
+void CreateBandwidth(Pipeline* pPipeline)
+{
+    Bandwidth* pBandwidth = &pPipeline->bandwidth;
+
+    // Create the compute root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_BandwidthRootParamCount] = {};
+        rootParameters[s_BandwidthRootParamConstants].InitAsConstants(
+            sizeof(BandwidthConstants) / 4,
+            0);
+        rootParameters[s_BandwidthRootParamSrc].InitAsShaderResourceView(0);
+        rootParameters[s_BandwidthRootParamDst].InitAsUnorderedAccessView(0);
+        rootParameters[s_BandwidthRootParamDstCounters].InitAsUnorderedAccessView(1);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pBandwidth->rootSignature);
+    }
+
+    // Create a PSO per kernel.
+    for (UINT i = 0; i < s_BandwidthKernelCount; ++i)
+    {
+        ComPtr<ID3DBlob> computeShader;
+        CompileShader(L"bandwidth.hlsl", s_BandwidthKernelEntryPoints[i], "cs_5_0", nullptr, &computeShader);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pBandwidth->rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+        CreateComputePipelineState(pPipeline, L"bandwidth", psoDesc, &pBandwidth->pipelineStates[i]);
+    }
+
+    // Create the buffers, as large as requested if both fit in video memory.
+    {
+        const UINT64 megabyte = 1024ull * 1024;
+        const UINT64 videoMemory = pPipeline->adapterDesc.DedicatedVideoMemory;
+        const UINT64 maxBufferSize = (videoMemory > s_BandwidthVideoMemoryReserve) ?
+            (videoMemory - s_BandwidthVideoMemoryReserve) / 2 : megabyte;
+
+        // Element indices are 32-bit in the kernels.
+        const UINT64 maxElementBufferSize = (UINT64)UINT_MAX * 16;
+
+        UINT64 bufferSize = (UINT64)pPipeline->options.bandwidthBufferMB * megabyte;
+        if (bufferSize > maxBufferSize || bufferSize > maxElementBufferSize)
+        {
+            bufferSize = min(maxBufferSize, maxElementBufferSize) & ~(megabyte - 1);
+            LogMessage(
+                "bandwidth: buffer size clamped to %llu MB, adapter has %llu MB of video memory\n",
+                bufferSize / megabyte,
+                videoMemory / megabyte);
+        }
+        pBandwidth->bufferSize = bufferSize;
+
+        CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+
+        CD3DX12_RESOURCE_DESC srcDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
+        ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &srcDesc,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            nullptr,
+            IID_PPV_ARGS(&pBandwidth->srcBuffer)));
+
+        CD3DX12_RESOURCE_DESC dstDesc = CD3DX12_RESOURCE_DESC::Buffer(
+            bufferSize,
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &dstDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&pBandwidth->dstBuffer)));
+    }
+}
+
+static void SetBandwidthRootArguments(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    Bandwidth* pBandwidth = &pPipeline->bandwidth;
+
+    pCmdList->SetComputeRootSignature(pBandwidth->rootSignature.Get());
+    pCmdList->SetComputeRootShaderResourceView(
+        s_BandwidthRootParamSrc,
+        pBandwidth->srcBuffer->GetGPUVirtualAddress());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_BandwidthRootParamDst,
+        pBandwidth->dstBuffer->GetGPUVirtualAddress());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_BandwidthRootParamDstCounters,
+        pBandwidth->dstBuffer->GetGPUVirtualAddress());
+}
+
+static void RecordBandwidthDispatch(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    BandwidthKernel kernel,
+    UINT seed)
+{
+    Bandwidth* pBandwidth = &pPipeline->bandwidth;
+    const UINT groupCount = GetThreadGroupCount(pPipeline);
+
+    BandwidthConstants constants = {};
+    constants.elementCount = GetElementCount(pPipeline);
+    constants.threadCount = groupCount * s_BandwidthThreadGroupSize;
+    constants.stride = pPipeline->options.bandwidthStride;
+    constants.strideRowCount = constants.elementCount / constants.stride;
+    // The counters are addressed with 32-bit byte offsets.
+    constants.atomicCount = (UINT)min((UINT64)constants.elementCount * 4, 1ull << 30);
+    constants.seed = seed;
+
+    pCmdList->SetPipelineState(pBandwidth->pipelineStates[(UINT)kernel].Get());
+    pCmdList->SetComputeRoot32BitConstants(
+        s_BandwidthRootParamConstants,
+        sizeof(BandwidthConstants) / 4,
+        &constants,
+        0);
+    pCmdList->Dispatch(groupCount, 1, 1);
+}
+
+void RecordBandwidth(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    SetBandwidthRootArguments(pPipeline, pCmdList);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordBandwidthDispatch(pPipeline, pCmdList, pPipeline->options.bandwidthKernel, seed);
+    }
+}
+
+void RunBandwidthSweep(Pipeline* pPipeline)
+{
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    const UINT iterations = pPipeline->options.bandwidthSweepIterations;
+    const double peakBandwidth = pPipeline->options.peakBandwidth;
+
+    LogMessage(
+        "bandwidth: %llu MB buffers, %u thread groups\n",
+        pPipeline->bandwidth.bufferSize / (1024ull * 1024),
+        GetThreadGroupCount(pPipeline));
+
+    for (UINT i = 0; i < s_BandwidthKernelCount; ++i)
+    {
+        const BandwidthKernel kernel = (BandwidthKernel)i;
+
+        ThrowIfFailed(cmdAlloc->Reset());
+        ThrowIfFailed(cmdList->Reset(cmdAlloc.Get(), nullptr));
+        SetBandwidthRootArguments(pPipeline, cmdList.Get());
+        BeginGpuMeasurement(pPipeline, cmdList.Get());
+        for (UINT iteration = 0; iteration < iterations; ++iteration)
+        {
+            RecordBandwidthDispatch(pPipeline, cmdList.Get(), kernel, iteration);
+        }
+        EndGpuMeasurement(pPipeline, cmdList.Get());
+        ThrowIfFailed(cmdList->Close());
+
+        const double elapsedMs = ExecuteTimedSweepList(pPipeline, cmdList.Get());
+
+        const double bytes = GetBytesPerDispatch(pPipeline, kernel) * iterations;
+        const double gigabytesPerSecond = GetRate(bytes, elapsedMs, 1.0e9);
+
+        if (peakBandwidth > 0.0)
+        {
+            LogMessage(
+                "bandwidth %s: %.1f GB/s, %.1f%% of %.1f GB/s peak (%.3f ms)\n",
+                GetBandwidthKernelName(kernel),
+                gigabytesPerSecond,
+                100.0 * gigabytesPerSecond / peakBandwidth,
+                peakBandwidth,
+                elapsedMs);
+        }
+        else
+        {
+            LogMessage(
+                "bandwidth %s: %.1f GB/s (%.3f ms)\n",
+                GetBandwidthKernelName(kernel),
+                gigabytesPerSecond,
+                elapsedMs);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "bandwidth %s", GetBandwidthKernelName(kernel));
+        ReportSweepResult(pPipeline, name, gigabytesPerSecond, "GB/s", elapsedMs);
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Compute kernels reading and writing two large buffers in default heaps.
+// Every kernel is a grid-stride loop over the whole buffer, see
+// bandwidth.hlsl.
+struct Bandwidth
+{
+    // Compute root signature: root constants at b0, the source buffer as a
+    // root SRV at t0, and the destination buffer as root UAVs at u0/u1.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStates[s_BandwidthKernelCount];
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> srcBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> dstBuffer;
+    // Size of each buffer, in bytes.
+    UINT64 bufferSize;
+};
+
+// Create the root signature, PSOs and buffers. The buffer size is clamped so
+// both buffers fit in the adapter's dedicated video memory.
+void CreateBandwidth(Pipeline* pPipeline);
+
+// Record dispatches [firstDraw, firstDraw + drawCount) of
+// `Options::bandwidthKernel`.
+void RecordBandwidth(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time every kernel in isolation and log GB/s, relative to
+// `Options::peakBandwidth` when it is known. The GPU must be idle; returns
+// with the GPU idle.
+void RunBandwidthSweep(Pipeline* pPipeline);
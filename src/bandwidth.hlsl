@@ -0,0 +1,95 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Memory bandwidth kernels. Every kernel walks `elementCount` 16-byte elements
+// with a grid-stride loop, so any buffer size works with a fixed dispatch.
+
+cbuffer BandwidthConstants : register(b0)
+{
+    // 16-byte elements in each buffer.
+    uint elementCount;
+    // Total threads of the dispatch.
+    uint threadCount;
+    // Distance between consecutive reads of the strided kernel, in elements.
+    uint stride;
+    // elementCount / stride, rounded down.
+    uint strideRowCount;
+    // 4-byte counters the atomic kernel spreads its adds over.
+    uint atomicCount;
+    // Changes every dispatch so random kernels take a different path.
+    uint seed;
+    uint2 padding;
+};
+
+StructuredBuffer<uint4> src : register(t0);
+RWStructuredBuffer<uint4> dst : register(u0);
+RWByteAddressBuffer dstCounters : register(u1);
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+// Keep the reads alive without paying for a write per thread: the condition
+// is never true in practice, but the compiler can't prove it.
+void KeepAlive(uint4 sum, uint threadId)
+{
+    if (all(sum == uint4(seed, seed, seed, seed)))
+    {
+        dst[threadId] = sum;
+    }
+}
+
+[numthreads(256, 1, 1)]
+void CSCopy(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    for (uint i = dispatchThreadId.x; i < elementCount; i += threadCount)
+    {
+        dst[i] = src[i];
+    }
+}
+
+[numthreads(256, 1, 1)]
+void CSStridedRead(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint4 sum = 0;
+
+    // Walk the buffer column by column, so neighbouring threads read
+    // addresses `stride` elements apart and every element is read once.
+    const uint readCount = strideRowCount * stride;
+    for (uint i = dispatchThreadId.x; i < readCount; i += threadCount)
+    {
+        uint index = (i % strideRowCount) * stride + (i / strideRowCount);
+        sum += src[index];
+    }
+
+    KeepAlive(sum, dispatchThreadId.x);
+}
+
+[numthreads(256, 1, 1)]
+void CSRandomGather(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint4 sum = 0;
+
+    for (uint i = dispatchThreadId.x; i < elementCount; i += threadCount)
+    {
+        uint index = Hash(i ^ seed) % elementCount;
+        sum += src[index];
+    }
+
+    KeepAlive(sum, dispatchThreadId.x);
+}
+
+[numthreads(256, 1, 1)]
+void CSAtomic(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    for (uint i = dispatchThreadId.x; i < elementCount; i += threadCount)
+    {
+        uint counter = Hash(i ^ seed) % atomicCount;
+        dstCounters.InterlockedAdd(counter * 4, 1);
+    }
+}
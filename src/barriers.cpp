@@ -0,0 +1,489 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "barriers.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdio.h>
+
+static const UINT s_BarrierThreadGroupSize = 64;
+
+// Root parameter slots of `Barriers::rootSignature`.
+static const UINT s_BarrierRootParamConstants = 0;
+static const UINT s_BarrierRootParamTarget = 1;
+static const UINT s_BarrierRootParamSource = 2;
+static const UINT s_BarrierRootParamSink = 3;
+
+// Matches `BarrierConstants` in barriers.hlsl.
+struct BarrierConstants
+{
+    UINT elementCount;
+    UINT seed;
+    UINT padding[2];
+};
+
+// Where in a round barriers go: right after the producing pass, or right
+// before the consuming one, with the filler dispatch in between.
+enum class BarrierSlot
+{
+    AfterProducer,
+    BeforeConsumer,
+};
+
+void CreateBarriersPipelineStates(Pipeline* pPipeline)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+
+    // Create the root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[4] = {};
+
+        rootParameters[s_BarrierRootParamConstants].InitAsConstants(sizeof(BarrierConstants) / 4, 0);
+        rootParameters[s_BarrierRootParamTarget].InitAsUnorderedAccessView(0);
+        rootParameters[s_BarrierRootParamSource].InitAsShaderResourceView(0);
+        rootParameters[s_BarrierRootParamSink].InitAsUnorderedAccessView(1);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pBarriers->rootSignature);
+    }
+
+    const struct
+    {
+        const char* entryPoint;
+        ComPtr<ID3D12PipelineState>* pPipelineState;
+    } kernels[] =
+    {
+        { "CSWrite", &pBarriers->writePipelineState },
+        { "CSRead", &pBarriers->readPipelineState },
+        { "CSReadUav", &pBarriers->readUavPipelineState },
+    };
+
+    for (UINT i = 0; i < _countof(kernels); ++i)
+    {
+        ComPtr<ID3DBlob> computeShader;
+        CompileShader(L"barriers.hlsl", kernels[i].entryPoint, "cs_5_1", nullptr, &computeShader);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pBarriers->rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+        CreateComputePipelineState(pPipeline, L"barriers", psoDesc, kernels[i].pPipelineState);
+    }
+}
+
+// Whether the device and the headers the tree is built with have enhanced
+// barriers.
+static bool CheckEnhancedBarriers(Pipeline* pPipeline)
+{
+#if defined(D3D12_SDK_VERSION) && D3D12_SDK_VERSION >= 606
+    D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = {};
+    return SUCCEEDED(pPipeline->device->CheckFeatureSupport(
+        D3D12_FEATURE_D3D12_OPTIONS12,
+        &options12,
+        sizeof(options12))) && options12.EnhancedBarriersSupported;
+#else
+    UNREFERENCED_PARAMETER(pPipeline);
+    return false;
+#endif
+}
+
+void CreateBarriersResources(Pipeline* pPipeline)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+    const UINT64 bufferSize = (UINT64)pPipeline->options.barrierResourceKB * 1024;
+
+    pBarriers->elementCount = (UINT)(bufferSize / 16);
+
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC bufferDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(bufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+    for (UINT i = 0; i < pPipeline->options.barrierResourceCount; ++i)
+    {
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&pBarriers->buffers[i])));
+    }
+
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pBarriers->sinkBuffer)));
+
+    // Both aliases start at the heap's first byte.
+    const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = pDevice->GetResourceAllocationInfo(0, 1, &bufferDesc);
+
+    D3D12_HEAP_DESC heapDesc = {};
+    heapDesc.SizeInBytes = allocationInfo.SizeInBytes;
+    heapDesc.Properties = defaultHeapProps;
+    heapDesc.Alignment = allocationInfo.Alignment;
+    heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    ThrowIfFailed(pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&pBarriers->aliasHeap)));
+
+    for (UINT i = 0; i < _countof(pBarriers->aliasBuffers); ++i)
+    {
+        ThrowIfFailed(pDevice->CreatePlacedResource(
+            pBarriers->aliasHeap.Get(),
+            0,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&pBarriers->aliasBuffers[i])));
+    }
+
+    pBarriers->enhancedBarriersSupported = CheckEnhancedBarriers(pPipeline);
+
+    pBarriers->mode = pPipeline->options.barrierMode;
+    if (pBarriers->mode == BarrierMode::Enhanced && !pBarriers->enhancedBarriersSupported)
+    {
+        LogMessage("barriers: enhanced barriers unsupported, using batched barriers\n");
+        pBarriers->mode = BarrierMode::Batched;
+    }
+}
+
+// The buffer pass dispatch `index` works on: every buffer in turn, or the two
+// aliases taking turns.
+static ID3D12Resource* GetBarrierBuffer(Pipeline* pPipeline, BarrierMode mode, UINT index)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+    return (mode == BarrierMode::Aliasing) ?
+        pBarriers->aliasBuffers[index % 2].Get() : pBarriers->buffers[index].Get();
+}
+
+// Whether `mode` keeps the buffers in the unordered access state, so the
+// reads go through the UAV.
+static bool IsBarrierModeUav(BarrierMode mode)
+{
+    return mode == BarrierMode::None || mode == BarrierMode::Uav || mode == BarrierMode::Aliasing;
+}
+
+#if defined(D3D12_SDK_VERSION) && D3D12_SDK_VERSION >= 606
+// One group of buffer barriers between the unordered access and shader
+// resource accesses of compute shading.
+static void RecordEnhancedBarriers(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, bool toRead)
+{
+    const UINT bufferCount = pPipeline->options.barrierResourceCount;
+
+    ComPtr<ID3D12GraphicsCommandList7> cmdList7;
+    ThrowIfFailed(pCmdList->QueryInterface(IID_PPV_ARGS(&cmdList7)));
+
+    D3D12_BUFFER_BARRIER bufferBarriers[s_MaxBarrierResourceCount] = {};
+    for (UINT i = 0; i < bufferCount; ++i)
+    {
+        D3D12_BUFFER_BARRIER* pBarrier = &bufferBarriers[i];
+        pBarrier->SyncBefore = D3D12_BARRIER_SYNC_COMPUTE_SHADING;
+        pBarrier->SyncAfter = D3D12_BARRIER_SYNC_COMPUTE_SHADING;
+        pBarrier->AccessBefore = toRead ? D3D12_BARRIER_ACCESS_UNORDERED_ACCESS : D3D12_BARRIER_ACCESS_SHADER_RESOURCE;
+        pBarrier->AccessAfter = toRead ? D3D12_BARRIER_ACCESS_SHADER_RESOURCE : D3D12_BARRIER_ACCESS_UNORDERED_ACCESS;
+        pBarrier->pResource = pPipeline->barriers.buffers[i].Get();
+        pBarrier->Offset = 0;
+        pBarrier->Size = UINT64_MAX;
+    }
+
+    D3D12_BARRIER_GROUP group = {};
+    group.Type = D3D12_BARRIER_TYPE_BUFFER;
+    group.NumBarriers = bufferCount;
+    group.pBufferBarriers = bufferBarriers;
+    cmdList7->Barrier(1, &group);
+}
+#endif
+
+// Record the barriers of `slot` that make the buffers readable, or writable
+// again when `toRead` is false.
+static void RecordBarrierSlot(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    BarrierMode mode,
+    BarrierSlot slot,
+    bool toRead)
+{
+    const UINT bufferCount = pPipeline->options.barrierResourceCount;
+    const D3D12_RESOURCE_STATES before =
+        toRead ? D3D12_RESOURCE_STATE_UNORDERED_ACCESS : D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    const D3D12_RESOURCE_STATES after =
+        toRead ? D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+
+    // Only split barriers do anything after the producer.
+    if (slot == BarrierSlot::AfterProducer && mode != BarrierMode::Split)
+    {
+        return;
+    }
+
+    D3D12_RESOURCE_BARRIER barriers[s_MaxBarrierResourceCount];
+    switch (mode)
+    {
+    case BarrierMode::Single:
+        for (UINT i = 0; i < bufferCount; ++i)
+        {
+            barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(pPipeline->barriers.buffers[i].Get(), before, after);
+            pCmdList->ResourceBarrier(1, barriers);
+        }
+        break;
+
+    case BarrierMode::Batched:
+    case BarrierMode::Split:
+    {
+        D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        if (mode == BarrierMode::Split)
+        {
+            flags = (slot == BarrierSlot::AfterProducer) ?
+                D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY : D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+        }
+
+        for (UINT i = 0; i < bufferCount; ++i)
+        {
+            barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(
+                pPipeline->barriers.buffers[i].Get(),
+                before,
+                after,
+                D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+                flags);
+        }
+        pCmdList->ResourceBarrier(bufferCount, barriers);
+        break;
+    }
+
+    case BarrierMode::Uav:
+        for (UINT i = 0; i < bufferCount; ++i)
+        {
+            barriers[i] = CD3DX12_RESOURCE_BARRIER::UAV(pPipeline->barriers.buffers[i].Get());
+        }
+        pCmdList->ResourceBarrier(bufferCount, barriers);
+        break;
+
+    case BarrierMode::Enhanced:
+#if defined(D3D12_SDK_VERSION) && D3D12_SDK_VERSION >= 606
+        RecordEnhancedBarriers(pPipeline, pCmdList, toRead);
+#endif
+        break;
+
+    default:
+        // No barriers, or aliasing barriers, which go between the dispatches
+        // of a pass.
+        break;
+    }
+}
+
+// Record a pass of one dispatch per buffer. Returns the CPU ticks recording
+// its aliasing barriers took.
+static UINT64 RecordBarrierPass(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    BarrierMode mode,
+    bool write,
+    UINT seed)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+    const UINT groupCount = (pBarriers->elementCount + s_BarrierThreadGroupSize - 1) / s_BarrierThreadGroupSize;
+
+    // Reads hold the seed constant, so the keep-alive compares against the
+    // same value the writes stored.
+    BarrierConstants constants = {};
+    constants.elementCount = pBarriers->elementCount;
+    constants.seed = seed;
+    pCmdList->SetComputeRoot32BitConstants(s_BarrierRootParamConstants, sizeof(constants) / 4, &constants, 0);
+
+    ID3D12PipelineState* pPipelineState = pBarriers->writePipelineState.Get();
+    if (!write)
+    {
+        pPipelineState = IsBarrierModeUav(mode) ?
+            pBarriers->readUavPipelineState.Get() : pBarriers->readPipelineState.Get();
+    }
+    pCmdList->SetPipelineState(pPipelineState);
+
+    UINT64 barrierTicks = 0;
+    for (UINT i = 0; i < pPipeline->options.barrierResourceCount; ++i)
+    {
+        ID3D12Resource* pBuffer = GetBarrierBuffer(pPipeline, mode, i);
+
+        // The buffer about to be used takes over the heap from the other.
+        if (mode == BarrierMode::Aliasing)
+        {
+            const UINT64 startTicks = GetCpuTicks();
+            CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Aliasing(
+                GetBarrierBuffer(pPipeline, mode, i + 1),
+                pBuffer);
+            pCmdList->ResourceBarrier(1, &barrier);
+            barrierTicks += GetCpuTicks() - startTicks;
+        }
+
+        if (write || IsBarrierModeUav(mode))
+        {
+            pCmdList->SetComputeRootUnorderedAccessView(s_BarrierRootParamTarget, pBuffer->GetGPUVirtualAddress());
+        }
+        else
+        {
+            pCmdList->SetComputeRootShaderResourceView(s_BarrierRootParamSource, pBuffer->GetGPUVirtualAddress());
+        }
+        pCmdList->Dispatch(groupCount, 1, 1);
+    }
+
+    return barrierTicks;
+}
+
+// A dispatch into the sink, independent of the buffers.
+static void RecordBarrierFiller(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, UINT seed)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+    const UINT groupCount = (pBarriers->elementCount + s_BarrierThreadGroupSize - 1) / s_BarrierThreadGroupSize;
+
+    BarrierConstants constants = {};
+    constants.elementCount = pBarriers->elementCount;
+    constants.seed = seed;
+    pCmdList->SetComputeRoot32BitConstants(s_BarrierRootParamConstants, sizeof(constants) / 4, &constants, 0);
+    pCmdList->SetPipelineState(pBarriers->writePipelineState.Get());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_BarrierRootParamTarget,
+        pBarriers->sinkBuffer->GetGPUVirtualAddress());
+    pCmdList->Dispatch(groupCount, 1, 1);
+}
+
+// Record a round in `mode`. Returns the CPU ticks recording its barriers
+// took.
+static UINT64 RecordBarrierRound(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    BarrierMode mode,
+    UINT seed)
+{
+    UINT64 barrierTicks = 0;
+
+    for (UINT pass = 0; pass < 2; ++pass)
+    {
+        const bool write = pass == 0;
+
+        barrierTicks += RecordBarrierPass(pPipeline, pCmdList, mode, write, seed);
+
+        UINT64 startTicks = GetCpuTicks();
+        RecordBarrierSlot(pPipeline, pCmdList, mode, BarrierSlot::AfterProducer, write);
+        barrierTicks += GetCpuTicks() - startTicks;
+
+        RecordBarrierFiller(pPipeline, pCmdList, seed);
+
+        startTicks = GetCpuTicks();
+        RecordBarrierSlot(pPipeline, pCmdList, mode, BarrierSlot::BeforeConsumer, write);
+        barrierTicks += GetCpuTicks() - startTicks;
+    }
+
+    return barrierTicks;
+}
+
+static void SetBarrierRootArguments(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+
+    pCmdList->SetComputeRootSignature(pBarriers->rootSignature.Get());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_BarrierRootParamSink,
+        pBarriers->sinkBuffer->GetGPUVirtualAddress());
+    // Bound for the root signature's sake in modes that read through UAVs.
+    pCmdList->SetComputeRootShaderResourceView(
+        s_BarrierRootParamSource,
+        pBarriers->buffers[0]->GetGPUVirtualAddress());
+}
+
+void RecordBarriers(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    SetBarrierRootArguments(pPipeline, pCmdList);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordBarrierRound(pPipeline, pCmdList, pPipeline->barriers.mode, seed);
+    }
+}
+
+void RunBarriersSweep(Pipeline* pPipeline)
+{
+    Barriers* pBarriers = &pPipeline->barriers;
+    const UINT rounds = pPipeline->options.barrierSweepRounds;
+    // Every mode has two barriers per buffer and round.
+    const double barrierCount = 2.0 * pPipeline->options.barrierResourceCount * rounds;
+
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    char name[64];
+    double noneMs = 0.0;
+
+    for (UINT mode = 0; mode < s_BarrierModeCount; ++mode)
+    {
+        if ((BarrierMode)mode == BarrierMode::Enhanced && !pBarriers->enhancedBarriersSupported)
+        {
+            LogMessage("barriers enhanced: unsupported, skipped\n");
+            continue;
+        }
+
+        ThrowIfFailed(cmdAlloc->Reset());
+        ThrowIfFailed(cmdList->Reset(cmdAlloc.Get(), nullptr));
+        SetBarrierRootArguments(pPipeline, cmdList.Get());
+
+        UINT64 barrierTicks = 0;
+        BeginGpuMeasurement(pPipeline, cmdList.Get());
+        for (UINT round = 0; round < rounds; ++round)
+        {
+            barrierTicks += RecordBarrierRound(pPipeline, cmdList.Get(), (BarrierMode)mode, round);
+        }
+        EndGpuMeasurement(pPipeline, cmdList.Get());
+        ThrowIfFailed(cmdList->Close());
+
+        const double elapsedMs = ExecuteTimedSweepList(pPipeline, cmdList.Get());
+
+        const char* modeName = GetBarrierModeName((BarrierMode)mode);
+        if ((BarrierMode)mode == BarrierMode::None)
+        {
+            noneMs = elapsedMs;
+            LogMessage("barriers %s: %.3f ms\n", modeName, elapsedMs);
+            snprintf(name, sizeof(name), "barriers %s", modeName);
+            ReportSweepResult(pPipeline, name, elapsedMs, "ms", elapsedMs);
+            continue;
+        }
+
+        // GPU time the barriers add over the same dispatches without them,
+        // and CPU time recording them, per barrier.
+        const double bubbleUs = (elapsedMs - noneMs) * 1.0e3 / barrierCount;
+        const double cpuNs = CpuTicksToMs(barrierTicks) * 1.0e6 / barrierCount;
+
+        LogMessage(
+            "barriers %s: %.3f ms, %.3f us GPU and %.1f ns CPU per barrier\n",
+            modeName,
+            elapsedMs,
+            bubbleUs,
+            cpuNs);
+
+        snprintf(name, sizeof(name), "barriers %s gpu", modeName);
+        ReportSweepResult(pPipeline, name, bubbleUs, "us/barrier", elapsedMs);
+        snprintf(name, sizeof(name), "barriers %s cpu", modeName);
+        ReportSweepResult(pPipeline, name, cpuNs, "ns/barrier", elapsedMs);
+    }
+}
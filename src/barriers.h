@@ -0,0 +1,61 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Barrier stress: every round writes `Options::barrierResourceCount` buffers
+// with one dispatch each, makes them readable, reads them with one
+// dispatch each and makes them writable again, see barriers.hlsl. Between
+// the passes a filler dispatch gives split barriers something to overlap.
+// The barriers of a round, two per buffer, follow `Options::barrierMode`;
+// with `BarrierMode::None` the same dispatches run with no barriers, which
+// is what the sweep measures GPU bubbles against.
+struct Barriers
+{
+    // Root constants at b0, the written buffer as a root UAV at u0, the read
+    // one as a root SRV at t0 and the sink as a root UAV at u1.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> writePipelineState;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> readPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> readUavPipelineState;
+
+    // In the unordered access state between rounds.
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffers[s_MaxBarrierResourceCount];
+    // Two placed buffers sharing the heap, for aliasing barriers.
+    Microsoft::WRL::ComPtr<ID3D12Heap> aliasHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> aliasBuffers[2];
+    // Written by the filler dispatches and the reads' keep-alive.
+    Microsoft::WRL::ComPtr<ID3D12Resource> sinkBuffer;
+    UINT elementCount;
+
+    // Whether the device takes ID3D12GraphicsCommandList7::Barrier().
+    bool enhancedBarriersSupported;
+    // Mode of the frames, `Options::barrierMode` unless that is unsupported.
+    BarrierMode mode;
+};
+
+// Create the root signature and PSOs.
+void CreateBarriersPipelineStates(Pipeline* pPipeline);
+
+// Create the buffers and check for enhanced barriers. Falls back to batched
+// barriers, with a message, when the options ask for enhanced ones and the
+// device or headers lack them.
+void CreateBarriersResources(Pipeline* pPipeline);
+
+// Record rounds [firstDraw, firstDraw + drawCount) in `Options::barrierMode`.
+void RecordBarriers(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time `Options::barrierSweepRounds` rounds in every mode, and log the GPU
+// bubble and the CPU recording cost per barrier against the rounds without
+// barriers. The GPU must be idle; returns with the GPU idle.
+void RunBarriersSweep(Pipeline* pPipeline);
@@ -0,0 +1,61 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Producer and consumer kernels the barrier workload puts barriers between.
+// Every thread writes or reads one 16-byte element, so a dispatch is short
+// and the barriers' drains dominate.
+
+cbuffer BarrierConstants : register(b0)
+{
+    // 16-byte elements of each buffer.
+    uint elementCount;
+    // Changes every dispatch.
+    uint seed;
+    uint2 padding;
+};
+
+RWByteAddressBuffer target : register(u0);
+ByteAddressBuffer source : register(t0);
+RWByteAddressBuffer sink : register(u1);
+
+// Keep the reads alive without paying for a write per thread: elements hold
+// their index, so the top bit is never set.
+void KeepAlive(uint4 value, uint element)
+{
+    if (value.x == (seed | 0x80000000))
+    {
+        sink.Store4(element * 16, value);
+    }
+}
+
+[numthreads(64, 1, 1)]
+void CSWrite(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint element = dispatchThreadId.x;
+    if (element < elementCount)
+    {
+        target.Store4(element * 16, uint4(element, seed, 0, 1));
+    }
+}
+
+// Reads through the SRV, after a transition.
+[numthreads(64, 1, 1)]
+void CSRead(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint element = dispatchThreadId.x;
+    if (element < elementCount)
+    {
+        KeepAlive(source.Load4(element * 16), element);
+    }
+}
+
+// Reads through the UAV, for modes that keep the buffers in the unordered
+// access state.
+[numthreads(64, 1, 1)]
+void CSReadUav(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint element = dispatchThreadId.x;
+    if (element < elementCount)
+    {
+        KeepAlive(target.Load4(element * 16), element);
+    }
+}
@@ -0,0 +1,343 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "bindless.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+
+static const UINT s_BindlessThreadGroupSize = 64;
+static const UINT s_BindlessThreadGroupCount = 1024;
+
+// Width and height of every texture. 128x128 RGBA8 is exactly one 64 KB
+// placement unit.
+static const UINT s_BindlessTextureSize = 128;
+
+// Distinct indices per thread group and sample the sweep runs.
+static const UINT s_BindlessSweepDivergences[] = { 1, 4, 16, 64 };
+
+// Root parameter slots of `Bindless::rootSignature`.
+static const UINT s_BindlessRootParamConstants = 0;
+static const UINT s_BindlessRootParamTextures = 1;
+static const UINT s_BindlessRootParamOutput = 2;
+static const UINT s_BindlessRootParamCount = 3;
+
+// Matches `BindlessConstants` in bindless.hlsl.
+struct BindlessConstants
+{
+    UINT descriptorCount;
+    UINT divergence;
+    UINT sampleCount;
+    UINT seed;
+};
+
+// Create one SRV per texture in the staging heap.
+static UINT64 WriteStagingDescriptors(Pipeline* pPipeline)
+{
+    Bindless* pBindless = &pPipeline->bindless;
+
+    const UINT64 startTicks = GetCpuTicks();
+    CD3DX12_CPU_DESCRIPTOR_HANDLE handle(pBindless->stagingHeap->GetCPUDescriptorHandleForHeapStart());
+    for (UINT i = 0; i < pBindless->textureCount; ++i)
+    {
+        pPipeline->device->CreateShaderResourceView(pBindless->textures[i].Get(), nullptr, handle);
+        handle.Offset(1, pBindless->descriptorSize);
+    }
+
+    return GetCpuTicks() - startTicks;
+}
+
+// Create every SRV of the shader-visible heap in place.
+static UINT64 WriteVisibleDescriptors(Pipeline* pPipeline)
+{
+    Bindless* pBindless = &pPipeline->bindless;
+
+    const UINT64 startTicks = GetCpuTicks();
+    CD3DX12_CPU_DESCRIPTOR_HANDLE handle(pBindless->descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+    for (UINT i = 0; i < pBindless->descriptorCount; ++i)
+    {
+        pPipeline->device->CreateShaderResourceView(
+            pBindless->textures[i % pBindless->textureCount].Get(),
+            nullptr,
+            handle);
+        handle.Offset(1, pBindless->descriptorSize);
+    }
+
+    return GetCpuTicks() - startTicks;
+}
+
+// Fill the shader-visible heap with copies of the staging heap, as a renderer
+// streaming descriptors in would.
+static UINT64 CopyVisibleDescriptors(Pipeline* pPipeline)
+{
+    Bindless* pBindless = &pPipeline->bindless;
+
+    const UINT64 startTicks = GetCpuTicks();
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dstHandle(pBindless->descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+    for (UINT first = 0; first < pBindless->descriptorCount; first += pBindless->textureCount)
+    {
+        const UINT count = min(pBindless->textureCount, pBindless->descriptorCount - first);
+        pPipeline->device->CopyDescriptorsSimple(
+            count,
+            dstHandle,
+            pBindless->stagingHeap->GetCPUDescriptorHandleForHeapStart(),
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        dstHandle.Offset(count, pBindless->descriptorSize);
+    }
+
+    return GetCpuTicks() - startTicks;
+}
+
+static double GetNsPerDescriptor(UINT64 ticks, UINT descriptorCount)
+{
+    return CpuTicksToMs(ticks) * 1.0e6 / descriptorCount;
+}
+
+void CreateBindless(Pipeline* pPipeline)
+{
+    Bindless* pBindless = &pPipeline->bindless;
+    const Options& options = pPipeline->options;
+
+    // Tier 1 caps SRV tables at 128 descriptors.
+    D3D12_FEATURE_DATA_D3D12_OPTIONS d3d12Options = {};
+    if (FAILED(pPipeline->device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &d3d12Options, sizeof(d3d12Options))) ||
+        d3d12Options.ResourceBindingTier < D3D12_RESOURCE_BINDING_TIER_2)
+    {
+        LogMessage("bindless: disabled, needs resource binding tier 2\n");
+        return;
+    }
+
+    pBindless->descriptorCount = options.bindlessDescriptorCount;
+    pBindless->textureCount = min(options.bindlessTextureCount, pBindless->descriptorCount);
+    pBindless->descriptorSize =
+        pPipeline->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    // Create the compute root signature.
+    {
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[1] = {};
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_BindlessRootParamCount] = {};
+
+        // Unbounded, the shader indexes as much of the heap as is bound.
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+        rootParameters[s_BindlessRootParamConstants].InitAsConstants(
+            sizeof(BindlessConstants) / 4,
+            0);
+        rootParameters[s_BindlessRootParamTextures].InitAsDescriptorTable(1, &ranges[0]);
+        rootParameters[s_BindlessRootParamOutput].InitAsUnorderedAccessView(0);
+
+        CD3DX12_STATIC_SAMPLER_DESC samplerDesc(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            1,
+            &samplerDesc,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pBindless->rootSignature);
+    }
+
+    // Unbounded arrays and NonUniformResourceIndex() need shader model 5.1.
+    {
+        ComPtr<ID3DBlob> computeShader;
+        CompileShader(L"bindless.hlsl", "CSMain", "cs_5_1", nullptr, &computeShader);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pBindless->rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+        CreateComputePipelineState(pPipeline, L"bindless", psoDesc, &pBindless->pipelineState);
+    }
+
+    // Create the textures, left zeroed; the kernel only needs distinct
+    // resources to index.
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+        DXGI_FORMAT_R8G8B8A8_UNORM,
+        s_BindlessTextureSize,
+        s_BindlessTextureSize,
+        1,
+        1);
+    for (UINT i = 0; i < pBindless->textureCount; ++i)
+    {
+        ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &textureDesc,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            nullptr,
+            IID_PPV_ARGS(&pBindless->textures[i])));
+    }
+
+    // One float4 per thread.
+    CD3DX12_RESOURCE_DESC outputDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)s_BindlessThreadGroupCount * s_BindlessThreadGroupSize * 16,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &outputDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pBindless->outputBuffer)));
+
+    // Create the heaps.
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+        heapDesc.NumDescriptors = pBindless->descriptorCount;
+        heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        ThrowIfFailed(pPipeline->device->CreateDescriptorHeap(
+            &heapDesc,
+            IID_PPV_ARGS(&pBindless->descriptorHeap)));
+
+        D3D12_DESCRIPTOR_HEAP_DESC stagingHeapDesc = {};
+        stagingHeapDesc.NumDescriptors = pBindless->textureCount;
+        stagingHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        stagingHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        ThrowIfFailed(pPipeline->device->CreateDescriptorHeap(
+            &stagingHeapDesc,
+            IID_PPV_ARGS(&pBindless->stagingHeap)));
+    }
+
+    WriteStagingDescriptors(pPipeline);
+    const UINT64 copyTicks = CopyVisibleDescriptors(pPipeline);
+
+    LogMessage(
+        "bindless: %u SRVs of %u textures, filled in %.1f ms\n",
+        pBindless->descriptorCount,
+        pBindless->textureCount,
+        CpuTicksToMs(copyTicks));
+
+    pBindless->supported = true;
+}
+
+static void SetBindlessRootArguments(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    Bindless* pBindless = &pPipeline->bindless;
+
+    ID3D12DescriptorHeap* ppHeaps[] = { pBindless->descriptorHeap.Get() };
+    pCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    pCmdList->SetComputeRootSignature(pBindless->rootSignature.Get());
+    pCmdList->SetComputeRootDescriptorTable(
+        s_BindlessRootParamTextures,
+        pBindless->descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_BindlessRootParamOutput,
+        pBindless->outputBuffer->GetGPUVirtualAddress());
+    pCmdList->SetPipelineState(pBindless->pipelineState.Get());
+}
+
+static void RecordBindlessDispatch(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT divergence,
+    UINT seed)
+{
+    BindlessConstants constants = {};
+    constants.descriptorCount = pPipeline->bindless.descriptorCount;
+    constants.divergence = divergence;
+    constants.sampleCount = pPipeline->options.bindlessSamples;
+    constants.seed = seed;
+
+    pCmdList->SetComputeRoot32BitConstants(
+        s_BindlessRootParamConstants,
+        sizeof(BindlessConstants) / 4,
+        &constants,
+        0);
+    pCmdList->Dispatch(s_BindlessThreadGroupCount, 1, 1);
+}
+
+void RecordBindless(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    if (!pPipeline->bindless.supported)
+    {
+        return;
+    }
+
+    SetBindlessRootArguments(pPipeline, pCmdList);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordBindlessDispatch(pPipeline, pCmdList, pPipeline->options.bindlessDivergence, seed);
+    }
+}
+
+void RunBindlessSweep(Pipeline* pPipeline)
+{
+    Bindless* pBindless = &pPipeline->bindless;
+
+    if (!pBindless->supported)
+    {
+        return;
+    }
+
+    // Descriptor writes and copies, on the CPU. The heap ends up as it was.
+    {
+        const double stagingNs = GetNsPerDescriptor(WriteStagingDescriptors(pPipeline), pBindless->textureCount);
+        const double visibleNs = GetNsPerDescriptor(WriteVisibleDescriptors(pPipeline), pBindless->descriptorCount);
+        const double copyNs = GetNsPerDescriptor(CopyVisibleDescriptors(pPipeline), pBindless->descriptorCount);
+
+        LogMessage(
+            "bindless descriptors: write %.1f ns, write shader-visible %.1f ns, copy %.1f ns per descriptor\n",
+            stagingNs,
+            visibleNs,
+            copyNs);
+
+        // CPU-side timings, there is no GPU time.
+        ReportSweepResult(pPipeline, "bindless descriptor write", stagingNs, "ns/descriptor", 0.0);
+        ReportSweepResult(pPipeline, "bindless descriptor write shader-visible", visibleNs, "ns/descriptor", 0.0);
+        ReportSweepResult(pPipeline, "bindless descriptor copy", copyNs, "ns/descriptor", 0.0);
+    }
+
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    const UINT iterations = pPipeline->options.bindlessSweepIterations;
+    const double samples = (double)s_BindlessThreadGroupCount * s_BindlessThreadGroupSize *
+        pPipeline->options.bindlessSamples * iterations;
+
+    for (UINT divergence : s_BindlessSweepDivergences)
+    {
+        ThrowIfFailed(cmdAlloc->Reset());
+        ThrowIfFailed(cmdList->Reset(cmdAlloc.Get(), nullptr));
+        SetBindlessRootArguments(pPipeline, cmdList.Get());
+        BeginGpuMeasurement(pPipeline, cmdList.Get());
+        for (UINT iteration = 0; iteration < iterations; ++iteration)
+        {
+            RecordBindlessDispatch(pPipeline, cmdList.Get(), divergence, iteration);
+        }
+        EndGpuMeasurement(pPipeline, cmdList.Get());
+        ThrowIfFailed(cmdList->Close());
+
+        const double elapsedMs = ExecuteTimedSweepList(pPipeline, cmdList.Get());
+
+        const double gigaSamplesPerSecond = GetRate(samples, elapsedMs, 1.0e9);
+
+        LogMessage(
+            "bindless sampling, %u indices per group: %.2f Gsamples/s (%.3f ms)\n",
+            divergence,
+            gigaSamplesPerSecond,
+            elapsedMs);
+
+        char name[64];
+        snprintf(name, sizeof(name), "bindless sample divergence %u", divergence);
+        ReportSweepResult(pPipeline, name, gigaSamplesPerSecond, "Gsamples/s", elapsedMs);
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Bindless texture sampling: one shader-visible CBV/SRV/UAV heap of up to
+// a million SRVs, cycling over `Options::bindlessTextureCount` small
+// textures, which a compute kernel samples through an unbounded `Texture2D`
+// array with divergent indices, see bindless.hlsl.
+//
+// The workload binds its own heap, so it replaces the frame's CBV heap for
+// the rest of the list it is recorded into.
+struct Bindless
+{
+    // The adapter's resource binding tier allows SRV tables spanning the
+    // whole heap. Without it nothing is created or recorded.
+    bool supported;
+
+    // Compute root signature: root constants at b0, the unbounded SRV table
+    // at t0, the output buffer as a root UAV at u0, and a static sampler
+    // at s0.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> textures[s_MaxBindlessTextureCount];
+    UINT textureCount;
+
+    // Shader-visible heap the kernel indexes.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    UINT descriptorCount;
+    // CPU-only heap with one SRV per texture, the source of copies into
+    // `descriptorHeap`.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> stagingHeap;
+    UINT descriptorSize;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> outputBuffer;
+};
+
+// Check the resource binding tier, then create the textures, heaps, root
+// signature and PSO, and fill the shader-visible heap.
+void CreateBindless(Pipeline* pPipeline);
+
+// Record dispatches [firstDraw, firstDraw + drawCount), each sampling at
+// `Options::bindlessDivergence`.
+void RecordBindless(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time descriptor writes and copies on the CPU, then sampling at growing
+// divergence on the GPU, and log their rates. The GPU must be idle; returns
+// with the GPU idle and the heap filled as after creation.
+void RunBindlessSweep(Pipeline* pPipeline);
@@ -0,0 +1,53 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Bindless sampling kernel. Every thread samples `sampleCount` textures out of
+// the whole descriptor heap; consecutive threads share `divergence` distinct
+// indices per sample, so 1 is uniform across the group and 64 gives every
+// thread of the group its own texture.
+
+cbuffer BindlessConstants : register(b0)
+{
+    // SRVs in the table.
+    uint descriptorCount;
+    // Distinct indices per thread group and sample, from 1 to 64.
+    uint divergence;
+    // Samples per thread.
+    uint sampleCount;
+    // Changes every dispatch so the indices do.
+    uint seed;
+};
+
+Texture2D<float4> textures[] : register(t0);
+SamplerState linearSampler : register(s0);
+RWStructuredBuffer<float4> output : register(u0);
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+[numthreads(64, 1, 1)]
+void CSMain(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex, uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    float4 sum = 0.0f;
+    const uint lane = groupIndex % divergence;
+    const float2 uv = float2(groupIndex, groupId.x) / 64.0f;
+
+    for (uint i = 0; i < sampleCount; ++i)
+    {
+        uint index = Hash(seed + (groupId.x * sampleCount + i) * 64 + lane) % descriptorCount;
+        sum += textures[NonUniformResourceIndex(index)].SampleLevel(linearSampler, uv, 0.0f);
+    }
+
+    // Keep the samples alive without paying for a write per thread: the
+    // textures are never written and start zeroed, so the sum stays 0.
+    if (sum.x != 0.0f)
+    {
+        output[dispatchThreadId.x] = sum;
+    }
+}
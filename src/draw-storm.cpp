@@ -0,0 +1,216 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "draw-storm.h"
+#include "pipeline.h"
+
+using namespace DirectX;
+
+// Center of grid cell `cell`, in clip space.
+static DrawConstants GetDrawConstants(UINT cell)
+{
+    const float cellSize = 2.0f / (float)s_DrawStormGridSize;
+    const UINT x = cell % s_DrawStormGridSize;
+    const UINT y = (cell / s_DrawStormGridSize) % s_DrawStormGridSize;
+
+    DrawConstants constants = {};
+    constants.offset = XMFLOAT4(
+        -1.0f + cellSize * ((float)x + 0.5f),
+        -1.0f + cellSize * ((float)y + 0.5f),
+        0.0f,
+        0.0f);
+    return constants;
+}
+
+void CreateDrawStormPipelineStates(
+    Pipeline* pPipeline,
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& baseDesc)
+{
+    DrawStorm* pStorm = &pPipeline->drawStorm;
+
+    for (UINT i = 0; i < s_DrawStormPsoCount; ++i)
+    {
+        // The triangle is front facing, so every variant still draws it.
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = baseDesc;
+        psoDesc.RasterizerState.CullMode = (i & 1) ? D3D12_CULL_MODE_NONE : D3D12_CULL_MODE_BACK;
+
+        D3D12_RENDER_TARGET_BLEND_DESC* pBlend = &psoDesc.BlendState.RenderTarget[0];
+        pBlend->BlendEnable = (i & 2) ? TRUE : FALSE;
+        pBlend->SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        pBlend->DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        pBlend->BlendOp = D3D12_BLEND_OP_ADD;
+
+        CreateGraphicsPipelineState(pPipeline, L"draw-storm", psoDesc, &pStorm->pipelineStates[i]);
+    }
+}
+
+void CreateDrawStormResources(Pipeline* pPipeline)
+{
+    DrawStorm* pStorm = &pPipeline->drawStorm;
+    const UINT frameCount = pPipeline->options.frameCount;
+
+    // Create descriptor tables to switch between.
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
+        cbvHeapDesc.NumDescriptors = frameCount * s_DrawStormTableCount;
+        cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        ThrowIfFailed(pPipeline->device->CreateDescriptorHeap(
+            &cbvHeapDesc,
+            IID_PPV_ARGS(&pStorm->cbvDescriptorHeap)));
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE cbvHandle(
+            pStorm->cbvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+
+        for (UINT frame = 0; frame < frameCount; ++frame)
+        {
+            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
+            cbvDesc.BufferLocation =
+                pPipeline->constantBuffer->GetGPUVirtualAddress() + (UINT64)frame * sizeof(ConstBuffer);
+            cbvDesc.SizeInBytes = sizeof(ConstBuffer);
+
+            for (UINT table = 0; table < s_DrawStormTableCount; ++table)
+            {
+                pPipeline->device->CreateConstantBufferView(&cbvDesc, cbvHandle);
+                cbvHandle.Offset(1, pPipeline->cbvDescriptorSize);
+            }
+        }
+    }
+
+    // Create the vertex buffers. Each copy is a triangle the size of a grid
+    // cell, so thousands of draws stay cheap on the GPU side.
+    {
+        const float halfSize = 1.0f / (float)s_DrawStormGridSize;
+        const UINT verticesPerBuffer = 3;
+
+        Vertex vertices[s_DrawStormVertexBufferCount * verticesPerBuffer];
+        for (UINT i = 0; i < s_DrawStormVertexBufferCount; ++i)
+        {
+            const float shade = (float)(i + 1) / (float)s_DrawStormVertexBufferCount;
+            vertices[i * 3 + 0] = { { 0.0f, halfSize, 0.0f }, { shade, 0.0f, 0.0f, 1.0f } };
+            vertices[i * 3 + 1] = { { halfSize, -halfSize, 0.0f }, { 0.0f, shade, 0.0f, 1.0f } };
+            vertices[i * 3 + 2] = { { -halfSize, -halfSize, 0.0f }, { 0.0f, 0.0f, shade, 1.0f } };
+        }
+
+        const UINT vertexBufferSize = sizeof(vertices);
+
+        // Same as the main vertex buffer, an upload heap keeps this simple and
+        // the data is tiny.
+        CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+        CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
+        ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+            &uploadHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&pStorm->vertexBuffer)));
+
+        UINT8* pVertexData;
+        CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+        ThrowIfFailed(pStorm->vertexBuffer->Map(
+            0,
+            &readRange,
+            reinterpret_cast<void**>(&pVertexData)));
+        memcpy(pVertexData, vertices, vertexBufferSize);
+        pStorm->vertexBuffer->Unmap(0, nullptr);
+
+        for (UINT i = 0; i < s_DrawStormVertexBufferCount; ++i)
+        {
+            D3D12_VERTEX_BUFFER_VIEW* pView = &pStorm->vertexBufferViews[i];
+            pView->BufferLocation = pStorm->vertexBuffer->GetGPUVirtualAddress() +
+                (UINT64)i * verticesPerBuffer * sizeof(Vertex);
+            pView->StrideInBytes = sizeof(Vertex);
+            pView->SizeInBytes = verticesPerBuffer * sizeof(Vertex);
+        }
+    }
+}
+
+// Upload fresh constants for `index` and bind them as the draw's root CBV.
+static void SetDrawData(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, UINT index)
+{
+    const UINT size = pPipeline->options.uploadBytesPerDraw;
+    const UploadAllocation allocation = AllocateUpload(pPipeline, size);
+
+    // Write every byte of the slice in order, so the cost scales with
+    // `-upload-bytes` and the write-combining buffers flush whole lines.
+    // The first float4 is the `DrawData` the shader reads.
+    const float shade = 0.5f + 0.5f * (float)(index % 16) / 15.0f;
+    const XMFLOAT4 color(shade, shade, shade, 1.0f);
+    XMFLOAT4* pData = (XMFLOAT4*)allocation.pCpuAddress;
+    for (UINT i = 0; i < size / sizeof(XMFLOAT4); ++i)
+    {
+        pData[i] = color;
+    }
+
+    pCmdList->SetGraphicsRootConstantBufferView(s_RootParamDrawData, allocation.gpuAddress);
+}
+
+// Whether state with change interval `interval` is set before `draw`.
+static bool ShouldChangeState(UINT interval, UINT draw, UINT firstDraw)
+{
+    return interval != 0 && (draw == firstDraw || draw % interval == 0);
+}
+
+void RecordDrawStorm(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    const Options& options = pPipeline->options;
+    DrawStorm* pStorm = &pPipeline->drawStorm;
+
+    ID3D12DescriptorHeap* ppHeaps[] = { pStorm->cbvDescriptorHeap.Get() };
+    pCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE frameTables(
+        pStorm->cbvDescriptorHeap->GetGPUDescriptorHandleForHeapStart(),
+        pPipeline->frameResourceIndex * s_DrawStormTableCount,
+        pPipeline->cbvDescriptorSize);
+    pCmdList->SetGraphicsRootDescriptorTable(s_RootParamCbvTable, frameTables);
+
+    pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCmdList->IASetVertexBuffers(0, 1, &pStorm->vertexBufferViews[0]);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        if (ShouldChangeState(options.psoInterval, draw, firstDraw))
+        {
+            const UINT pso = (draw / options.psoInterval) % s_DrawStormPsoCount;
+            pCmdList->SetPipelineState(pStorm->pipelineStates[pso].Get());
+        }
+
+        if (ShouldChangeState(options.descriptorTableInterval, draw, firstDraw))
+        {
+            const UINT table = (draw / options.descriptorTableInterval) % s_DrawStormTableCount;
+            CD3DX12_GPU_DESCRIPTOR_HANDLE tableHandle(
+                frameTables,
+                table,
+                pPipeline->cbvDescriptorSize);
+            pCmdList->SetGraphicsRootDescriptorTable(s_RootParamCbvTable, tableHandle);
+        }
+
+        if (ShouldChangeState(options.vertexBufferInterval, draw, firstDraw))
+        {
+            const UINT vertexBuffer = (draw / options.vertexBufferInterval) % s_DrawStormVertexBufferCount;
+            pCmdList->IASetVertexBuffers(0, 1, &pStorm->vertexBufferViews[vertexBuffer]);
+        }
+
+        if (ShouldChangeState(options.rootConstantInterval, draw, firstDraw))
+        {
+            const DrawConstants constants = GetDrawConstants(draw / options.rootConstantInterval);
+            pCmdList->SetGraphicsRoot32BitConstants(
+                s_RootParamDrawConstants,
+                sizeof(DrawConstants) / 4,
+                &constants,
+                0);
+        }
+
+        if (ShouldChangeState(options.rootCbvInterval, draw, firstDraw))
+        {
+            SetDrawData(pPipeline, pCmdList, draw / options.rootCbvInterval);
+        }
+
+        pCmdList->DrawInstanced(3, 1, 0, 0);
+    }
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// Number of distinct values each kind of state cycles through.
+static const UINT s_DrawStormPsoCount = 4;
+static const UINT s_DrawStormTableCount = 16;
+static const UINT s_DrawStormVertexBufferCount = 16;
+
+// Draws are spread over a grid of this many cells per side.
+static const UINT s_DrawStormGridSize = 64;
+
+// Issues `Options::drawCount` tiny draws per frame. Between draws it changes
+// root constants, descriptor tables, PSOs and vertex buffers, and uploads
+// constants for a root CBV, at the intervals given in `Options`, so the cost
+// measured is CPU/driver submission rather than GPU work.
+struct DrawStorm
+{
+    // Variants of the main PSO differing in rasterizer and blend state.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStates[s_DrawStormPsoCount];
+
+    // `s_DrawStormTableCount` CBVs per frame resource, all viewing that frame's
+    // slice of `Pipeline::constantBuffer`. The contents are identical, only
+    // the descriptor tables differ.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> cbvDescriptorHeap;
+
+    // `s_DrawStormVertexBufferCount` copies of a small triangle, one view each.
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[s_DrawStormVertexBufferCount];
+};
+
+// Create the PSO variants from the description of the main PSO.
+void CreateDrawStormPipelineStates(
+    Pipeline* pPipeline,
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& baseDesc);
+
+// Create descriptors and vertex buffers. Requires the constant buffer.
+void CreateDrawStormResources(Pipeline* pPipeline);
+
+// Record draws [firstDraw, firstDraw + drawCount) of the storm. State changes
+// are a function of the draw index only, so a list recorded on any thread
+// sees the same state sequence as a single-threaded recording.
+void RecordDrawStorm(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
@@ -0,0 +1,514 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "fault.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+
+// float4 elements of each buffer, as many as a constant buffer can have.
+static const UINT s_FaultElementCount = 4096;
+static const UINT s_FaultBufferSize = s_FaultElementCount * 16;
+
+// Threads per dispatch, in groups of 64, and vertices per draw.
+static const UINT s_FaultComputeThreadCount = 64 * 1024;
+static const UINT s_FaultThreadGroupSize = 64;
+static const UINT s_FaultVertexCount = 64 * 1024;
+
+// Root parameter slots of both root signatures.
+static const UINT s_FaultRootParamConstants = 0;
+// `Fault::tableRootSignature`.
+static const UINT s_FaultRootParamTable = 1;
+// `Fault::rootRootSignature`.
+static const UINT s_FaultRootParamCbv = 1;
+static const UINT s_FaultRootParamSrv = 2;
+static const UINT s_FaultRootParamUav = 3;
+
+// Matches `FaultConstants` in fault.hlsl.
+struct FaultConstants
+{
+    UINT firstElement;
+    UINT iterations;
+    UINT seed;
+    UINT width;
+};
+
+struct FaultCase
+{
+    FaultAccess access;
+    FaultStage stage;
+    FaultBinding binding;
+    UINT firstElement;
+};
+
+void CreateFaultPipelineStates(Pipeline* pPipeline)
+{
+    Fault* pFault = &pPipeline->fault;
+
+    // Create the root signatures.
+    {
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[3] = {};
+        CD3DX12_ROOT_PARAMETER1 rootParameters[2] = {};
+
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1);
+        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+        ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+        rootParameters[s_FaultRootParamConstants].InitAsConstants(sizeof(FaultConstants) / 4, 0);
+        rootParameters[s_FaultRootParamTable].InitAsDescriptorTable(_countof(ranges), ranges);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pFault->tableRootSignature);
+    }
+
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[4] = {};
+
+        rootParameters[s_FaultRootParamConstants].InitAsConstants(sizeof(FaultConstants) / 4, 0);
+        rootParameters[s_FaultRootParamCbv].InitAsConstantBufferView(1);
+        rootParameters[s_FaultRootParamSrv].InitAsShaderResourceView(0);
+        rootParameters[s_FaultRootParamUav].InitAsUnorderedAccessView(0);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pFault->rootRootSignature);
+    }
+
+    ID3D12RootSignature* ppRootSignatures[s_FaultBindingCount] =
+    {
+        pFault->tableRootSignature.Get(),
+        pFault->rootRootSignature.Get(),
+    };
+
+    ComPtr<ID3DBlob> fullScreenShader;
+    CompileShader(L"fault.hlsl", "VSFullScreen", "vs_5_1", nullptr, &fullScreenShader);
+
+    for (UINT access = 0; access < s_FaultAccessCount; ++access)
+    {
+        char accessValue[4];
+        snprintf(accessValue, sizeof(accessValue), "%u", access);
+        const D3D_SHADER_MACRO defines[] = { { "FAULT_ACCESS", accessValue }, { nullptr, nullptr } };
+
+        ComPtr<ID3DBlob> computeShader;
+        ComPtr<ID3DBlob> vertexShader;
+        ComPtr<ID3DBlob> pixelShader;
+        CompileShader(L"fault.hlsl", "CSMain", "cs_5_1", defines, &computeShader);
+        CompileShader(L"fault.hlsl", "VSMain", "vs_5_1", defines, &vertexShader);
+        CompileShader(L"fault.hlsl", "PSMain", "ps_5_1", defines, &pixelShader);
+
+        for (UINT binding = 0; binding < s_FaultBindingCount; ++binding)
+        {
+            D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc = {};
+            computeDesc.pRootSignature = ppRootSignatures[binding];
+            computeDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+            CreateComputePipelineState(
+                pPipeline,
+                L"fault",
+                computeDesc,
+                &pFault->pipelineStates[binding][(UINT)FaultStage::Compute][access]);
+
+            // The vertex stage case rasterizes nothing, so needs no pixel
+            // shader; both keep the frame's render target bound.
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc = {};
+            graphicsDesc.pRootSignature = ppRootSignatures[binding];
+            graphicsDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+            graphicsDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+            graphicsDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+            graphicsDesc.DepthStencilState.DepthEnable = FALSE;
+            graphicsDesc.DepthStencilState.StencilEnable = FALSE;
+            graphicsDesc.SampleMask = UINT_MAX;
+            graphicsDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+            graphicsDesc.NumRenderTargets = 1;
+            graphicsDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+            graphicsDesc.SampleDesc.Count = 1;
+            CreateGraphicsPipelineState(
+                pPipeline,
+                L"fault",
+                graphicsDesc,
+                &pFault->pipelineStates[binding][(UINT)FaultStage::Vertex][access]);
+
+            graphicsDesc.VS = CD3DX12_SHADER_BYTECODE(fullScreenShader.Get());
+            graphicsDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+            graphicsDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+            CreateGraphicsPipelineState(
+                pPipeline,
+                L"fault",
+                graphicsDesc,
+                &pFault->pipelineStates[binding][(UINT)FaultStage::Pixel][access]);
+        }
+    }
+}
+
+void CreateFaultResources(Pipeline* pPipeline)
+{
+    Fault* pFault = &pPipeline->fault;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC dataDesc = CD3DX12_RESOURCE_DESC::Buffer(s_FaultBufferSize);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &dataDesc,
+        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+        nullptr,
+        IID_PPV_ARGS(&pFault->dataBuffer)));
+
+    CD3DX12_RESOURCE_DESC uavDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(s_FaultBufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &uavDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pFault->uavBuffer)));
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = 3;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    ThrowIfFailed(pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&pFault->descriptorHeap)));
+
+    const UINT descriptorSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE handle(pFault->descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+
+    // The views' sizes are what the table accesses are checked against.
+    D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
+    cbvDesc.BufferLocation = pFault->dataBuffer->GetGPUVirtualAddress();
+    cbvDesc.SizeInBytes = s_FaultBufferSize;
+    pDevice->CreateConstantBufferView(&cbvDesc, handle);
+    handle.Offset(1, descriptorSize);
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.NumElements = s_FaultElementCount;
+    srvDesc.Buffer.StructureByteStride = 16;
+    pDevice->CreateShaderResourceView(pFault->dataBuffer.Get(), &srvDesc, handle);
+    handle.Offset(1, descriptorSize);
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavViewDesc = {};
+    uavViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    uavViewDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    uavViewDesc.Buffer.NumElements = s_FaultElementCount;
+    uavViewDesc.Buffer.StructureByteStride = 16;
+    pDevice->CreateUnorderedAccessView(pFault->uavBuffer.Get(), nullptr, &uavViewDesc, handle);
+}
+
+static void SetFaultState(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, const FaultCase& faultCase)
+{
+    Fault* pFault = &pPipeline->fault;
+    const bool compute = faultCase.stage == FaultStage::Compute;
+
+    ID3D12DescriptorHeap* ppHeaps[] = { pFault->descriptorHeap.Get() };
+    pCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+    if (faultCase.binding == FaultBinding::Table)
+    {
+        const D3D12_GPU_DESCRIPTOR_HANDLE table = pFault->descriptorHeap->GetGPUDescriptorHandleForHeapStart();
+        if (compute)
+        {
+            pCmdList->SetComputeRootSignature(pFault->tableRootSignature.Get());
+            pCmdList->SetComputeRootDescriptorTable(s_FaultRootParamTable, table);
+        }
+        else
+        {
+            pCmdList->SetGraphicsRootSignature(pFault->tableRootSignature.Get());
+            pCmdList->SetGraphicsRootDescriptorTable(s_FaultRootParamTable, table);
+        }
+    }
+    else
+    {
+        const D3D12_GPU_VIRTUAL_ADDRESS dataAddress = pFault->dataBuffer->GetGPUVirtualAddress();
+        const D3D12_GPU_VIRTUAL_ADDRESS uavAddress = pFault->uavBuffer->GetGPUVirtualAddress();
+        if (compute)
+        {
+            pCmdList->SetComputeRootSignature(pFault->rootRootSignature.Get());
+            pCmdList->SetComputeRootConstantBufferView(s_FaultRootParamCbv, dataAddress);
+            pCmdList->SetComputeRootShaderResourceView(s_FaultRootParamSrv, dataAddress);
+            pCmdList->SetComputeRootUnorderedAccessView(s_FaultRootParamUav, uavAddress);
+        }
+        else
+        {
+            pCmdList->SetGraphicsRootSignature(pFault->rootRootSignature.Get());
+            pCmdList->SetGraphicsRootConstantBufferView(s_FaultRootParamCbv, dataAddress);
+            pCmdList->SetGraphicsRootShaderResourceView(s_FaultRootParamSrv, dataAddress);
+            pCmdList->SetGraphicsRootUnorderedAccessView(s_FaultRootParamUav, uavAddress);
+        }
+    }
+
+    pCmdList->SetPipelineState(
+        pFault->pipelineStates[(UINT)faultCase.binding][(UINT)faultCase.stage][(UINT)faultCase.access].Get());
+
+    if (faultCase.stage == FaultStage::Vertex)
+    {
+        pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_POINTLIST);
+    }
+    else if (faultCase.stage == FaultStage::Pixel)
+    {
+        pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+}
+
+// Threads, vertices or pixels of every dispatch or draw.
+static UINT GetFaultInvocationCount(Pipeline* pPipeline, FaultStage stage)
+{
+    switch (stage)
+    {
+    case FaultStage::Vertex:
+        return s_FaultVertexCount;
+    case FaultStage::Pixel:
+        return (UINT)pPipeline->viewport.Width * (UINT)pPipeline->viewport.Height;
+    default:
+        return s_FaultComputeThreadCount;
+    }
+}
+
+static void RecordFaultDraw(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    const FaultCase& faultCase,
+    UINT seed)
+{
+    FaultConstants constants = {};
+    constants.firstElement = faultCase.firstElement;
+    constants.iterations = pPipeline->options.faultIterations;
+    constants.seed = seed;
+    constants.width = (UINT)pPipeline->viewport.Width;
+
+    switch (faultCase.stage)
+    {
+    case FaultStage::Vertex:
+        pCmdList->SetGraphicsRoot32BitConstants(s_FaultRootParamConstants, sizeof(constants) / 4, &constants, 0);
+        pCmdList->DrawInstanced(s_FaultVertexCount, 1, 0, 0);
+        break;
+    case FaultStage::Pixel:
+        pCmdList->SetGraphicsRoot32BitConstants(s_FaultRootParamConstants, sizeof(constants) / 4, &constants, 0);
+        pCmdList->DrawInstanced(3, 1, 0, 0);
+        break;
+    default:
+        pCmdList->SetComputeRoot32BitConstants(s_FaultRootParamConstants, sizeof(constants) / 4, &constants, 0);
+        pCmdList->Dispatch(s_FaultComputeThreadCount / s_FaultThreadGroupSize, 1, 1);
+        break;
+    }
+}
+
+void RecordFault(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    const Options& options = pPipeline->options;
+
+    FaultCase faultCase = {};
+    faultCase.access = options.faultAccess;
+    faultCase.stage = options.faultStage;
+    faultCase.binding = options.faultBinding;
+    faultCase.firstElement = options.faultIndex;
+
+    // Graphics cases draw into the render target the frame bound.
+    SetFaultState(pPipeline, pCmdList, faultCase);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordFaultDraw(pPipeline, pCmdList, faultCase, seed);
+    }
+}
+
+// Reusable list of the sweep, run twice per case.
+struct FaultSweepContext
+{
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+};
+
+static double ExecuteFaultSweepList(Pipeline* pPipeline, FaultSweepContext* pContext)
+{
+    ThrowIfFailed(pContext->cmdList->Close());
+
+    const double elapsedMs = ExecuteTimedSweepList(pPipeline, pContext->cmdList.Get());
+
+    // A removed device completes its fences at once, so the waits alone
+    // don't tell a fault from a fast case.
+    ThrowIfFailed(pPipeline->device->GetDeviceRemovedReason());
+
+    return elapsedMs;
+}
+
+// Time a case and return its GPU time. Rethrows once the device is gone.
+static double RunFaultCase(
+    Pipeline* pPipeline,
+    FaultSweepContext* pContext,
+    const FaultCase& faultCase,
+    const char* name)
+{
+    ID3D12GraphicsCommandList* pCmdList = pContext->cmdList.Get();
+    ID3D12Resource* pRenderTarget = pPipeline->renderTargets[pPipeline->backBufferIndex].Get();
+    const bool graphics = faultCase.stage != FaultStage::Compute;
+    const UINT iterations = pPipeline->options.faultSweepIterations;
+
+    ThrowIfFailed(pContext->cmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pContext->cmdAlloc.Get(), nullptr));
+
+    // Draw into the current back buffer, it isn't presented before the frame
+    // loop renders over it.
+    if (graphics)
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_PRESENT,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+        pCmdList->ResourceBarrier(1, &barrier);
+
+        pCmdList->RSSetViewports(1, &pPipeline->viewport);
+        pCmdList->RSSetScissorRects(1, &pPipeline->scissorRect);
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(
+            pPipeline->rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+            pPipeline->backBufferIndex,
+            pPipeline->rtvDescriptorSize);
+        pCmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    }
+
+    SetFaultState(pPipeline, pCmdList, faultCase);
+    BeginGpuMeasurement(pPipeline, pCmdList);
+    for (UINT iteration = 0; iteration < iterations; ++iteration)
+    {
+        RecordFaultDraw(pPipeline, pCmdList, faultCase, iteration);
+    }
+    EndGpuMeasurement(pPipeline, pCmdList);
+
+    if (graphics)
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PRESENT);
+        pCmdList->ResourceBarrier(1, &barrier);
+    }
+
+    double elapsedMs = 0.0;
+    try
+    {
+        elapsedMs = ExecuteFaultSweepList(pPipeline, pContext);
+    }
+    catch (const HResultException&)
+    {
+        const HRESULT removedReason = pPipeline->device->GetDeviceRemovedReason();
+        if (FAILED(removedReason))
+        {
+            LogMessage(
+                "%s: device removed, reason %s (0x%08x)\n",
+                name,
+                GetDeviceRemovedReasonName(removedReason),
+                (UINT)removedReason);
+            ReportSweepResult(pPipeline, name, 0.0, "device removed", 0.0);
+        }
+        throw;
+    }
+
+    const double accesses = (double)GetFaultInvocationCount(pPipeline, faultCase.stage) *
+        pPipeline->options.faultIterations * iterations;
+    const double gigaAccessesPerSecond = GetRate(accesses, elapsedMs, 1.0e9);
+
+    LogMessage("%s: %.2f Gaccesses/s (%.3f ms)\n", name, gigaAccessesPerSecond, elapsedMs);
+    ReportSweepResult(pPipeline, name, gigaAccessesPerSecond, "Gaccesses/s", elapsedMs);
+
+    return elapsedMs;
+}
+
+void RunFaultSweep(Pipeline* pPipeline)
+{
+    const Options& options = pPipeline->options;
+
+    FaultSweepContext context = {};
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&context.cmdAlloc)));
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        context.cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&context.cmdList)));
+    ThrowIfFailed(context.cmdList->Close());
+
+    char caseName[64];
+    char name[128];
+
+    // Everything defined first. The unbounded out-of-bounds cases may
+    // remove the device, so they go last, after every other case.
+    for (UINT pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1 && !options.faultUnbounded)
+        {
+            break;
+        }
+
+        for (UINT stage = 0; stage < s_FaultStageCount; ++stage)
+        {
+            for (UINT access = 0; access < s_FaultAccessCount; ++access)
+            {
+                FaultCase faultCase = {};
+                faultCase.access = (FaultAccess)access;
+                faultCase.stage = (FaultStage)stage;
+
+                snprintf(
+                    caseName,
+                    sizeof(caseName),
+                    "fault %s %s",
+                    GetFaultStageName(faultCase.stage),
+                    GetFaultAccessName(faultCase.access));
+
+                if (pass == 1)
+                {
+                    faultCase.binding = FaultBinding::Root;
+                    faultCase.firstElement = options.faultIndex;
+                    snprintf(name, sizeof(name), "%s root @%u", caseName, faultCase.firstElement);
+                    RunFaultCase(pPipeline, &context, faultCase, name);
+                    continue;
+                }
+
+                // In bounds, both bindings make the same accesses, so the
+                // difference is the bounds checks.
+                double bindingMs[s_FaultBindingCount] = {};
+                for (UINT binding = 0; binding < s_FaultBindingCount; ++binding)
+                {
+                    faultCase.binding = (FaultBinding)binding;
+                    faultCase.firstElement = 0;
+                    snprintf(name, sizeof(name), "%s %s @0", caseName, GetFaultBindingName(faultCase.binding));
+                    bindingMs[binding] = RunFaultCase(pPipeline, &context, faultCase, name);
+                }
+
+                const double rootMs = bindingMs[(UINT)FaultBinding::Root];
+                const double checkCostPercent = (rootMs > 0.0) ?
+                    (bindingMs[(UINT)FaultBinding::Table] / rootMs - 1.0) * 100.0 : 0.0;
+                LogMessage("%s: bounds checks cost %.1f%%\n", caseName, checkCostPercent);
+                snprintf(name, sizeof(name), "%s bounds-check cost", caseName);
+                ReportSweepResult(pPipeline, name, checkCostPercent, "%", bindingMs[(UINT)FaultBinding::Table]);
+
+                faultCase.binding = FaultBinding::Table;
+                faultCase.firstElement = options.faultIndex;
+                snprintf(name, sizeof(name), "%s table @%u", caseName, faultCase.firstElement);
+                RunFaultCase(pPipeline, &context, faultCase, name);
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Fault injection: constant, structured and RW structured buffer accesses at
+// `Options::faultIndex` from the vertex, pixel and compute stages, see
+// fault.hlsl. The buffers hold 4096 float4s, so large indices are out of
+// bounds.
+//
+// D3D12 has no robust buffer access switch. Accesses through views in a
+// descriptor table are bounds-checked, out-of-bounds reads return zero and
+// writes are dropped; root descriptors carry no size and aren't checked at
+// all. The sweep times both, in bounds and out, so the cost of the checks
+// shows as the gap between the two bindings.
+//
+// The workload binds its own descriptor heap, so it replaces the frame's
+// CBV heap for the rest of the list it is recorded into.
+struct Fault
+{
+    // Views of the buffers in a table at b1, t0 and u0, next to root
+    // constants at b0.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> tableRootSignature;
+    // The same buffers as root descriptors.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootRootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStates[s_FaultBindingCount][s_FaultStageCount][s_FaultAccessCount];
+
+    // Read through the CBV and SRV, never written.
+    Microsoft::WRL::ComPtr<ID3D12Resource> dataBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> uavBuffer;
+    // CBV, SRV and UAV, in that order.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+};
+
+// Create the root signatures and PSOs.
+void CreateFaultPipelineStates(Pipeline* pPipeline);
+
+// Create the buffers and their views.
+void CreateFaultResources(Pipeline* pPipeline);
+
+// Record draws [firstDraw, firstDraw + drawCount), each a dispatch or draw
+// making the access of the options.
+void RecordFault(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time every access from every stage through both bindings, in bounds and
+// at `Options::faultIndex`, and log accesses per second and the cost of
+// bounds checking. Unbounded out-of-bounds cases only run with
+// `Options::faultUnbounded`, last. A case that removes the device is logged
+// and reported, and its exception rethrown. The GPU must be idle; returns
+// with the GPU idle.
+void RunFaultSweep(Pipeline* pPipeline);
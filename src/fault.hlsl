@@ -0,0 +1,91 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Fault injection kernels. Every thread, vertex or pixel makes
+// `iterations` accesses to a 4096-element buffer, starting at element
+// `firstElement`, which may well be past its end. FAULT_ACCESS selects the
+// access:
+//   0  constant buffer read
+//   1  structured buffer read
+//   2  RW structured buffer read
+//   3  RW structured buffer write
+//
+// Whether an access past the end is bounds-checked depends on the root
+// signature only: views in a descriptor table are, root descriptors aren't.
+
+cbuffer FaultConstants : register(b0)
+{
+    uint firstElement;
+    uint iterations;
+    // Changes every draw.
+    uint seed;
+    // Pixels per row, to number the pixels.
+    uint width;
+};
+
+cbuffer FaultData : register(b1)
+{
+    float4 data[4096];
+};
+
+StructuredBuffer<float4> source : register(t0);
+RWStructuredBuffer<float4> target : register(u0);
+
+static const uint s_ElementMask = 4095;
+
+float4 Access(uint thread)
+{
+    float4 sum = 0.0f;
+    for (uint i = 0; i < iterations; ++i)
+    {
+        // Neighbouring threads access neighbouring elements.
+        const uint element = firstElement + ((thread + i * 64) & s_ElementMask);
+#if FAULT_ACCESS == 0
+        sum += data[element];
+#elif FAULT_ACCESS == 1
+        sum += source[element];
+#elif FAULT_ACCESS == 2
+        sum += target[element];
+#else
+        target[element] = float4(thread, i, seed, 1.0f);
+#endif
+    }
+    return sum;
+}
+
+// Keep the reads alive without paying for a write per thread: whatever they
+// return, the sum practically never matches the seed.
+void KeepAlive(uint thread, float4 sum)
+{
+    if (asuint(sum.x) == (seed | 0x7fc00001))
+    {
+        target[thread & s_ElementMask] = sum;
+    }
+}
+
+[numthreads(64, 1, 1)]
+void CSMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    KeepAlive(dispatchThreadId.x, Access(dispatchThreadId.x));
+}
+
+// A point per vertex, outside the viewport so nothing is rasterized.
+float4 VSMain(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    KeepAlive(vertexId, Access(vertexId));
+    return float4(2.0f, 2.0f, 0.0f, 1.0f);
+}
+
+// Full-screen triangle for the pixel stage.
+float4 VSFullScreen(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    const float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+
+float4 PSMain(float4 position : SV_POSITION) : SV_TARGET
+{
+    const uint pixel = (uint)position.y * width + (uint)position.x;
+    const float4 sum = Access(pixel);
+    KeepAlive(pixel, sum);
+    return sum;
+}
@@ -0,0 +1,245 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "fill-rate.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+
+struct FillRateFormat
+{
+    DXGI_FORMAT format;
+    const char* name;
+};
+
+static const FillRateFormat s_FillRateFormats[s_FillRateFormatCount] =
+{
+    { DXGI_FORMAT_R8G8B8A8_UNORM, "RGBA8" },
+    { DXGI_FORMAT_R16G16B16A16_FLOAT, "RGBA16F" },
+    { DXGI_FORMAT_R32G32B32A32_FLOAT, "RGBA32F" },
+};
+
+struct FillRateSize
+{
+    UINT width;
+    UINT height;
+};
+
+// Render target sizes of the sweep, in addition to the window size.
+static const FillRateSize s_FillRateSizes[] =
+{
+    { 1920, 1080 },
+    { 2560, 1440 },
+    { 3840, 2160 },
+    { 7680, 4320 },
+};
+
+void CreateFillRatePipelineStates(Pipeline* pPipeline)
+{
+    ComPtr<ID3DBlob> vertexShader;
+    ComPtr<ID3DBlob> pixelShader;
+    CompileShader(L"fill-rate.hlsl", "VSMain", "vs_5_0", nullptr, &vertexShader);
+    CompileShader(L"fill-rate.hlsl", "PSMain", "ps_5_0", nullptr, &pixelShader);
+
+    // Positions come from SV_VertexID, there is no input layout. The main root
+    // signature is compatible, the shaders don't bind any resources.
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.InputLayout = { nullptr, 0 };
+    psoDesc.pRootSignature = pPipeline->rootSignature.Get();
+    psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+    psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+    psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    psoDesc.DepthStencilState.DepthEnable = FALSE;
+    psoDesc.DepthStencilState.StencilEnable = FALSE;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.SampleDesc.Count = 1;
+
+    // Blend every layer over the previous ones to exercise the ROPs'
+    // read-modify-write path.
+    D3D12_RENDER_TARGET_BLEND_DESC* pBlend = &psoDesc.BlendState.RenderTarget[0];
+    pBlend->BlendEnable = TRUE;
+    pBlend->SrcBlend = D3D12_BLEND_SRC_ALPHA;
+    pBlend->DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+    pBlend->BlendOp = D3D12_BLEND_OP_ADD;
+    pBlend->SrcBlendAlpha = D3D12_BLEND_ONE;
+    pBlend->DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+    pBlend->BlendOpAlpha = D3D12_BLEND_OP_ADD;
+
+    for (UINT i = 0; i < s_FillRateFormatCount; ++i)
+    {
+        psoDesc.RTVFormats[0] = s_FillRateFormats[i].format;
+        CreateGraphicsPipelineState(pPipeline, L"fill-rate", psoDesc, &pPipeline->fillRate.pipelineStates[i]);
+    }
+}
+
+void RecordFillRate(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    // The back buffer uses the first format of the sweep.
+    pCmdList->SetPipelineState(pPipeline->fillRate.pipelineStates[0].Get());
+    pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+    for (UINT i = 0; i < drawCount; ++i)
+    {
+        pCmdList->DrawInstanced(4, pPipeline->options.fillLayers, 0, 0);
+    }
+}
+
+// Time one sweep case. Returns false if the render target can't be created,
+// e.g. because it doesn't fit in memory.
+static bool MeasureFillRate(
+    Pipeline* pPipeline,
+    ID3D12CommandAllocator* pCmdAlloc,
+    ID3D12GraphicsCommandList* pCmdList,
+    ID3D12DescriptorHeap* pRtvHeap,
+    UINT formatIndex,
+    UINT width,
+    UINT height)
+{
+    const FillRateFormat& format = s_FillRateFormats[formatIndex];
+    const float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    // Create the offscreen render target.
+    ComPtr<ID3D12Resource> renderTarget;
+    {
+        CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+        CD3DX12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            format.format,
+            width,
+            height,
+            1,
+            1,
+            1,
+            0,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+        CD3DX12_CLEAR_VALUE clearValue(format.format, clearColor);
+
+        HRESULT hr = pPipeline->device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &textureDesc,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            &clearValue,
+            IID_PPV_ARGS(&renderTarget));
+
+        if (FAILED(hr))
+        {
+            return false;
+        }
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = pRtvHeap->GetCPUDescriptorHandleForHeapStart();
+    pPipeline->device->CreateRenderTargetView(renderTarget.Get(), nullptr, rtvHandle);
+
+    // Record the whole measurement into one list: clear once, then cover the
+    // target `layers * iterations` times.
+    const UINT layers = pPipeline->options.fillLayers;
+    const UINT iterations = pPipeline->options.fillSweepIterations;
+    {
+        ThrowIfFailed(pCmdAlloc->Reset());
+        ThrowIfFailed(pCmdList->Reset(pCmdAlloc, pPipeline->fillRate.pipelineStates[formatIndex].Get()));
+
+        CD3DX12_VIEWPORT viewport(0.0f, 0.0f, (float)width, (float)height);
+        CD3DX12_RECT scissorRect(0, 0, (LONG)width, (LONG)height);
+
+        pCmdList->SetGraphicsRootSignature(pPipeline->rootSignature.Get());
+        pCmdList->RSSetViewports(1, &viewport);
+        pCmdList->RSSetScissorRects(1, &scissorRect);
+        pCmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+        pCmdList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+        pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+        BeginGpuMeasurement(pPipeline, pCmdList);
+        for (UINT i = 0; i < iterations; ++i)
+        {
+            pCmdList->DrawInstanced(4, layers, 0, 0);
+        }
+        EndGpuMeasurement(pPipeline, pCmdList);
+
+        ThrowIfFailed(pCmdList->Close());
+    }
+
+    const double elapsedMs = ExecuteTimedSweepList(pPipeline, pCmdList);
+
+    const double pixels = (double)width * (double)height * (double)layers * (double)iterations;
+    LogMessage(
+        "fill-rate %ux%u %s: %.2f GPixels/s (%.3f ms, %u layers x %u iterations)\n",
+        width,
+        height,
+        format.name,
+        GetRate(pixels, elapsedMs, 1.0e9),
+        elapsedMs,
+        layers,
+        iterations);
+
+    char name[64];
+    snprintf(name, sizeof(name), "fill-rate %ux%u %s", width, height, format.name);
+    ReportSweepResult(pPipeline, name, GetRate(pixels, elapsedMs, 1.0e9), "GPixels/s", elapsedMs);
+
+    return true;
+}
+
+void RunFillRateSweep(Pipeline* pPipeline)
+{
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    // A CPU-only heap for the offscreen render target's RTV.
+    ComPtr<ID3D12DescriptorHeap> rtvHeap;
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+        rtvHeapDesc.NumDescriptors = 1;
+        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        ThrowIfFailed(pPipeline->device->CreateDescriptorHeap(
+            &rtvHeapDesc,
+            IID_PPV_ARGS(&rtvHeap)));
+    }
+
+    const UINT sizeCount = _countof(s_FillRateSizes) + 1;
+    for (UINT formatIndex = 0; formatIndex < s_FillRateFormatCount; ++formatIndex)
+    {
+        for (UINT sizeIndex = 0; sizeIndex < sizeCount; ++sizeIndex)
+        {
+            // Start with the window size, then the fixed sizes.
+            const UINT width = (sizeIndex == 0) ?
+                pPipeline->options.width : s_FillRateSizes[sizeIndex - 1].width;
+            const UINT height = (sizeIndex == 0) ?
+                pPipeline->options.height : s_FillRateSizes[sizeIndex - 1].height;
+
+            if (!MeasureFillRate(
+                pPipeline,
+                cmdAlloc.Get(),
+                cmdList.Get(),
+                rtvHeap.Get(),
+                formatIndex,
+                width,
+                height))
+            {
+                LogMessage(
+                    "fill-rate %ux%u %s: skipped, render target creation failed\n",
+                    width,
+                    height,
+                    s_FillRateFormats[formatIndex].name);
+            }
+        }
+    }
+}
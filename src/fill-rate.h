@@ -0,0 +1,37 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// Render target formats the fill-rate sweep goes through. The first one is
+// the swapchain format, used by the per-frame workload.
+static const UINT s_FillRateFormatCount = 3;
+
+// Draws `Options::fillLayers` blended full-screen quads. Every frame draws
+// them into the back buffer; RunFillRateSweep() measures them in isolation
+// over a range of render target sizes and formats.
+struct FillRate
+{
+    // One PSO per format in the sweep.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStates[s_FillRateFormatCount];
+};
+
+void CreateFillRatePipelineStates(Pipeline* pPipeline);
+
+// Record draws [firstDraw, firstDraw + drawCount); each one covers the render
+// target `Options::fillLayers` times.
+void RecordFillRate(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time every size/format combination with offscreen render targets, which
+// may be larger than the window, and log GPixels/s. The GPU must be idle;
+// returns with the GPU idle.
+void RunFillRateSweep(Pipeline* pPipeline);
@@ -0,0 +1,34 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Full-screen quads for the fill-rate workload. Every instance is one layer
+// blended over the previous ones, so each pixel is shaded and blended once
+// per layer.
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+PSInput VSMain(uint vertexId : SV_VertexID, uint layer : SV_InstanceID)
+{
+    PSInput result;
+
+    // A 4-vertex triangle strip covering the whole render target.
+    float2 uv = float2(vertexId & 1, vertexId >> 1);
+    result.position = float4(uv.x * 2.0f - 1.0f, 1.0f - uv.y * 2.0f, 0.0f, 1.0f);
+
+    // Vary the color per layer so consecutive blends can't be folded.
+    result.color = float4(
+        frac(layer * 0.13f),
+        frac(layer * 0.29f),
+        frac(layer * 0.47f),
+        0.25f);
+
+    return result;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+    return input.color;
+}
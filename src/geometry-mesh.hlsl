@@ -0,0 +1,133 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Mesh shader path of the geometry workload. A thread of the amplification
+// shader tests a meshlet's bounding sphere against the view and passes the
+// survivors on; a mesh shader group then shades a meshlet's vertices and
+// emits its triangles, with the same output as VSMain in geometry.hlsl.
+//
+// Compiled with MESHLET_MAX_VERTICES and MESHLET_MAX_PRIMITIVES set to the
+// meshlets' limits, which size the mesh shader's output.
+
+#define AS_GROUP_SIZE 32
+#define MS_GROUP_SIZE 128
+
+cbuffer MeshConstants : register(b0)
+{
+    uint meshletCount;
+    // Instance of the first group row; draws with many instances take more
+    // than one DispatchMesh().
+    uint firstInstance;
+    // Right plane of the view, in the mesh's coordinates.
+    float cullMaxX;
+    uint padding;
+};
+
+struct Meshlet
+{
+    uint vertexOffset;
+    uint vertexCount;
+    uint primitiveOffset;
+    uint primitiveCount;
+    float3 center;
+    float radius;
+};
+
+// The geometry workload's vertices, 32 bytes each: position, normal, uv.
+ByteAddressBuffer vertices : register(t0);
+StructuredBuffer<Meshlet> meshlets : register(t1);
+// Mesh vertex of every meshlet vertex.
+StructuredBuffer<uint> meshletVertices : register(t2);
+// Three 8-bit meshlet vertex indices per triangle.
+StructuredBuffer<uint> meshletPrimitives : register(t3);
+
+struct Payload
+{
+    uint instance;
+    uint meshletIndices[AS_GROUP_SIZE];
+};
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+groupshared Payload s_payload;
+groupshared uint s_visibleCount;
+
+// Matches the instance shift of VSMain.
+float2 GetInstanceOffset(uint instance)
+{
+    return float2(instance % 8, instance / 8 % 8) * (1.0f / 256.0f);
+}
+
+[numthreads(AS_GROUP_SIZE, 1, 1)]
+void ASMain(uint groupThreadId : SV_GroupThreadID, uint3 groupId : SV_GroupID)
+{
+    const uint instance = firstInstance + groupId.y;
+    const uint meshletIndex = groupId.x * AS_GROUP_SIZE + groupThreadId;
+
+    bool visible = false;
+    if (meshletIndex < meshletCount)
+    {
+        const Meshlet meshlet = meshlets[meshletIndex];
+        const float2 center = meshlet.center.xy + GetInstanceOffset(instance);
+        visible = all(abs(center) - meshlet.radius <= 1.0f) && center.x - meshlet.radius <= cullMaxX;
+    }
+
+    if (groupThreadId == 0)
+    {
+        s_payload.instance = instance;
+        s_visibleCount = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // A group counter rather than wave intrinsics, waves may be narrower
+    // than the group.
+    if (visible)
+    {
+        uint slot;
+        InterlockedAdd(s_visibleCount, 1, slot);
+        s_payload.meshletIndices[slot] = meshletIndex;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    DispatchMesh(s_visibleCount, 1, 1, s_payload);
+}
+
+[outputtopology("triangle")]
+[numthreads(MS_GROUP_SIZE, 1, 1)]
+void MSMain(
+    uint groupThreadId : SV_GroupThreadID,
+    uint groupId : SV_GroupID,
+    in payload Payload payload,
+    out vertices PSInput outVertices[MESHLET_MAX_VERTICES],
+    out indices uint3 outTriangles[MESHLET_MAX_PRIMITIVES])
+{
+    const Meshlet meshlet = meshlets[payload.meshletIndices[groupId]];
+    SetMeshOutputCounts(meshlet.vertexCount, meshlet.primitiveCount);
+
+    const float2 instanceOffset = GetInstanceOffset(payload.instance);
+
+    for (uint i = groupThreadId; i < meshlet.vertexCount; i += MS_GROUP_SIZE)
+    {
+        const uint address = meshletVertices[meshlet.vertexOffset + i] * 32;
+        const float3 position = asfloat(vertices.Load3(address));
+        const float3 normal = asfloat(vertices.Load3(address + 12));
+        const float2 uv = asfloat(vertices.Load2(address + 24));
+
+        outVertices[i].position = float4(position.xy + instanceOffset, position.z, 1.0f);
+        outVertices[i].color = float4(normal * 0.5f + 0.5f, 1.0f) * float4(uv, 1.0f, 1.0f);
+    }
+
+    for (uint j = groupThreadId; j < meshlet.primitiveCount; j += MS_GROUP_SIZE)
+    {
+        const uint packed = meshletPrimitives[meshlet.primitiveOffset + j];
+        outTriangles[j] = uint3(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff);
+    }
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+    return input.color;
+}
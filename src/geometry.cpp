@@ -0,0 +1,942 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "geometry.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace DirectX;
+
+// The upload buffer is split in two chunks, one filled by the CPU while the
+// other is copied.
+static const UINT64 s_GeometryStagingSize = 32ull * 1024 * 1024;
+static const UINT s_GeometryStagingChunkCount = 2;
+
+// Matches geometry-mesh.hlsl.
+static const UINT s_MeshletsPerAmplificationGroup = 32;
+
+// DispatchMesh() limits, per dimension and in total.
+static const UINT s_MaxDispatchMeshGroupsPerDimension = 65535;
+static const UINT s_MaxDispatchMeshGroupCount = 1u << 22;
+
+// Root parameter slots of `Geometry::meshRootSignature`.
+static const UINT s_MeshRootParamConstants = 0;
+static const UINT s_MeshRootParamVertices = 1;
+static const UINT s_MeshRootParamMeshlets = 2;
+static const UINT s_MeshRootParamMeshletVertices = 3;
+static const UINT s_MeshRootParamMeshletPrimitives = 4;
+static const UINT s_MeshRootParamCount = 5;
+
+// Meshlet limits the sweep times the mesh path at: vertices, triangles.
+static const UINT s_MeshletSweepSizes[][2] =
+{
+    { 32, 32 },
+    { 64, 64 },
+    { 64, 126 },
+    { 128, 128 },
+    { 128, 256 },
+    { 256, 256 },
+};
+
+// Matches `VSInput` in geometry.hlsl.
+struct GeometryVertex
+{
+    XMFLOAT3 position;
+    XMFLOAT3 normal;
+    XMFLOAT2 uv;
+};
+
+// Matches `Meshlet` in geometry-mesh.hlsl.
+struct GeometryMeshlet
+{
+    UINT vertexOffset;
+    UINT vertexCount;
+    UINT primitiveOffset;
+    UINT primitiveCount;
+    XMFLOAT3 center;
+    float radius;
+};
+
+// Matches `MeshConstants` in geometry-mesh.hlsl.
+struct GeometryMeshConstants
+{
+    UINT meshletCount;
+    UINT firstInstance;
+    float cullMaxX;
+    UINT padding;
+};
+
+// Fills `count` elements starting at `first` into `pDst`. `pSource` is the
+// data to copy, for data generated up front.
+typedef void (*GenerateGeometryProc)(
+    const Geometry* pGeometry,
+    const void* pSource,
+    UINT first,
+    UINT count,
+    void* pDst);
+
+// Meshlets in CPU memory, before the upload.
+struct GeometryMeshletData
+{
+    GeometryMeshlet* pMeshlets;
+    UINT* pVertices;
+    UINT* pPrimitives;
+    UINT meshletCount;
+    UINT vertexCount;
+};
+
+// Copy queue and staging buffer, only alive while the mesh uploads.
+struct GeometryUploader
+{
+    ComPtr<ID3D12CommandQueue> queue;
+    ComPtr<ID3D12Fence> fence;
+    UINT64 fenceValue;
+    ComPtr<ID3D12CommandAllocator> cmdAllocs[s_GeometryStagingChunkCount];
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+
+    ComPtr<ID3D12Resource> stagingBuffer;
+    UINT8* pStagingData;
+    // Fence value of the last copy out of each chunk.
+    UINT64 chunkFenceValues[s_GeometryStagingChunkCount];
+    UINT chunkIndex;
+};
+
+static bool CheckGeometryMeshShaderSupport(Pipeline* pPipeline)
+{
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS7 options7 = {};
+    D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { D3D_SHADER_MODEL_6_5 };
+    const bool supported =
+        IsDxcAvailable() &&
+        SUCCEEDED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &options7, sizeof(options7))) &&
+        options7.MeshShaderTier >= D3D12_MESH_SHADER_TIER_1 &&
+        SUCCEEDED(pDevice->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))) &&
+        shaderModel.HighestShaderModel >= D3D_SHADER_MODEL_6_5;
+
+    if (!supported && pPipeline->options.geometryPath == GeometryPath::MeshShader)
+    {
+        LogMessage("geometry: the mesh path needs mesh shader tier 1, shader model 6.5 and dxcompiler.dll, drawing through the input assembler\n");
+    }
+
+    return supported;
+}
+
+static void CreateGeometryMeshRootSignature(Pipeline* pPipeline)
+{
+    CD3DX12_ROOT_PARAMETER1 rootParameters[s_MeshRootParamCount] = {};
+    rootParameters[s_MeshRootParamConstants].InitAsConstants(sizeof(GeometryMeshConstants) / 4, 0);
+    rootParameters[s_MeshRootParamVertices].InitAsShaderResourceView(0);
+    rootParameters[s_MeshRootParamMeshlets].InitAsShaderResourceView(1);
+    rootParameters[s_MeshRootParamMeshletVertices].InitAsShaderResourceView(2);
+    rootParameters[s_MeshRootParamMeshletPrimitives].InitAsShaderResourceView(3);
+
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+    rootSignatureDesc.Init_1_1(
+        _countof(rootParameters),
+        rootParameters,
+        0,
+        nullptr,
+        D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+    CreateRootSignature(pPipeline, rootSignatureDesc, &pPipeline->geometry.meshRootSignature);
+}
+
+// The mesh shader's output arrays are sized by the meshlet limits, so every
+// limit has its own PSO.
+static void CreateGeometryMeshPipelineState(Pipeline* pPipeline, UINT maxVertices, UINT maxPrimitives)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    char maxVerticesText[16];
+    char maxPrimitivesText[16];
+    snprintf(maxVerticesText, sizeof(maxVerticesText), "%u", maxVertices);
+    snprintf(maxPrimitivesText, sizeof(maxPrimitivesText), "%u", maxPrimitives);
+
+    const D3D_SHADER_MACRO defines[] =
+    {
+        { "MESHLET_MAX_VERTICES", maxVerticesText },
+        { "MESHLET_MAX_PRIMITIVES", maxPrimitivesText },
+        { nullptr, nullptr },
+    };
+
+    // Mesh shader PSOs can't mix in DXBC, so the pixel shader is DXIL too.
+    ComPtr<ID3DBlob> amplificationShader;
+    ComPtr<ID3DBlob> meshShader;
+    ComPtr<ID3DBlob> pixelShader;
+    CompileShader(L"geometry-mesh.hlsl", "ASMain", "as_6_5", defines, &amplificationShader);
+    CompileShader(L"geometry-mesh.hlsl", "MSMain", "ms_6_5", defines, &meshShader);
+    CompileShader(L"geometry-mesh.hlsl", "PSMain", "ps_6_5", defines, &pixelShader);
+
+    D3DX12_MESH_SHADER_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = pGeometry->meshRootSignature.Get();
+    psoDesc.AS = CD3DX12_SHADER_BYTECODE(amplificationShader.Get());
+    psoDesc.MS = CD3DX12_SHADER_BYTECODE(meshShader.Get());
+    psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+    psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    psoDesc.DepthStencilState.DepthEnable = FALSE;
+    psoDesc.DepthStencilState.StencilEnable = FALSE;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    psoDesc.SampleDesc.Count = 1;
+    CreateMeshPipelineState(pPipeline, L"geometry-mesh", psoDesc, &pGeometry->meshPipelineState);
+}
+
+void CreateGeometryPipelineState(Pipeline* pPipeline)
+{
+    ComPtr<ID3DBlob> vertexShader;
+    ComPtr<ID3DBlob> pixelShader;
+    CompileShader(L"geometry.hlsl", "VSMain", "vs_5_0", nullptr, &vertexShader);
+    CompileShader(L"geometry.hlsl", "PSMain", "ps_5_0", nullptr, &pixelShader);
+
+    D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+
+    // The main root signature is compatible, the shaders only read the
+    // per-draw root constants.
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
+    psoDesc.pRootSignature = pPipeline->rootSignature.Get();
+    psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+    psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+    psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    psoDesc.DepthStencilState.DepthEnable = FALSE;
+    psoDesc.DepthStencilState.StencilEnable = FALSE;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    psoDesc.SampleDesc.Count = 1;
+    CreateGraphicsPipelineState(pPipeline, L"geometry", psoDesc, &pPipeline->geometry.pipelineState);
+
+    pPipeline->geometry.meshShaderSupported = CheckGeometryMeshShaderSupport(pPipeline);
+    if (pPipeline->geometry.meshShaderSupported)
+    {
+        CreateGeometryMeshRootSignature(pPipeline);
+        CreateGeometryMeshPipelineState(
+            pPipeline,
+            pPipeline->options.geometryMeshletVertices,
+            pPipeline->options.geometryMeshletPrimitives);
+    }
+}
+
+// Grid coordinates of `vertex`, in [0, 1].
+static XMFLOAT2 GetGridUv(const Geometry* pGeometry, UINT vertex)
+{
+    const UINT rowLength = pGeometry->gridSize + 1;
+    const float step = 1.0f / (float)pGeometry->gridSize;
+    return XMFLOAT2((float)(vertex % rowLength) * step, (float)(vertex / rowLength) * step);
+}
+
+// A gently curved grid covering the middle of the screen.
+static void GenerateVertices(const Geometry* pGeometry, const void* pSource, UINT first, UINT count, void* pDst)
+{
+    GeometryVertex* pVertices = (GeometryVertex*)pDst;
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        const XMFLOAT2 uv = GetGridUv(pGeometry, first + i);
+        const float u = uv.x;
+        const float v = uv.y;
+
+        const float dx = 0.25f * cosf(u * 12.0f);
+        const float dy = 0.25f * cosf(v * 12.0f);
+        const float length = sqrtf(dx * dx + dy * dy + 1.0f);
+
+        GeometryVertex* pVertex = &pVertices[i];
+        pVertex->position = XMFLOAT3(u - 0.5f, v - 0.5f, 0.5f);
+        pVertex->normal = XMFLOAT3(-dx / length, -dy / length, 1.0f / length);
+        pVertex->uv = XMFLOAT2(u, v);
+    }
+}
+
+// Two triangles per quad, in row order, so neighbouring triangles share
+// vertices and the post-transform cache sees realistic reuse.
+static void GenerateIndices(const Geometry* pGeometry, const void* pSource, UINT first, UINT count, void* pDst)
+{
+    UINT* pIndices = (UINT*)pDst;
+    const UINT gridSize = pGeometry->gridSize;
+    const UINT rowLength = gridSize + 1;
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        const UINT index = first + i;
+        const UINT triangle = index / 3;
+        const UINT quad = triangle / 2;
+
+        const UINT v0 = (quad / gridSize) * rowLength + quad % gridSize;
+        const UINT v1 = v0 + 1;
+        const UINT v2 = v0 + rowLength;
+        const UINT v3 = v2 + 1;
+
+        const UINT corners[2][3] = { { v0, v2, v1 }, { v1, v2, v3 } };
+        pIndices[i] = corners[triangle & 1][index % 3];
+    }
+}
+
+static void CopyUints(const Geometry* pGeometry, const void* pSource, UINT first, UINT count, void* pDst)
+{
+    memcpy(pDst, (const UINT*)pSource + first, (size_t)count * sizeof(UINT));
+}
+
+static void CreateGeometryUploader(Pipeline* pPipeline, GeometryUploader* pUploader)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    ThrowIfFailed(pPipeline->device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&pUploader->queue)));
+
+    ThrowIfFailed(pPipeline->device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pUploader->fence)));
+
+    for (UINT i = 0; i < s_GeometryStagingChunkCount; ++i)
+    {
+        ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_COPY,
+            IID_PPV_ARGS(&pUploader->cmdAllocs[i])));
+    }
+
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_COPY,
+        pUploader->cmdAllocs[0].Get(),
+        nullptr,
+        IID_PPV_ARGS(&pUploader->cmdList)));
+    ThrowIfFailed(pUploader->cmdList->Close());
+
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC stagingDesc = CD3DX12_RESOURCE_DESC::Buffer(s_GeometryStagingSize);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &stagingDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pUploader->stagingBuffer)));
+
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pUploader->stagingBuffer->Map(
+        0,
+        &readRange,
+        reinterpret_cast<void**>(&pUploader->pStagingData)));
+}
+
+// Generate `elementCount` elements chunk by chunk into the staging buffer
+// and copy them to `pDstBuffer` on the copy queue.
+static void UploadGeometryBuffer(
+    Pipeline* pPipeline,
+    GeometryUploader* pUploader,
+    ID3D12Resource* pDstBuffer,
+    UINT elementCount,
+    UINT elementSize,
+    GenerateGeometryProc generate,
+    const void* pSource = nullptr)
+{
+    const UINT64 chunkSize = s_GeometryStagingSize / s_GeometryStagingChunkCount;
+    const UINT chunkElementCount = (UINT)(chunkSize / elementSize);
+
+    for (UINT first = 0; first < elementCount; first += chunkElementCount)
+    {
+        const UINT chunk = pUploader->chunkIndex;
+        const UINT count = min(chunkElementCount, elementCount - first);
+        const UINT64 stagingOffset = chunk * chunkSize;
+
+        // Wait for the previous copy out of this chunk, blocking in
+        // SetEventOnCompletion().
+        ThrowIfFailed(pUploader->fence->SetEventOnCompletion(pUploader->chunkFenceValues[chunk], nullptr));
+
+        generate(&pPipeline->geometry, pSource, first, count, pUploader->pStagingData + stagingOffset);
+
+        ID3D12CommandAllocator* pCmdAlloc = pUploader->cmdAllocs[chunk].Get();
+        ThrowIfFailed(pCmdAlloc->Reset());
+        ThrowIfFailed(pUploader->cmdList->Reset(pCmdAlloc, nullptr));
+
+        // Default heap buffers in the common state promote to copy
+        // destination on the copy queue.
+        pUploader->cmdList->CopyBufferRegion(
+            pDstBuffer,
+            (UINT64)first * elementSize,
+            pUploader->stagingBuffer.Get(),
+            stagingOffset,
+            (UINT64)count * elementSize);
+        ThrowIfFailed(pUploader->cmdList->Close());
+
+        ID3D12CommandList* ppCommandLists[] = { pUploader->cmdList.Get() };
+        pUploader->queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+        pUploader->fenceValue += 1;
+        ThrowIfFailed(pUploader->queue->Signal(pUploader->fence.Get(), pUploader->fenceValue));
+        pUploader->chunkFenceValues[chunk] = pUploader->fenceValue;
+        pUploader->chunkIndex = (chunk + 1) % s_GeometryStagingChunkCount;
+    }
+}
+
+static void CreateGeometryBuffer(Pipeline* pPipeline, UINT64 size, ComPtr<ID3D12Resource>* pBuffer)
+{
+    // Buffers are created in the common state. They decay back to it after
+    // every ExecuteCommandLists(), so neither queue needs barriers.
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(pBuffer->ReleaseAndGetAddressOf())));
+}
+
+static void* AllocateGeometryData(size_t size)
+{
+    void* pData = malloc(size);
+    if (pData == nullptr)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+    return pData;
+}
+
+// Scan the triangles in index order, as the simplest meshlet builders do,
+// and bound every meshlet with a sphere around its box.
+static void BuildGeometryMeshlets(
+    const Geometry* pGeometry,
+    UINT maxVertices,
+    UINT maxPrimitives,
+    GeometryMeshletData* pData)
+{
+    const UINT triangleCount = pGeometry->indexCount / 3;
+
+    // A meshlet is only closed when the next triangle doesn't fit, so all
+    // but the last have at least this many triangles.
+    const UINT minPrimitives = max(1u, min(maxPrimitives, maxVertices / 3));
+    pData->pMeshlets = (GeometryMeshlet*)AllocateGeometryData(
+        (size_t)(triangleCount / minPrimitives + 1) * sizeof(GeometryMeshlet));
+    pData->pVertices = (UINT*)AllocateGeometryData((size_t)pGeometry->indexCount * sizeof(UINT));
+    pData->pPrimitives = (UINT*)AllocateGeometryData((size_t)triangleCount * sizeof(UINT));
+    pData->meshletCount = 0;
+    pData->vertexCount = 0;
+
+    UINT* pIndices = (UINT*)AllocateGeometryData((size_t)pGeometry->indexCount * sizeof(UINT));
+    GenerateIndices(pGeometry, nullptr, 0, pGeometry->indexCount, pIndices);
+
+    // The meshlet each vertex was last added to, and its index there.
+    UINT* pVertexMeshlets = (UINT*)AllocateGeometryData((size_t)pGeometry->vertexCount * sizeof(UINT));
+    UINT8* pVertexSlots = (UINT8*)AllocateGeometryData(pGeometry->vertexCount);
+    memset(pVertexMeshlets, 0xff, (size_t)pGeometry->vertexCount * sizeof(UINT));
+
+    GeometryMeshlet* pMeshlet = nullptr;
+    for (UINT triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const UINT* pCorners = &pIndices[triangle * 3];
+
+        UINT newVertexCount = 0;
+        for (UINT corner = 0; corner < 3; ++corner)
+        {
+            newVertexCount += (pVertexMeshlets[pCorners[corner]] != pData->meshletCount - 1) ? 1 : 0;
+        }
+
+        if (pMeshlet == nullptr ||
+            pMeshlet->vertexCount + newVertexCount > maxVertices ||
+            pMeshlet->primitiveCount == maxPrimitives)
+        {
+            pMeshlet = &pData->pMeshlets[pData->meshletCount++];
+            memset(pMeshlet, 0, sizeof(*pMeshlet));
+            pMeshlet->vertexOffset = pData->vertexCount;
+            pMeshlet->primitiveOffset = triangle;
+        }
+
+        UINT packed = 0;
+        for (UINT corner = 0; corner < 3; ++corner)
+        {
+            const UINT vertex = pCorners[corner];
+            if (pVertexMeshlets[vertex] != pData->meshletCount - 1)
+            {
+                pVertexMeshlets[vertex] = pData->meshletCount - 1;
+                pVertexSlots[vertex] = (UINT8)pMeshlet->vertexCount;
+                pData->pVertices[pData->vertexCount++] = vertex;
+                pMeshlet->vertexCount += 1;
+            }
+            packed |= (UINT)pVertexSlots[vertex] << (corner * 8);
+        }
+
+        pData->pPrimitives[triangle] = packed;
+        pMeshlet->primitiveCount += 1;
+    }
+
+    for (UINT i = 0; i < pData->meshletCount; ++i)
+    {
+        GeometryMeshlet* pBounded = &pData->pMeshlets[i];
+
+        XMFLOAT2 boundsMin = XMFLOAT2(1.0f, 1.0f);
+        XMFLOAT2 boundsMax = XMFLOAT2(0.0f, 0.0f);
+        for (UINT j = 0; j < pBounded->vertexCount; ++j)
+        {
+            const XMFLOAT2 uv = GetGridUv(pGeometry, pData->pVertices[pBounded->vertexOffset + j]);
+            boundsMin = XMFLOAT2(min(boundsMin.x, uv.x), min(boundsMin.y, uv.y));
+            boundsMax = XMFLOAT2(max(boundsMax.x, uv.x), max(boundsMax.y, uv.y));
+        }
+
+        // The grid is flat in z, and spans [-0.5, 0.5] in x and y.
+        const float halfWidth = 0.5f * (boundsMax.x - boundsMin.x);
+        const float halfHeight = 0.5f * (boundsMax.y - boundsMin.y);
+        pBounded->center = XMFLOAT3(boundsMin.x + halfWidth - 0.5f, boundsMin.y + halfHeight - 0.5f, 0.5f);
+        pBounded->radius = sqrtf(halfWidth * halfWidth + halfHeight * halfHeight);
+    }
+
+    free(pVertexSlots);
+    free(pVertexMeshlets);
+    free(pIndices);
+}
+
+// Build and upload meshlets of at most `maxVertices` vertices and
+// `maxPrimitives` triangles, replacing the previous ones; the GPU must not
+// be using them. Blocks until the copies are complete. Fails on meshes with
+// more meshlets than a DispatchMesh() row takes.
+static bool CreateGeometryMeshlets(Pipeline* pPipeline, UINT maxVertices, UINT maxPrimitives)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    GeometryMeshletData data = {};
+    BuildGeometryMeshlets(pGeometry, maxVertices, maxPrimitives, &data);
+
+    const UINT groupCount =
+        (data.meshletCount + s_MeshletsPerAmplificationGroup - 1) / s_MeshletsPerAmplificationGroup;
+    const bool fits = groupCount <= s_MaxDispatchMeshGroupsPerDimension;
+
+    if (fits)
+    {
+        const UINT triangleCount = pGeometry->indexCount / 3;
+        CreateGeometryBuffer(pPipeline, (UINT64)data.meshletCount * sizeof(GeometryMeshlet), &pGeometry->meshletBuffer);
+        CreateGeometryBuffer(pPipeline, (UINT64)data.vertexCount * sizeof(UINT), &pGeometry->meshletVertexBuffer);
+        CreateGeometryBuffer(pPipeline, (UINT64)triangleCount * sizeof(UINT), &pGeometry->meshletPrimitiveBuffer);
+
+        GeometryUploader uploader = {};
+        CreateGeometryUploader(pPipeline, &uploader);
+        // Meshlets upload as the UINTs they are made of.
+        UploadGeometryBuffer(
+            pPipeline,
+            &uploader,
+            pGeometry->meshletBuffer.Get(),
+            data.meshletCount * (sizeof(GeometryMeshlet) / sizeof(UINT)),
+            sizeof(UINT),
+            CopyUints,
+            data.pMeshlets);
+        UploadGeometryBuffer(
+            pPipeline,
+            &uploader,
+            pGeometry->meshletVertexBuffer.Get(),
+            data.vertexCount,
+            sizeof(UINT),
+            CopyUints,
+            data.pVertices);
+        UploadGeometryBuffer(
+            pPipeline,
+            &uploader,
+            pGeometry->meshletPrimitiveBuffer.Get(),
+            triangleCount,
+            sizeof(UINT),
+            CopyUints,
+            data.pPrimitives);
+        ThrowIfFailed(uploader.fence->SetEventOnCompletion(uploader.fenceValue, nullptr));
+
+        pGeometry->meshletMaxVertices = maxVertices;
+        pGeometry->meshletMaxPrimitives = maxPrimitives;
+        pGeometry->meshletCount = data.meshletCount;
+        pGeometry->meshletVertexCount = data.vertexCount;
+    }
+    else
+    {
+        LogMessage(
+            "geometry: %u meshlets of up to %u vertices and %u triangles are too many for DispatchMesh()\n",
+            data.meshletCount,
+            maxVertices,
+            maxPrimitives);
+    }
+
+    free(data.pPrimitives);
+    free(data.pVertices);
+    free(data.pMeshlets);
+
+    return fits;
+}
+
+void CreateGeometryResources(Pipeline* pPipeline)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    // Two triangles per quad.
+    pGeometry->gridSize = max(1u, (UINT)sqrt(pPipeline->options.geometryTriangles / 2.0));
+    pGeometry->vertexCount = (pGeometry->gridSize + 1) * (pGeometry->gridSize + 1);
+    pGeometry->indexCount = pGeometry->gridSize * pGeometry->gridSize * 6;
+
+    const UINT64 vertexBufferSize = (UINT64)pGeometry->vertexCount * sizeof(GeometryVertex);
+    const UINT64 indexBufferSize = (UINT64)pGeometry->indexCount * sizeof(UINT);
+    CreateGeometryBuffer(pPipeline, vertexBufferSize, &pGeometry->vertexBuffer);
+    CreateGeometryBuffer(pPipeline, indexBufferSize, &pGeometry->indexBuffer);
+
+    const UINT64 startTicks = GetCpuTicks();
+
+    GeometryUploader uploader = {};
+    CreateGeometryUploader(pPipeline, &uploader);
+    UploadGeometryBuffer(
+        pPipeline,
+        &uploader,
+        pGeometry->vertexBuffer.Get(),
+        pGeometry->vertexCount,
+        sizeof(GeometryVertex),
+        GenerateVertices);
+    UploadGeometryBuffer(
+        pPipeline,
+        &uploader,
+        pGeometry->indexBuffer.Get(),
+        pGeometry->indexCount,
+        sizeof(UINT),
+        GenerateIndices);
+    ThrowIfFailed(uploader.fence->SetEventOnCompletion(uploader.fenceValue, nullptr));
+
+    // Includes generating the data, which overlaps the copies.
+    const double uploadMs = CpuTicksToMs(GetCpuTicks() - startTicks);
+    const double megabyte = 1024.0 * 1024.0;
+    LogMessage(
+        "geometry: %u triangles, %.1f MB of vertices and %.1f MB of indices uploaded in %.1f ms (%.2f GB/s)\n",
+        pGeometry->indexCount / 3,
+        vertexBufferSize / megabyte,
+        indexBufferSize / megabyte,
+        uploadMs,
+        GetRate((double)(vertexBufferSize + indexBufferSize), uploadMs, 1.0e9));
+
+    pGeometry->vertexBufferView.BufferLocation = pGeometry->vertexBuffer->GetGPUVirtualAddress();
+    pGeometry->vertexBufferView.StrideInBytes = sizeof(GeometryVertex);
+    pGeometry->vertexBufferView.SizeInBytes = (UINT)vertexBufferSize;
+
+    pGeometry->indexBufferView.BufferLocation = pGeometry->indexBuffer->GetGPUVirtualAddress();
+    pGeometry->indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+    pGeometry->indexBufferView.SizeInBytes = (UINT)indexBufferSize;
+
+    if (pGeometry->meshPipelineState)
+    {
+        const Options& options = pPipeline->options;
+        pGeometry->meshShaderSupported =
+            CreateGeometryMeshlets(pPipeline, options.geometryMeshletVertices, options.geometryMeshletPrimitives);
+    }
+
+    if (pGeometry->meshShaderSupported)
+    {
+        LogMessage(
+            "geometry: %u meshlets of up to %u vertices and %u triangles, %.1f vertices and %.1f triangles on average\n",
+            pGeometry->meshletCount,
+            pGeometry->meshletMaxVertices,
+            pGeometry->meshletMaxPrimitives,
+            (double)pGeometry->meshletVertexCount / pGeometry->meshletCount,
+            (double)(pGeometry->indexCount / 3) / pGeometry->meshletCount);
+    }
+}
+
+static void SetGeometryMeshState(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    GeometryMeshConstants constants = {};
+    constants.meshletCount = pGeometry->meshletCount;
+    constants.cullMaxX = -0.5f + pPipeline->options.geometryVisiblePercent / 100.0f;
+
+    pCmdList->SetPipelineState(pGeometry->meshPipelineState.Get());
+    pCmdList->SetGraphicsRootSignature(pGeometry->meshRootSignature.Get());
+    pCmdList->SetGraphicsRoot32BitConstants(
+        s_MeshRootParamConstants,
+        sizeof(GeometryMeshConstants) / 4,
+        &constants,
+        0);
+    pCmdList->SetGraphicsRootShaderResourceView(
+        s_MeshRootParamVertices,
+        pGeometry->vertexBuffer->GetGPUVirtualAddress());
+    pCmdList->SetGraphicsRootShaderResourceView(
+        s_MeshRootParamMeshlets,
+        pGeometry->meshletBuffer->GetGPUVirtualAddress());
+    pCmdList->SetGraphicsRootShaderResourceView(
+        s_MeshRootParamMeshletVertices,
+        pGeometry->meshletVertexBuffer->GetGPUVirtualAddress());
+    pCmdList->SetGraphicsRootShaderResourceView(
+        s_MeshRootParamMeshletPrimitives,
+        pGeometry->meshletPrimitiveBuffer->GetGPUVirtualAddress());
+}
+
+// A group row per instance, a group per 32 meshlets. Leaves the mesh root
+// signature bound.
+static void RecordGeometryMeshDraws(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, UINT drawCount)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    ComPtr<ID3D12GraphicsCommandList6> cmdList6;
+    ThrowIfFailed(pCmdList->QueryInterface(IID_PPV_ARGS(&cmdList6)));
+
+    SetGeometryMeshState(pPipeline, pCmdList);
+
+    const UINT instanceCount = pPipeline->options.geometryInstances;
+    const UINT groupCount =
+        (pGeometry->meshletCount + s_MeshletsPerAmplificationGroup - 1) / s_MeshletsPerAmplificationGroup;
+    // Instances split over several dispatches past the total group limit.
+    const UINT dispatchInstanceCount = max(1u, min(instanceCount, s_MaxDispatchMeshGroupCount / groupCount));
+
+    for (UINT draw = 0; draw < drawCount; ++draw)
+    {
+        for (UINT firstInstance = 0; firstInstance < instanceCount; firstInstance += dispatchInstanceCount)
+        {
+            pCmdList->SetGraphicsRoot32BitConstant(
+                s_MeshRootParamConstants,
+                firstInstance,
+                offsetof(GeometryMeshConstants, firstInstance) / 4);
+            cmdList6->DispatchMesh(groupCount, min(dispatchInstanceCount, instanceCount - firstInstance), 1);
+        }
+    }
+}
+
+static void SetGeometryState(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    pCmdList->SetPipelineState(pGeometry->pipelineState.Get());
+    pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCmdList->IASetVertexBuffers(0, 1, &pGeometry->vertexBufferView);
+    pCmdList->IASetIndexBuffer(&pGeometry->indexBufferView);
+}
+
+void RecordGeometry(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    if (pPipeline->options.geometryPath == GeometryPath::MeshShader && pPipeline->geometry.meshShaderSupported)
+    {
+        RecordGeometryMeshDraws(pPipeline, pCmdList, drawCount);
+        return;
+    }
+
+    SetGeometryState(pPipeline, pCmdList);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        pCmdList->DrawIndexedInstanced(
+            pPipeline->geometry.indexCount,
+            pPipeline->options.geometryInstances,
+            0,
+            0,
+            0);
+    }
+}
+
+// Time the mesh path at every sweep size, against `iaPrimitives`, the
+// input assembler's Mprims/s, then put the frames' meshlets back.
+static void RunGeometryMeshSweep(
+    Pipeline* pPipeline,
+    ID3D12CommandAllocator* pCmdAlloc,
+    ID3D12GraphicsCommandList* pCmdList,
+    double iaPrimitives)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+    const UINT iterations = pPipeline->options.geometrySweepIterations;
+    ID3D12Resource* pRenderTarget = pPipeline->renderTargets[pPipeline->backBufferIndex].Get();
+
+    // Lists recorded once point at the frames' meshlets, so they are kept
+    // aside rather than rebuilt.
+    const Geometry frameGeometry = *pGeometry;
+
+    char name[128];
+    for (const UINT* pSize : s_MeshletSweepSizes)
+    {
+        if (!CreateGeometryMeshlets(pPipeline, pSize[0], pSize[1]))
+        {
+            continue;
+        }
+        CreateGeometryMeshPipelineState(pPipeline, pSize[0], pSize[1]);
+
+        ThrowIfFailed(pCmdAlloc->Reset());
+        ThrowIfFailed(pCmdList->Reset(pCmdAlloc, nullptr));
+        {
+            CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                pRenderTarget,
+                D3D12_RESOURCE_STATE_PRESENT,
+                D3D12_RESOURCE_STATE_RENDER_TARGET);
+            pCmdList->ResourceBarrier(1, &barrier);
+        }
+
+        SetDrawState(pPipeline, pCmdList);
+
+        BeginGpuMeasurement(pPipeline, pCmdList);
+        RecordGeometryMeshDraws(pPipeline, pCmdList, iterations);
+        EndGpuMeasurement(pPipeline, pCmdList);
+        {
+            CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                pRenderTarget,
+                D3D12_RESOURCE_STATE_RENDER_TARGET,
+                D3D12_RESOURCE_STATE_PRESENT);
+            pCmdList->ResourceBarrier(1, &barrier);
+        }
+        ThrowIfFailed(pCmdList->Close());
+
+        const double elapsedMs = ExecuteTimedSweepList(pPipeline, pCmdList);
+
+        // Every triangle of the mesh counts, culled ones too, as they do
+        // for the input assembler.
+        const double triangleCount = (double)(pGeometry->indexCount / 3);
+        const double primitives =
+            GetRate(triangleCount * pPipeline->options.geometryInstances * iterations, elapsedMs, 1.0e6);
+        const double speedup = (iaPrimitives > 0.0) ? primitives / iaPrimitives : 0.0;
+        // Vertex indices per vertex shaded, as the input assembler's reuse.
+        const double reuse = 3.0 * triangleCount / pGeometry->meshletVertexCount;
+
+        LogMessage(
+            "geometry mesh %u/%u: %.1f Mprims/s, %.2fx the input assembler, %.2fx vertex reuse, %u meshlets (%.3f ms)\n",
+            pSize[0],
+            pSize[1],
+            primitives,
+            speedup,
+            reuse,
+            pGeometry->meshletCount,
+            elapsedMs);
+
+        snprintf(name, sizeof(name), "geometry mesh %u/%u primitives", pSize[0], pSize[1]);
+        ReportSweepResult(pPipeline, name, primitives, "Mprims/s", elapsedMs);
+        snprintf(name, sizeof(name), "geometry mesh %u/%u vs ia", pSize[0], pSize[1]);
+        ReportSweepResult(pPipeline, name, speedup, "x", elapsedMs);
+        snprintf(name, sizeof(name), "geometry mesh %u/%u vertex reuse", pSize[0], pSize[1]);
+        ReportSweepResult(pPipeline, name, reuse, "x", elapsedMs);
+    }
+
+    *pGeometry = frameGeometry;
+}
+
+void RunGeometrySweep(Pipeline* pPipeline)
+{
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    ComPtr<ID3D12QueryHeap> queryHeap;
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
+    queryHeapDesc.Count = 1;
+    ThrowIfFailed(pPipeline->device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&queryHeap)));
+
+    ComPtr<ID3D12Resource> readbackBuffer;
+    CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+    CD3DX12_RESOURCE_DESC readbackDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS));
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &readbackHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &readbackDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&readbackBuffer)));
+
+    const UINT iterations = pPipeline->options.geometrySweepIterations;
+    ID3D12Resource* pRenderTarget = pPipeline->renderTargets[pPipeline->backBufferIndex].Get();
+
+    // Draw into the current back buffer, it isn't presented before the frame
+    // loop renders over it.
+    ThrowIfFailed(cmdAlloc->Reset());
+    ThrowIfFailed(cmdList->Reset(cmdAlloc.Get(), pGeometry->pipelineState.Get()));
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_PRESENT,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+        cmdList->ResourceBarrier(1, &barrier);
+    }
+
+    SetDrawState(pPipeline, cmdList.Get());
+    SetGeometryState(pPipeline, cmdList.Get());
+
+    BeginGpuMeasurement(pPipeline, cmdList.Get());
+    cmdList->BeginQuery(queryHeap.Get(), D3D12_QUERY_TYPE_PIPELINE_STATISTICS, 0);
+    for (UINT i = 0; i < iterations; ++i)
+    {
+        cmdList->DrawIndexedInstanced(pGeometry->indexCount, pPipeline->options.geometryInstances, 0, 0, 0);
+    }
+    cmdList->EndQuery(queryHeap.Get(), D3D12_QUERY_TYPE_PIPELINE_STATISTICS, 0);
+    EndGpuMeasurement(pPipeline, cmdList.Get());
+
+    cmdList->ResolveQueryData(
+        queryHeap.Get(),
+        D3D12_QUERY_TYPE_PIPELINE_STATISTICS,
+        0,
+        1,
+        readbackBuffer.Get(),
+        0);
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PRESENT);
+        cmdList->ResourceBarrier(1, &barrier);
+    }
+    ThrowIfFailed(cmdList->Close());
+
+    const double elapsedMs = ExecuteTimedSweepList(pPipeline, cmdList.Get());
+
+    D3D12_QUERY_DATA_PIPELINE_STATISTICS statistics = {};
+    {
+        D3D12_RANGE readRange = { 0, sizeof(statistics) };
+        void* pData = nullptr;
+        ThrowIfFailed(readbackBuffer->Map(0, &readRange, &pData));
+        statistics = *(const D3D12_QUERY_DATA_PIPELINE_STATISTICS*)pData;
+        D3D12_RANGE writeRange = { 0, 0 };
+        readbackBuffer->Unmap(0, &writeRange);
+    }
+
+    const double primitives = GetRate((double)statistics.IAPrimitives, elapsedMs, 1.0e6);
+    const double vertices = GetRate((double)statistics.IAVertices, elapsedMs, 1.0e6);
+    const double vsInvocations = GetRate((double)statistics.VSInvocations, elapsedMs, 1.0e6);
+    // Vertices fetched per vertex shaded, from post-transform cache hits.
+    const double reuse = (statistics.VSInvocations > 0) ?
+        (double)statistics.IAVertices / (double)statistics.VSInvocations : 0.0;
+
+    LogMessage(
+        "geometry: %.1f Mprims/s, %.1f Mverts/s fetched, %.1f Mverts/s shaded, %.2fx vertex reuse (%.3f ms, %u instances x %u iterations)\n",
+        primitives,
+        vertices,
+        vsInvocations,
+        reuse,
+        elapsedMs,
+        pPipeline->options.geometryInstances,
+        iterations);
+
+    ReportSweepResult(pPipeline, "geometry primitives", primitives, "Mprims/s", elapsedMs);
+    ReportSweepResult(pPipeline, "geometry vertices fetched", vertices, "Mverts/s", elapsedMs);
+    ReportSweepResult(pPipeline, "geometry vertices shaded", vsInvocations, "Mverts/s", elapsedMs);
+    ReportSweepResult(pPipeline, "geometry vertex reuse", reuse, "x", elapsedMs);
+
+    // Also when the options' meshlets didn't fit.
+    if (pGeometry->meshPipelineState)
+    {
+        RunGeometryMeshSweep(pPipeline, cmdAlloc.Get(), cmdList.Get(), primitives);
+    }
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// A grid mesh of about `Options::geometryTriangles` triangles in default heap
+// buffers, drawn indexed and instanced. The data is generated straight into
+// an upload buffer and copied on a copy queue, in chunks, so meshes larger
+// than the staging buffer work.
+//
+// On adapters with mesh shader tier 1 the mesh is also split into meshlets,
+// for `GeometryPath::MeshShader`: the index buffer is scanned in order and a
+// meshlet closed when the next triangle would take it past
+// `Options::geometryMeshletVertices` vertices or
+// `Options::geometryMeshletPrimitives` triangles. An amplification shader
+// culls meshlets by their bounding spheres, see geometry-mesh.hlsl.
+struct Geometry
+{
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+    D3D12_INDEX_BUFFER_VIEW indexBufferView;
+
+    // Quads per side of the grid.
+    UINT gridSize;
+    UINT vertexCount;
+    UINT indexCount;
+
+    bool meshShaderSupported;
+    // Constants at b0, and the vertices and the three meshlet buffers as
+    // root SRVs at t0-t3.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> meshRootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> meshPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12Resource> meshletBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> meshletVertexBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> meshletPrimitiveBuffer;
+    // Limits the meshlets and the mesh PSO were made for; the sweep changes
+    // them.
+    UINT meshletMaxVertices;
+    UINT meshletMaxPrimitives;
+    UINT meshletCount;
+    // Vertices of all meshlets, counting those they share.
+    UINT meshletVertexCount;
+};
+
+// Create the PSOs, the mesh shader one where supported. Requires the main
+// root signature.
+void CreateGeometryPipelineState(Pipeline* pPipeline);
+
+// Generate the mesh and upload it to the default heap buffers, with its
+// meshlets if the mesh shader PSO exists. Blocks until the copies are
+// complete.
+void CreateGeometryResources(Pipeline* pPipeline);
+
+// Record draws [firstDraw, firstDraw + drawCount), each of the whole mesh
+// with `Options::geometryInstances` instances, along
+// `Options::geometryPath`.
+void RecordGeometry(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time instanced draws of the mesh with pipeline statistics, and log the
+// vertex and primitive rates. With mesh shaders, then time the mesh path at
+// several meshlet sizes and log its primitive rate against the input
+// assembler's. The GPU must be idle; returns with the GPU idle.
+void RunGeometrySweep(Pipeline* pPipeline);
@@ -0,0 +1,43 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Large indexed meshes for the geometry workload. The triangles are a pixel
+// or smaller, so vertex fetch, vertex shading and primitive assembly bound
+// the draws rather than pixel shading.
+
+// Per-draw constants, set as root constants.
+cbuffer DrawConstants : register(b1)
+{
+    float4 drawOffset;
+};
+
+struct VSInput
+{
+    float3 position : POSITION;
+    float3 normal : NORMAL;
+    float2 uv : TEXCOORD;
+};
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+};
+
+PSInput VSMain(VSInput input, uint instance : SV_InstanceID)
+{
+    PSInput result;
+
+    // Instances are shifted slightly so they don't rasterize identically.
+    float2 instanceOffset = float2(instance % 8, instance / 8 % 8) * (1.0f / 256.0f);
+    result.position = float4(input.position.xy + instanceOffset + drawOffset.xy, input.position.z, 1.0f);
+
+    // Use every attribute, so none of them is skipped by the fetch.
+    result.color = float4(input.normal * 0.5f + 0.5f, 1.0f) * float4(input.uv, 1.0f, 1.0f);
+
+    return result;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+    return input.color;
+}
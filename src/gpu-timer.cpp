@@ -0,0 +1,263 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "gpu-timer.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Every pass has a begin and an end timestamp.
+static UINT GetFrameQueryCount()
+{
+    return s_MaxGpuPassCount * 2;
+}
+
+static UINT GetFirstFrameQuery(UINT frameResourceIndex)
+{
+    return frameResourceIndex * GetFrameQueryCount();
+}
+
+// The measurement queries follow the ones of the frame ring.
+static UINT GetFirstMeasurementQuery(Pipeline* pPipeline)
+{
+    return pPipeline->options.frameCount * GetFrameQueryCount();
+}
+
+static double TicksToMs(Pipeline* pPipeline, UINT64 beginTicks, UINT64 endTicks)
+{
+    // A pass that never ran, or a timestamp reset by a power state change.
+    if (endTicks <= beginTicks)
+    {
+        return 0.0;
+    }
+
+    return (double)(endTicks - beginTicks) * 1000.0 / (double)pPipeline->gpuTimer.frequency;
+}
+
+void CreateGpuTimer(Pipeline* pPipeline)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+    const UINT queryCount = GetFirstMeasurementQuery(pPipeline) + 2;
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = queryCount;
+    ThrowIfFailed(pPipeline->device->CreateQueryHeap(
+        &queryHeapDesc,
+        IID_PPV_ARGS(&pTimer->queryHeap)));
+
+    CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(queryCount * sizeof(UINT64));
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &readbackHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&pTimer->readbackBuffer)));
+
+    ThrowIfFailed(pPipeline->cmdQueue->GetTimestampFrequency(&pTimer->frequency));
+}
+
+UINT BeginGpuPass(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, const char* name)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+    const UINT frame = pPipeline->frameResourceIndex;
+
+    const UINT pass = pTimer->framePassCounts[frame];
+    if (pass >= s_MaxGpuPassCount)
+    {
+        return s_InvalidGpuPass;
+    }
+
+    pTimer->framePassCounts[frame] += 1;
+    pTimer->framePassNames[frame][pass] = name;
+
+    pCmdList->EndQuery(
+        pTimer->queryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        GetFirstFrameQuery(frame) + pass * 2);
+
+    return pass;
+}
+
+void EndGpuPass(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, UINT pass)
+{
+    if (pass == s_InvalidGpuPass)
+    {
+        return;
+    }
+
+    pCmdList->EndQuery(
+        pPipeline->gpuTimer.queryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        GetFirstFrameQuery(pPipeline->frameResourceIndex) + pass * 2 + 1);
+}
+
+void ResolveGpuPasses(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+    const UINT frame = pPipeline->frameResourceIndex;
+    const UINT firstQuery = GetFirstFrameQuery(frame);
+    const UINT passCount = pTimer->framePassCounts[frame];
+
+    if (passCount == 0)
+    {
+        return;
+    }
+
+    pCmdList->ResolveQueryData(
+        pTimer->queryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        firstQuery,
+        passCount * 2,
+        pTimer->readbackBuffer.Get(),
+        firstQuery * sizeof(UINT64));
+}
+
+void ReadGpuPasses(Pipeline* pPipeline, UINT frameResourceIndex)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+    const UINT passCount = pTimer->framePassCounts[frameResourceIndex];
+
+    if (passCount == 0)
+    {
+        return;
+    }
+
+    const UINT firstQuery = GetFirstFrameQuery(frameResourceIndex);
+    CD3DX12_RANGE readRange(
+        firstQuery * sizeof(UINT64),
+        (firstQuery + passCount * 2) * sizeof(UINT64));
+
+    UINT8* pData = nullptr;
+    ThrowIfFailed(pTimer->readbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pData)));
+    const UINT64* pTimestamps = reinterpret_cast<const UINT64*>(pData) + firstQuery;
+
+    UINT64 frameBeginTicks = UINT64_MAX;
+    UINT64 frameEndTicks = 0;
+
+    for (UINT pass = 0; pass < passCount; ++pass)
+    {
+        frameBeginTicks = min(frameBeginTicks, pTimestamps[pass * 2]);
+        frameEndTicks = max(frameEndTicks, pTimestamps[pass * 2 + 1]);
+
+        GpuPassTiming* pTiming = &pTimer->passes[pass];
+        pTiming->name = pTimer->framePassNames[frameResourceIndex][pass];
+        pTiming->lastMs = TicksToMs(pPipeline, pTimestamps[pass * 2], pTimestamps[pass * 2 + 1]);
+        pTiming->totalMs += pTiming->lastMs;
+        pTiming->sampleCount += 1;
+    }
+    pTimer->passCount = max(pTimer->passCount, passCount);
+    pTimer->frameMs = TicksToMs(pPipeline, frameBeginTicks, frameEndTicks);
+
+    // Nothing was written by the CPU.
+    CD3DX12_RANGE writeRange(0, 0);
+    pTimer->readbackBuffer->Unmap(0, &writeRange);
+
+    // The frame resource is about to be recorded again.
+    pTimer->framePassCounts[frameResourceIndex] = 0;
+}
+
+void ResetGpuPassTimings(Pipeline* pPipeline)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+
+    for (UINT pass = 0; pass < pTimer->passCount; ++pass)
+    {
+        pTimer->passes[pass].totalMs = 0.0;
+        pTimer->passes[pass].sampleCount = 0;
+    }
+}
+
+void LogGpuPassTimings(Pipeline* pPipeline)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+
+    char message[1024];
+    int length = snprintf(
+        message,
+        sizeof(message),
+        "adapter %u: GPU ms/frame:",
+        pPipeline->options.adapterIndex);
+
+    for (UINT pass = 0; pass < pTimer->passCount; ++pass)
+    {
+        const GpuPassTiming& timing = pTimer->passes[pass];
+        if (timing.sampleCount == 0 || length < 0 || length >= (int)sizeof(message))
+        {
+            continue;
+        }
+
+        length += snprintf(
+            message + length,
+            sizeof(message) - length,
+            " %s %.3f",
+            timing.name,
+            timing.totalMs / timing.sampleCount);
+    }
+
+    LogMessage("%s\n", message);
+}
+
+void BeginGpuMeasurement(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    pCmdList->EndQuery(
+        pPipeline->gpuTimer.queryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        GetFirstMeasurementQuery(pPipeline));
+}
+
+void EndGpuMeasurement(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+    const UINT firstQuery = GetFirstMeasurementQuery(pPipeline);
+
+    pCmdList->EndQuery(
+        pTimer->queryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        firstQuery + 1);
+
+    pCmdList->ResolveQueryData(
+        pTimer->queryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        firstQuery,
+        2,
+        pTimer->readbackBuffer.Get(),
+        firstQuery * sizeof(UINT64));
+}
+
+double GetGpuMeasurementMs(Pipeline* pPipeline)
+{
+    GpuTimer* pTimer = &pPipeline->gpuTimer;
+    const UINT firstQuery = GetFirstMeasurementQuery(pPipeline);
+
+    CD3DX12_RANGE readRange(firstQuery * sizeof(UINT64), (firstQuery + 2) * sizeof(UINT64));
+
+    UINT8* pData = nullptr;
+    ThrowIfFailed(pTimer->readbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pData)));
+    const UINT64* pTimestamps = reinterpret_cast<const UINT64*>(pData) + firstQuery;
+    const double ms = TicksToMs(pPipeline, pTimestamps[0], pTimestamps[1]);
+
+    CD3DX12_RANGE writeRange(0, 0);
+    pTimer->readbackBuffer->Unmap(0, &writeRange);
+
+    return ms;
+}
+
+double ExecuteTimedSweepList(Pipeline* pPipeline, ID3D12CommandList* pCmdList)
+{
+    ID3D12CommandList* ppCommandLists[] = { pCmdList };
+
+    pPipeline->cmdQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    WaitForFenceValue(pPipeline, SignalFence(pPipeline));
+
+    pPipeline->cmdQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    WaitForFenceValue(pPipeline, SignalFence(pPipeline));
+    return GetGpuMeasurementMs(pPipeline);
+}
+
+UINT GetDrawSeed(const Pipeline* pPipeline, UINT draw)
+{
+    return (UINT)pPipeline->frameNumber * 7919 + draw;
+}
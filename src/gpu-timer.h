@@ -0,0 +1,89 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include <limits.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Upper bound of timed passes per frame.
+static const UINT s_MaxGpuPassCount = 16;
+
+// Returned by BeginGpuPass() when the frame is out of passes.
+static const UINT s_InvalidGpuPass = UINT_MAX;
+
+struct GpuPassTiming
+{
+    const char* name;
+    // Of the frame most recently read back.
+    double lastMs;
+    // Accumulated since the last ResetGpuPassTimings().
+    double totalMs;
+    UINT sampleCount;
+};
+
+// Timestamp queries around the passes of each frame. Every frame resource has
+// its own range of queries and of the readback buffer. The results of a frame
+// are read when its frame resource is about to be reused, i.e. once its fence
+// has been reached, so reading never stalls. With N frames in flight the
+// results are N frames old.
+struct GpuTimer
+{
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> queryHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> readbackBuffer;
+    // Timestamp ticks per second on the direct queue.
+    UINT64 frequency;
+
+    // Passes recorded into each frame resource, and their names.
+    UINT framePassCounts[s_MaxFrameCount];
+    const char* framePassNames[s_MaxFrameCount][s_MaxGpuPassCount];
+
+    // Results by pass index. Pass indices are assigned in the order passes
+    // begin, so they are stable as long as the frame structure is.
+    GpuPassTiming passes[s_MaxGpuPassCount];
+    UINT passCount;
+    // From the first begin to the last end timestamp of the frame most
+    // recently read back.
+    double frameMs;
+};
+
+void CreateGpuTimer(Pipeline* pPipeline);
+
+// Write the begin timestamp of a pass into the current frame's queries and
+// return the pass index for EndGpuPass(). Main thread only.
+UINT BeginGpuPass(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, const char* name);
+void EndGpuPass(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, UINT pass);
+
+// Copy the current frame's timestamps to the readback buffer. Record this
+// after the frame's last EndGpuPass().
+void ResolveGpuPasses(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList);
+
+// Read back the timestamps of `frameResourceIndex` and accumulate them. The
+// GPU must be past that frame resource's fence.
+void ReadGpuPasses(Pipeline* pPipeline, UINT frameResourceIndex);
+
+void ResetGpuPassTimings(Pipeline* pPipeline);
+
+// Log the average of every pass since the last reset.
+void LogGpuPassTimings(Pipeline* pPipeline);
+
+// A single begin/end pair outside the frame ring, for measurements that wait
+// for the GPU anyway, such as the sweeps. EndGpuMeasurement() also resolves;
+// read the result once the list's execution has completed.
+void BeginGpuMeasurement(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList);
+void EndGpuMeasurement(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList);
+double GetGpuMeasurementMs(Pipeline* pPipeline);
+
+// Execute `pCmdList`, closed and holding one Begin/EndGpuMeasurement() pair,
+// twice on the direct queue: once to warm up, so first-use costs such as
+// paging resources in stay out, then timed. Returns GetGpuMeasurementMs() of
+// the second run, with the GPU idle.
+double ExecuteTimedSweepList(Pipeline* pPipeline, ID3D12CommandList* pCmdList);
+
+// Seed of a frame's `draw`, derived from the frame and draw index so lists
+// recorded on different threads don't share state.
+UINT GetDrawSeed(const Pipeline* pPipeline, UINT draw);
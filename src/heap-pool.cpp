@@ -0,0 +1,97 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "heap-pool.h"
+#include "pipeline.h"
+#include "utils.h"
+
+void InitHeapPool(HeapPool* pPool, D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS heapFlags, UINT64 heapSize)
+{
+    pPool->heapType = heapType;
+    pPool->heapFlags = heapFlags;
+    // Heaps are sized in whole 64 KB placement alignment units.
+    pPool->heapSize = (heapSize + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) &
+        ~(UINT64)(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+    pPool->heapCount = 0;
+    pPool->heapOffset = 0;
+}
+
+static bool AddPoolHeap(Pipeline* pPipeline, HeapPool* pPool)
+{
+    if (pPool->heapCount == s_MaxPoolHeapCount)
+    {
+        return false;
+    }
+
+    CD3DX12_HEAP_DESC heapDesc(
+        pPool->heapSize,
+        pPool->heapType,
+        D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+        pPool->heapFlags);
+
+    const HRESULT hr = pPipeline->device->CreateHeap(
+        &heapDesc,
+        IID_PPV_ARGS(&pPool->heaps[pPool->heapCount]));
+    if (FAILED(hr))
+    {
+        LogMessage(
+            "Heap pool: can't create heap %u of %llu MB (0x%08x)\n",
+            pPool->heapCount,
+            pPool->heapSize / (1024 * 1024),
+            (UINT)hr);
+        return false;
+    }
+
+    pPool->heapCount += 1;
+    pPool->heapOffset = 0;
+    return true;
+}
+
+bool CreatePooledBuffer(
+    Pipeline* pPipeline,
+    HeapPool* pPool,
+    UINT64 size,
+    D3D12_RESOURCE_FLAGS flags,
+    D3D12_RESOURCE_STATES initialState,
+    ComPtr<ID3D12Resource>* pBuffer,
+    UINT* pHeapIndex)
+{
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size, flags);
+    const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo =
+        pPipeline->device->GetResourceAllocationInfo(0, 1, &bufferDesc);
+
+    if (allocationInfo.SizeInBytes > pPool->heapSize)
+    {
+        return false;
+    }
+
+    const UINT64 alignment = allocationInfo.Alignment;
+    UINT64 offset = (pPool->heapOffset + alignment - 1) & ~(alignment - 1);
+
+    // Start a new heap when the newest one can't fit the buffer; the rest of
+    // it is wasted.
+    if (pPool->heapCount == 0 || offset + allocationInfo.SizeInBytes > pPool->heapSize)
+    {
+        if (!AddPoolHeap(pPipeline, pPool))
+        {
+            return false;
+        }
+        offset = 0;
+    }
+
+    const UINT heapIndex = pPool->heapCount - 1;
+    const HRESULT hr = pPipeline->device->CreatePlacedResource(
+        pPool->heaps[heapIndex].Get(),
+        offset,
+        &bufferDesc,
+        initialState,
+        nullptr,
+        IID_PPV_ARGS(pBuffer->ReleaseAndGetAddressOf()));
+    if (FAILED(hr))
+    {
+        return false;
+    }
+
+    pPool->heapOffset = offset + allocationInfo.SizeInBytes;
+    *pHeapIndex = heapIndex;
+    return true;
+}
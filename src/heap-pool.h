@@ -0,0 +1,47 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// Upper bound of heaps in a pool.
+static const UINT s_MaxPoolHeapCount = 1024;
+
+// Places buffers in large ID3D12Heaps instead of committing a heap per
+// resource. Buffers are carved linearly out of the newest heap, and a new
+// heap is created when it is full. Nothing is freed before the pool is
+// destroyed, which suits resources living as long as the workload.
+//
+// Residency is managed per heap: `MakeResident()` and `Evict()` take the
+// heaps, not the placed resources.
+struct HeapPool
+{
+    D3D12_HEAP_TYPE heapType;
+    D3D12_HEAP_FLAGS heapFlags;
+    UINT64 heapSize;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> heaps[s_MaxPoolHeapCount];
+    UINT heapCount;
+    // Next free byte of the newest heap.
+    UINT64 heapOffset;
+};
+
+// Set the pool up, without creating any heap yet. `heapFlags` must allow
+// buffers.
+void InitHeapPool(HeapPool* pPool, D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS heapFlags, UINT64 heapSize);
+
+// Place a buffer in the pool, and return the index of the heap it is in.
+// Returns false, with nothing created, when the buffer doesn't fit in a heap,
+// the pool is full, or the device is out of memory.
+bool CreatePooledBuffer(
+    Pipeline* pPipeline,
+    HeapPool* pPool,
+    UINT64 size,
+    D3D12_RESOURCE_FLAGS flags,
+    D3D12_RESOURCE_STATES initialState,
+    Microsoft::WRL::ComPtr<ID3D12Resource>* pBuffer,
+    UINT* pHeapIndex);
@@ -1,124 +1,126 @@
 // Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
 
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-
-#include <Windows.h>
-#include <wrl.h>
-#include <exception>
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-#include <DirectXMath.h>
-#include "d3dx12.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipeline.h"
+#include "scenario.h"
+#include "shaders.h"
 #include "utils.h"
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
 
-static int s_RenderWidth = 1080;
-static int s_RenderHeight = 960;
-static const int s_FrameCount = 2;
+// Main message handler for the app.
+static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
-struct Vertex
-{
-    XMFLOAT3 position;
-    XMFLOAT4 color;
-};
+static const float s_ClearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
 
-static const size_t s_ColorCount = 4096;
-struct ConstBuffer
+void WaitForFenceValue(Pipeline* pPipeline, UINT64 fenceValue)
 {
-    // error X3059: array dimension must be between 1 and 65536
-    XMFLOAT4 colors[s_ColorCount];
-};
+    if (pPipeline->fence->GetCompletedValue() < fenceValue)
+    {
+        const UINT64 waitTicks = BeginTelemetryMarker(pPipeline, TelemetryMarker::FenceWait);
 
-struct Pipeline
-{
-    // pipeline objects
-    CD3DX12_VIEWPORT viewport;
-    CD3DX12_RECT scissorRect;
-    ComPtr<IDXGISwapChain3> swapchain;
-    ComPtr<ID3D12Device> device;
-    ComPtr<ID3D12Resource> renderTargets[s_FrameCount];
-    ComPtr<ID3D12CommandAllocator> cmdAlloc;
-    ComPtr<ID3D12CommandQueue> cmdQueue;
-    ComPtr<ID3D12DescriptorHeap> rtvDescriptorHeap;
-    ComPtr<ID3D12DescriptorHeap> cbvDescriptorHeap;
-    UINT rtvDescriptorSize;
-    ComPtr<ID3D12RootSignature> rootSignature;
-    ComPtr<ID3D12PipelineState> pipelineState;
-    ComPtr<ID3D12GraphicsCommandList> cmdList;
-
-    // app resource
-    ComPtr<ID3D12Resource> vertexBuffer;
-    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
-    ComPtr<ID3D12Resource> constantBuffer;
-    UINT* pConstBufferMappedBeginAddr;
-    ConstBuffer* pConstBufferData;
-
-    // synchronization
-    UINT frameIndex;
-    HANDLE fenceEvent;
-    ComPtr<ID3D12Fence> fence;
-    UINT64 fenceValue;
-};
+        ThrowIfFailed(pPipeline->fence->SetEventOnCompletion(
+            fenceValue,
+            pPipeline->fenceEvent));
 
-inline void ThrowIfFailed(HRESULT hr)
-{
-    if (FAILED(hr))
-    {
-        // Set a breakpoint on this line to catch DirectX API errors
-        throw std::exception();
+        WaitForSingleObject(pPipeline->fenceEvent, INFINITE);
+
+        EndTelemetryMarker(pPipeline, s_TelemetryMainThread, TelemetryMarker::FenceWait, waitTicks);
     }
 }
 
-// Main message handler for the app.
-static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
-
-static void WaitForPreviousFrame(Pipeline* pPipeline)
+UINT64 SignalFence(Pipeline* pPipeline)
 {
-    // WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
-    // This is code implemented as such for simplicity. The D3D12HelloFrameBuffering
-    // sample illustrates how to use fences for efficient resource usage and to
-    // maximize GPU utilization.
-
     // Increment the fence value from CPU side.
     pPipeline->fenceValue += 1;
 
-    // Add a command to set fence value from GPU side to CPU `fenceValue`.
     ThrowIfFailed(pPipeline->cmdQueue->Signal(
         pPipeline->fence.Get(),
         pPipeline->fenceValue));
 
-    // Wait until the previous frame is finished.
-    if (pPipeline->fence->GetCompletedValue() < pPipeline->fenceValue)
-    {
-        ThrowIfFailed(pPipeline->fence->SetEventOnCompletion(
-            pPipeline->fenceValue,
-            pPipeline->fenceEvent));
+    return pPipeline->fenceValue;
+}
 
-        WaitForSingleObject(pPipeline->fenceEvent, INFINITE);
+// The swapchain decides which back buffer comes next. Offscreen render
+// targets are used round robin.
+static void UpdateBackBufferIndex(Pipeline* pPipeline)
+{
+    if (pPipeline->swapchain)
+    {
+        pPipeline->backBufferIndex = pPipeline->swapchain->GetCurrentBackBufferIndex();
     }
+    else
+    {
+        pPipeline->backBufferIndex = (UINT)(pPipeline->frameNumber % pPipeline->backBufferCount);
+    }
+}
+
+// Drain the queue. Only used at load and shutdown; the frame loop never waits
+// for the GPU to go idle.
+static void WaitForGpu(Pipeline* pPipeline)
+{
+    WaitForFenceValue(pPipeline, SignalFence(pPipeline));
 
-    pPipeline->frameIndex = pPipeline->swapchain->GetCurrentBackBufferIndex();
+    UpdateBackBufferIndex(pPipeline);
 }
 
-static void LoadPipeline(Pipeline* pPipeline, HWND hwnd)
+// Read back the GPU time of the frame last submitted with `frameResourceIndex`
+// and report it. The GPU must be past that frame resource's fence.
+static void ReadFrameResults(Pipeline* pPipeline, UINT frameResourceIndex)
 {
-    pPipeline->viewport = CD3DX12_VIEWPORT(
-        0.0f,
-        0.0f,
-        (float)s_RenderWidth,
-        (float)s_RenderHeight);
+    FrameResource* pFrame = &pPipeline->frameResources[frameResourceIndex];
 
-    pPipeline->scissorRect = CD3DX12_RECT(
-        0.0f,
-        0.0f,
-        (float)s_RenderWidth,
-        (float)s_RenderHeight);
+    if (!pFrame->resultsPending)
+    {
+        return;
+    }
+
+    ReadGpuPasses(pPipeline, frameResourceIndex);
+
+    if (!pPipeline->renderingSweepFrames)
+    {
+        ReportFrame(
+            pPipeline,
+            pFrame->frameNumber,
+            CpuTicksToMs(pFrame->cpuTicks),
+            pPipeline->gpuTimer.frameMs);
+        UpdateSoak(pPipeline, pPipeline->gpuTimer.frameMs);
+        UpdateLoadController(pPipeline, pFrame->drawCount, pPipeline->gpuTimer.frameMs);
+    }
+
+    pFrame->resultsPending = false;
+}
 
+static void MoveToNextFrame(Pipeline* pPipeline)
+{
+    // Mark the end of the frame just submitted on the GPU timeline.
+    FrameResource* pFrame = &pPipeline->frameResources[pPipeline->frameResourceIndex];
+    pFrame->fenceValue = SignalFence(pPipeline);
+    pFrame->frameNumber = pPipeline->frameNumber;
+    pFrame->resultsPending = true;
+    pPipeline->frameNumber += 1;
+
+    pPipeline->frameResourceIndex =
+        (pPipeline->frameResourceIndex + 1) % pPipeline->options.frameCount;
+    UpdateBackBufferIndex(pPipeline);
+
+    // The next frame resource was last used `frameCount` frames ago. Only
+    // block if the GPU is still executing that frame, so recording of this
+    // frame overlaps GPU execution of the previous ones.
+    FrameResource* pNextFrame = &pPipeline->frameResources[pPipeline->frameResourceIndex];
+    WaitForFenceValue(pPipeline, pNextFrame->fenceValue);
+
+    // The GPU is past that frame, so its timestamps are ready.
+    ReadFrameResults(pPipeline, pPipeline->frameResourceIndex);
+}
+
+// Create the factory, device and direct queue. Scenario phases share them,
+// so they outlive the rest of the pipeline.
+static void CreateDevice(Pipeline* pPipeline)
+{
     UINT dxgiFactoryFlag = 0;
 
 #if defined(_DEBUG)
@@ -138,19 +140,52 @@ static void LoadPipeline(Pipeline* pPipeline, HWND hwnd)
     }
 #endif
 
-    ComPtr<IDXGIFactory4> dxgiFactory;
-    ThrowIfFailed(CreateDXGIFactory2(dxgiFactoryFlag, IID_PPV_ARGS(&dxgiFactory)));
+    ThrowIfFailed(CreateDXGIFactory2(dxgiFactoryFlag, IID_PPV_ARGS(&pPipeline->dxgiFactory)));
 
-    // Find an Adapter that supports D3D12.
-    ComPtr<IDXGIAdapter1> dxgiAdapter;
-    ThrowIfFailed(FindD3D12HardwareAdapter(dxgiFactory, dxgiAdapter));
+    // Find the requested adapter that supports D3D12.
+    HRESULT hr = FindD3D12HardwareAdapter(
+        pPipeline->dxgiFactory.Get(),
+        pPipeline->options.adapterIndex,
+        pPipeline->options.adapterLuid,
+        &pPipeline->adapter);
+    if (FAILED(hr))
+    {
+        LogMessage(
+            "No D3D12 hardware adapter %u / luid 0x%016llx, see -list-adapters\n",
+            pPipeline->options.adapterIndex,
+            pPipeline->options.adapterLuid);
+        ThrowIfFailed(hr);
+    }
+    ThrowIfFailed(pPipeline->adapter->GetDesc1(&pPipeline->adapterDesc));
 
     // Create device.
     ThrowIfFailed(D3D12CreateDevice(
-            dxgiAdapter.Get(),
+            pPipeline->adapter.Get(),
             D3D_FEATURE_LEVEL_11_0,
             IID_PPV_ARGS(&pPipeline->device)));
 
+    // Find the highest root signature version the device supports.
+    {
+        D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+
+        // This is the highest version the sample supports. If
+        // CheckFeatureSupport succeeds, the HighestVersion returned will not
+        // be greater than this.
+        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+
+        HRESULT hr = pPipeline->device->CheckFeatureSupport(
+            D3D12_FEATURE_ROOT_SIGNATURE,
+            &featureData,
+            sizeof(featureData));
+
+        if (FAILED(hr))
+        {
+            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+        }
+
+        pPipeline->rootSignatureVersion = featureData.HighestVersion;
+    }
+
     // Create command queue.
     D3D12_COMMAND_QUEUE_DESC queueDesc = {};
     queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
@@ -158,37 +193,72 @@ static void LoadPipeline(Pipeline* pPipeline, HWND hwnd)
     ThrowIfFailed(pPipeline->device->CreateCommandQueue(
             &queueDesc,
             IID_PPV_ARGS(&pPipeline->cmdQueue)));
+}
+
+// Without a window, `hwnd` is null and the frames render to offscreen render
+// targets in place of the swapchain's back buffers.
+static void LoadPipeline(Pipeline* pPipeline, HWND hwnd)
+{
+    const UINT renderWidth = pPipeline->options.width;
+    const UINT renderHeight = pPipeline->options.height;
+
+    pPipeline->viewport = CD3DX12_VIEWPORT(
+        0.0f,
+        0.0f,
+        (float)renderWidth,
+        (float)renderHeight);
+
+    pPipeline->scissorRect = CD3DX12_RECT(
+        0,
+        0,
+        (LONG)renderWidth,
+        (LONG)renderHeight);
+
+    // Scenario phases come with the device of the first one.
+    if (!pPipeline->device)
+    {
+        CreateDevice(pPipeline);
+    }
+
+    // Flip model needs at least 2 buffers; use one per frame in flight so the
+    // CPU doesn't wait on back buffers when frames overlap.
+    pPipeline->backBufferCount = max(pPipeline->options.frameCount, 2u);
 
     // Create swapchain.
-    DXGI_SWAP_CHAIN_DESC1 swapchainDesc = {};
-    swapchainDesc.BufferCount = s_FrameCount;
-    swapchainDesc.Width = s_RenderWidth;
-    swapchainDesc.Height = s_RenderHeight;
-    swapchainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapchainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapchainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapchainDesc.SampleDesc.Count = 1;
-
-    ComPtr<IDXGISwapChain1> swapchain;
-    ThrowIfFailed(dxgiFactory->CreateSwapChainForHwnd(
-        // swapchain needs the command queue so it force flush it
-        pPipeline->cmdQueue.Get(),
-        hwnd,
-        &swapchainDesc,
-        nullptr,
-        nullptr,
-        &swapchain));
-
-    // This example doesn't support fullscreen.
-    ThrowIfFailed(dxgiFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
-
-    ThrowIfFailed(swapchain.As(&pPipeline->swapchain));
+    if (hwnd != nullptr)
+    {
+        DXGI_SWAP_CHAIN_DESC1 swapchainDesc = {};
+        swapchainDesc.BufferCount = pPipeline->backBufferCount;
+        swapchainDesc.Width = renderWidth;
+        swapchainDesc.Height = renderHeight;
+        swapchainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        swapchainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        swapchainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+        swapchainDesc.SampleDesc.Count = 1;
+        swapchainDesc.Flags = InitPresentLatency(pPipeline);
+
+        ComPtr<IDXGISwapChain1> swapchain;
+        ThrowIfFailed(pPipeline->dxgiFactory->CreateSwapChainForHwnd(
+            // swapchain needs the command queue so it force flush it
+            pPipeline->cmdQueue.Get(),
+            hwnd,
+            &swapchainDesc,
+            nullptr,
+            nullptr,
+            &swapchain));
+
+        // This example doesn't support fullscreen.
+        ThrowIfFailed(pPipeline->dxgiFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
+
+        ThrowIfFailed(swapchain.As(&pPipeline->swapchain));
+        CreatePresentLatency(pPipeline);
+    }
 
     // Create descriptor heaps.
     {
         // Describe and create a render target view (RTV) descriptor heap.
         D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-        rtvHeapDesc.NumDescriptors = s_FrameCount;
+        rtvHeapDesc.NumDescriptors = pPipeline->backBufferCount;
         rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
         rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(pPipeline->device->CreateDescriptorHeap(
@@ -202,68 +272,128 @@ static void LoadPipeline(Pipeline* pPipeline, HWND hwnd)
         // Describe and create a constant buffer view (CBV) descriptor heap.
         // Flags indicate that this descriptor heap can be bound to the pipeline
         // and that descriptors contained in it can be referenced by a root table.
+        // Each frame resource has its own CBV.
         D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
-        cbvHeapDesc.NumDescriptors = 1;
+        cbvHeapDesc.NumDescriptors = pPipeline->options.frameCount;
         cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
         cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         ThrowIfFailed(pPipeline->device->CreateDescriptorHeap(
             &cbvHeapDesc,
             IID_PPV_ARGS(&pPipeline->cbvDescriptorHeap)));
+
+        pPipeline->cbvDescriptorSize =
+            pPipeline->device->GetDescriptorHandleIncrementSize(
+                D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     }
 
-    // Create frame resource.
+    // Create back buffers.
     {
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptorHandle(
             pPipeline->rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
 
-        // Create render target view for each frame.
-        for (UINT i = 0; i < s_FrameCount; ++i)
+        // Offscreen render targets start in the same state as swapchain
+        // buffers, so the frame's barriers are the same either way.
+        CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+        CD3DX12_RESOURCE_DESC renderTargetDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            DXGI_FORMAT_R8G8B8A8_UNORM,
+            renderWidth,
+            renderHeight,
+            1,
+            1,
+            1,
+            0,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+        CD3DX12_CLEAR_VALUE clearValue(DXGI_FORMAT_R8G8B8A8_UNORM, s_ClearColor);
+
+        // Create render target view for each back buffer.
+        for (UINT i = 0; i < pPipeline->backBufferCount; ++i)
         {
-            ThrowIfFailed(pPipeline->swapchain->GetBuffer(
-                i,
-                IID_PPV_ARGS(&pPipeline->renderTargets[i])));
+            if (pPipeline->swapchain)
+            {
+                ThrowIfFailed(pPipeline->swapchain->GetBuffer(
+                    i,
+                    IID_PPV_ARGS(&pPipeline->renderTargets[i])));
+            }
+            else
+            {
+                ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+                    &defaultHeapProps,
+                    D3D12_HEAP_FLAG_NONE,
+                    &renderTargetDesc,
+                    D3D12_RESOURCE_STATE_PRESENT,
+                    &clearValue,
+                    IID_PPV_ARGS(&pPipeline->renderTargets[i])));
+            }
 
             pPipeline->device->CreateRenderTargetView(
                 pPipeline->renderTargets[i].Get(),
                 nullptr,
                 rtvDescriptorHandle);
 
-            // There are 2 diescriptors, advance to the next descriptor in memory.
+            // Advance to the next descriptor in memory.
             rtvDescriptorHandle.Offset(1, pPipeline->rtvDescriptorSize);
         }
     }
 
-    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        IID_PPV_ARGS(&pPipeline->cmdAlloc)));
+    // Create a command allocator for each frame resource.
+    for (UINT i = 0; i < pPipeline->options.frameCount; ++i)
+    {
+        ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(&pPipeline->frameResources[i].cmdAlloc)));
+    }
 }
 
-static void LoadAssets(Pipeline* pPipeline)
+void CreateRootSignature(
+    Pipeline* pPipeline,
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc,
+    ComPtr<ID3D12RootSignature>* pRootSignature)
 {
-    // Create a root signature consisting of a descriptor table with a single CBV.
+    // Converts a 1.1 description down if the device only supports 1.0.
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    HRESULT hr = D3DX12SerializeVersionedRootSignature(
+        &desc,
+        pPipeline->rootSignatureVersion,
+        &signature,
+        &error);
+    if (FAILED(hr))
     {
-        D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
-
-        // This is the highest version the sample supports. If
-        // CheckFeatureSupport succeeds, the HighestVersion returned will not
-        // be greater than this.
-        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        OutputDebugStringA((char*)error->GetBufferPointer());
+        throw std::exception();
+    }
 
-        HRESULT hr = pPipeline->device->CheckFeatureSupport(
-            D3D12_FEATURE_ROOT_SIGNATURE,
-            &featureData,
-            sizeof(featureData));
+    ThrowIfFailed(pPipeline->device->CreateRootSignature(
+        0,
+        signature->GetBufferPointer(),
+        signature->GetBufferSize(),
+        IID_PPV_ARGS(pRootSignature->ReleaseAndGetAddressOf())));
+}
 
-        if (FAILED(hr))
-        {
-            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
-        }
+static void LoadAssets(Pipeline* pPipeline)
+{
+    OpenPipelineLibrary(pPipeline);
 
+    // Create a root signature consisting of a descriptor table with a single
+    // CBV, per-draw root constants, and a per-draw root CBV.
+    {
         CD3DX12_DESCRIPTOR_RANGE1 ranges[1] = {};
-        CD3DX12_ROOT_PARAMETER1 rootParameters[1] = {};
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_RootParamCount] = {};
 
         ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-        rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
+        rootParameters[s_RootParamCbvTable].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
+        // Per-draw constants at b1.
+        rootParameters[s_RootParamDrawConstants].InitAsConstants(
+            sizeof(DrawConstants) / 4,
+            1,
+            0,
+            D3D12_SHADER_VISIBILITY_VERTEX);
+        // Per-draw uploaded constants at b2.
+        rootParameters[s_RootParamDrawData].InitAsConstantBufferView(
+            2,
+            0,
+            D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+            D3D12_SHADER_VISIBILITY_VERTEX);
 
         // Allow input layout and deny uneccessary access to certain pipeline stages.
         D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
@@ -276,24 +406,7 @@ static void LoadAssets(Pipeline* pPipeline)
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
         rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, rootSignatureFlags);
 
-        ComPtr<ID3DBlob> signature;
-        ComPtr<ID3DBlob> error;
-        hr = D3DX12SerializeVersionedRootSignature(
-            &rootSignatureDesc,
-            featureData.HighestVersion,
-            &signature,
-            &error);
-        if (FAILED(hr))
-        {
-            OutputDebugStringA((char*)error->GetBufferPointer());
-            throw std::exception();
-        }
-
-        ThrowIfFailed(pPipeline->device->CreateRootSignature(
-            0,
-            signature->GetBufferPointer(),
-            signature->GetBufferSize(),
-            IID_PPV_ARGS(&pPipeline->rootSignature)));
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pPipeline->rootSignature);
     }
 
     // Create pipeline state, which includes compiling and loading shaders.
@@ -301,53 +414,8 @@ static void LoadAssets(Pipeline* pPipeline)
         ComPtr<ID3DBlob> vertexShader;
         ComPtr<ID3DBlob> pixelShader;
 
-#if defined(_DEBUG)
-        // Enable better shader debugging with the graphics debugging tools.
-        UINT compileFlags = 0; // D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-        UINT compileFlag = 0;
-#endif
-
-        {
-            ComPtr<ID3DBlob> compileError;
-            HRESULT compileResult = D3DCompileFromFile(
-                L"C:/projects/gputrasher/src/hello-triangle.hlsl",
-                nullptr,
-                nullptr,
-                "VSMain",
-                "vs_5_0",
-                compileFlags,
-                0,
-                &vertexShader,
-                &compileError);
-
-            if (FAILED(compileResult))
-            {
-                OutputDebugStringA((char*)compileError->GetBufferPointer());
-                throw std::exception();
-            }
-
-        }
-
-        {
-            ComPtr<ID3DBlob> compileError;
-            HRESULT compileResult = D3DCompileFromFile(
-                L"C:/projects/gputrasher/src/hello-triangle.hlsl",
-                nullptr,
-                nullptr,
-                "PSMain",
-                "ps_5_0",
-                compileFlags,
-                0,
-                &pixelShader,
-                &compileError);
-
-            if (FAILED(compileResult))
-            {
-                OutputDebugStringA((char*)compileError->GetBufferPointer());
-                throw std::exception();
-            }
-        }
+        CompileShader(L"hello-triangle.hlsl", "VSMain", "vs_5_0", nullptr, &vertexShader);
+        CompileShader(L"hello-triangle.hlsl", "PSMain", "ps_5_0", nullptr, &pixelShader);
 
         // vertex input layout
         D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
@@ -371,15 +439,89 @@ static void LoadAssets(Pipeline* pPipeline)
         psoDesc.NumRenderTargets = 1;
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
         psoDesc.SampleDesc.Count = 1;
-        ThrowIfFailed(pPipeline->device->CreateGraphicsPipelineState(
-            &psoDesc,
-            IID_PPV_ARGS(&pPipeline->pipelineState)));
+        CreateGraphicsPipelineState(pPipeline, L"hello-triangle", psoDesc, &pPipeline->pipelineState);
+
+        if (pPipeline->options.workload == Workload::DrawStorm)
+        {
+            CreateDrawStormPipelineStates(pPipeline, psoDesc);
+        }
+    }
+
+    if (pPipeline->options.workload == Workload::Geometry)
+    {
+        CreateGeometryPipelineState(pPipeline);
+        CreateGeometryResources(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::FillRate)
+    {
+        CreateFillRatePipelineStates(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Bandwidth)
+    {
+        CreateBandwidth(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::WaveOps)
+    {
+        CreateWaveOps(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Residency)
+    {
+        CreateResidency(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Bindless)
+    {
+        CreateBindless(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Sampling)
+    {
+        CreateSamplingPipelineStates(pPipeline);
+        CreateSamplingResources(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Fault)
+    {
+        CreateFaultPipelineStates(pPipeline);
+        CreateFaultResources(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Indirect)
+    {
+        CreateIndirectPipelineStates(pPipeline);
+        CreateIndirectResources(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Transfer)
+    {
+        CreateTransfer(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Barriers)
+    {
+        CreateBarriersPipelineStates(pPipeline);
+        CreateBarriersResources(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Raytracing)
+    {
+        CreateGeometryResources(pPipeline);
+        CreateRaytracing(pPipeline);
+    }
+
+    if (pPipeline->options.workload == Workload::Alu)
+    {
+        CreateAlu(pPipeline);
     }
 
     ThrowIfFailed(pPipeline->device->CreateCommandList(
         0,
         D3D12_COMMAND_LIST_TYPE_DIRECT,
-        pPipeline->cmdAlloc.Get(),
+        pPipeline->frameResources[0].cmdAlloc.Get(),
         pPipeline->pipelineState.Get(),
         IID_PPV_ARGS(&pPipeline->cmdList)));
 
@@ -387,9 +529,33 @@ static void LoadAssets(Pipeline* pPipeline)
     // to record yet. The main loop expects it to be closed, so close it now.
     ThrowIfFailed(pPipeline->cmdList->Close());
 
+    // With worker threads or reused lists holding the draws, the main thread
+    // records the frame's prologue into `cmdList` and its epilogue into
+    // `postCmdList`.
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        pPipeline->frameResources[0].cmdAlloc.Get(),
+        pPipeline->pipelineState.Get(),
+        IID_PPV_ARGS(&pPipeline->postCmdList)));
+
+    ThrowIfFailed(pPipeline->postCmdList->Close());
+
+    if (pPipeline->options.recordThreadCount > 0)
+    {
+        CreateRecordThreads(pPipeline);
+    }
+
+    CreateGpuTimer(pPipeline);
+    CreateAsyncCompute(pPipeline);
+    CreateUploadRing(pPipeline);
+
+    // Every PSO exists by now.
+    SavePipelineLibrary(pPipeline);
+
     // Create the vertex buffer.
     {
-        const float aspectRatio = (float)s_RenderWidth / (float)s_RenderHeight;
+        const float aspectRatio = (float)pPipeline->options.width / (float)pPipeline->options.height;
 
         Vertex vertices[] =
         {
@@ -429,24 +595,41 @@ static void LoadAssets(Pipeline* pPipeline)
         pPipeline->vertexBufferView.SizeInBytes = vertexBufferSize;
     }
 
-    // Create constant buffer.
+    // Create constant buffer, one slice per frame resource so the CPU can
+    // update a frame's constants while the GPU still reads older frames.
     {
+        // The size is a multiple of 256, so every slice is a valid CBV address.
         const UINT constBufferSize = sizeof(ConstBuffer);
+        static_assert(sizeof(ConstBuffer) % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0,
+            "Constant buffer slices must be 256-byte aligned.");
 
         ThrowIfFailed(pPipeline->device->CreateCommittedResource(
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
             D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(constBufferSize),
+            &CD3DX12_RESOURCE_DESC::Buffer(constBufferSize * pPipeline->options.frameCount),
             D3D12_RESOURCE_STATE_GENERIC_READ,
             nullptr,
             IID_PPV_ARGS(&pPipeline->constantBuffer)));
 
-        // Describe and create a constant buffer view.
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-        cbvDesc.BufferLocation = pPipeline->constantBuffer->GetGPUVirtualAddress();
-        cbvDesc.SizeInBytes = constBufferSize;
-        pPipeline->device->CreateConstantBufferView(
-            &cbvDesc, pPipeline->cbvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+        // Describe and create a constant buffer view for each slice.
+        CD3DX12_CPU_DESCRIPTOR_HANDLE cbvCpuHandle(
+            pPipeline->cbvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+        CD3DX12_GPU_DESCRIPTOR_HANDLE cbvGpuHandle(
+            pPipeline->cbvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+
+        for (UINT i = 0; i < pPipeline->options.frameCount; ++i)
+        {
+            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
+            cbvDesc.BufferLocation =
+                pPipeline->constantBuffer->GetGPUVirtualAddress() + (UINT64)i * constBufferSize;
+            cbvDesc.SizeInBytes = constBufferSize;
+            pPipeline->device->CreateConstantBufferView(&cbvDesc, cbvCpuHandle);
+
+            pPipeline->frameResources[i].cbvHandle = cbvGpuHandle;
+
+            cbvCpuHandle.Offset(1, pPipeline->cbvDescriptorSize);
+            cbvGpuHandle.Offset(1, pPipeline->cbvDescriptorSize);
+        }
 
         pPipeline->pConstBufferData = (ConstBuffer*)malloc(constBufferSize);
         memset(pPipeline->pConstBufferData, 0, constBufferSize);
@@ -464,19 +647,23 @@ static void LoadAssets(Pipeline* pPipeline)
             &readRange,
             reinterpret_cast<void**>(&pPipeline->pConstBufferMappedBeginAddr)));
 
-        memcpy(
-            pPipeline->pConstBufferMappedBeginAddr,
-            pPipeline->pConstBufferData,
-            constBufferSize);
+        for (UINT i = 0; i < pPipeline->options.frameCount; ++i)
+        {
+            FrameResource* pFrame = &pPipeline->frameResources[i];
+            pFrame->pConstBuffer = reinterpret_cast<ConstBuffer*>(
+                pPipeline->pConstBufferMappedBeginAddr + (size_t)i * constBufferSize);
 
-        pPipeline->constantBuffer->Release();
+            memcpy(pFrame->pConstBuffer, pPipeline->pConstBufferData, constBufferSize);
+        }
+    }
 
-        // memcpy(
-        //     &pPipeline->pConstBufferMappedBeginAddr,
-        //     pPipeline->pConstBufferData,
-        //     constBufferSize);
+    if (pPipeline->options.workload == Workload::DrawStorm)
+    {
+        CreateDrawStormResources(pPipeline);
     }
 
+    CreateRecordCache(pPipeline);
+
     // Create synchronization objects and wait until assets have been uploaded to the GPU.
     {
         pPipeline->fenceValue = 0;
@@ -496,101 +683,795 @@ static void LoadAssets(Pipeline* pPipeline)
         // Wait for the command list to execute; we are reusing the same command
         // list in our main loop but for now, we just want to wait for setup to
         // complete before continuing.
-        WaitForPreviousFrame(pPipeline);
+        WaitForGpu(pPipeline);
+        pPipeline->frameResourceIndex = 0;
     }
+
+    OpenReport(pPipeline);
+    CreateSoak(pPipeline);
+    CreateTelemetry(pPipeline);
+    CreateLoadController(pPipeline);
 }
 
-static void PopulateCommandList(Pipeline* pPipeline)
+void SetDrawState(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
 {
-    // Command list allocators can only be reset when the associated
-    // command lists have finished execution on the GPU; apps should use
-    // fences to determine GPU execution progress.
-    ThrowIfFailed(pPipeline->cmdAlloc->Reset());
+    FrameResource* pFrame = &pPipeline->frameResources[pPipeline->frameResourceIndex];
 
-    // However, when ExecuteCommandList() is called on a particular command
-    // list, that command list can then be reset at any time and must be before
-    // re-recording.
-    ThrowIfFailed(pPipeline->cmdList->Reset(
-        pPipeline->cmdAlloc.Get(),
-        pPipeline->pipelineState.Get()));
-
-    // Set necessary states.
-    {
-        pPipeline->cmdList->SetGraphicsRootSignature(pPipeline->rootSignature.Get());
+    pCmdList->SetGraphicsRootSignature(pPipeline->rootSignature.Get());
 
-        ID3D12DescriptorHeap* ppHeaps[] = { pPipeline->cbvDescriptorHeap.Get() };
-        pPipeline->cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-        pPipeline->cmdList->SetGraphicsRootDescriptorTable(
-            0,
-            pPipeline->cbvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-    }
+    ID3D12DescriptorHeap* ppHeaps[] = { pPipeline->cbvDescriptorHeap.Get() };
+    pCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    pCmdList->SetGraphicsRootDescriptorTable(s_RootParamCbvTable, pFrame->cbvHandle);
 
-    pPipeline->cmdList->RSSetViewports(1, &pPipeline->viewport);
-    pPipeline->cmdList->RSSetScissorRects(1, &pPipeline->scissorRect);
+    const DrawConstants drawConstants = {};
+    pCmdList->SetGraphicsRoot32BitConstants(
+        s_RootParamDrawConstants,
+        sizeof(DrawConstants) / 4,
+        &drawConstants,
+        0);
 
-    // Indicate that the back buffer will be used as a render target.
-    {
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            pPipeline->renderTargets[pPipeline->frameIndex].Get(),
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_RENDER_TARGET);
+    // Neutral per-draw data, for draws that don't upload their own.
+    UploadAllocation drawData = AllocateUpload(pPipeline, sizeof(DrawData));
+    ((DrawData*)drawData.pCpuAddress)->color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    pCmdList->SetGraphicsRootConstantBufferView(s_RootParamDrawData, drawData.gpuAddress);
 
-        pPipeline->cmdList->ResourceBarrier(1, &barrier);
-    }
+    pCmdList->RSSetViewports(1, &pPipeline->viewport);
+    pCmdList->RSSetScissorRects(1, &pPipeline->scissorRect);
 
     CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(
         pPipeline->rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-        pPipeline->frameIndex,
+        pPipeline->backBufferIndex,
         pPipeline->rtvDescriptorSize);
 
-    pPipeline->cmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
-
-    // Record commands.
-    const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-    pPipeline->cmdList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    pPipeline->cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    pPipeline->cmdList->IASetVertexBuffers(0, 1, &pPipeline->vertexBufferView);
-    pPipeline->cmdList->DrawInstanced(3, 1, 0, 0);
+    pCmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+}
 
-    // Indicate that the back buffer will now be used to present.
+void RecordDraws(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    switch (pPipeline->options.workload)
     {
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            pPipeline->renderTargets[pPipeline->frameIndex].Get(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
-            D3D12_RESOURCE_STATE_PRESENT);
+    case Workload::DrawStorm:
+        RecordDrawStorm(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
 
-        pPipeline->cmdList->ResourceBarrier(1, &barrier);
-    }
+    case Workload::FillRate:
+        RecordFillRate(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
 
-    ThrowIfFailed(pPipeline->cmdList->Close());
-}
+    case Workload::Bandwidth:
+        RecordBandwidth(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::WaveOps:
+        RecordWaveOps(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Geometry:
+        RecordGeometry(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Residency:
+        RecordResidency(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Bindless:
+        RecordBindless(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Sampling:
+        RecordSampling(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Fault:
+        RecordFault(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Indirect:
+        RecordIndirect(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Transfer:
+        RecordTransfer(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Barriers:
+        RecordBarriers(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Raytracing:
+        RecordRaytracing(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    case Workload::Alu:
+        RecordAlu(pPipeline, pCmdList, firstDraw, drawCount);
+        return;
+
+    default:
+        break;
+    }
+
+    pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCmdList->IASetVertexBuffers(0, 1, &pPipeline->vertexBufferView);
+
+    for (UINT i = 0; i < drawCount; ++i)
+    {
+        pCmdList->DrawInstanced(3, 1, 0, 0);
+    }
+}
+
+static void PopulateCommandList(Pipeline* pPipeline)
+{
+    FrameResource* pFrame = &pPipeline->frameResources[pPipeline->frameResourceIndex];
+
+    // Command list allocators can only be reset when the associated
+    // command lists have finished execution on the GPU. MoveToNextFrame()
+    // has already waited on this frame resource's fence.
+    ThrowIfFailed(pFrame->cmdAlloc->Reset());
+
+    // However, when ExecuteCommandList() is called on a particular command
+    // list, that command list can then be reset at any time and must be before
+    // re-recording.
+    ThrowIfFailed(pPipeline->cmdList->Reset(
+        pFrame->cmdAlloc.Get(),
+        pPipeline->pipelineState.Get()));
+
+    // The GPU is done with this frame's constant buffer slice, refresh it
+    // from the CPU-side copy.
+    memcpy(pFrame->pConstBuffer, pPipeline->pConstBufferData, sizeof(ConstBuffer));
+
+    const UINT framePass = BeginGpuPass(pPipeline, pPipeline->cmdList.Get(), "frame");
+
+    // Set necessary states.
+    SetDrawState(pPipeline, pPipeline->cmdList.Get());
+
+    const UINT clearPass = BeginGpuPass(pPipeline, pPipeline->cmdList.Get(), "clear");
+
+    // Indicate that the back buffer will be used as a render target.
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pPipeline->renderTargets[pPipeline->backBufferIndex].Get(),
+            D3D12_RESOURCE_STATE_PRESENT,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        pPipeline->cmdList->ResourceBarrier(1, &barrier);
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(
+        pPipeline->rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+        pPipeline->backBufferIndex,
+        pPipeline->rtvDescriptorSize);
+
+    // Record commands.
+    pPipeline->cmdList->ClearRenderTargetView(rtvHandle, s_ClearColor, 0, nullptr);
+
+    EndGpuPass(pPipeline, pPipeline->cmdList.Get(), clearPass);
+
+    // The draws either go into this list, directly or as a bundle, or are
+    // in lists of their own, recorded by the worker threads or reused, which
+    // execute between `cmdList` and `postCmdList`. Either way the draw pass
+    // brackets all of them.
+    const UINT drawPass = BeginGpuPass(pPipeline, pPipeline->cmdList.Get(), "draws");
+
+    const RecordMode recordMode = pPipeline->recordCache.mode;
+    ID3D12GraphicsCommandList* pPostCmdList = pPipeline->cmdList.Get();
+    if (recordMode == RecordMode::Bundle)
+    {
+        ExecuteRecordCacheBundle(pPipeline, pPipeline->cmdList.Get());
+    }
+    else if (recordMode == RecordMode::Record && pPipeline->options.recordThreadCount == 0)
+    {
+        RecordDraws(pPipeline, pPipeline->cmdList.Get(), 0, pPipeline->frameDrawCount);
+    }
+    else
+    {
+        ThrowIfFailed(pPipeline->cmdList->Close());
+
+        // `cmdList` is closed, so its allocator is free to back another list.
+        pPostCmdList = pPipeline->postCmdList.Get();
+        ThrowIfFailed(pPostCmdList->Reset(
+            pFrame->cmdAlloc.Get(),
+            pPipeline->pipelineState.Get()));
+    }
+
+    EndGpuPass(pPipeline, pPostCmdList, drawPass);
+
+    // Indicate that the back buffer will now be used to present.
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pPipeline->renderTargets[pPipeline->backBufferIndex].Get(),
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PRESENT);
+
+        pPostCmdList->ResourceBarrier(1, &barrier);
+    }
+
+    EndGpuPass(pPipeline, pPostCmdList, framePass);
+    ResolveGpuPasses(pPipeline, pPostCmdList);
+
+    ThrowIfFailed(pPostCmdList->Close());
+}
+
+// Log CPU-side throughput and GPU pass times about once per second.
+static void UpdateFrameStats(Pipeline* pPipeline, UINT64 cpuTicks)
+{
+    FrameStats* pStats = &pPipeline->frameStats;
+
+    const UINT64 nowTicks = GetCpuTicks();
+    if (pStats->windowStartTicks == 0)
+    {
+        pStats->windowStartTicks = nowTicks;
+    }
+
+    pStats->frameCount += 1;
+    pStats->drawCount += pPipeline->frameDrawCount;
+    pStats->cpuTicks += cpuTicks;
+
+    const double windowMs = CpuTicksToMs(nowTicks - pStats->windowStartTicks);
+    if (windowMs >= 1000.0)
+    {
+        const double frameCount = (double)pStats->frameCount;
+        const double draws = (double)pStats->drawCount;
+
+        // Tagged with the adapter, as `-all-adapters` logs from many threads.
+        LogMessage(
+            "adapter %u: %.1f frames/s, %.3f CPU ms/frame, %.3f Mdraws/s\n",
+            pPipeline->options.adapterIndex,
+            GetRate(frameCount, windowMs, 1.0),
+            CpuTicksToMs(pStats->cpuTicks) / frameCount,
+            GetRate(draws, windowMs, 1.0e6));
+
+        LogGpuPassTimings(pPipeline);
+        ResetGpuPassTimings(pPipeline);
+        LogUploadStats(pPipeline, windowMs);
+        LogResidencyStats(pPipeline);
+        LogPresentLatencyStats(pPipeline);
+        LogLoadControllerStats(pPipeline, windowMs);
+
+        pStats->windowStartTicks = nowTicks;
+        pStats->frameCount = 0;
+        pStats->drawCount = 0;
+        pStats->cpuTicks = 0;
+    }
+}
+
+// Record and execute the current frame. Returns the CPU time it took.
+static UINT64 SubmitFrame(Pipeline* pPipeline)
+{
+    const UINT64 frameStartTicks = GetCpuTicks();
+
+    const bool multiThreaded = pPipeline->options.recordThreadCount > 0;
+
+    pPipeline->frameDrawCount = GetLoadDrawCount(pPipeline);
+
+    BeginUploadFrame(pPipeline);
+    UpdateResidency(pPipeline);
+
+    // Kick the worker threads first so their recording overlaps the main
+    // thread's.
+    if (multiThreaded)
+    {
+        BeginRecordThreads(pPipeline);
+    }
 
-static void Render(Pipeline* pPipeline)
-{
     // Record all the commands we need to render the scene into the command list.
+    const UINT64 populateTicks = BeginTelemetryMarker(pPipeline, TelemetryMarker::Populate);
     PopulateCommandList(pPipeline);
+    EndTelemetryMarker(pPipeline, s_TelemetryMainThread, TelemetryMarker::Populate, populateTicks);
+
+    BeginAsyncWork(pPipeline);
+
+    // Execute all command lists of the frame in a single batch.
+    ID3D12CommandList* ppCommandLists[s_MaxRecordThreadCount + 2];
+    UINT cmdListCount = 0;
+
+    ppCommandLists[cmdListCount++] = pPipeline->cmdList.Get();
+    if (multiThreaded)
+    {
+        const UINT64 waitTicks = BeginTelemetryMarker(pPipeline, TelemetryMarker::RecordWait);
+        cmdListCount += FinishRecordThreads(pPipeline, &ppCommandLists[cmdListCount]);
+        EndTelemetryMarker(pPipeline, s_TelemetryMainThread, TelemetryMarker::RecordWait, waitTicks);
+        ppCommandLists[cmdListCount++] = pPipeline->postCmdList.Get();
+    }
+    else if (pPipeline->recordCache.mode == RecordMode::Reuse)
+    {
+        ppCommandLists[cmdListCount++] = GetRecordCacheList(pPipeline);
+        ppCommandLists[cmdListCount++] = pPipeline->postCmdList.Get();
+    }
+
+    EndUploadFrame(pPipeline);
+
+    const UINT64 executeTicks = BeginTelemetryMarker(pPipeline, TelemetryMarker::ExecuteCommandLists);
+    pPipeline->cmdQueue->ExecuteCommandLists(cmdListCount, ppCommandLists);
+    EndTelemetryMarker(pPipeline, s_TelemetryMainThread, TelemetryMarker::ExecuteCommandLists, executeTicks);
+
+    EndAsyncWork(pPipeline);
+
+    const UINT64 cpuTicks = GetCpuTicks() - frameStartTicks;
+    pPipeline->frameResources[pPipeline->frameResourceIndex].cpuTicks = cpuTicks;
+    pPipeline->frameResources[pPipeline->frameResourceIndex].drawCount = pPipeline->frameDrawCount;
+
+    return cpuTicks;
+}
+
+static void Render(Pipeline* pPipeline)
+{
+    WaitForLoadPeriod(pPipeline);
+    WaitForPresentLatency(pPipeline);
+
+    const UINT64 cpuTicks = SubmitFrame(pPipeline);
+
+    // Present the frame. Offscreen frames are done once submitted.
+    if (pPipeline->swapchain)
+    {
+        const UINT64 presentTicks = BeginTelemetryMarker(pPipeline, TelemetryMarker::Present);
+        PresentFrame(pPipeline);
+        EndTelemetryMarker(pPipeline, s_TelemetryMainThread, TelemetryMarker::Present, presentTicks);
+    }
+
+    MoveToNextFrame(pPipeline);
+
+    UpdateFrameStats(pPipeline, cpuTicks);
+}
+
+// Read back and report every frame still in flight, oldest first. The GPU
+// must be idle.
+static void ReadInFlightFrameResults(Pipeline* pPipeline)
+{
+    for (UINT i = 1; i <= pPipeline->options.frameCount; ++i)
+    {
+        ReadFrameResults(pPipeline, (pPipeline->frameResourceIndex + i) % pPipeline->options.frameCount);
+    }
+}
+
+UINT64 RenderFrames(Pipeline* pPipeline, UINT frameCount)
+{
+    pPipeline->renderingSweepFrames = true;
+
+    UINT64 cpuTicks = 0;
+    for (UINT i = 0; i < frameCount; ++i)
+    {
+        cpuTicks += SubmitFrame(pPipeline);
+        MoveToNextFrame(pPipeline);
+    }
+
+    WaitForGpu(pPipeline);
+    ReadInFlightFrameResults(pPipeline);
+
+    pPipeline->renderingSweepFrames = false;
+    ResetGpuPassTimings(pPipeline);
+
+    return cpuTicks;
+}
+
+// Whether `Options::exitFrameCount` frames or `Options::exitSeconds` have
+// passed since the first frame.
+static bool IsRunFinished(Pipeline* pPipeline)
+{
+    const Options& options = pPipeline->options;
+
+    if (options.exitFrameCount > 0 && pPipeline->frameNumber >= options.exitFrameCount)
+    {
+        return true;
+    }
+
+    if (options.exitSeconds > 0.0)
+    {
+        const double runMs = CpuTicksToMs(GetCpuTicks() - pPipeline->runStartTicks);
+        if (runMs >= options.exitSeconds * 1000.0)
+        {
+            return true;
+        }
+    }
 
-    // Execute the command list.
-    ID3D12CommandList* ppCommandLists[] = { pPipeline->cmdList.Get() };
-    pPipeline->cmdQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    return false;
+}
+
+// Workloads that measure throughput in isolation before the frame loop.
+static void RunSweeps(Pipeline* pPipeline)
+{
+    if (pPipeline->options.workload == Workload::DrawStorm)
+    {
+        RunUploadSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::FillRate)
+    {
+        RunFillRateSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Bandwidth)
+    {
+        RunBandwidthSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::WaveOps)
+    {
+        RunWaveOpsSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Geometry)
+    {
+        RunGeometrySweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Residency)
+    {
+        RunResidencySweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Bindless)
+    {
+        RunBindlessSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Sampling)
+    {
+        RunSamplingSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Fault)
+    {
+        RunFaultSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Indirect)
+    {
+        RunIndirectSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Transfer)
+    {
+        RunTransferSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Barriers)
+    {
+        RunBarriersSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Raytracing)
+    {
+        RunRaytracingSweep(pPipeline);
+    }
+    else if (pPipeline->options.workload == Workload::Alu)
+    {
+        RunAluSweep(pPipeline);
+    }
 
-    // Present the frame.
-    ThrowIfFailed(pPipeline->swapchain->Present(1, 0));
+    if (pPipeline->options.recordMode != RecordMode::Record && pPipeline->recordCache.supported)
+    {
+        RunRecordCacheSweep(pPipeline);
+    }
 
-    WaitForPreviousFrame(pPipeline);
+    if (pPipeline->options.asyncCompute || pPipeline->options.asyncCopy)
+    {
+        RunAsyncComputeSweep(pPipeline);
+    }
 }
 
 static void Destroy(Pipeline* pPipeline)
 {
-    WaitForPreviousFrame(pPipeline);
+    // A removed device signals nothing anymore, and the frames in flight have
+    // no results to read.
+    if (pPipeline->fence && SUCCEEDED(pPipeline->device->GetDeviceRemovedReason()))
+    {
+        WaitForGpu(pPipeline);
+        ReadInFlightFrameResults(pPipeline);
+    }
+
+    DestroySoak(pPipeline);
+    DestroyPresentLatency(pPipeline);
+    // The workers and the telemetry thread may still write to the report.
+    DestroyRecordThreads(pPipeline);
+    DestroyTelemetry(pPipeline);
+    CloseReport(pPipeline);
+    DestroyLoadController(pPipeline);
+    DestroyTransfer(pPipeline);
     CloseHandle(pPipeline->fenceEvent);
     free(pPipeline->pConstBufferData);
 }
 
+// The HRESULT behind an exception, E_FAIL for those not from ThrowIfFailed().
+static HRESULT GetExceptionResult(const std::exception& e)
+{
+    const HResultException* pHResultException = dynamic_cast<const HResultException*>(&e);
+    return (pHResultException != nullptr) ? pHResultException->hr : E_FAIL;
+}
+
+// Log and report the error a run stopped on. After a TDR every call fails
+// with DXGI_ERROR_DEVICE_REMOVED, so the removed reason is what tells a hang
+// from a driver crash.
+static void LogRunFailure(Pipeline* pPipeline, HRESULT hr)
+{
+    const HRESULT removedReason =
+        pPipeline->device ? pPipeline->device->GetDeviceRemovedReason() : S_OK;
+
+    LogMessage(
+        "adapter %u: failed at frame %llu with 0x%08x\n",
+        pPipeline->options.adapterIndex,
+        pPipeline->frameNumber,
+        (UINT)hr);
+
+    if (FAILED(removedReason))
+    {
+        LogMessage(
+            "adapter %u: device removed, reason %s (0x%08x)\n",
+            pPipeline->options.adapterIndex,
+            GetDeviceRemovedReasonName(removedReason),
+            (UINT)removedReason);
+    }
+
+    ReportFailure(pPipeline, hr, removedReason);
+}
+
+// Load the pipeline, run its sweeps and frames until IsRunFinished(), and
+// tear it down. Returns false, once the failure is logged, if anything threw
+// on the way.
+static bool RunPipeline(Pipeline* pPipeline)
+{
+    bool succeeded = true;
+
+    try
+    {
+        LoadPipeline(pPipeline, nullptr);
+        LoadAssets(pPipeline);
+        RunSweeps(pPipeline);
+
+        pPipeline->runStartTicks = GetCpuTicks();
+        while (!IsRunFinished(pPipeline))
+        {
+            Render(pPipeline);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        LogRunFailure(pPipeline, GetExceptionResult(e));
+        succeeded = false;
+    }
+
+    Destroy(pPipeline);
+
+    return succeeded;
+}
+
+// Insert `.<suffix>` before the extension of `path`, so every adapter or
+// scenario phase writes its own report.
+static void GetSuffixedReportPath(const char* path, const char* suffix, char* pResult, size_t resultSize)
+{
+    const char* fileName = path;
+    for (const char* c = path; *c != '\0'; ++c)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            fileName = c + 1;
+        }
+    }
+
+    const char* extension = strrchr(fileName, '.');
+    if (extension == nullptr)
+    {
+        extension = path + strlen(path);
+    }
+
+    snprintf(
+        pResult,
+        resultSize,
+        "%.*s.%s%s",
+        (int)(extension - path),
+        path,
+        suffix,
+        extension);
+}
+
+// Run the phases of `Options::scenarioPath` back to back. The device and
+// queue are created once; everything else, down to the frame resources, is
+// rebuilt per phase from the phase's options. Shaders and PSOs come from
+// their caches after the first phase that uses them. A failed phase ends the
+// scenario, as the device is likely gone. Returns the process exit code.
+static int RunScenario(Pipeline* pPipeline)
+{
+    // Too big for the stack.
+    Scenario* pScenario = new Scenario();
+    if (!LoadScenario(pPipeline->options.scenarioPath, pPipeline->options, pScenario))
+    {
+        delete pScenario;
+        return 1;
+    }
+
+    try
+    {
+        CreateDevice(pPipeline);
+    }
+    catch (const std::exception& e)
+    {
+        LogRunFailure(pPipeline, GetExceptionResult(e));
+        FreeScenario(pScenario);
+        delete pScenario;
+        return 1;
+    }
+
+    int result = 0;
+    for (UINT i = 0; i < pScenario->phaseCount; ++i)
+    {
+        const ScenarioPhase& phase = pScenario->phases[i];
+        LogMessage(
+            "adapter %u: scenario phase %u of %u, %s: %s\n",
+            pPipeline->options.adapterIndex,
+            i + 1,
+            pScenario->phaseCount,
+            phase.name,
+            GetWorkloadName(phase.options.workload));
+
+        Pipeline* pPhase = new Pipeline();
+        pPhase->options = phase.options;
+        pPhase->dxgiFactory = pPipeline->dxgiFactory;
+        pPhase->adapter = pPipeline->adapter;
+        pPhase->adapterDesc = pPipeline->adapterDesc;
+        pPhase->device = pPipeline->device;
+        pPhase->rootSignatureVersion = pPipeline->rootSignatureVersion;
+        pPhase->cmdQueue = pPipeline->cmdQueue;
+
+        char reportPath[MAX_PATH];
+        if (phase.options.reportPath != nullptr)
+        {
+            GetSuffixedReportPath(phase.options.reportPath, phase.name, reportPath, sizeof(reportPath));
+            pPhase->options.reportPath = reportPath;
+        }
+
+        const bool succeeded = RunPipeline(pPhase);
+        delete pPhase;
+
+        if (!succeeded)
+        {
+            result = 1;
+            break;
+        }
+    }
+
+    FreeScenario(pScenario);
+    delete pScenario;
+
+    return result;
+}
+
+// Frame loop without a window. Runs until IsRunFinished(), or through every
+// phase of a scenario. Returns the process exit code.
+static int RunHeadless(Pipeline* pPipeline)
+{
+    if (pPipeline->options.scenarioPath != nullptr)
+    {
+        return RunScenario(pPipeline);
+    }
+
+    return RunPipeline(pPipeline) ? 0 : 1;
+}
+
+// One independent pipeline per adapter with `-all-adapters`.
+struct AdapterRun
+{
+    Pipeline pipeline;
+    HANDLE thread;
+    // Per-adapter report, derived from `Options::reportPath`.
+    char reportPath[MAX_PATH];
+};
+
+static DWORD WINAPI AdapterThreadProc(void* pParam)
+{
+    AdapterRun* pRun = (AdapterRun*)pParam;
+
+    // Keep the other adapters going if this one fails. Failures past device
+    // creation are logged by RunPipeline().
+    try
+    {
+        return (DWORD)RunHeadless(&pRun->pipeline);
+    }
+    catch (const std::exception& e)
+    {
+        LogRunFailure(&pRun->pipeline, GetExceptionResult(e));
+        return 1;
+    }
+}
+
+// Stress every adapter at the same time, so they contend for PCIe and power
+// like they do in production.
+static int RunAllAdapters(const Options& options)
+{
+    ComPtr<IDXGIFactory4> dxgiFactory;
+    ThrowIfFailed(CreateDXGIFactory2(0, IID_PPV_ARGS(&dxgiFactory)));
+
+    ComPtr<IDXGIAdapter1> adapters[s_MaxAdapterCount];
+    const UINT adapterCount = EnumD3D12HardwareAdapters(dxgiFactory.Get(), adapters, s_MaxAdapterCount);
+    if (adapterCount == 0)
+    {
+        LogMessage("-all-adapters: no D3D12 hardware adapters\n");
+        return 1;
+    }
+
+    // Too big for the stack.
+    AdapterRun* pRuns = new AdapterRun[adapterCount]();
+    HANDLE threads[s_MaxAdapterCount] = {};
+
+    int result = 0;
+    UINT threadCount = 0;
+    for (UINT i = 0; i < adapterCount; ++i)
+    {
+        AdapterRun* pRun = &pRuns[i];
+        pRun->pipeline.options = options;
+        pRun->pipeline.options.adapterIndex = i;
+        pRun->pipeline.options.adapterLuid = 0;
+
+        if (options.reportPath != nullptr)
+        {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), "adapter%u", i);
+            GetSuffixedReportPath(options.reportPath, suffix, pRun->reportPath, sizeof(pRun->reportPath));
+            pRun->pipeline.options.reportPath = pRun->reportPath;
+        }
+
+        pRun->thread = CreateThread(nullptr, 0, AdapterThreadProc, pRun, 0, nullptr);
+        if (pRun->thread == nullptr)
+        {
+            LogMessage("adapter %u: creating the thread failed with %u\n", i, GetLastError());
+            result = 1;
+            break;
+        }
+        threads[threadCount++] = pRun->thread;
+    }
+
+    // The runs already started use `pRuns` until they finish, so they are
+    // waited for even if the rest could not start.
+    if (threadCount > 0 &&
+        WaitForMultipleObjects(threadCount, threads, TRUE, INFINITE) == WAIT_FAILED)
+    {
+        // Threads may still be running on `pRuns`; leave it to the process
+        // exit.
+        LogMessage("-all-adapters: waiting for the adapter threads failed with %u\n", GetLastError());
+        return 1;
+    }
+
+    for (UINT i = 0; i < threadCount; ++i)
+    {
+        DWORD exitCode = 1;
+        GetExitCodeThread(threads[i], &exitCode);
+        result |= (int)exitCode;
+
+        CloseHandle(threads[i]);
+    }
+
+    delete[] pRuns;
+
+    return result;
+}
+
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nShowCmd)
 {
     int result = 0;
 
+    Pipeline pipeline = {};
+    ParseOptions(__argc, __argv, &pipeline.options);
+    InitShaders(pipeline.options.shaderDirectory);
+
+    if (pipeline.options.listAdapters)
+    {
+        // A WIN32 subsystem exe has no console of its own; print to the one
+        // it was started from, if any.
+        if (AttachConsole(ATTACH_PARENT_PROCESS))
+        {
+            FILE* pStdout = nullptr;
+            freopen_s(&pStdout, "CONOUT$", "w", stdout);
+        }
+
+        ComPtr<IDXGIFactory4> dxgiFactory;
+        ThrowIfFailed(CreateDXGIFactory2(0, IID_PPV_ARGS(&dxgiFactory)));
+        PrintD3D12HardwareAdapters(dxgiFactory.Get());
+
+        return result;
+    }
+
+    if (pipeline.options.allAdapters)
+    {
+        return RunAllAdapters(pipeline.options);
+    }
+
+    // Render nodes may have no desktop at all; drive the frames directly.
+    // Scenarios always run headless.
+    if (pipeline.options.headless || pipeline.options.scenarioPath != nullptr)
+    {
+        return RunHeadless(&pipeline);
+    }
+
     WNDCLASSEXA windowClass = {};
     windowClass.cbSize = sizeof(WNDCLASSEX);
     windowClass.style = CS_HREDRAW | CS_VREDRAW;
@@ -600,11 +1481,9 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nS
     windowClass.lpszClassName = "GPU Trasher";
     RegisterClassExA(&windowClass);
 
-    RECT windowRect = { 0, 0, s_RenderWidth, s_RenderHeight };
+    RECT windowRect = { 0, 0, (LONG)pipeline.options.width, (LONG)pipeline.options.height };
     AdjustWindowRect(&windowRect, WS_OVERLAPPEDWINDOW, FALSE);
 
-    Pipeline pipeline = {};
-
     HWND hwnd = CreateWindowA(
         windowClass.lpszClassName,
         "GPU Trasher",
@@ -620,11 +1499,23 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nS
 
     if (hwnd != NULL)
     {
-
-        LoadPipeline(&pipeline, hwnd);
-        LoadAssets(&pipeline);
+        // Same as RunPipeline(); past this point WM_PAINT catches its own.
+        try
+        {
+            LoadPipeline(&pipeline, hwnd);
+            LoadAssets(&pipeline);
+            RunSweeps(&pipeline);
+        }
+        catch (const std::exception& e)
+        {
+            LogRunFailure(&pipeline, GetExceptionResult(e));
+            Destroy(&pipeline);
+            DestroyWindow(hwnd);
+            return 1;
+        }
 
         ShowWindow(hwnd, nShowCmd);
+        pipeline.runStartTicks = GetCpuTicks();
 
         MSG msg = {};
         while (msg.message != WM_QUIT)
@@ -661,7 +1552,22 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARA
 
     case WM_PAINT:
     {
-        Render(pPipeline);
+        // Exceptions must not unwind through the window manager.
+        try
+        {
+            Render(pPipeline);
+        }
+        catch (const std::exception& e)
+        {
+            LogRunFailure(pPipeline, GetExceptionResult(e));
+            PostQuitMessage(1);
+            return 0;
+        }
+
+        if (IsRunFinished(pPipeline))
+        {
+            DestroyWindow(hwnd);
+        }
         return 0;
     } break;
 
@@ -7,6 +7,18 @@ cbuffer ConstBuffer : register(b0)
     float4 colors[4096];
 };
 
+// Per-draw constants, set as root constants.
+cbuffer DrawConstants : register(b1)
+{
+    float4 drawOffset;
+};
+
+// Per-draw constants, uploaded every draw through a root CBV.
+cbuffer DrawData : register(b2)
+{
+    float4 drawColor;
+};
+
 struct PSInput
 {
     float4 position : SV_POSITION;
@@ -17,10 +29,10 @@ PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
 {
     PSInput result;
 
-    result.position = position;
+    result.position = position + float4(drawOffset.xy, 0.0f, 0.0f);
     result.color = color;
     int colorIndex = (int)colors[0].x;
-    result.color = colors[colorIndex];
+    result.color = colors[colorIndex] * drawColor;
 
     return result;
 }
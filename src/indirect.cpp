@@ -0,0 +1,455 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "indirect.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+#include <math.h>
+
+using namespace DirectX;
+
+// Draw counts of the sweep. The argument buffer holds the largest.
+static const UINT s_IndirectSweepDrawCounts[] = { 1024, 16384, 131072 };
+
+static const UINT s_IndirectThreadGroupSize = 64;
+
+// Objects are the size of a draw storm triangle.
+static const float s_IndirectHalfSize = 1.0f / (float)s_DrawStormGridSize;
+
+// Root parameter slots of `Indirect::cullRootSignature`.
+static const UINT s_IndirectRootParamConstants = 0;
+static const UINT s_IndirectRootParamArguments = 1;
+static const UINT s_IndirectRootParamCountBuffer = 2;
+static const UINT s_IndirectRootParamCount = 3;
+
+// Matches `IndirectConstants` in indirect.hlsl.
+struct IndirectConstants
+{
+    UINT objectCount;
+    UINT seed;
+    float extent;
+    float halfSize;
+};
+
+// One command of `Indirect::commandSignature`, matches `DrawArguments` in
+// indirect.hlsl.
+struct IndirectArguments
+{
+    DrawConstants constants;
+    D3D12_DRAW_ARGUMENTS draw;
+};
+
+enum class IndirectMode
+{
+    // A root constants update and a draw per object, recorded on the CPU.
+    Direct,
+    // ExecuteIndirect() of every object's arguments.
+    Execute,
+    // ExecuteIndirect() up to the count the cull pass wrote.
+    ExecuteCount,
+    // The cull pass alone.
+    Cull,
+};
+
+void CreateIndirectPipelineStates(Pipeline* pPipeline)
+{
+    Indirect* pIndirect = &pPipeline->indirect;
+
+    // Create the cull root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_IndirectRootParamCount] = {};
+
+        rootParameters[s_IndirectRootParamConstants].InitAsConstants(sizeof(IndirectConstants) / 4, 0);
+        rootParameters[s_IndirectRootParamArguments].InitAsUnorderedAccessView(0);
+        rootParameters[s_IndirectRootParamCountBuffer].InitAsUnorderedAccessView(1);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pIndirect->cullRootSignature);
+    }
+
+    ComPtr<ID3DBlob> clearShader;
+    ComPtr<ID3DBlob> cullShader;
+    CompileShader(L"indirect.hlsl", "CSClear", "cs_5_1", nullptr, &clearShader);
+    CompileShader(L"indirect.hlsl", "CSCull", "cs_5_1", nullptr, &cullShader);
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = pIndirect->cullRootSignature.Get();
+    psoDesc.CS = CD3DX12_SHADER_BYTECODE(clearShader.Get());
+    CreateComputePipelineState(pPipeline, L"indirect-clear", psoDesc, &pIndirect->clearPipelineState);
+
+    psoDesc.CS = CD3DX12_SHADER_BYTECODE(cullShader.Get());
+    CreateComputePipelineState(pPipeline, L"indirect-cull", psoDesc, &pIndirect->cullPipelineState);
+
+    // Each command sets the draw's offset, as the draw storm does with root
+    // constants, then draws.
+    D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[2] = {};
+    argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    argumentDescs[0].Constant.RootParameterIndex = s_RootParamDrawConstants;
+    argumentDescs[0].Constant.DestOffsetIn32BitValues = 0;
+    argumentDescs[0].Constant.Num32BitValuesToSet = sizeof(DrawConstants) / 4;
+    argumentDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+    D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+    signatureDesc.ByteStride = sizeof(IndirectArguments);
+    signatureDesc.NumArgumentDescs = _countof(argumentDescs);
+    signatureDesc.pArgumentDescs = argumentDescs;
+    ThrowIfFailed(pPipeline->device->CreateCommandSignature(
+        &signatureDesc,
+        pPipeline->rootSignature.Get(),
+        IID_PPV_ARGS(&pIndirect->commandSignature)));
+}
+
+void CreateIndirectResources(Pipeline* pPipeline)
+{
+    Indirect* pIndirect = &pPipeline->indirect;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    pIndirect->maxDrawCount = max(
+        pPipeline->options.drawCount,
+        s_IndirectSweepDrawCounts[_countof(s_IndirectSweepDrawCounts) - 1]);
+
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC argumentDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)pIndirect->maxDrawCount * sizeof(IndirectArguments),
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &argumentDesc,
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+        nullptr,
+        IID_PPV_ARGS(&pIndirect->argumentBuffer)));
+
+    CD3DX12_RESOURCE_DESC countDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &countDesc,
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+        nullptr,
+        IID_PPV_ARGS(&pIndirect->countBuffer)));
+
+    // The draw storm's triangle, centered so the offset places it.
+    const Vertex vertices[] =
+    {
+        { { 0.0f, s_IndirectHalfSize, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+        { { s_IndirectHalfSize, -s_IndirectHalfSize, 0.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+        { { -s_IndirectHalfSize, -s_IndirectHalfSize, 0.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } },
+    };
+    const UINT vertexBufferSize = sizeof(vertices);
+
+    // Same as the main vertex buffer, an upload heap keeps this simple and
+    // the data is tiny.
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pIndirect->vertexBuffer)));
+
+    UINT8* pVertexData;
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pIndirect->vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexData)));
+    memcpy(pVertexData, vertices, vertexBufferSize);
+    pIndirect->vertexBuffer->Unmap(0, nullptr);
+
+    pIndirect->vertexBufferView.BufferLocation = pIndirect->vertexBuffer->GetGPUVirtualAddress();
+    pIndirect->vertexBufferView.StrideInBytes = sizeof(Vertex);
+    pIndirect->vertexBufferView.SizeInBytes = vertexBufferSize;
+}
+
+// Transition the argument and count buffers between the cull pass writing
+// them and ExecuteIndirect() reading them.
+static void TransitionIndirectBuffers(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    D3D12_RESOURCE_STATES before,
+    D3D12_RESOURCE_STATES after)
+{
+    Indirect* pIndirect = &pPipeline->indirect;
+
+    CD3DX12_RESOURCE_BARRIER barriers[] =
+    {
+        CD3DX12_RESOURCE_BARRIER::Transition(pIndirect->argumentBuffer.Get(), before, after),
+        CD3DX12_RESOURCE_BARRIER::Transition(pIndirect->countBuffer.Get(), before, after),
+    };
+    pCmdList->ResourceBarrier(_countof(barriers), barriers);
+}
+
+// Record the cull pass of `objectCount` objects spread over
+// [-extent, extent]. Expects the buffers writable and leaves the compute
+// root signature and the cull PSO bound.
+static void RecordIndirectCull(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT objectCount,
+    float extent,
+    UINT seed)
+{
+    Indirect* pIndirect = &pPipeline->indirect;
+
+    IndirectConstants constants = {};
+    constants.objectCount = objectCount;
+    constants.seed = seed;
+    constants.extent = extent;
+    constants.halfSize = s_IndirectHalfSize;
+
+    pCmdList->SetComputeRootSignature(pIndirect->cullRootSignature.Get());
+    pCmdList->SetComputeRoot32BitConstants(s_IndirectRootParamConstants, sizeof(constants) / 4, &constants, 0);
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_IndirectRootParamArguments,
+        pIndirect->argumentBuffer->GetGPUVirtualAddress());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_IndirectRootParamCountBuffer,
+        pIndirect->countBuffer->GetGPUVirtualAddress());
+
+    pCmdList->SetPipelineState(pIndirect->clearPipelineState.Get());
+    pCmdList->Dispatch(1, 1, 1);
+
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(pIndirect->countBuffer.Get());
+    pCmdList->ResourceBarrier(1, &barrier);
+
+    pCmdList->SetPipelineState(pIndirect->cullPipelineState.Get());
+    pCmdList->Dispatch((objectCount + s_IndirectThreadGroupSize - 1) / s_IndirectThreadGroupSize, 1, 1);
+}
+
+// Cull, from and back to the indirect argument state.
+static void RecordIndirectCullPass(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT objectCount,
+    float extent,
+    UINT seed)
+{
+    TransitionIndirectBuffers(
+        pPipeline,
+        pCmdList,
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    RecordIndirectCull(pPipeline, pCmdList, objectCount, extent, seed);
+    TransitionIndirectBuffers(
+        pPipeline,
+        pCmdList,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
+
+// Restore the main PSO the cull pass replaced and bind the triangle.
+static void SetIndirectDrawState(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    pCmdList->SetPipelineState(pPipeline->pipelineState.Get());
+    pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCmdList->IASetVertexBuffers(0, 1, &pPipeline->indirect.vertexBufferView);
+}
+
+void RecordIndirect(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    UNREFERENCED_PARAMETER(drawCount);
+
+    if (firstDraw != 0)
+    {
+        return;
+    }
+
+    Indirect* pIndirect = &pPipeline->indirect;
+    const UINT objectCount = pPipeline->frameDrawCount;
+
+    // The screen is a 2x2 square in clip space; spreading the objects over
+    // a square 1/sqrt(percent) times wider leaves that share of them on it.
+    const float extent = sqrtf(100.0f / (float)pPipeline->options.indirectVisiblePercent);
+
+    RecordIndirectCullPass(pPipeline, pCmdList, objectCount, extent, (UINT)pPipeline->frameNumber);
+
+    // The graphics root signature and parameters the frame set are untouched
+    // by the cull pass.
+    SetIndirectDrawState(pPipeline, pCmdList);
+    pCmdList->ExecuteIndirect(
+        pIndirect->commandSignature.Get(),
+        objectCount,
+        pIndirect->argumentBuffer.Get(),
+        0,
+        pIndirect->countBuffer.Get(),
+        0);
+}
+
+// Offset of direct draw `draw`, on a grid like the draw storm's.
+static DrawConstants GetIndirectDirectConstants(UINT draw)
+{
+    const float cellSize = 2.0f / (float)s_DrawStormGridSize;
+    const UINT x = draw % s_DrawStormGridSize;
+    const UINT y = (draw / s_DrawStormGridSize) % s_DrawStormGridSize;
+
+    DrawConstants constants = {};
+    constants.offset = XMFLOAT4(
+        -1.0f + cellSize * ((float)x + 0.5f),
+        -1.0f + cellSize * ((float)y + 0.5f),
+        0.0f,
+        0.0f);
+    return constants;
+}
+
+// Time `drawCount` draws in `mode` and log and report them, direct draws'
+// CPU recording time too.
+static void RunIndirectCase(
+    Pipeline* pPipeline,
+    ID3D12CommandAllocator* pCmdAlloc,
+    ID3D12GraphicsCommandList* pCmdList,
+    IndirectMode mode,
+    UINT drawCount,
+    const char* name)
+{
+    Indirect* pIndirect = &pPipeline->indirect;
+    ID3D12Resource* pRenderTarget = pPipeline->renderTargets[pPipeline->backBufferIndex].Get();
+
+    ThrowIfFailed(pCmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pCmdAlloc, pPipeline->pipelineState.Get()));
+
+    // Draw into the current back buffer, it isn't presented before the frame
+    // loop renders over it.
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_PRESENT,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+        pCmdList->ResourceBarrier(1, &barrier);
+    }
+
+    SetDrawState(pPipeline, pCmdList);
+
+    // Every object on screen, so all modes draw `drawCount` triangles. The
+    // cull is only timed on its own.
+    const float extent = 1.0f;
+    if (mode == IndirectMode::Execute || mode == IndirectMode::ExecuteCount)
+    {
+        RecordIndirectCullPass(pPipeline, pCmdList, drawCount, extent, 0);
+    }
+    SetIndirectDrawState(pPipeline, pCmdList);
+
+    UINT64 recordTicks = 0;
+    BeginGpuMeasurement(pPipeline, pCmdList);
+    switch (mode)
+    {
+    case IndirectMode::Direct:
+    {
+        const UINT64 startTicks = GetCpuTicks();
+        for (UINT draw = 0; draw < drawCount; ++draw)
+        {
+            const DrawConstants constants = GetIndirectDirectConstants(draw);
+            pCmdList->SetGraphicsRoot32BitConstants(
+                s_RootParamDrawConstants,
+                sizeof(DrawConstants) / 4,
+                &constants,
+                0);
+            pCmdList->DrawInstanced(3, 1, 0, 0);
+        }
+        recordTicks = GetCpuTicks() - startTicks;
+        break;
+    }
+    case IndirectMode::Execute:
+        pCmdList->ExecuteIndirect(
+            pIndirect->commandSignature.Get(),
+            drawCount,
+            pIndirect->argumentBuffer.Get(),
+            0,
+            nullptr,
+            0);
+        break;
+    case IndirectMode::ExecuteCount:
+        pCmdList->ExecuteIndirect(
+            pIndirect->commandSignature.Get(),
+            drawCount,
+            pIndirect->argumentBuffer.Get(),
+            0,
+            pIndirect->countBuffer.Get(),
+            0);
+        break;
+    case IndirectMode::Cull:
+        RecordIndirectCullPass(pPipeline, pCmdList, drawCount, extent, 0);
+        break;
+    }
+    EndGpuMeasurement(pPipeline, pCmdList);
+
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PRESENT);
+        pCmdList->ResourceBarrier(1, &barrier);
+    }
+    ThrowIfFailed(pCmdList->Close());
+
+    const double elapsedMs = ExecuteTimedSweepList(pPipeline, pCmdList);
+
+    const double megaDrawsPerSecond = GetRate((double)drawCount, elapsedMs, 1.0e6);
+    const char* unit = (mode == IndirectMode::Cull) ? "Mobjects/s" : "Mdraws/s";
+
+    LogMessage("%s: %.2f %s (%.3f ms)\n", name, megaDrawsPerSecond, unit, elapsedMs);
+    ReportSweepResult(pPipeline, name, megaDrawsPerSecond, unit, elapsedMs);
+
+    // What the CPU pays to issue the draws, which ExecuteIndirect() moves
+    // to the GPU.
+    if (mode == IndirectMode::Direct)
+    {
+        const double recordMs = CpuTicksToMs(recordTicks);
+        const double megaRecordsPerSecond = GetRate((double)drawCount, recordMs, 1.0e6);
+
+        char recordName[128];
+        snprintf(recordName, sizeof(recordName), "%s record", name);
+        LogMessage("%s: %.2f Mdraws/s (%.3f ms CPU)\n", recordName, megaRecordsPerSecond, recordMs);
+        ReportSweepResult(pPipeline, recordName, megaRecordsPerSecond, "Mdraws/s", elapsedMs);
+    }
+}
+
+void RunIndirectSweep(Pipeline* pPipeline)
+{
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    static const struct
+    {
+        IndirectMode mode;
+        const char* name;
+    } s_Modes[] =
+    {
+        { IndirectMode::Direct, "direct" },
+        { IndirectMode::Execute, "execute" },
+        { IndirectMode::ExecuteCount, "execute-count" },
+        { IndirectMode::Cull, "cull" },
+    };
+
+    char name[128];
+    for (UINT drawCount : s_IndirectSweepDrawCounts)
+    {
+        for (const auto& mode : s_Modes)
+        {
+            snprintf(name, sizeof(name), "indirect %s %u", mode.name, drawCount);
+            RunIndirectCase(pPipeline, cmdAlloc.Get(), cmdList.Get(), mode.mode, drawCount, name);
+        }
+    }
+}
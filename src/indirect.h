@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// GPU-driven draws: `Options::drawCount` objects per frame are culled by a
+// compute pass, which writes the visible ones' draw arguments and their
+// count, see indirect.hlsl. A single ExecuteIndirect() then issues the
+// draws, each setting its offset root constants and drawing a triangle the
+// size of a draw storm one, with the main PSO.
+//
+// Only `Options::indirectVisiblePercent` of the objects land on screen, so
+// the count the GPU writes differs from the maximum the CPU passes.
+struct Indirect
+{
+    // Root constants at b0, the arguments and count as root UAVs at u0 and
+    // u1.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> cullRootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> clearPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> cullPipelineState;
+    // Draw offset root constants, then a draw, against the main root
+    // signature.
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature> commandSignature;
+
+    // Both live in the indirect argument state between cull passes.
+    Microsoft::WRL::ComPtr<ID3D12Resource> argumentBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> countBuffer;
+    UINT maxDrawCount;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+};
+
+// Create the cull root signature, PSOs and command signature. Requires the
+// main root signature.
+void CreateIndirectPipelineStates(Pipeline* pPipeline);
+
+// Create the argument, count and vertex buffers.
+void CreateIndirectResources(Pipeline* pPipeline);
+
+// Cull and draw every object of the frame. One dispatch and one
+// ExecuteIndirect() cover all draws, so only the range starting at draw 0
+// records anything; the other ranges' lists stay empty.
+void RecordIndirect(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time growing draw counts recorded directly on the CPU, as the draw storm
+// does, against ExecuteIndirect() with and without the GPU-written count,
+// and the cull pass itself, and log draws per second. The GPU must be idle;
+// returns with the GPU idle.
+void RunIndirectSweep(Pipeline* pPipeline);
@@ -0,0 +1,77 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// GPU culling for the indirect workload. Every object is a small triangle at
+// a hashed position; the visible ones append their draw's arguments, which
+// ExecuteIndirect() then draws up to the count in `drawCount`.
+
+cbuffer IndirectConstants : register(b0)
+{
+    uint objectCount;
+    // Changes every frame, so the objects move.
+    uint seed;
+    // Objects are spread over [-extent, extent] in clip space, of which
+    // [-1, 1] is on screen.
+    float extent;
+    // Half the size of an object's bounds.
+    float halfSize;
+};
+
+// Matches `IndirectArguments` in indirect.cpp: root constants for the
+// draw's offset, then D3D12_DRAW_ARGUMENTS.
+struct DrawArguments
+{
+    float4 offset;
+    uint vertexCountPerInstance;
+    uint instanceCount;
+    uint startVertexLocation;
+    uint startInstanceLocation;
+};
+
+RWStructuredBuffer<DrawArguments> arguments : register(u0);
+RWByteAddressBuffer drawCount : register(u1);
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+[numthreads(1, 1, 1)]
+void CSClear()
+{
+    drawCount.Store(0, 0);
+}
+
+[numthreads(64, 1, 1)]
+void CSCull(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint object = dispatchThreadId.x;
+    if (object >= objectCount)
+    {
+        return;
+    }
+
+    const uint h = Hash(object ^ Hash(seed));
+    const float2 position = (float2(h & 0xffff, h >> 16) / 65535.0f * 2.0f - 1.0f) * extent;
+
+    // Frustum test of the object's bounds against the clip-space square.
+    if (any(abs(position) > 1.0f + halfSize))
+    {
+        return;
+    }
+
+    uint slot;
+    drawCount.InterlockedAdd(0, 1, slot);
+
+    DrawArguments drawArguments;
+    drawArguments.offset = float4(position, 0.0f, 0.0f);
+    drawArguments.vertexCountPerInstance = 3;
+    drawArguments.instanceCount = 1;
+    drawArguments.startVertexLocation = 0;
+    drawArguments.startInstanceLocation = 0;
+    arguments[slot] = drawArguments;
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "load-controller.h"
+#include "pipeline.h"
+#include "utils.h"
+
+// Share of the way to the draw count that would have hit the target the
+// controller moves per frame. Frames already in flight still have the old
+// count, so going all the way overshoots.
+static const double s_LoadGain = 0.25;
+
+void CreateLoadController(Pipeline* pPipeline)
+{
+    LoadController* pLoad = &pPipeline->loadController;
+    const Options& options = pPipeline->options;
+
+    if (options.loadTargetPercent == 0 && options.loadTargetMs == 0.0)
+    {
+        return;
+    }
+
+    if (pPipeline->recordCache.mode != RecordMode::Record)
+    {
+        LogMessage("load: draws recorded once can't be scaled, no load control without -record-mode record\n");
+        return;
+    }
+
+    pLoad->paced = options.loadTargetPercent > 0;
+    pLoad->targetGpuMs = pLoad->paced ?
+        options.loadPeriodMs * options.loadTargetPercent / 100.0 : options.loadTargetMs;
+
+    // Ramp up from a fraction of the draws rather than swamp a shared GPU
+    // for the first frames.
+    pLoad->drawCount = max(options.drawCount / 16.0, 1.0);
+    pLoad->nextFrameTicks = 0;
+
+    if (pLoad->paced)
+    {
+        // Sleep() and plain timers round up to the scheduler tick, ~15 ms by
+        // default; the high resolution timer needs Windows 10 1803.
+        pLoad->timer = CreateWaitableTimerEx(
+            nullptr,
+            nullptr,
+            CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+            TIMER_ALL_ACCESS);
+        if (pLoad->timer == nullptr)
+        {
+            pLoad->timer = CreateWaitableTimer(nullptr, TRUE, nullptr);
+        }
+        if (pLoad->timer == nullptr)
+        {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
+    }
+
+    pLoad->enabled = true;
+
+    LogMessage(
+        "load: %.3f GPU ms/frame target%s\n",
+        pLoad->targetGpuMs,
+        pLoad->paced ? ", paced" : "");
+}
+
+UINT GetLoadDrawCount(Pipeline* pPipeline)
+{
+    LoadController* pLoad = &pPipeline->loadController;
+    const UINT drawCount = pPipeline->options.drawCount;
+
+    // Sweeps measure the options' draws.
+    if (!pLoad->enabled || pPipeline->renderingSweepFrames)
+    {
+        return drawCount;
+    }
+
+    return min((UINT)(pLoad->drawCount + 0.5), drawCount);
+}
+
+void WaitForLoadPeriod(Pipeline* pPipeline)
+{
+    LoadController* pLoad = &pPipeline->loadController;
+
+    if (!pLoad->enabled || !pLoad->paced)
+    {
+        return;
+    }
+
+    const double periodMs = pPipeline->options.loadPeriodMs;
+    const UINT64 nowTicks = GetCpuTicks();
+
+    // A frame late by a whole period restarts the schedule; catching up
+    // would burst frames back to back.
+    if (pLoad->nextFrameTicks == 0 ||
+        (nowTicks > pLoad->nextFrameTicks && CpuTicksToMs(nowTicks - pLoad->nextFrameTicks) >= periodMs))
+    {
+        pLoad->nextFrameTicks = nowTicks;
+    }
+    else if (nowTicks < pLoad->nextFrameTicks)
+    {
+        // Negative due times are relative, in 100 ns units.
+        LARGE_INTEGER dueTime = {};
+        dueTime.QuadPart = -(LONGLONG)(CpuTicksToMs(pLoad->nextFrameTicks - nowTicks) * 10000.0);
+        if (dueTime.QuadPart < 0 &&
+            SetWaitableTimer(pLoad->timer, &dueTime, 0, nullptr, nullptr, FALSE))
+        {
+            WaitForSingleObject(pLoad->timer, INFINITE);
+        }
+    }
+
+    // Advance by the period in ticks from the CPU timestamp frequency.
+    pLoad->nextFrameTicks += (UINT64)(periodMs / CpuTicksToMs(1));
+}
+
+void UpdateLoadController(Pipeline* pPipeline, UINT drawCount, double gpuMs)
+{
+    LoadController* pLoad = &pPipeline->loadController;
+
+    if (!pLoad->enabled)
+    {
+        return;
+    }
+
+    pLoad->windowFrameCount += 1;
+    pLoad->windowGpuMs += gpuMs;
+    pLoad->windowDrawCount += drawCount;
+
+    if (drawCount == 0 || gpuMs <= 0.0)
+    {
+        return;
+    }
+
+    // GPU time grows about linearly with the draws; the clear and other
+    // fixed costs only slow the convergence down.
+    const double targetDrawCount = drawCount * pLoad->targetGpuMs / gpuMs;
+    pLoad->drawCount += s_LoadGain * (targetDrawCount - pLoad->drawCount);
+    pLoad->drawCount = min(max(pLoad->drawCount, 1.0), (double)pPipeline->options.drawCount);
+}
+
+void LogLoadControllerStats(Pipeline* pPipeline, double windowMs)
+{
+    LoadController* pLoad = &pPipeline->loadController;
+
+    if (!pLoad->enabled || pLoad->windowFrameCount == 0)
+    {
+        return;
+    }
+
+    const double frameCount = (double)pLoad->windowFrameCount;
+    const double gpuMs = pLoad->windowGpuMs / frameCount;
+
+    // Pinned at either end, the target is out of reach of the draws.
+    const UINT drawCount = GetLoadDrawCount(pPipeline);
+    const char* limit = "";
+    if (drawCount == pPipeline->options.drawCount && gpuMs < pLoad->targetGpuMs)
+    {
+        limit = ", at -draw-count";
+    }
+    else if (drawCount <= 1 && gpuMs > pLoad->targetGpuMs)
+    {
+        limit = ", at one draw";
+    }
+
+    LogMessage(
+        "adapter %u: load %.0f draws/frame, %.3f of %.3f target GPU ms/frame, %.0f%% busy%s\n",
+        pPipeline->options.adapterIndex,
+        pLoad->windowDrawCount / frameCount,
+        gpuMs,
+        pLoad->targetGpuMs,
+        100.0 * pLoad->windowGpuMs / windowMs,
+        limit);
+
+    pLoad->windowFrameCount = 0;
+    pLoad->windowGpuMs = 0.0;
+    pLoad->windowDrawCount = 0;
+}
+
+void DestroyLoadController(Pipeline* pPipeline)
+{
+    LoadController* pLoad = &pPipeline->loadController;
+
+    if (pLoad->timer != nullptr)
+    {
+        CloseHandle(pLoad->timer);
+        pLoad->timer = nullptr;
+    }
+}
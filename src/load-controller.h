@@ -0,0 +1,60 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+
+struct Pipeline;
+
+// Closed-loop control of the frame loop's load, for running next to other
+// GPU tenants as a steady source of interference.
+//
+// Every frame's GPU time, from the frame's timestamps, is compared to a
+// target and the draws of the next frames scaled towards it, between one
+// and `Options::drawCount`. A draw is each workload's unit of work: a
+// triangle, a fill layer, a dispatch, a copy, a barrier round, and so on.
+//
+// With `Options::loadTargetPercent` frames start every
+// `Options::loadPeriodMs` and the target is that share of the period, so
+// the GPU idles for the rest: a utilization target. With
+// `Options::loadTargetMs` frames run back to back and the target is the GPU
+// time of a frame.
+struct LoadController
+{
+    bool enabled;
+    // Whether frames are started on `Options::loadPeriodMs` boundaries.
+    bool paced;
+    double targetGpuMs;
+
+    // Draws per frame the controller asks for; fractional so small
+    // corrections accumulate.
+    double drawCount;
+    // Start of the next paced frame.
+    UINT64 nextFrameTicks;
+    HANDLE timer;
+
+    // Since the last LogLoadControllerStats().
+    UINT64 windowFrameCount;
+    double windowGpuMs;
+    UINT64 windowDrawCount;
+};
+
+// Work out the target from the options. Does nothing unless they ask for
+// one; lists recorded once can't change their draws, so record modes other
+// than `RecordMode::Record` turn the controller off with a message.
+void CreateLoadController(Pipeline* pPipeline);
+
+// Draws of the frame about to be recorded.
+UINT GetLoadDrawCount(Pipeline* pPipeline);
+
+// Block until the next frame's period starts, when pacing. Call before
+// recording the frame.
+void WaitForLoadPeriod(Pipeline* pPipeline);
+
+// Steer by the GPU time of a frame that had `drawCount` draws, as read back.
+void UpdateLoadController(Pipeline* pPipeline, UINT drawCount, double gpuMs);
+
+// Log the draws, GPU time and utilization since the last call.
+void LogLoadControllerStats(Pipeline* pPipeline, double windowMs);
+
+void DestroyLoadController(Pipeline* pPipeline);
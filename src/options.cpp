@@ -0,0 +1,1041 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "options.h"
+#include <d3d12.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void ReportBadOption(const char* name, const char* value)
+{
+    char message[256];
+    snprintf(message, sizeof(message), "Ignoring option %s %s\n", name, value ? value : "");
+    OutputDebugStringA(message);
+}
+
+// Parse `value` as a non-negative number. `*pResult` is only written on success.
+static bool ParseDouble(const char* value, double* pResult)
+{
+    if (value == nullptr)
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    double result = strtod(value, &end);
+    if (end == value || *end != '\0' || !(result >= 0.0))
+    {
+        return false;
+    }
+
+    *pResult = result;
+    return true;
+}
+
+// Parse `value` as a 64-bit unsigned integer, decimal or 0x-prefixed hex.
+// `*pResult` is only written on success.
+static bool ParseUint64(const char* value, UINT64* pResult)
+{
+    if (value == nullptr)
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    UINT64 result = _strtoui64(value, &end, 0);
+    if (end == value || *end != '\0')
+    {
+        return false;
+    }
+
+    *pResult = result;
+    return true;
+}
+
+// Parse `value` as an unsigned integer within [minValue, maxValue]. `*pResult`
+// is only written on success.
+static bool ParseUint(const char* value, UINT minValue, UINT maxValue, UINT* pResult)
+{
+    if (value == nullptr)
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    unsigned long result = strtoul(value, &end, 0);
+    if (end == value || *end != '\0' || result < minValue || result > maxValue)
+    {
+        return false;
+    }
+
+    *pResult = (UINT)result;
+    return true;
+}
+
+static const char* s_WorkloadNames[s_WorkloadCount] =
+{
+    "triangle",
+    "draw-storm",
+    "fill-rate",
+    "bandwidth",
+    "wave-ops",
+    "geometry",
+    "residency",
+    "bindless",
+    "sampling",
+    "fault",
+    "indirect",
+    "transfer",
+    "barriers",
+    "raytracing",
+    "alu",
+};
+
+const char* GetWorkloadName(Workload workload)
+{
+    return s_WorkloadNames[(UINT)workload];
+}
+
+static bool ParseWorkload(const char* value, Workload* pWorkload)
+{
+    for (UINT i = 0; value != nullptr && i < s_WorkloadCount; ++i)
+    {
+        if (strcmp(value, s_WorkloadNames[i]) == 0)
+        {
+            *pWorkload = (Workload)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_BandwidthKernelNames[s_BandwidthKernelCount] =
+{
+    "copy",
+    "strided-read",
+    "random-gather",
+    "atomic",
+};
+
+const char* GetBandwidthKernelName(BandwidthKernel kernel)
+{
+    return s_BandwidthKernelNames[(UINT)kernel];
+}
+
+static bool ParseBandwidthKernel(const char* value, BandwidthKernel* pKernel)
+{
+    for (UINT i = 0; value != nullptr && i < s_BandwidthKernelCount; ++i)
+    {
+        if (strcmp(value, s_BandwidthKernelNames[i]) == 0)
+        {
+            *pKernel = (BandwidthKernel)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_WaveKernelNames[s_WaveKernelCount] =
+{
+    "active-sum",
+    "prefix-sum",
+    "read-lane-at",
+    "fma32",
+    "fma16",
+};
+
+const char* GetWaveKernelName(WaveKernel kernel)
+{
+    return s_WaveKernelNames[(UINT)kernel];
+}
+
+static bool ParseWaveKernel(const char* value, WaveKernel* pKernel)
+{
+    for (UINT i = 0; value != nullptr && i < s_WaveKernelCount; ++i)
+    {
+        if (strcmp(value, s_WaveKernelNames[i]) == 0)
+        {
+            *pKernel = (WaveKernel)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_GeometryPathNames[s_GeometryPathCount] =
+{
+    "ia",
+    "mesh",
+};
+
+const char* GetGeometryPathName(GeometryPath path)
+{
+    return s_GeometryPathNames[(UINT)path];
+}
+
+static bool ParseGeometryPath(const char* value, GeometryPath* pPath)
+{
+    for (UINT i = 0; value != nullptr && i < s_GeometryPathCount; ++i)
+    {
+        if (strcmp(value, s_GeometryPathNames[i]) == 0)
+        {
+            *pPath = (GeometryPath)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_SamplingFormatNames[s_SamplingFormatCount] =
+{
+    "rgba8",
+    "rgba16f",
+    "bc1",
+    "bc7",
+};
+
+const char* GetSamplingFormatName(SamplingFormat format)
+{
+    return s_SamplingFormatNames[(UINT)format];
+}
+
+static bool ParseSamplingFormat(const char* value, SamplingFormat* pFormat)
+{
+    for (UINT i = 0; value != nullptr && i < s_SamplingFormatCount; ++i)
+    {
+        if (strcmp(value, s_SamplingFormatNames[i]) == 0)
+        {
+            *pFormat = (SamplingFormat)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_SamplingDimensionNames[s_SamplingDimensionCount] =
+{
+    "2d",
+    "2d-array",
+    "3d",
+};
+
+const char* GetSamplingDimensionName(SamplingDimension dimension)
+{
+    return s_SamplingDimensionNames[(UINT)dimension];
+}
+
+static bool ParseSamplingDimension(const char* value, SamplingDimension* pDimension)
+{
+    for (UINT i = 0; value != nullptr && i < s_SamplingDimensionCount; ++i)
+    {
+        if (strcmp(value, s_SamplingDimensionNames[i]) == 0)
+        {
+            *pDimension = (SamplingDimension)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_SamplingFilterNames[s_SamplingFilterCount] =
+{
+    "point",
+    "bilinear",
+    "trilinear",
+    "anisotropic",
+};
+
+const char* GetSamplingFilterName(SamplingFilter filter)
+{
+    return s_SamplingFilterNames[(UINT)filter];
+}
+
+static bool ParseSamplingFilter(const char* value, SamplingFilter* pFilter)
+{
+    for (UINT i = 0; value != nullptr && i < s_SamplingFilterCount; ++i)
+    {
+        if (strcmp(value, s_SamplingFilterNames[i]) == 0)
+        {
+            *pFilter = (SamplingFilter)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_SamplingPatternNames[s_SamplingPatternCount] =
+{
+    "coherent",
+    "random",
+};
+
+const char* GetSamplingPatternName(SamplingPattern pattern)
+{
+    return s_SamplingPatternNames[(UINT)pattern];
+}
+
+static bool ParseSamplingPattern(const char* value, SamplingPattern* pPattern)
+{
+    for (UINT i = 0; value != nullptr && i < s_SamplingPatternCount; ++i)
+    {
+        if (strcmp(value, s_SamplingPatternNames[i]) == 0)
+        {
+            *pPattern = (SamplingPattern)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_FaultAccessNames[s_FaultAccessCount] =
+{
+    "cbv-read",
+    "srv-read",
+    "uav-read",
+    "uav-write",
+};
+
+const char* GetFaultAccessName(FaultAccess access)
+{
+    return s_FaultAccessNames[(UINT)access];
+}
+
+static bool ParseFaultAccess(const char* value, FaultAccess* pAccess)
+{
+    for (UINT i = 0; value != nullptr && i < s_FaultAccessCount; ++i)
+    {
+        if (strcmp(value, s_FaultAccessNames[i]) == 0)
+        {
+            *pAccess = (FaultAccess)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_FaultStageNames[s_FaultStageCount] =
+{
+    "vs",
+    "ps",
+    "cs",
+};
+
+const char* GetFaultStageName(FaultStage stage)
+{
+    return s_FaultStageNames[(UINT)stage];
+}
+
+static bool ParseFaultStage(const char* value, FaultStage* pStage)
+{
+    for (UINT i = 0; value != nullptr && i < s_FaultStageCount; ++i)
+    {
+        if (strcmp(value, s_FaultStageNames[i]) == 0)
+        {
+            *pStage = (FaultStage)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_FaultBindingNames[s_FaultBindingCount] =
+{
+    "table",
+    "root",
+};
+
+const char* GetFaultBindingName(FaultBinding binding)
+{
+    return s_FaultBindingNames[(UINT)binding];
+}
+
+static bool ParseFaultBinding(const char* value, FaultBinding* pBinding)
+{
+    for (UINT i = 0; value != nullptr && i < s_FaultBindingCount; ++i)
+    {
+        if (strcmp(value, s_FaultBindingNames[i]) == 0)
+        {
+            *pBinding = (FaultBinding)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_RecordModeNames[s_RecordModeCount] =
+{
+    "record",
+    "bundle",
+    "reuse",
+};
+
+const char* GetRecordModeName(RecordMode mode)
+{
+    return s_RecordModeNames[(UINT)mode];
+}
+
+static bool ParseRecordMode(const char* value, RecordMode* pMode)
+{
+    for (UINT i = 0; value != nullptr && i < s_RecordModeCount; ++i)
+    {
+        if (strcmp(value, s_RecordModeNames[i]) == 0)
+        {
+            *pMode = (RecordMode)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_BarrierModeNames[s_BarrierModeCount] =
+{
+    "none",
+    "single",
+    "batched",
+    "split",
+    "uav",
+    "aliasing",
+    "enhanced",
+};
+
+const char* GetBarrierModeName(BarrierMode mode)
+{
+    return s_BarrierModeNames[(UINT)mode];
+}
+
+static bool ParseBarrierMode(const char* value, BarrierMode* pMode)
+{
+    for (UINT i = 0; value != nullptr && i < s_BarrierModeCount; ++i)
+    {
+        if (strcmp(value, s_BarrierModeNames[i]) == 0)
+        {
+            *pMode = (BarrierMode)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_RaytracingModeNames[s_RaytracingModeCount] =
+{
+    "build",
+    "refit",
+    "dispatch-rays",
+    "ray-query",
+};
+
+const char* GetRaytracingModeName(RaytracingMode mode)
+{
+    return s_RaytracingModeNames[(UINT)mode];
+}
+
+static bool ParseRaytracingMode(const char* value, RaytracingMode* pMode)
+{
+    for (UINT i = 0; value != nullptr && i < s_RaytracingModeCount; ++i)
+    {
+        if (strcmp(value, s_RaytracingModeNames[i]) == 0)
+        {
+            *pMode = (RaytracingMode)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_AluOpNames[s_AluOpCount] =
+{
+    "fma",
+    "transcendental",
+    "integer",
+};
+
+const char* GetAluOpName(AluOp op)
+{
+    return s_AluOpNames[(UINT)op];
+}
+
+static bool ParseAluOp(const char* value, AluOp* pOp)
+{
+    for (UINT i = 0; value != nullptr && i < s_AluOpCount; ++i)
+    {
+        if (strcmp(value, s_AluOpNames[i]) == 0)
+        {
+            *pOp = (AluOp)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const char* s_AluStageNames[s_AluStageCount] =
+{
+    "compute",
+    "pixel",
+};
+
+const char* GetAluStageName(AluStage stage)
+{
+    return s_AluStageNames[(UINT)stage];
+}
+
+static bool ParseAluStage(const char* value, AluStage* pStage)
+{
+    for (UINT i = 0; value != nullptr && i < s_AluStageCount; ++i)
+    {
+        if (strcmp(value, s_AluStageNames[i]) == 0)
+        {
+            *pStage = (AluStage)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool IsAluRegisterCount(UINT registers)
+{
+    for (UINT count : s_AluRegisterCounts)
+    {
+        if (count == registers)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ParseReportFormat(const char* value, ReportFormat* pFormat)
+{
+    if (value == nullptr)
+    {
+        return false;
+    }
+
+    if (strcmp(value, "json") == 0)
+    {
+        *pFormat = ReportFormat::Json;
+    }
+    else if (strcmp(value, "csv") == 0)
+    {
+        *pFormat = ReportFormat::Csv;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options* pOptions)
+{
+    bool succeeded = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* name = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool valid = false;
+
+        // Switches, which take no value.
+        if (strcmp(name, "-headless") == 0)
+        {
+            pOptions->headless = true;
+            continue;
+        }
+        else if (strcmp(name, "-no-vsync") == 0)
+        {
+            pOptions->vsync = false;
+            continue;
+        }
+        else if (strcmp(name, "-tearing") == 0)
+        {
+            pOptions->tearing = true;
+            continue;
+        }
+        else if (strcmp(name, "-waitable-swapchain") == 0)
+        {
+            pOptions->waitableSwapchain = true;
+            continue;
+        }
+        else if (strcmp(name, "-fault-unbounded") == 0)
+        {
+            pOptions->faultUnbounded = true;
+            continue;
+        }
+        else if (strcmp(name, "-all-adapters") == 0)
+        {
+            pOptions->allAdapters = true;
+            pOptions->headless = true;
+            continue;
+        }
+        else if (strcmp(name, "-list-adapters") == 0)
+        {
+            pOptions->listAdapters = true;
+            continue;
+        }
+        else if (strcmp(name, "-async-compute") == 0)
+        {
+            pOptions->asyncCompute = true;
+            continue;
+        }
+        else if (strcmp(name, "-telemetry") == 0)
+        {
+            pOptions->telemetry = true;
+            continue;
+        }
+        else if (strcmp(name, "-async-copy") == 0)
+        {
+            pOptions->asyncCopy = true;
+            continue;
+        }
+        else if (strcmp(name, "-raytracing-incoherent") == 0)
+        {
+            pOptions->raytracingIncoherent = true;
+            continue;
+        }
+
+        if (strcmp(name, "-workload") == 0)
+        {
+            valid = ParseWorkload(value, &pOptions->workload);
+        }
+        else if (strcmp(name, "-adapter") == 0)
+        {
+            valid = ParseUint(value, 0, s_MaxAdapterCount - 1, &pOptions->adapterIndex);
+        }
+        else if (strcmp(name, "-adapter-luid") == 0)
+        {
+            valid = ParseUint64(value, &pOptions->adapterLuid);
+        }
+        else if (strcmp(name, "-width") == 0)
+        {
+            valid = ParseUint(value, 1, D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION, &pOptions->width);
+        }
+        else if (strcmp(name, "-height") == 0)
+        {
+            valid = ParseUint(value, 1, D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION, &pOptions->height);
+        }
+        else if (strcmp(name, "-frame-count") == 0)
+        {
+            valid = ParseUint(value, 1, s_MaxFrameCount, &pOptions->frameCount);
+        }
+        else if (strcmp(name, "-draw-count") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->drawCount);
+        }
+        else if (strcmp(name, "-record-threads") == 0)
+        {
+            valid = ParseUint(value, 0, s_MaxRecordThreadCount, &pOptions->recordThreadCount);
+        }
+        else if (strcmp(name, "-record-mode") == 0)
+        {
+            valid = ParseRecordMode(value, &pOptions->recordMode);
+        }
+        else if (strcmp(name, "-record-sweep-frames") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->recordSweepFrames);
+        }
+        else if (strcmp(name, "-root-constant-interval") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->rootConstantInterval);
+        }
+        else if (strcmp(name, "-table-interval") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->descriptorTableInterval);
+        }
+        else if (strcmp(name, "-pso-interval") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->psoInterval);
+        }
+        else if (strcmp(name, "-vb-interval") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->vertexBufferInterval);
+        }
+        else if (strcmp(name, "-root-cbv-interval") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->rootCbvInterval);
+        }
+        else if (strcmp(name, "-upload-bytes") == 0)
+        {
+            // Up to a whole constant buffer, in float4s. Parsed aside, so a
+            // rejected size doesn't reach the draws.
+            UINT bytes = 0;
+            valid = ParseUint(value, 16, 65536, &bytes) && bytes % 16 == 0;
+            if (valid)
+            {
+                pOptions->uploadBytesPerDraw = bytes;
+            }
+        }
+        else if (strcmp(name, "-upload-ring-mb") == 0)
+        {
+            valid = ParseUint(value, 1, 4096, &pOptions->uploadRingMB);
+        }
+        else if (strcmp(name, "-fill-layers") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->fillLayers);
+        }
+        else if (strcmp(name, "-fill-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->fillSweepIterations);
+        }
+        else if (strcmp(name, "-bandwidth-kernel") == 0)
+        {
+            valid = ParseBandwidthKernel(value, &pOptions->bandwidthKernel);
+        }
+        else if (strcmp(name, "-bandwidth-mb") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->bandwidthBufferMB);
+        }
+        else if (strcmp(name, "-bandwidth-stride") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->bandwidthStride);
+        }
+        else if (strcmp(name, "-bandwidth-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->bandwidthSweepIterations);
+        }
+        else if (strcmp(name, "-peak-bandwidth") == 0)
+        {
+            valid = ParseDouble(value, &pOptions->peakBandwidth);
+        }
+        else if (strcmp(name, "-wave-kernel") == 0)
+        {
+            valid = ParseWaveKernel(value, &pOptions->waveKernel);
+        }
+        else if (strcmp(name, "-wave-size") == 0)
+        {
+            // Powers of two, D3D12 allows 4 to 128 lanes.
+            // Parsed aside, so a rejected size doesn't reach the kernels.
+            UINT waveSize = 0;
+            valid = ParseUint(value, 0, 128, &waveSize) &&
+                (waveSize & (waveSize - 1)) == 0 &&
+                waveSize != 1 && waveSize != 2;
+            if (valid)
+            {
+                pOptions->waveSize = waveSize;
+            }
+        }
+        else if (strcmp(name, "-wave-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->waveIterations);
+        }
+        else if (strcmp(name, "-wave-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->waveSweepIterations);
+        }
+        else if (strcmp(name, "-geometry-triangles") == 0)
+        {
+            // Keeps both buffers under 2 GB, and the index count in 32 bits.
+            valid = ParseUint(value, 2, 32 * 1024 * 1024, &pOptions->geometryTriangles);
+        }
+        else if (strcmp(name, "-geometry-instances") == 0)
+        {
+            valid = ParseUint(value, 1, 1024, &pOptions->geometryInstances);
+        }
+        else if (strcmp(name, "-geometry-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->geometrySweepIterations);
+        }
+        else if (strcmp(name, "-geometry-path") == 0)
+        {
+            valid = ParseGeometryPath(value, &pOptions->geometryPath);
+        }
+        else if (strcmp(name, "-geometry-meshlet-vertices") == 0)
+        {
+            // A triangle's worth at least.
+            valid = ParseUint(value, 3, s_MaxMeshletVertexCount, &pOptions->geometryMeshletVertices);
+        }
+        else if (strcmp(name, "-geometry-meshlet-primitives") == 0)
+        {
+            valid = ParseUint(value, 1, s_MaxMeshletPrimitiveCount, &pOptions->geometryMeshletPrimitives);
+        }
+        else if (strcmp(name, "-geometry-visible-percent") == 0)
+        {
+            valid = ParseUint(value, 0, 100, &pOptions->geometryVisiblePercent);
+        }
+        else if (strcmp(name, "-residency-oversubscribe") == 0)
+        {
+            valid = ParseUint(value, 1, 1000, &pOptions->residencyOversubscribe);
+        }
+        else if (strcmp(name, "-residency-heap-mb") == 0)
+        {
+            valid = ParseUint(value, 1, 4096, &pOptions->residencyHeapMB);
+        }
+        else if (strcmp(name, "-residency-working-set-mb") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->residencyWorkingSetMB);
+        }
+        else if (strcmp(name, "-bindless-descriptors") == 0)
+        {
+            valid = ParseUint(value, 1, D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_2, &pOptions->bindlessDescriptorCount);
+        }
+        else if (strcmp(name, "-bindless-textures") == 0)
+        {
+            valid = ParseUint(value, 1, s_MaxBindlessTextureCount, &pOptions->bindlessTextureCount);
+        }
+        else if (strcmp(name, "-bindless-divergence") == 0)
+        {
+            valid = ParseUint(value, 1, 64, &pOptions->bindlessDivergence);
+        }
+        else if (strcmp(name, "-bindless-samples") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->bindlessSamples);
+        }
+        else if (strcmp(name, "-bindless-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->bindlessSweepIterations);
+        }
+        else if (strcmp(name, "-sampling-format") == 0)
+        {
+            valid = ParseSamplingFormat(value, &pOptions->samplingFormat);
+        }
+        else if (strcmp(name, "-sampling-dimension") == 0)
+        {
+            valid = ParseSamplingDimension(value, &pOptions->samplingDimension);
+        }
+        else if (strcmp(name, "-sampling-filter") == 0)
+        {
+            valid = ParseSamplingFilter(value, &pOptions->samplingFilter);
+        }
+        else if (strcmp(name, "-sampling-pattern") == 0)
+        {
+            valid = ParseSamplingPattern(value, &pOptions->samplingPattern);
+        }
+        else if (strcmp(name, "-sampling-size") == 0)
+        {
+            valid = ParseUint(value, 16, D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION, &pOptions->samplingTextureSize);
+        }
+        else if (strcmp(name, "-sampling-lod") == 0)
+        {
+            valid = ParseUint(value, 0, 14, &pOptions->samplingLod);
+        }
+        else if (strcmp(name, "-sampling-samples") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->samplingSamples);
+        }
+        else if (strcmp(name, "-sampling-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->samplingSweepIterations);
+        }
+        else if (strcmp(name, "-fault-access") == 0)
+        {
+            valid = ParseFaultAccess(value, &pOptions->faultAccess);
+        }
+        else if (strcmp(name, "-fault-stage") == 0)
+        {
+            valid = ParseFaultStage(value, &pOptions->faultStage);
+        }
+        else if (strcmp(name, "-fault-binding") == 0)
+        {
+            valid = ParseFaultBinding(value, &pOptions->faultBinding);
+        }
+        else if (strcmp(name, "-fault-index") == 0)
+        {
+            // Keeps byte offsets within 32 bits.
+            valid = ParseUint(value, 0, 1 << 24, &pOptions->faultIndex);
+        }
+        else if (strcmp(name, "-fault-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->faultIterations);
+        }
+        else if (strcmp(name, "-fault-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->faultSweepIterations);
+        }
+        else if (strcmp(name, "-indirect-visible-percent") == 0)
+        {
+            valid = ParseUint(value, 1, 100, &pOptions->indirectVisiblePercent);
+        }
+        else if (strcmp(name, "-transfer-frame-kb") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX / 1024, &pOptions->transferFrameKB);
+        }
+        else if (strcmp(name, "-transfer-max-mb") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->transferMaxMB);
+        }
+        else if (strcmp(name, "-transfer-in-flight") == 0)
+        {
+            // Splits the smallest, 4 KB, transfer into 256-byte copies at most.
+            valid = ParseUint(value, 1, 16, &pOptions->transferInFlight);
+        }
+        else if (strcmp(name, "-transfer-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->transferSweepIterations);
+        }
+        else if (strcmp(name, "-barrier-mode") == 0)
+        {
+            valid = ParseBarrierMode(value, &pOptions->barrierMode);
+        }
+        else if (strcmp(name, "-barrier-resources") == 0)
+        {
+            valid = ParseUint(value, 1, s_MaxBarrierResourceCount, &pOptions->barrierResourceCount);
+        }
+        else if (strcmp(name, "-barrier-resource-kb") == 0)
+        {
+            valid = ParseUint(value, 1, 1024 * 1024, &pOptions->barrierResourceKB);
+        }
+        else if (strcmp(name, "-barrier-sweep-rounds") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->barrierSweepRounds);
+        }
+        else if (strcmp(name, "-raytracing-mode") == 0)
+        {
+            valid = ParseRaytracingMode(value, &pOptions->raytracingMode);
+        }
+        else if (strcmp(name, "-raytracing-instances") == 0)
+        {
+            valid = ParseUint(value, 1, 65536, &pOptions->raytracingInstances);
+        }
+        else if (strcmp(name, "-raytracing-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->raytracingSweepIterations);
+        }
+        else if (strcmp(name, "-alu-op") == 0)
+        {
+            valid = ParseAluOp(value, &pOptions->aluOp);
+        }
+        else if (strcmp(name, "-alu-stage") == 0)
+        {
+            valid = ParseAluStage(value, &pOptions->aluStage);
+        }
+        else if (strcmp(name, "-alu-registers") == 0)
+        {
+            // Parsed aside, a rejected count must not reach CreateAlu().
+            UINT registers = 0;
+            valid = ParseUint(value, 1, UINT_MAX, &registers) && IsAluRegisterCount(registers);
+            if (valid)
+            {
+                pOptions->aluRegisters = registers;
+            }
+        }
+        else if (strcmp(name, "-alu-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->aluIterations);
+        }
+        else if (strcmp(name, "-alu-sweep-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->aluSweepIterations);
+        }
+        else if (strcmp(name, "-peak-tflops") == 0)
+        {
+            valid = ParseDouble(value, &pOptions->peakTflops);
+        }
+        else if (strcmp(name, "-async-dispatches") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->asyncDispatchCount);
+        }
+        else if (strcmp(name, "-async-iterations") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->asyncIterations);
+        }
+        else if (strcmp(name, "-async-copy-mb") == 0)
+        {
+            valid = ParseUint(value, 1, 4096, &pOptions->asyncCopyMB);
+        }
+        else if (strcmp(name, "-async-sweep-frames") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->asyncSweepFrames);
+        }
+        else if (strcmp(name, "-exit-frames") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->exitFrameCount);
+        }
+        else if (strcmp(name, "-exit-seconds") == 0)
+        {
+            valid = ParseDouble(value, &pOptions->exitSeconds);
+        }
+        else if (strcmp(name, "-load-target-percent") == 0)
+        {
+            valid = ParseUint(value, 0, 100, &pOptions->loadTargetPercent);
+        }
+        else if (strcmp(name, "-load-period-ms") == 0)
+        {
+            // Parsed aside, a rejected 0 would stop the pacing.
+            double periodMs = 0.0;
+            valid = ParseDouble(value, &periodMs) && periodMs > 0.0;
+            if (valid)
+            {
+                pOptions->loadPeriodMs = periodMs;
+            }
+        }
+        else if (strcmp(name, "-load-target-ms") == 0)
+        {
+            valid = ParseDouble(value, &pOptions->loadTargetMs);
+        }
+        else if (strcmp(name, "-max-frame-latency") == 0)
+        {
+            // SetMaximumFrameLatency() takes up to 16.
+            valid = ParseUint(value, 1, 16, &pOptions->maxFrameLatency);
+        }
+        else if (strcmp(name, "-soak-window-seconds") == 0)
+        {
+            valid = ParseUint(value, 0, UINT_MAX, &pOptions->soakWindowSeconds);
+        }
+        else if (strcmp(name, "-soak-throttle-percent") == 0)
+        {
+            valid = ParseUint(value, 1, 100, &pOptions->soakThrottlePercent);
+        }
+        else if (strcmp(name, "-soak-throttle-windows") == 0)
+        {
+            valid = ParseUint(value, 1, UINT_MAX, &pOptions->soakThrottleWindows);
+        }
+        else if (strcmp(name, "-shader-dir") == 0)
+        {
+            valid = value != nullptr;
+            if (valid)
+            {
+                pOptions->shaderDirectory = value;
+            }
+        }
+        else if (strcmp(name, "-scenario") == 0)
+        {
+            valid = value != nullptr;
+            if (valid)
+            {
+                pOptions->scenarioPath = value;
+            }
+        }
+        else if (strcmp(name, "-report") == 0)
+        {
+            valid = value != nullptr;
+            if (valid)
+            {
+                pOptions->reportPath = value;
+            }
+        }
+        else if (strcmp(name, "-report-format") == 0)
+        {
+            valid = ParseReportFormat(value, &pOptions->reportFormat);
+        }
+
+        if (valid)
+        {
+            // Consume the value as well.
+            ++i;
+        }
+        else
+        {
+            ReportBadOption(name, value);
+            succeeded = false;
+        }
+    }
+
+    return succeeded;
+}
@@ -0,0 +1,533 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+
+// Upper bound of frames the CPU is allowed to record ahead of the GPU.
+static const UINT s_MaxFrameCount = 8;
+static const UINT s_DefaultFrameCount = 3;
+
+// Upper bound of worker threads. Keeps the finish events within what
+// WaitForMultipleObjects() accepts.
+static const UINT s_MaxRecordThreadCount = 32;
+
+// Upper bound of adapters enumerated, and run at once by `-all-adapters`.
+static const UINT s_MaxAdapterCount = 16;
+
+// Upper bound of `Options::bindlessTextureCount`.
+static const UINT s_MaxBindlessTextureCount = 4096;
+
+// Upper bound of `Options::barrierResourceCount`.
+static const UINT s_MaxBarrierResourceCount = 1024;
+
+// Accumulators per thread the ALU kernels are compiled for, see alu.hlsl.
+static const UINT s_AluRegisterCounts[] = { 2, 4, 8, 16, 32, 64 };
+static const UINT s_AluRegisterVariantCount = _countof(s_AluRegisterCounts);
+
+// Upper bounds of a mesh shader's output, and so of the geometry workload's
+// meshlets.
+static const UINT s_MaxMeshletVertexCount = 256;
+static const UINT s_MaxMeshletPrimitiveCount = 256;
+
+enum class Workload
+{
+    // One triangle per draw, the original trashing workload.
+    Triangle,
+    // Many tiny draws with state churn, see draw-storm.h.
+    DrawStorm,
+    // Blended full-screen layers, see fill-rate.h.
+    FillRate,
+    // Compute memory bandwidth kernels, see bandwidth.h.
+    Bandwidth,
+    // Shader model 6 wave intrinsic and 16-bit ALU kernels, see wave-ops.h.
+    WaveOps,
+    // Indexed, instanced draws of a large mesh, see geometry.h.
+    Geometry,
+    // Heaps paged in and out past the video memory budget, see residency.h.
+    Residency,
+    // Divergent sampling through a bindless descriptor heap, see bindless.h.
+    Bindless,
+    // Texture filtering throughput and cache locality, see sampling.h.
+    Sampling,
+    // Out-of-bounds buffer accesses, bounds-checked or not, see fault.h.
+    Fault,
+    // GPU-culled draws submitted with ExecuteIndirect(), see indirect.h.
+    Indirect,
+    // Upload, readback and copy transfers over the bus, see transfer.h.
+    Transfer,
+    // Transition, UAV and aliasing barriers between tiny dispatches, see
+    // barriers.h.
+    Barriers,
+    // DXR acceleration structure builds, refits and traces, see raytracing.h.
+    Raytracing,
+    // ALU bound compute and pixel kernels, specialized per op and register
+    // count, see alu.h.
+    Alu,
+};
+static const UINT s_WorkloadCount = 15;
+
+enum class BandwidthKernel
+{
+    // Sequential read and write.
+    Copy,
+    // Reads `Options::bandwidthStride` elements apart across threads.
+    StridedRead,
+    // Reads at hashed addresses.
+    RandomGather,
+    // InterlockedAdd at hashed addresses.
+    Atomic,
+};
+static const UINT s_BandwidthKernelCount = 4;
+
+enum class WaveKernel
+{
+    // WaveActiveSum, a reduction across the wave.
+    ActiveSum,
+    // WavePrefixSum, a scan across the wave.
+    PrefixSum,
+    // WaveReadLaneAt, a broadcast from another lane.
+    ReadLaneAt,
+    // 32-bit float FMA, the baseline of the 16-bit kernel.
+    Fma32,
+    // 16-bit float FMA with native 16-bit types.
+    Fma16,
+};
+static const UINT s_WaveKernelCount = 5;
+
+enum class GeometryPath
+{
+    // Indexed draws through the input assembler and a vertex shader.
+    InputAssembler,
+    // Meshlets culled by an amplification shader and expanded by a mesh
+    // shader, where available.
+    MeshShader,
+};
+static const UINT s_GeometryPathCount = 2;
+
+enum class SamplingFormat
+{
+    Rgba8,
+    Rgba16f,
+    // 4 bits per texel.
+    Bc1,
+    // 8 bits per texel.
+    Bc7,
+};
+static const UINT s_SamplingFormatCount = 4;
+
+enum class SamplingDimension
+{
+    Texture2D,
+    Texture2DArray,
+    Texture3D,
+};
+static const UINT s_SamplingDimensionCount = 3;
+
+enum class SamplingFilter
+{
+    Point,
+    // Linear within the nearest mip.
+    Bilinear,
+    // Linear within and between mips.
+    Trilinear,
+    // 16x anisotropic, sampled at 4:1 anisotropy.
+    Anisotropic,
+};
+static const UINT s_SamplingFilterCount = 4;
+
+enum class SamplingPattern
+{
+    // Neighbouring threads sample neighbouring texels.
+    Coherent,
+    // Every sample at a hashed location.
+    Random,
+};
+static const UINT s_SamplingPatternCount = 2;
+
+enum class FaultAccess
+{
+    // Constant buffer array read at a dynamic index.
+    CbvRead,
+    // Structured buffer read.
+    SrvRead,
+    // RW structured buffer read.
+    UavRead,
+    // RW structured buffer write.
+    UavWrite,
+};
+static const UINT s_FaultAccessCount = 4;
+
+enum class FaultStage
+{
+    Vertex,
+    Pixel,
+    Compute,
+};
+static const UINT s_FaultStageCount = 3;
+
+enum class FaultBinding
+{
+    // Views in a descriptor table, whose size bounds-checks every access.
+    Table,
+    // Root descriptors, a bare GPU address with no size.
+    Root,
+};
+static const UINT s_FaultBindingCount = 2;
+
+enum class RecordMode
+{
+    // Re-record every command of every frame.
+    Record,
+    // Record the draws once into a bundle each frame's list executes.
+    Bundle,
+    // Record the draws once into closed direct lists executed every frame.
+    Reuse,
+};
+static const UINT s_RecordModeCount = 3;
+
+enum class BarrierMode
+{
+    // The same dispatches without barriers, the baseline.
+    None,
+    // A ResourceBarrier() call per transition.
+    Single,
+    // All transitions of a pass in one ResourceBarrier() call.
+    Batched,
+    // Batched, begun after the producer and ended before the consumer.
+    Split,
+    // UAV barriers, the buffers stay in the unordered access state.
+    Uav,
+    // Aliasing barriers between two placed buffers sharing memory.
+    Aliasing,
+    // ID3D12GraphicsCommandList7::Barrier(), where available.
+    Enhanced,
+};
+static const UINT s_BarrierModeCount = 7;
+
+enum class RaytracingMode
+{
+    // Full BLAS and TLAS builds.
+    Build,
+    // A compute pass deforming the mesh, then BLAS and TLAS refits.
+    Refit,
+    // Rays traced with DispatchRays().
+    DispatchRays,
+    // Rays traced inline, with RayQuery from a compute shader.
+    RayQuery,
+};
+static const UINT s_RaytracingModeCount = 4;
+
+enum class AluOp
+{
+    // 32-bit float multiply-adds.
+    Fma,
+    // exp2(), on the transcendental units.
+    Transcendental,
+    // 32-bit integer multiply-adds.
+    Integer,
+};
+static const UINT s_AluOpCount = 3;
+
+enum class AluStage
+{
+    // A thread per element of a fixed size dispatch.
+    Compute,
+    // A thread per pixel of a full screen triangle.
+    Pixel,
+};
+static const UINT s_AluStageCount = 2;
+
+enum class ReportFormat
+{
+    // One JSON object per line, see report.h.
+    Json,
+    // One row per frame, with the run description and summary in comments.
+    Csv,
+};
+
+// Run-time configuration, filled from the command line.
+struct Options
+{
+    Workload workload = Workload::Triangle;
+
+    // Adapter to run on, by index in the `-list-adapters` order, or by LUID
+    // when `adapterLuid` isn't 0.
+    UINT adapterIndex = 0;
+    UINT64 adapterLuid = 0;
+    // Run an independent pipeline on every adapter at once, each on its own
+    // thread. Implies `headless`.
+    bool allAdapters = false;
+    // Log the adapters and exit.
+    bool listAdapters = false;
+
+    // Window and swapchain size, or offscreen render target size when
+    // headless.
+    UINT width = 1080;
+    UINT height = 960;
+
+    // Render to offscreen render targets from a tight loop, without a window
+    // or swapchain. Nothing is presented, so frames are never capped by the
+    // refresh rate.
+    bool headless = false;
+    // Present with sync interval 1. Without it frames are presented as fast
+    // as the flip model allows, which is still capped when composed by DWM.
+    bool vsync = true;
+    // Present uncapped with DXGI_PRESENT_ALLOW_TEARING, overriding `vsync`.
+    bool tearing = false;
+    // Wait on the swapchain's frame latency waitable object before every
+    // frame, see present-latency.h.
+    bool waitableSwapchain = false;
+    // Presents the waitable swapchain may queue, 0 for its default of 1.
+    // Anything else implies `waitableSwapchain`.
+    UINT maxFrameLatency = 0;
+
+    // Stop after this many frames, or this many seconds, whichever comes
+    // first. 0 runs until the window is closed.
+    UINT exitFrameCount = 0;
+    double exitSeconds = 0.0;
+
+    // Soak monitoring, see soak.h: frame throughput is sampled over windows
+    // of this many seconds, 0 turns it off.
+    UINT soakWindowSeconds = 0;
+    // Throughput drop from the first window, in percent, that counts as
+    // throttling once it lasts `soakThrottleWindows` windows in a row.
+    UINT soakThrottlePercent = 10;
+    UINT soakThrottleWindows = 3;
+
+    // Load control, see load-controller.h: scale the draws so the GPU is
+    // busy this share of every `loadPeriodMs`, or so frames take
+    // `loadTargetMs` of GPU time back to back. 0 turns either off; the
+    // percentage wins when both are given. `drawCount` is the upper bound.
+    UINT loadTargetPercent = 0;
+    double loadPeriodMs = 16.0;
+    double loadTargetMs = 0.0;
+
+    // Run FMA kernels on a compute queue and buffer copies on a copy queue
+    // next to every frame, see async-compute.h.
+    bool asyncCompute = false;
+    bool asyncCopy = false;
+    // Dispatches per frame, and FMA loop iterations per thread.
+    UINT asyncDispatchCount = 8;
+    UINT asyncIterations = 1024;
+    // Size of the buffer copied every frame.
+    UINT asyncCopyMB = 64;
+    // Frames per phase of the overlap sweep.
+    UINT asyncSweepFrames = 64;
+
+    // Time the frame loop's hot path with CPU markers, see telemetry.h.
+    bool telemetry = false;
+
+    // Directory of the HLSL sources, null to look next to the executable.
+    // Points into argv.
+    const char* shaderDirectory = nullptr;
+
+    // File the results are streamed to, null for none. Points into argv.
+    const char* reportPath = nullptr;
+    ReportFormat reportFormat = ReportFormat::Json;
+
+    // Scenario file of phases to run instead of a single workload, see
+    // scenario.h. Points into argv.
+    const char* scenarioPath = nullptr;
+    // Name of the phase these options belong to, null outside scenarios.
+    const char* scenarioPhase = nullptr;
+
+    // Depth of the frame-resource ring, i.e. how many frames may be in flight.
+    UINT frameCount = s_DefaultFrameCount;
+
+    // Draws recorded per frame.
+    UINT drawCount = 1;
+
+    // Worker threads recording the draws. 0 records everything on the
+    // message-loop thread into a single command list.
+    UINT recordThreadCount = 0;
+
+    // How the draws get into the frame, see record-cache.h. Caching modes
+    // also run a sweep of every mode; `recordSweepFrames` frames each.
+    RecordMode recordMode = RecordMode::Record;
+    UINT recordSweepFrames = 256;
+
+    // Draw storm state churn: change the state every N draws, 0 never
+    // changes it.
+    UINT rootConstantInterval = 0;
+    UINT descriptorTableInterval = 0;
+    UINT psoInterval = 0;
+    UINT vertexBufferInterval = 0;
+    // Upload fresh per-draw constants through the upload ring and bind them
+    // as a root CBV every N draws, 0 never does.
+    UINT rootCbvInterval = 0;
+    // Bytes written per root CBV update, a multiple of 16. The shaders only
+    // read the first 16, the rest measures the cost of larger uploads.
+    UINT uploadBytesPerDraw = 256;
+    // Size of the upload ring shared by the frames in flight.
+    UINT uploadRingMB = 64;
+
+    // Full-screen layers per fill-rate draw.
+    UINT fillLayers = 8;
+    // Times the layers are drawn per fill-rate sweep case.
+    UINT fillSweepIterations = 16;
+
+    // Kernel the bandwidth workload dispatches every frame; the sweep runs
+    // all of them.
+    BandwidthKernel bandwidthKernel = BandwidthKernel::Copy;
+    // Size of each of the two bandwidth buffers.
+    UINT bandwidthBufferMB = 256;
+    // Strided kernel read distance, in 16-byte elements.
+    UINT bandwidthStride = 16;
+    // Dispatches per bandwidth sweep case.
+    UINT bandwidthSweepIterations = 8;
+    // Theoretical memory bandwidth of the adapter in GB/s, from its spec
+    // sheet. DXGI doesn't report it; 0 leaves it out of the results.
+    double peakBandwidth = 0.0;
+
+    // Kernel the wave-ops workload dispatches every frame; the sweep runs
+    // all of them.
+    WaveKernel waveKernel = WaveKernel::ActiveSum;
+    // Lanes per wave of the wave-ops workload, which must be within the
+    // adapter's range and needs shader model 6.6. 0 lets the driver choose;
+    // the sweep runs every size the adapter supports.
+    UINT waveSize = 0;
+    // Loop iterations per thread of every wave-ops dispatch.
+    UINT waveIterations = 1024;
+    // Dispatches per wave-ops sweep case.
+    UINT waveSweepIterations = 8;
+
+    // Triangles of the geometry workload's mesh, rounded to a square grid.
+    UINT geometryTriangles = 1024 * 1024;
+    // Instances per geometry draw.
+    UINT geometryInstances = 4;
+    // Draws per geometry sweep.
+    UINT geometrySweepIterations = 4;
+    // How the geometry workload's frames draw, see geometry.h; the sweep
+    // runs both, the mesh path at several meshlet sizes.
+    GeometryPath geometryPath = GeometryPath::InputAssembler;
+    // Limits of a meshlet of the mesh path.
+    UINT geometryMeshletVertices = 64;
+    UINT geometryMeshletPrimitives = 126;
+    // Share of the mesh's width the mesh path's amplification shader keeps,
+    // culling the meshlets past it as if the view ended there.
+    UINT geometryVisiblePercent = 100;
+
+    // Heaps the residency workload allocates, in percent of the local video
+    // memory budget.
+    UINT residencyOversubscribe = 150;
+    // Size of each residency heap, the unit of paging.
+    UINT residencyHeapMB = 256;
+    // Heaps made resident per frame, rounded down to whole heaps.
+    UINT residencyWorkingSetMB = 512;
+
+    // SRVs in the bindless heap, up to the 1M descriptors every binding tier
+    // allows.
+    UINT bindlessDescriptorCount = 1000000;
+    // Distinct textures the bindless SRVs cycle over.
+    UINT bindlessTextureCount = 1024;
+    // Distinct textures per thread group of 64 and sample, 1 being uniform.
+    UINT bindlessDivergence = 64;
+    // Samples per bindless thread.
+    UINT bindlessSamples = 16;
+    // Dispatches per bindless sweep case.
+    UINT bindlessSweepIterations = 8;
+
+    // Texture the sampling workload samples every frame, and how; the sweep
+    // runs every combination.
+    SamplingFormat samplingFormat = SamplingFormat::Rgba8;
+    SamplingDimension samplingDimension = SamplingDimension::Texture2D;
+    SamplingFilter samplingFilter = SamplingFilter::Bilinear;
+    SamplingPattern samplingPattern = SamplingPattern::Coherent;
+    // Width and height of the 2D textures, rounded up to a power of two.
+    UINT samplingTextureSize = 2048;
+    // Mip level sampled, which sets the texture footprint.
+    UINT samplingLod = 0;
+    // Samples per thread or pixel.
+    UINT samplingSamples = 16;
+    // Dispatches or draws per sampling sweep case.
+    UINT samplingSweepIterations = 4;
+
+    // Access the fault workload makes every frame, the stage making it and
+    // how the buffer is bound; the sweep runs every combination.
+    FaultAccess faultAccess = FaultAccess::CbvRead;
+    FaultStage faultStage = FaultStage::Compute;
+    FaultBinding faultBinding = FaultBinding::Table;
+    // First float4 element accessed. The buffers have 4096, so from 4096 on
+    // every access is out of bounds; the default matches the triangle
+    // workload's read.
+    UINT faultIndex = 65536;
+    // Accesses per thread, vertex or pixel.
+    UINT faultIterations = 64;
+    // Also sweep out-of-bounds accesses through root descriptors, which
+    // nothing bounds-checks: they read or corrupt whatever memory lies there,
+    // or page fault and remove the device.
+    bool faultUnbounded = false;
+    // Dispatches or draws per fault sweep case.
+    UINT faultSweepIterations = 8;
+
+    // Share of the indirect workload's objects that land on screen and
+    // survive the cull pass, in percent.
+    UINT indirectVisiblePercent = 50;
+
+    // Bytes the transfer workload copies per draw.
+    UINT transferFrameKB = 1024;
+    // Largest transfer of the sweep, and the size of its buffers. Clamped to
+    // the adapter's memory.
+    UINT transferMaxMB = 1024;
+    // GPU copies the sweep keeps in flight, splitting every transfer.
+    UINT transferInFlight = 4;
+    // Least repeats per transfer sweep case; small transfers repeat more.
+    UINT transferSweepIterations = 4;
+
+    // How the barrier workload's rounds synchronize, see barriers.h; the
+    // sweep runs every mode.
+    BarrierMode barrierMode = BarrierMode::Batched;
+    // Buffers each round transitions, and their size.
+    UINT barrierResourceCount = 64;
+    UINT barrierResourceKB = 64;
+    // Rounds per barrier sweep case.
+    UINT barrierSweepRounds = 16;
+
+    // What the raytracing workload's draws do, see raytracing.h; the sweep
+    // runs every mode.
+    RaytracingMode raytracingMode = RaytracingMode::DispatchRays;
+    // Trace random rays rather than camera rays.
+    bool raytracingIncoherent = false;
+    // Instances of the mesh in the TLAS.
+    UINT raytracingInstances = 64;
+    // Builds or traces per raytracing sweep case.
+    UINT raytracingSweepIterations = 8;
+
+    // Kernel the alu workload runs every frame, see alu.h; the sweep runs
+    // every op, stage and register count.
+    AluOp aluOp = AluOp::Fma;
+    AluStage aluStage = AluStage::Compute;
+    // One of `s_AluRegisterCounts`.
+    UINT aluRegisters = 8;
+    // Loop iterations per thread, each stepping every accumulator.
+    UINT aluIterations = 64;
+    // Dispatches or draws per alu sweep case.
+    UINT aluSweepIterations = 4;
+    // Theoretical FP32 FMA throughput of the adapter in TFLOPS, from its
+    // spec sheet. DXGI doesn't report it; 0 leaves it out of the results.
+    double peakTflops = 0.0;
+};
+
+// Names used on the command line and in results.
+const char* GetWorkloadName(Workload workload);
+const char* GetBandwidthKernelName(BandwidthKernel kernel);
+const char* GetWaveKernelName(WaveKernel kernel);
+const char* GetGeometryPathName(GeometryPath path);
+const char* GetSamplingFormatName(SamplingFormat format);
+const char* GetSamplingDimensionName(SamplingDimension dimension);
+const char* GetSamplingFilterName(SamplingFilter filter);
+const char* GetSamplingPatternName(SamplingPattern pattern);
+const char* GetFaultAccessName(FaultAccess access);
+const char* GetFaultStageName(FaultStage stage);
+const char* GetFaultBindingName(FaultBinding binding);
+const char* GetRecordModeName(RecordMode mode);
+const char* GetBarrierModeName(BarrierMode mode);
+const char* GetRaytracingModeName(RaytracingMode mode);
+const char* GetAluOpName(AluOp op);
+const char* GetAluStageName(AluStage stage);
+
+// Parse `-name value` pairs and `-name` switches. Unknown or malformed options
+// are reported to the debugger output and skipped; returns false if there
+// were any.
+bool ParseOptions(int argc, char** argv, Options* pOptions);
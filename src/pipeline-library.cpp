@@ -0,0 +1,325 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "pipeline-library.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+// Hash field by field: several D3D12 state structs have padding, whose bytes
+// aren't guaranteed to match between runs.
+template <typename T>
+static UINT64 HashValue(UINT64 hash, const T& value)
+{
+    return HashBytes(hash, &value, sizeof(value));
+}
+
+static UINT64 HashBytecode(UINT64 hash, const D3D12_SHADER_BYTECODE& bytecode)
+{
+    hash = HashValue(hash, bytecode.BytecodeLength);
+    return HashBytes(hash, bytecode.pShaderBytecode, bytecode.BytecodeLength);
+}
+
+static UINT64 HashBlendState(UINT64 hash, const D3D12_BLEND_DESC& blend)
+{
+    hash = HashValue(hash, blend.AlphaToCoverageEnable);
+    hash = HashValue(hash, blend.IndependentBlendEnable);
+
+    for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blend.RenderTarget)
+    {
+        hash = HashValue(hash, target.BlendEnable);
+        hash = HashValue(hash, target.LogicOpEnable);
+        hash = HashValue(hash, target.SrcBlend);
+        hash = HashValue(hash, target.DestBlend);
+        hash = HashValue(hash, target.BlendOp);
+        hash = HashValue(hash, target.SrcBlendAlpha);
+        hash = HashValue(hash, target.DestBlendAlpha);
+        hash = HashValue(hash, target.BlendOpAlpha);
+        hash = HashValue(hash, target.LogicOp);
+        hash = HashValue(hash, target.RenderTargetWriteMask);
+    }
+
+    return hash;
+}
+
+static UINT64 HashDepthStencilState(UINT64 hash, const D3D12_DEPTH_STENCIL_DESC& depthStencil)
+{
+    hash = HashValue(hash, depthStencil.DepthEnable);
+    hash = HashValue(hash, depthStencil.DepthWriteMask);
+    hash = HashValue(hash, depthStencil.DepthFunc);
+    hash = HashValue(hash, depthStencil.StencilEnable);
+    hash = HashValue(hash, depthStencil.StencilReadMask);
+    hash = HashValue(hash, depthStencil.StencilWriteMask);
+    // The op descs are all enums, without padding.
+    hash = HashValue(hash, depthStencil.FrontFace);
+    hash = HashValue(hash, depthStencil.BackFace);
+    return hash;
+}
+
+static UINT64 HashGraphicsDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    UINT64 hash = s_Fnv1aOffsetBasis;
+
+    hash = HashBytecode(hash, desc.VS);
+    hash = HashBytecode(hash, desc.PS);
+    hash = HashBytecode(hash, desc.DS);
+    hash = HashBytecode(hash, desc.HS);
+    hash = HashBytecode(hash, desc.GS);
+    hash = HashBlendState(hash, desc.BlendState);
+    hash = HashValue(hash, desc.SampleMask);
+    // All 4-byte fields, without padding.
+    hash = HashValue(hash, desc.RasterizerState);
+    hash = HashDepthStencilState(hash, desc.DepthStencilState);
+
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+        hash = HashBytes(hash, element.SemanticName, strlen(element.SemanticName));
+        hash = HashValue(hash, element.SemanticIndex);
+        hash = HashValue(hash, element.Format);
+        hash = HashValue(hash, element.InputSlot);
+        hash = HashValue(hash, element.AlignedByteOffset);
+        hash = HashValue(hash, element.InputSlotClass);
+        hash = HashValue(hash, element.InstanceDataStepRate);
+    }
+
+    hash = HashValue(hash, desc.IBStripCutValue);
+    hash = HashValue(hash, desc.PrimitiveTopologyType);
+    hash = HashValue(hash, desc.NumRenderTargets);
+    hash = HashValue(hash, desc.RTVFormats);
+    hash = HashValue(hash, desc.DSVFormat);
+    hash = HashValue(hash, desc.SampleDesc);
+    hash = HashValue(hash, desc.NodeMask);
+    hash = HashValue(hash, desc.Flags);
+
+    return hash;
+}
+
+static UINT64 HashMeshDesc(const D3DX12_MESH_SHADER_PIPELINE_STATE_DESC& desc)
+{
+    UINT64 hash = s_Fnv1aOffsetBasis;
+
+    hash = HashBytecode(hash, desc.AS);
+    hash = HashBytecode(hash, desc.MS);
+    hash = HashBytecode(hash, desc.PS);
+    hash = HashBlendState(hash, desc.BlendState);
+    hash = HashValue(hash, desc.SampleMask);
+    hash = HashValue(hash, desc.RasterizerState);
+    hash = HashDepthStencilState(hash, desc.DepthStencilState);
+    hash = HashValue(hash, desc.PrimitiveTopologyType);
+    hash = HashValue(hash, desc.NumRenderTargets);
+    hash = HashValue(hash, desc.RTVFormats);
+    hash = HashValue(hash, desc.DSVFormat);
+    hash = HashValue(hash, desc.SampleDesc);
+    hash = HashValue(hash, desc.NodeMask);
+    hash = HashValue(hash, desc.Flags);
+
+    return hash;
+}
+
+static UINT64 HashComputeDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    UINT64 hash = s_Fnv1aOffsetBasis;
+
+    hash = HashBytecode(hash, desc.CS);
+    hash = HashValue(hash, desc.NodeMask);
+    hash = HashValue(hash, desc.Flags);
+
+    return hash;
+}
+
+void OpenPipelineLibrary(Pipeline* pPipeline)
+{
+    PipelineLibrary* pLibrary = &pPipeline->pipelineLibrary;
+
+    const wchar_t* cacheDirectory = GetShaderCacheDirectory();
+    if (cacheDirectory[0] == L'\0')
+    {
+        return;
+    }
+
+    ComPtr<ID3D12Device1> device1;
+    if (FAILED(pPipeline->device.As(&device1)))
+    {
+        return;
+    }
+
+    // Identical adapters could share a file, but adapters running at once
+    // with `-all-adapters` mustn't write the same one.
+    swprintf(
+        pLibrary->path,
+        MAX_PATH,
+        L"%lspipelines-adapter%u-%04x-%04x.bin",
+        cacheDirectory,
+        pPipeline->options.adapterIndex,
+        pPipeline->adapterDesc.VendorId,
+        pPipeline->adapterDesc.DeviceId);
+
+    if (ReadFileBlob(pLibrary->path, &pLibrary->serializedLibrary))
+    {
+        HRESULT hr = device1->CreatePipelineLibrary(
+            pLibrary->serializedLibrary->GetBufferPointer(),
+            pLibrary->serializedLibrary->GetBufferSize(),
+            IID_PPV_ARGS(&pLibrary->library));
+
+        if (SUCCEEDED(hr))
+        {
+            return;
+        }
+
+        // D3D12_ERROR_DRIVER_VERSION_MISMATCH after a driver update,
+        // D3D12_ERROR_ADAPTER_NOT_FOUND if the adapters were reordered.
+        LogMessage("Rebuilding pipeline library %ls (0x%08x)\n", pLibrary->path, (UINT)hr);
+        pLibrary->serializedLibrary.Reset();
+    }
+
+    // Some drivers don't support pipeline libraries at all.
+    if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&pLibrary->library))))
+    {
+        pLibrary->library.Reset();
+    }
+}
+
+static void GetPipelineName(const wchar_t* name, UINT64 hash, wchar_t* pResult)
+{
+    swprintf(pResult, MAX_PATH, L"%ls-%016llx", name, hash);
+}
+
+void CreateGraphicsPipelineState(
+    Pipeline* pPipeline,
+    const wchar_t* name,
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+    ComPtr<ID3D12PipelineState>* pPipelineState)
+{
+    PipelineLibrary* pLibrary = &pPipeline->pipelineLibrary;
+
+    wchar_t pipelineName[MAX_PATH];
+    GetPipelineName(name, HashGraphicsDesc(desc), pipelineName);
+
+    if (pLibrary->library &&
+        SUCCEEDED(pLibrary->library->LoadGraphicsPipeline(
+            pipelineName,
+            &desc,
+            IID_PPV_ARGS(pPipelineState->ReleaseAndGetAddressOf()))))
+    {
+        pLibrary->loadedCount += 1;
+        return;
+    }
+
+    ThrowIfFailed(pPipeline->device->CreateGraphicsPipelineState(
+        &desc,
+        IID_PPV_ARGS(pPipelineState->ReleaseAndGetAddressOf())));
+
+    // Fails if the name is taken, e.g. by a PSO with another root
+    // signature; this one is then created every run.
+    if (pLibrary->library &&
+        SUCCEEDED(pLibrary->library->StorePipeline(pipelineName, pPipelineState->Get())))
+    {
+        pLibrary->storedCount += 1;
+    }
+}
+
+void CreateComputePipelineState(
+    Pipeline* pPipeline,
+    const wchar_t* name,
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+    ComPtr<ID3D12PipelineState>* pPipelineState)
+{
+    PipelineLibrary* pLibrary = &pPipeline->pipelineLibrary;
+
+    wchar_t pipelineName[MAX_PATH];
+    GetPipelineName(name, HashComputeDesc(desc), pipelineName);
+
+    if (pLibrary->library &&
+        SUCCEEDED(pLibrary->library->LoadComputePipeline(
+            pipelineName,
+            &desc,
+            IID_PPV_ARGS(pPipelineState->ReleaseAndGetAddressOf()))))
+    {
+        pLibrary->loadedCount += 1;
+        return;
+    }
+
+    ThrowIfFailed(pPipeline->device->CreateComputePipelineState(
+        &desc,
+        IID_PPV_ARGS(pPipelineState->ReleaseAndGetAddressOf())));
+
+    if (pLibrary->library &&
+        SUCCEEDED(pLibrary->library->StorePipeline(pipelineName, pPipelineState->Get())))
+    {
+        pLibrary->storedCount += 1;
+    }
+}
+
+void CreateMeshPipelineState(
+    Pipeline* pPipeline,
+    const wchar_t* name,
+    const D3DX12_MESH_SHADER_PIPELINE_STATE_DESC& desc,
+    ComPtr<ID3D12PipelineState>* pPipelineState)
+{
+    PipelineLibrary* pLibrary = &pPipeline->pipelineLibrary;
+
+    wchar_t pipelineName[MAX_PATH];
+    GetPipelineName(name, HashMeshDesc(desc), pipelineName);
+
+    CD3DX12_PIPELINE_MESH_STATE_STREAM stream(desc);
+    D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof(stream), &stream };
+
+    ComPtr<ID3D12PipelineLibrary1> library1;
+    if (pLibrary->library && FAILED(pLibrary->library.As(&library1)))
+    {
+        library1.Reset();
+    }
+
+    if (library1 &&
+        SUCCEEDED(library1->LoadPipeline(
+            pipelineName,
+            &streamDesc,
+            IID_PPV_ARGS(pPipelineState->ReleaseAndGetAddressOf()))))
+    {
+        pLibrary->loadedCount += 1;
+        return;
+    }
+
+    ComPtr<ID3D12Device2> device2;
+    ThrowIfFailed(pPipeline->device.As(&device2));
+    ThrowIfFailed(device2->CreatePipelineState(
+        &streamDesc,
+        IID_PPV_ARGS(pPipelineState->ReleaseAndGetAddressOf())));
+
+    if (library1 &&
+        SUCCEEDED(library1->StorePipeline(pipelineName, pPipelineState->Get())))
+    {
+        pLibrary->storedCount += 1;
+    }
+}
+
+void SavePipelineLibrary(Pipeline* pPipeline)
+{
+    PipelineLibrary* pLibrary = &pPipeline->pipelineLibrary;
+
+    LogMessage(
+        "pipeline library: %u PSOs loaded, %u created\n",
+        pLibrary->loadedCount,
+        pLibrary->storedCount);
+
+    if (!pLibrary->library || pLibrary->storedCount == 0)
+    {
+        return;
+    }
+
+    const SIZE_T size = pLibrary->library->GetSerializedSize();
+    void* pData = malloc(size);
+
+    if (pData != nullptr &&
+        SUCCEEDED(pLibrary->library->Serialize(pData, size)) &&
+        !WriteFileAtomically(pLibrary->path, pData, size))
+    {
+        LogMessage("Can't write pipeline library %ls\n", pLibrary->path);
+    }
+
+    free(pData);
+    pLibrary->storedCount = 0;
+}
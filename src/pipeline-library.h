@@ -0,0 +1,60 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+
+struct Pipeline;
+
+// PSOs persisted across runs with an ID3D12PipelineLibrary, so repeat runs
+// skip the driver's compilation. Every adapter has its own library file in the
+// shader cache directory. The driver rejects a library written by another
+// driver version, in which case it is rebuilt from scratch.
+//
+// PSOs are stored under their caller's name plus a hash of their shaders and
+// fixed-function state, so a changed PSO gets a new entry instead of failing
+// to load.
+struct PipelineLibrary
+{
+    // Null when the runtime or driver doesn't support pipeline libraries;
+    // PSOs are then created directly.
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> library;
+    // The library references the serialized data it was created from for its
+    // whole lifetime.
+    Microsoft::WRL::ComPtr<ID3DBlob> serializedLibrary;
+    wchar_t path[MAX_PATH];
+    // PSOs added since the library was loaded.
+    UINT storedCount;
+    UINT loadedCount;
+};
+
+// Load the adapter's library, or start an empty one. Call once the device is
+// created.
+void OpenPipelineLibrary(Pipeline* pPipeline);
+
+void CreateGraphicsPipelineState(
+    Pipeline* pPipeline,
+    const wchar_t* name,
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>* pPipelineState);
+
+void CreateComputePipelineState(
+    Pipeline* pPipeline,
+    const wchar_t* name,
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>* pPipelineState);
+
+// Mesh shader PSOs are created from a pipeline state stream, which needs
+// ID3D12Device2, and are only cached with ID3D12PipelineLibrary1.
+void CreateMeshPipelineState(
+    Pipeline* pPipeline,
+    const wchar_t* name,
+    const D3DX12_MESH_SHADER_PIPELINE_STATE_DESC& desc,
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>* pPipelineState);
+
+// Write the library back if PSOs were added to it. Call once every PSO is
+// created.
+void SavePipelineLibrary(Pipeline* pPipeline);
@@ -0,0 +1,249 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <Windows.h>
+#include <wrl.h>
+#include <exception>
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <DirectXMath.h>
+#include "d3dx12.h"
+#include "alu.h"
+#include "async-compute.h"
+#include "bandwidth.h"
+#include "barriers.h"
+#include "bindless.h"
+#include "draw-storm.h"
+#include "fault.h"
+#include "fill-rate.h"
+#include "geometry.h"
+#include "gpu-timer.h"
+#include "indirect.h"
+#include "load-controller.h"
+#include "options.h"
+#include "pipeline-library.h"
+#include "present-latency.h"
+#include "raytracing.h"
+#include "record-cache.h"
+#include "record-threads.h"
+#include "report.h"
+#include "residency.h"
+#include "sampling.h"
+#include "soak.h"
+#include "telemetry.h"
+#include "transfer.h"
+#include "upload-ring.h"
+#include "wave-ops.h"
+
+using Microsoft::WRL::ComPtr;
+
+struct Vertex
+{
+    DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT4 color;
+};
+
+static const size_t s_ColorCount = 4096;
+struct ConstBuffer
+{
+    // error X3059: array dimension must be between 1 and 65536
+    DirectX::XMFLOAT4 colors[s_ColorCount];
+};
+
+// Per-draw constants, set as root constants.
+struct DrawConstants
+{
+    // Clip-space translation applied to every vertex of the draw.
+    DirectX::XMFLOAT4 offset;
+};
+
+// Per-draw constants allocated from `Pipeline::uploadRing`, set as a root CBV.
+struct DrawData
+{
+    // Multiplies the vertex colors.
+    DirectX::XMFLOAT4 color;
+};
+
+// Root parameter slots of `Pipeline::rootSignature`.
+static const UINT s_RootParamCbvTable = 0;
+static const UINT s_RootParamDrawConstants = 1;
+static const UINT s_RootParamDrawData = 2;
+static const UINT s_RootParamCount = 3;
+
+// Everything the CPU touches while recording a frame that must not be reused
+// until the GPU has finished executing that frame.
+struct FrameResource
+{
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+
+    // Fence value signaled after this frame's command lists. The resource can
+    // be reused once the fence reaches this value.
+    UINT64 fenceValue;
+
+    // This frame's slice of `Pipeline::constantBuffer`.
+    ConstBuffer* pConstBuffer;
+    CD3DX12_GPU_DESCRIPTOR_HANDLE cbvHandle;
+
+    // The frame last submitted with this resource, and the CPU time spent
+    // recording and submitting it. Reported once its GPU time is read back.
+    UINT64 frameNumber;
+    UINT64 cpuTicks;
+    UINT drawCount;
+    bool resultsPending;
+
+    // `Pipeline::uploadRing` position after this frame's allocations.
+    UINT64 uploadRingEnd;
+};
+
+// CPU-side frame timing, accumulated over a reporting window.
+struct FrameStats
+{
+    UINT64 windowStartTicks;
+    UINT frameCount;
+    UINT64 drawCount;
+    // Time spent recording and submitting command lists.
+    UINT64 cpuTicks;
+};
+
+struct Pipeline
+{
+    Options options;
+
+    // pipeline objects
+    CD3DX12_VIEWPORT viewport;
+    CD3DX12_RECT scissorRect;
+    ComPtr<IDXGISwapChain3> swapchain;
+    PresentLatency presentLatency;
+    ComPtr<IDXGIFactory4> dxgiFactory;
+    ComPtr<IDXGIAdapter1> adapter;
+    DXGI_ADAPTER_DESC1 adapterDesc;
+    ComPtr<ID3D12Device> device;
+    D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion;
+    UINT backBufferCount;
+    ComPtr<ID3D12Resource> renderTargets[s_MaxFrameCount];
+    ComPtr<ID3D12CommandQueue> cmdQueue;
+    ComPtr<ID3D12DescriptorHeap> rtvDescriptorHeap;
+    ComPtr<ID3D12DescriptorHeap> cbvDescriptorHeap;
+    UINT rtvDescriptorSize;
+    UINT cbvDescriptorSize;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineState;
+    PipelineLibrary pipelineLibrary;
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    // Closes the frame after the worker threads' lists in multi-threaded
+    // recording mode. Shares the frame resource's allocator with `cmdList`.
+    ComPtr<ID3D12GraphicsCommandList> postCmdList;
+
+    // app resource
+    ComPtr<ID3D12Resource> vertexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+    ComPtr<ID3D12Resource> constantBuffer;
+    UINT8* pConstBufferMappedBeginAddr;
+    ConstBuffer* pConstBufferData;
+    UploadRing uploadRing;
+
+    // workloads
+    DrawStorm drawStorm;
+    FillRate fillRate;
+    Bandwidth bandwidth;
+    WaveOps waveOps;
+    Geometry geometry;
+    Residency residency;
+    Bindless bindless;
+    Sampling sampling;
+    Fault fault;
+    Indirect indirect;
+    Transfer transfer;
+    Barriers barriers;
+    Raytracing raytracing;
+    Alu alu;
+    AsyncCompute asyncCompute;
+
+    Soak soak;
+    LoadController loadController;
+
+    // frame resources
+    FrameResource frameResources[s_MaxFrameCount];
+    UINT frameResourceIndex;
+    // Frames submitted so far.
+    UINT64 frameNumber;
+    // Draws of the frame being recorded: `Options::drawCount`, unless the
+    // load controller scales it down.
+    UINT frameDrawCount;
+
+    // multi-threaded recording
+    RecordThreadPool recordThreads;
+
+    // draws recorded once, reused across frames
+    RecordCache recordCache;
+
+    FrameStats frameStats;
+    // CPU ticks when the frame loop started.
+    UINT64 runStartTicks;
+    // Set by RenderFrames(), whose frames stay out of the report.
+    bool renderingSweepFrames;
+    GpuTimer gpuTimer;
+    Report report;
+    Telemetry telemetry;
+
+    // synchronization
+    UINT backBufferIndex;
+    HANDLE fenceEvent;
+    ComPtr<ID3D12Fence> fence;
+    // Last value signaled on `fence` from the command queue.
+    UINT64 fenceValue;
+};
+
+// Thrown by ThrowIfFailed(). After a device removal the failing call is
+// usually not the cause; check GetDeviceRemovedReason().
+struct HResultException : std::exception
+{
+    HRESULT hr;
+
+    explicit HResultException(HRESULT hr) : hr(hr) {}
+};
+
+inline void ThrowIfFailed(HRESULT hr)
+{
+    if (FAILED(hr))
+    {
+        // Set a breakpoint on this line to catch DirectX API errors
+        throw HResultException(hr);
+    }
+}
+
+// Block the CPU until the GPU has reached `fenceValue`.
+void WaitForFenceValue(Pipeline* pPipeline, UINT64 fenceValue);
+
+// Add a command to set the fence to a new value from GPU side, and return it.
+UINT64 SignalFence(Pipeline* pPipeline);
+
+// Serialize `desc` for the highest version the device supports and create
+// the root signature. Serialization errors go to the debugger output and throw.
+void CreateRootSignature(
+    Pipeline* pPipeline,
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc,
+    ComPtr<ID3D12RootSignature>* pRootSignature);
+
+// Bind everything a draw needs: root signature, descriptor heaps, viewport and
+// the current back buffer. Command lists recorded on worker threads start
+// with no state inherited from the main list, so each has to call this.
+void SetDrawState(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList);
+
+// Record draws [firstDraw, firstDraw + drawCount) of the current frame.
+void RecordDraws(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Render `frameCount` frames back to back without presenting them, for sweeps
+// comparing frame loop configurations. The frames stay out of the report.
+// Returns with the GPU idle, and the CPU time recording and submitting the
+// frames took.
+UINT64 RenderFrames(Pipeline* pPipeline, UINT frameCount);
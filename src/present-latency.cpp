@@ -0,0 +1,204 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "present-latency.h"
+#include "pipeline.h"
+#include "utils.h"
+
+static bool IsSwapchainWaitable(const Options& options)
+{
+    return options.waitableSwapchain || options.maxFrameLatency > 0;
+}
+
+UINT InitPresentLatency(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+    const Options& options = pPipeline->options;
+    UINT flags = 0;
+
+    if (options.tearing)
+    {
+        BOOL allowTearing = FALSE;
+        ComPtr<IDXGIFactory5> factory5;
+        if (SUCCEEDED(pPipeline->dxgiFactory.As(&factory5)) &&
+            FAILED(factory5->CheckFeatureSupport(
+                DXGI_FEATURE_PRESENT_ALLOW_TEARING,
+                &allowTearing,
+                sizeof(allowTearing))))
+        {
+            allowTearing = FALSE;
+        }
+
+        pLatency->tearing = allowTearing != FALSE;
+        if (pLatency->tearing)
+        {
+            flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+        }
+        else
+        {
+            LogMessage(
+                "adapter %u: tearing isn't supported, presenting uncapped without it\n",
+                options.adapterIndex);
+        }
+    }
+
+    if (IsSwapchainWaitable(options))
+    {
+        flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    }
+
+    return flags;
+}
+
+void CreatePresentLatency(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+    const Options& options = pPipeline->options;
+
+    if (!IsSwapchainWaitable(options))
+    {
+        return;
+    }
+
+    // Waitable swapchains start with a latency of 1.
+    if (options.maxFrameLatency > 0)
+    {
+        ThrowIfFailed(pPipeline->swapchain->SetMaximumFrameLatency(options.maxFrameLatency));
+    }
+
+    pLatency->waitableObject = pPipeline->swapchain->GetFrameLatencyWaitableObject();
+}
+
+void WaitForPresentLatency(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+
+    if (pLatency->waitableObject == nullptr)
+    {
+        return;
+    }
+
+    // Bounded, so a swapchain that stops presenting doesn't hang the loop.
+    const UINT64 startTicks = GetCpuTicks();
+    WaitForSingleObjectEx(pLatency->waitableObject, 1000, TRUE);
+    pLatency->waitTicks += GetCpuTicks() - startTicks;
+}
+
+static void SampleFrameStatistics(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+
+    // Fails until frames are displayed, and while the statistics are
+    // disjoint, e.g. after a mode change; start over from the next sample.
+    DXGI_FRAME_STATISTICS stats = {};
+    if (FAILED(pPipeline->swapchain->GetFrameStatistics(&stats)))
+    {
+        pLatency->lastSyncQpcTime = 0;
+        return;
+    }
+
+    const UINT64 syncQpcTime = (UINT64)stats.SyncQPCTime.QuadPart;
+
+    if (pLatency->lastSyncQpcTime != 0)
+    {
+        if (stats.SyncRefreshCount != pLatency->lastSyncRefreshCount)
+        {
+            pLatency->refreshPeriodTicks =
+                (double)(syncQpcTime - pLatency->lastSyncQpcTime) /
+                (stats.SyncRefreshCount - pLatency->lastSyncRefreshCount);
+        }
+
+        const bool tracked = pLatency->lastPresentCount - stats.PresentCount < s_MaxTrackedPresentCount;
+        if (stats.PresentCount != pLatency->lastDisplayedPresentCount && tracked && pLatency->refreshPeriodTicks > 0.0)
+        {
+            pLatency->displayedFrameCount += stats.PresentCount - pLatency->lastDisplayedPresentCount;
+            pLatency->refreshCount += stats.PresentRefreshCount - pLatency->lastPresentRefreshCount;
+
+            // The frame went out that many refreshes before the sampled one.
+            const double displayTicks =
+                syncQpcTime - (double)(stats.SyncRefreshCount - stats.PresentRefreshCount) * pLatency->refreshPeriodTicks;
+            const double latencyTicks =
+                displayTicks - pLatency->presentTicks[stats.PresentCount % s_MaxTrackedPresentCount];
+            const double latencyMs = CpuTicksToMs((UINT64)max(latencyTicks, 0.0));
+
+            pLatency->latencySampleCount += 1;
+            pLatency->latencyTotalMs += latencyMs;
+            pLatency->latencyMaxMs = max(pLatency->latencyMaxMs, latencyMs);
+            ReportPresentLatency(pPipeline, latencyMs);
+        }
+    }
+
+    pLatency->lastDisplayedPresentCount = stats.PresentCount;
+    pLatency->lastPresentRefreshCount = stats.PresentRefreshCount;
+    pLatency->lastSyncRefreshCount = stats.SyncRefreshCount;
+    pLatency->lastSyncQpcTime = syncQpcTime;
+}
+
+void PresentFrame(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+    const Options& options = pPipeline->options;
+
+    // Tearing needs sync interval 0; asked for without support, it still
+    // presents uncapped.
+    const UINT syncInterval = (options.vsync && !options.tearing) ? 1 : 0;
+    const UINT flags = pLatency->tearing ? DXGI_PRESENT_ALLOW_TEARING : 0;
+
+    const UINT64 presentTicks = GetCpuTicks();
+    ThrowIfFailed(pPipeline->swapchain->Present(syncInterval, flags));
+
+    UINT presentCount = 0;
+    if (SUCCEEDED(pPipeline->swapchain->GetLastPresentCount(&presentCount)))
+    {
+        pLatency->presentTicks[presentCount % s_MaxTrackedPresentCount] = presentTicks;
+        pLatency->lastPresentCount = presentCount;
+    }
+
+    SampleFrameStatistics(pPipeline);
+}
+
+void LogPresentLatencyStats(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+
+    if (!pPipeline->swapchain)
+    {
+        return;
+    }
+
+    if (pLatency->latencySampleCount > 0)
+    {
+        LogMessage(
+            "adapter %u: present-to-display %.2f ms mean, %.2f ms max, %u frames shown over %u refreshes\n",
+            pPipeline->options.adapterIndex,
+            pLatency->latencyTotalMs / pLatency->latencySampleCount,
+            pLatency->latencyMaxMs,
+            pLatency->displayedFrameCount,
+            pLatency->refreshCount);
+    }
+
+    if (pLatency->waitableObject != nullptr)
+    {
+        LogMessage(
+            "adapter %u: %.1f ms waiting on the swapchain\n",
+            pPipeline->options.adapterIndex,
+            CpuTicksToMs(pLatency->waitTicks));
+    }
+
+    pLatency->waitTicks = 0;
+    pLatency->latencySampleCount = 0;
+    pLatency->latencyTotalMs = 0.0;
+    pLatency->latencyMaxMs = 0.0;
+    pLatency->displayedFrameCount = 0;
+    pLatency->refreshCount = 0;
+}
+
+void DestroyPresentLatency(Pipeline* pPipeline)
+{
+    PresentLatency* pLatency = &pPipeline->presentLatency;
+
+    if (pLatency->waitableObject != nullptr)
+    {
+        CloseHandle(pLatency->waitableObject);
+        pLatency->waitableObject = nullptr;
+    }
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+
+struct Pipeline;
+
+// Presents whose submit time is kept until they reach the display.
+static const UINT s_MaxTrackedPresentCount = 64;
+
+// Swapchain frame pacing and present-to-display latency.
+//
+// With `Options::waitableSwapchain` the frame loop blocks on the swapchain's
+// frame latency waitable object before recording a frame, so at most
+// `Options::maxFrameLatency` presents are queued and the frame starts from
+// fresh input. `Options::tearing` presents uncapped with
+// DXGI_PRESENT_ALLOW_TEARING, which only tears in independent flip, e.g. a
+// borderless full-screen window.
+//
+// Latency is measured from the Present() call to the vblank that scanned the
+// frame out, from GetFrameStatistics(). The statistics only describe the
+// last frame displayed; its vblank time is extrapolated from the last
+// sampled vblank with the refresh period measured between samples.
+struct PresentLatency
+{
+    HANDLE waitableObject;
+    // `Options::tearing`, if the factory supports it.
+    bool tearing;
+
+    // CPU ticks of recent presents by present count.
+    UINT64 presentTicks[s_MaxTrackedPresentCount];
+    UINT lastPresentCount;
+
+    // Last statistics sampled.
+    UINT lastDisplayedPresentCount;
+    UINT lastPresentRefreshCount;
+    UINT lastSyncRefreshCount;
+    UINT64 lastSyncQpcTime;
+    double refreshPeriodTicks;
+
+    // Since the last `LogPresentLatencyStats()`.
+    UINT64 waitTicks;
+    UINT64 latencySampleCount;
+    double latencyTotalMs;
+    double latencyMaxMs;
+    UINT displayedFrameCount;
+    UINT refreshCount;
+};
+
+// Check what the options ask for against the factory, and return the
+// swapchain creation flags it needs.
+UINT InitPresentLatency(Pipeline* pPipeline);
+
+// Get the waitable object of the new swapchain and set its frame latency.
+void CreatePresentLatency(Pipeline* pPipeline);
+
+// Block until the swapchain takes another frame, with a waitable swapchain.
+// Call before recording the frame.
+void WaitForPresentLatency(Pipeline* pPipeline);
+
+// Present the frame and sample the frame statistics.
+void PresentFrame(Pipeline* pPipeline);
+
+// Log latency, waits and displayed frames since the last call.
+void LogPresentLatencyStats(Pipeline* pPipeline);
+
+void DestroyPresentLatency(Pipeline* pPipeline);
@@ -0,0 +1,732 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "raytracing.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const UINT s_RaytracingThreadGroupSize = 64;
+static const UINT s_RayQueryTileSize = 8;
+
+// Distance between instances of the mesh, which is a unit square.
+static const float s_RaytracingInstanceSpacing = 1.25f;
+
+// Root parameter slots of `Raytracing::rootSignature`.
+static const UINT s_RaytracingRootParamConstants = 0;
+static const UINT s_RaytracingRootParamScene = 1;
+static const UINT s_RaytracingRootParamVertices = 2;
+static const UINT s_RaytracingRootParamDeformed = 3;
+static const UINT s_RaytracingRootParamOutput = 4;
+static const UINT s_RaytracingRootParamCount = 5;
+
+// Matches `RaytracingConstants` in raytracing.hlsl.
+struct RaytracingConstants
+{
+    UINT width;
+    UINT height;
+    UINT vertexCount;
+    UINT seed;
+    float extent;
+    UINT incoherent;
+    UINT padding[2];
+};
+
+// Exports of the library, in shader table order.
+static const wchar_t* s_RaytracingRecordExports[] =
+{
+    L"RayGenPrimary",
+    L"RayGenIncoherent",
+    L"Miss",
+    L"HitGroup",
+};
+
+// Matches `RayPayload` and the triangle barycentrics in raytracing.hlsl.
+static const UINT s_RayPayloadSize = sizeof(UINT);
+static const UINT s_RayAttributeSize = 2 * sizeof(float);
+
+static bool CheckRaytracingSupport(Pipeline* pPipeline)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    if (!IsDxcAvailable())
+    {
+        LogMessage("raytracing: disabled, needs dxcompiler.dll\n");
+        return false;
+    }
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS5 options5 = {};
+    if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &options5, sizeof(options5))) ||
+        options5.RaytracingTier < D3D12_RAYTRACING_TIER_1_1)
+    {
+        LogMessage("raytracing: disabled, the adapter doesn't support raytracing tier 1.1\n");
+        return false;
+    }
+
+    // RayQuery needs shader model 6.5; runtimes that don't know it fail the
+    // query.
+    D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { D3D_SHADER_MODEL_6_5 };
+    if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))) ||
+        shaderModel.HighestShaderModel < D3D_SHADER_MODEL_6_5)
+    {
+        LogMessage("raytracing: disabled, the adapter doesn't support shader model 6.5\n");
+        return false;
+    }
+
+    if (FAILED(pPipeline->device.As(&pRaytracing->device5)))
+    {
+        LogMessage("raytracing: disabled, the runtime has no ID3D12Device5\n");
+        return false;
+    }
+
+    return true;
+}
+
+static void CreateRaytracingPipelines(Pipeline* pPipeline)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+
+    // Create the root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_RaytracingRootParamCount] = {};
+        rootParameters[s_RaytracingRootParamConstants].InitAsConstants(sizeof(RaytracingConstants) / 4, 0);
+        rootParameters[s_RaytracingRootParamScene].InitAsShaderResourceView(0);
+        rootParameters[s_RaytracingRootParamVertices].InitAsShaderResourceView(1);
+        rootParameters[s_RaytracingRootParamDeformed].InitAsUnorderedAccessView(0);
+        rootParameters[s_RaytracingRootParamOutput].InitAsUnorderedAccessView(1);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pRaytracing->rootSignature);
+    }
+
+    const struct
+    {
+        const char* entryPoint;
+        ComPtr<ID3D12PipelineState>* pPipelineState;
+    } kernels[] =
+    {
+        { "CSDeform", &pRaytracing->deformPipelineState },
+        { "CSRayQuery", &pRaytracing->rayQueryPipelineState },
+    };
+
+    for (UINT i = 0; i < _countof(kernels); ++i)
+    {
+        ComPtr<ID3DBlob> computeShader;
+        CompileShader(L"raytracing.hlsl", kernels[i].entryPoint, "cs_6_5", nullptr, &computeShader);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pRaytracing->rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+        CreateComputePipelineState(pPipeline, L"raytracing", psoDesc, kernels[i].pPipelineState);
+    }
+
+    // Create the state object. The shader and root signature subobjects
+    // aren't associated with anything, so they apply to every export.
+    {
+        const D3D_SHADER_MACRO defines[] =
+        {
+            { "RAYTRACING_LIBRARY", "1" },
+            { nullptr, nullptr },
+        };
+
+        ComPtr<ID3DBlob> library;
+        CompileShader(L"raytracing.hlsl", "library", "lib_6_3", defines, &library);
+
+        CD3DX12_STATE_OBJECT_DESC stateObjectDesc(D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE);
+
+        CD3DX12_DXIL_LIBRARY_SUBOBJECT* pLibrary = stateObjectDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
+        const D3D12_SHADER_BYTECODE libraryBytecode = CD3DX12_SHADER_BYTECODE(library.Get());
+        pLibrary->SetDXILLibrary(&libraryBytecode);
+
+        CD3DX12_HIT_GROUP_SUBOBJECT* pHitGroup = stateObjectDesc.CreateSubobject<CD3DX12_HIT_GROUP_SUBOBJECT>();
+        pHitGroup->SetClosestHitShaderImport(L"ClosestHit");
+        pHitGroup->SetHitGroupExport(s_RaytracingRecordExports[3]);
+        pHitGroup->SetHitGroupType(D3D12_HIT_GROUP_TYPE_TRIANGLES);
+
+        CD3DX12_RAYTRACING_SHADER_CONFIG_SUBOBJECT* pShaderConfig =
+            stateObjectDesc.CreateSubobject<CD3DX12_RAYTRACING_SHADER_CONFIG_SUBOBJECT>();
+        pShaderConfig->Config(s_RayPayloadSize, s_RayAttributeSize);
+
+        CD3DX12_GLOBAL_ROOT_SIGNATURE_SUBOBJECT* pRootSignature =
+            stateObjectDesc.CreateSubobject<CD3DX12_GLOBAL_ROOT_SIGNATURE_SUBOBJECT>();
+        pRootSignature->SetRootSignature(pRaytracing->rootSignature.Get());
+
+        // Hits don't trace further.
+        CD3DX12_RAYTRACING_PIPELINE_CONFIG_SUBOBJECT* pPipelineConfig =
+            stateObjectDesc.CreateSubobject<CD3DX12_RAYTRACING_PIPELINE_CONFIG_SUBOBJECT>();
+        pPipelineConfig->Config(1);
+
+        ThrowIfFailed(pRaytracing->device5->CreateStateObject(
+            stateObjectDesc,
+            IID_PPV_ARGS(&pRaytracing->stateObject)));
+    }
+
+    // Fill the shader table: one record per table, and no local root
+    // arguments, so a record is just the shader identifier.
+    {
+        ComPtr<ID3D12StateObjectProperties> properties;
+        ThrowIfFailed(pRaytracing->stateObject.As(&properties));
+
+        const UINT64 tableStride = D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT;
+        const UINT64 recordSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
+
+        CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+        CD3DX12_RESOURCE_DESC tableDesc =
+            CD3DX12_RESOURCE_DESC::Buffer(tableStride * _countof(s_RaytracingRecordExports));
+        ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+            &uploadHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &tableDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&pRaytracing->shaderTable)));
+
+        UINT8* pTableData = nullptr;
+        CD3DX12_RANGE readRange(0, 0);
+        ThrowIfFailed(pRaytracing->shaderTable->Map(0, &readRange, reinterpret_cast<void**>(&pTableData)));
+        for (UINT i = 0; i < _countof(s_RaytracingRecordExports); ++i)
+        {
+            memcpy(
+                pTableData + i * tableStride,
+                properties->GetShaderIdentifier(s_RaytracingRecordExports[i]),
+                recordSize);
+        }
+        pRaytracing->shaderTable->Unmap(0, nullptr);
+
+        const D3D12_GPU_VIRTUAL_ADDRESS tableAddress = pRaytracing->shaderTable->GetGPUVirtualAddress();
+        pRaytracing->rayGenRecords[0] = { tableAddress, recordSize };
+        pRaytracing->rayGenRecords[1] = { tableAddress + tableStride, recordSize };
+        pRaytracing->missRecords = { tableAddress + 2 * tableStride, recordSize, recordSize };
+        pRaytracing->hitGroupRecords = { tableAddress + 3 * tableStride, recordSize, recordSize };
+    }
+}
+
+static D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS GetBlasInputs(const Raytracing* pRaytracing, bool update)
+{
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+    inputs.Flags =
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+    if (update)
+    {
+        inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+    }
+    inputs.NumDescs = 1;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.pGeometryDescs = &pRaytracing->geometryDesc;
+    return inputs;
+}
+
+static D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS GetTlasInputs(const Raytracing* pRaytracing, bool update)
+{
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+    inputs.Flags =
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+    if (update)
+    {
+        inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+    }
+    inputs.NumDescs = pRaytracing->instanceCount;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.InstanceDescs = pRaytracing->instanceBuffer->GetGPUVirtualAddress();
+    return inputs;
+}
+
+static void CreateRaytracingBuffer(
+    Pipeline* pPipeline,
+    UINT64 size,
+    D3D12_RESOURCE_STATES state,
+    ComPtr<ID3D12Resource>* pBuffer)
+{
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC bufferDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        state,
+        nullptr,
+        IID_PPV_ARGS(pBuffer->ReleaseAndGetAddressOf())));
+}
+
+// Create an acceleration structure and a scratch buffer large enough for
+// both builds and updates of it.
+static void CreateAccelerationStructure(
+    Pipeline* pPipeline,
+    const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs,
+    ComPtr<ID3D12Resource>* pAccelerationStructure,
+    ComPtr<ID3D12Resource>* pScratch)
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo = {};
+    pPipeline->raytracing.device5->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &prebuildInfo);
+
+    CreateRaytracingBuffer(
+        pPipeline,
+        prebuildInfo.ResultDataMaxSizeInBytes,
+        D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+        pAccelerationStructure);
+    CreateRaytracingBuffer(
+        pPipeline,
+        max(prebuildInfo.ScratchDataSizeInBytes, prebuildInfo.UpdateScratchDataSizeInBytes),
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        pScratch);
+}
+
+// Instances on a square grid facing the camera, staggered in depth so rays
+// between them go on to the next ones.
+static void CreateRaytracingInstances(Pipeline* pPipeline)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+
+    pRaytracing->instanceCount = pPipeline->options.raytracingInstances;
+    const UINT gridSize = (UINT)ceil(sqrt((double)pRaytracing->instanceCount));
+    pRaytracing->extent = gridSize * s_RaytracingInstanceSpacing;
+
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC instanceDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)pRaytracing->instanceCount * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &instanceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pRaytracing->instanceBuffer)));
+
+    D3D12_RAYTRACING_INSTANCE_DESC* pInstances = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(pRaytracing->instanceBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pInstances)));
+
+    const float origin = -0.5f * (gridSize - 1) * s_RaytracingInstanceSpacing;
+    for (UINT i = 0; i < pRaytracing->instanceCount; ++i)
+    {
+        D3D12_RAYTRACING_INSTANCE_DESC* pInstance = &pInstances[i];
+        memset(pInstance, 0, sizeof(*pInstance));
+
+        // Row-major 3x4, translation in the last column.
+        pInstance->Transform[0][0] = 1.0f;
+        pInstance->Transform[1][1] = 1.0f;
+        pInstance->Transform[2][2] = 1.0f;
+        pInstance->Transform[0][3] = origin + (i % gridSize) * s_RaytracingInstanceSpacing;
+        pInstance->Transform[1][3] = origin + (i / gridSize) * s_RaytracingInstanceSpacing;
+        pInstance->Transform[2][3] = 0.25f * (i % 4);
+        pInstance->InstanceID = i;
+        pInstance->InstanceMask = 0xff;
+        pInstance->AccelerationStructure = pRaytracing->blas->GetGPUVirtualAddress();
+    }
+
+    pRaytracing->instanceBuffer->Unmap(0, nullptr);
+}
+
+// Bind the root signature and every root argument; each pass only touches
+// its own.
+static void SetRaytracingRootArguments(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT seed,
+    bool incoherent)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+
+    RaytracingConstants constants = {};
+    constants.width = pPipeline->options.width;
+    constants.height = pPipeline->options.height;
+    constants.vertexCount = pPipeline->geometry.vertexCount;
+    constants.seed = seed;
+    constants.extent = pRaytracing->extent;
+    constants.incoherent = incoherent ? 1 : 0;
+
+    pCmdList->SetComputeRootSignature(pRaytracing->rootSignature.Get());
+    pCmdList->SetComputeRoot32BitConstants(
+        s_RaytracingRootParamConstants,
+        sizeof(RaytracingConstants) / 4,
+        &constants,
+        0);
+    pCmdList->SetComputeRootShaderResourceView(
+        s_RaytracingRootParamScene,
+        pRaytracing->tlas->GetGPUVirtualAddress());
+    pCmdList->SetComputeRootShaderResourceView(
+        s_RaytracingRootParamVertices,
+        pPipeline->geometry.vertexBuffer->GetGPUVirtualAddress());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_RaytracingRootParamDeformed,
+        pRaytracing->deformedVertexBuffer->GetGPUVirtualAddress());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_RaytracingRootParamOutput,
+        pRaytracing->outputBuffer->GetGPUVirtualAddress());
+}
+
+// Wait for every UAV write before, acceleration structure builds included.
+static void RecordRaytracingUavBarrier(ID3D12GraphicsCommandList* pCmdList)
+{
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+    pCmdList->ResourceBarrier(1, &barrier);
+}
+
+// Ripple the positions the BLAS is built from. Root arguments must be set.
+static void RecordRaytracingDeform(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        pRaytracing->deformedVertexBuffer.Get(),
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmdList->ResourceBarrier(1, &barrier);
+
+    pCmdList->SetPipelineState(pRaytracing->deformPipelineState.Get());
+    const UINT vertexCount = pPipeline->geometry.vertexCount;
+    pCmdList->Dispatch((vertexCount + s_RaytracingThreadGroupSize - 1) / s_RaytracingThreadGroupSize, 1, 1);
+
+    barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        pRaytracing->deformedVertexBuffer.Get(),
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCmdList->ResourceBarrier(1, &barrier);
+}
+
+static void RecordBlasBuild(Pipeline* pPipeline, ID3D12GraphicsCommandList4* pCmdList, bool update)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+    buildDesc.Inputs = GetBlasInputs(pRaytracing, update);
+    buildDesc.DestAccelerationStructureData = pRaytracing->blas->GetGPUVirtualAddress();
+    buildDesc.SourceAccelerationStructureData = update ? buildDesc.DestAccelerationStructureData : 0;
+    buildDesc.ScratchAccelerationStructureData = pRaytracing->blasScratch->GetGPUVirtualAddress();
+    pCmdList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+}
+
+static void RecordTlasBuild(Pipeline* pPipeline, ID3D12GraphicsCommandList4* pCmdList, bool update)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+    buildDesc.Inputs = GetTlasInputs(pRaytracing, update);
+    buildDesc.DestAccelerationStructureData = pRaytracing->tlas->GetGPUVirtualAddress();
+    buildDesc.SourceAccelerationStructureData = update ? buildDesc.DestAccelerationStructureData : 0;
+    buildDesc.ScratchAccelerationStructureData = pRaytracing->tlasScratch->GetGPUVirtualAddress();
+    pCmdList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+}
+
+// Both levels, the TLAS once the BLAS it points to is complete.
+static void RecordRaytracingBuilds(Pipeline* pPipeline, ID3D12GraphicsCommandList4* pCmdList, bool update)
+{
+    RecordBlasBuild(pPipeline, pCmdList, update);
+    RecordRaytracingUavBarrier(pCmdList);
+    RecordTlasBuild(pPipeline, pCmdList, update);
+}
+
+// Trace a ray per output element. Root arguments must be set.
+static void RecordRaytracingTrace(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList4* pCmdList,
+    RaytracingMode mode,
+    bool incoherent)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+    const UINT width = pPipeline->options.width;
+    const UINT height = pPipeline->options.height;
+
+    if (mode == RaytracingMode::DispatchRays)
+    {
+        D3D12_DISPATCH_RAYS_DESC dispatchDesc = {};
+        dispatchDesc.RayGenerationShaderRecord = pRaytracing->rayGenRecords[incoherent ? 1 : 0];
+        dispatchDesc.MissShaderTable = pRaytracing->missRecords;
+        dispatchDesc.HitGroupTable = pRaytracing->hitGroupRecords;
+        dispatchDesc.Width = width;
+        dispatchDesc.Height = height;
+        dispatchDesc.Depth = 1;
+
+        pCmdList->SetPipelineState1(pRaytracing->stateObject.Get());
+        pCmdList->DispatchRays(&dispatchDesc);
+    }
+    else
+    {
+        pCmdList->SetPipelineState(pRaytracing->rayQueryPipelineState.Get());
+        pCmdList->Dispatch(
+            (width + s_RayQueryTileSize - 1) / s_RayQueryTileSize,
+            (height + s_RayQueryTileSize - 1) / s_RayQueryTileSize,
+            1);
+    }
+}
+
+void CreateRaytracing(Pipeline* pPipeline)
+{
+    Raytracing* pRaytracing = &pPipeline->raytracing;
+    Geometry* pGeometry = &pPipeline->geometry;
+
+    if (!CheckRaytracingSupport(pPipeline))
+    {
+        return;
+    }
+
+    CreateRaytracingPipelines(pPipeline);
+
+    // Built from the deformed positions, against the geometry workload's
+    // indices.
+    CreateRaytracingBuffer(
+        pPipeline,
+        (UINT64)pGeometry->vertexCount * 12,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        &pRaytracing->deformedVertexBuffer);
+
+    D3D12_RAYTRACING_GEOMETRY_DESC* pGeometryDesc = &pRaytracing->geometryDesc;
+    pGeometryDesc->Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+    pGeometryDesc->Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+    pGeometryDesc->Triangles.VertexBuffer.StartAddress = pRaytracing->deformedVertexBuffer->GetGPUVirtualAddress();
+    pGeometryDesc->Triangles.VertexBuffer.StrideInBytes = 12;
+    pGeometryDesc->Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+    pGeometryDesc->Triangles.VertexCount = pGeometry->vertexCount;
+    pGeometryDesc->Triangles.IndexBuffer = pGeometry->indexBuffer->GetGPUVirtualAddress();
+    pGeometryDesc->Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+    pGeometryDesc->Triangles.IndexCount = pGeometry->indexCount;
+
+    CreateAccelerationStructure(pPipeline, GetBlasInputs(pRaytracing, false), &pRaytracing->blas, &pRaytracing->blasScratch);
+    CreateRaytracingInstances(pPipeline);
+    CreateAccelerationStructure(pPipeline, GetTlasInputs(pRaytracing, false), &pRaytracing->tlas, &pRaytracing->tlasScratch);
+
+    CreateRaytracingBuffer(
+        pPipeline,
+        (UINT64)pPipeline->options.width * pPipeline->options.height * sizeof(UINT),
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        &pRaytracing->outputBuffer);
+
+    // Build once, so the frames can trace or refit from the start. The
+    // pipeline's fence doesn't exist yet.
+    {
+        ComPtr<ID3D12CommandAllocator> cmdAlloc;
+        ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(&cmdAlloc)));
+
+        ComPtr<ID3D12GraphicsCommandList4> cmdList;
+        ThrowIfFailed(pRaytracing->device5->CreateCommandList(
+            0,
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            cmdAlloc.Get(),
+            nullptr,
+            IID_PPV_ARGS(&cmdList)));
+
+        SetRaytracingRootArguments(pPipeline, cmdList.Get(), 0, false);
+        RecordRaytracingDeform(pPipeline, cmdList.Get());
+        RecordRaytracingBuilds(pPipeline, cmdList.Get(), false);
+        ThrowIfFailed(cmdList->Close());
+
+        ID3D12CommandList* ppCommandLists[] = { cmdList.Get() };
+        pPipeline->cmdQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+        ComPtr<ID3D12Fence> fence;
+        ThrowIfFailed(pPipeline->device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+        ThrowIfFailed(pPipeline->cmdQueue->Signal(fence.Get(), 1));
+        // Blocks in SetEventOnCompletion().
+        ThrowIfFailed(fence->SetEventOnCompletion(1, nullptr));
+    }
+
+    LogMessage(
+        "raytracing: %u triangles per BLAS, %u instances, %ux%u rays per trace\n",
+        pGeometry->indexCount / 3,
+        pRaytracing->instanceCount,
+        pPipeline->options.width,
+        pPipeline->options.height);
+
+    pRaytracing->supported = true;
+}
+
+void RecordRaytracing(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    if (!pPipeline->raytracing.supported)
+    {
+        return;
+    }
+
+    ComPtr<ID3D12GraphicsCommandList4> cmdList4;
+    ThrowIfFailed(pCmdList->QueryInterface(IID_PPV_ARGS(&cmdList4)));
+
+    const RaytracingMode mode = pPipeline->options.raytracingMode;
+    const bool incoherent = pPipeline->options.raytracingIncoherent;
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+
+        RecordRaytracingUavBarrier(cmdList4.Get());
+        SetRaytracingRootArguments(pPipeline, cmdList4.Get(), seed, incoherent);
+
+        switch (mode)
+        {
+        case RaytracingMode::Build:
+            RecordRaytracingBuilds(pPipeline, cmdList4.Get(), false);
+            break;
+
+        case RaytracingMode::Refit:
+            RecordRaytracingDeform(pPipeline, cmdList4.Get());
+            RecordRaytracingBuilds(pPipeline, cmdList4.Get(), true);
+            break;
+
+        default:
+            RecordRaytracingTrace(pPipeline, cmdList4.Get(), mode, incoherent);
+            break;
+        }
+    }
+}
+
+// What a sweep case times.
+enum class RaytracingCase
+{
+    BlasBuild,
+    BlasRefit,
+    TlasBuild,
+    TlasRefit,
+    Trace,
+};
+
+static void RunRaytracingCase(
+    Pipeline* pPipeline,
+    ID3D12CommandAllocator* pCmdAlloc,
+    ID3D12GraphicsCommandList4* pCmdList,
+    RaytracingCase kind,
+    RaytracingMode traceMode,
+    bool incoherent,
+    const char* name)
+{
+    const UINT iterations = pPipeline->options.raytracingSweepIterations;
+
+    ThrowIfFailed(pCmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pCmdAlloc, nullptr));
+
+    SetRaytracingRootArguments(pPipeline, pCmdList, 0, incoherent);
+
+    BeginGpuMeasurement(pPipeline, pCmdList);
+    for (UINT i = 0; i < iterations; ++i)
+    {
+        RecordRaytracingUavBarrier(pCmdList);
+
+        switch (kind)
+        {
+        case RaytracingCase::BlasBuild:
+        case RaytracingCase::BlasRefit:
+            RecordBlasBuild(pPipeline, pCmdList, kind == RaytracingCase::BlasRefit);
+            break;
+
+        case RaytracingCase::TlasBuild:
+        case RaytracingCase::TlasRefit:
+            RecordTlasBuild(pPipeline, pCmdList, kind == RaytracingCase::TlasRefit);
+            break;
+
+        case RaytracingCase::Trace:
+            RecordRaytracingTrace(pPipeline, pCmdList, traceMode, incoherent);
+            break;
+        }
+    }
+    EndGpuMeasurement(pPipeline, pCmdList);
+    ThrowIfFailed(pCmdList->Close());
+
+    const double elapsedMs = ExecuteTimedSweepList(pPipeline, pCmdList);
+
+    if (kind == RaytracingCase::Trace)
+    {
+        const double rays = (double)pPipeline->options.width * pPipeline->options.height * iterations;
+        const double megaRaysPerSecond = GetRate(rays, elapsedMs, 1.0e6);
+
+        LogMessage("%s: %.1f Mrays/s (%.3f ms)\n", name, megaRaysPerSecond, elapsedMs);
+        ReportSweepResult(pPipeline, name, megaRaysPerSecond, "Mrays/s", elapsedMs);
+    }
+    else
+    {
+        const double buildMs = elapsedMs / iterations;
+
+        LogMessage("%s: %.3f ms (%.3f ms)\n", name, buildMs, elapsedMs);
+        ReportSweepResult(pPipeline, name, buildMs, "ms", elapsedMs);
+    }
+}
+
+void RunRaytracingSweep(Pipeline* pPipeline)
+{
+    if (!pPipeline->raytracing.supported)
+    {
+        return;
+    }
+
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList4> cmdList;
+    ThrowIfFailed(pPipeline->raytracing.device5->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    // Builds first, the TLAS last, so the traces see a TLAS pointing at the
+    // current BLAS.
+    static const struct
+    {
+        RaytracingCase kind;
+        const char* name;
+    } s_BuildCases[] =
+    {
+        { RaytracingCase::BlasBuild, "raytracing blas build" },
+        { RaytracingCase::BlasRefit, "raytracing blas refit" },
+        { RaytracingCase::TlasBuild, "raytracing tlas build" },
+        { RaytracingCase::TlasRefit, "raytracing tlas refit" },
+    };
+
+    for (const auto& buildCase : s_BuildCases)
+    {
+        RunRaytracingCase(
+            pPipeline,
+            cmdAlloc.Get(),
+            cmdList.Get(),
+            buildCase.kind,
+            RaytracingMode::DispatchRays,
+            false,
+            buildCase.name);
+    }
+
+    const RaytracingMode traceModes[] = { RaytracingMode::DispatchRays, RaytracingMode::RayQuery };
+
+    char name[128];
+    for (RaytracingMode traceMode : traceModes)
+    {
+        for (UINT incoherent = 0; incoherent < 2; ++incoherent)
+        {
+            snprintf(
+                name,
+                sizeof(name),
+                "raytracing %s %s",
+                GetRaytracingModeName(traceMode),
+                incoherent ? "incoherent" : "primary");
+            RunRaytracingCase(
+                pPipeline,
+                cmdAlloc.Get(),
+                cmdList.Get(),
+                RaytracingCase::Trace,
+                traceMode,
+                incoherent != 0,
+                name);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// DXR stress over the geometry workload's grid mesh: a BLAS of the mesh and
+// a TLAS of `Options::raytracingInstances` instances of it, side by side.
+// Every draw, per `Options::raytracingMode`:
+//   - builds both from scratch,
+//   - ripples the mesh with a compute pass and refits both,
+//   - traces `Options::width` x `Options::height` rays with DispatchRays(),
+//   - or traces as many inline, with RayQuery from a compute shader,
+// primary rays from a camera, or incoherent ones with
+// `Options::raytracingIncoherent`, see raytracing.hlsl.
+//
+// Needs raytracing tier 1.1, for RayQuery, shader model 6.5 and
+// dxcompiler.dll; without them nothing is created or recorded.
+struct Raytracing
+{
+    bool supported;
+    Microsoft::WRL::ComPtr<ID3D12Device5> device5;
+
+    // For the compute passes and, as the global root signature, the state
+    // object: root constants at b0, the TLAS and the mesh's vertices as root
+    // SRVs at t0 and t1, the deformed positions and the output as root UAVs
+    // at u0 and u1.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> deformPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> rayQueryPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12StateObject> stateObject;
+
+    // Ray generation records for primary and incoherent rays, then the miss
+    // and hit group records, each on a table boundary.
+    Microsoft::WRL::ComPtr<ID3D12Resource> shaderTable;
+    D3D12_GPU_VIRTUAL_ADDRESS_RANGE rayGenRecords[2];
+    D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE missRecords;
+    D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE hitGroupRecords;
+
+    // Positions the BLAS is built from, in the non-pixel shader resource
+    // state between deform passes.
+    Microsoft::WRL::ComPtr<ID3D12Resource> deformedVertexBuffer;
+    D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc;
+
+    // Refits need the update scratch size, builds the build one; each
+    // scratch buffer has the larger.
+    Microsoft::WRL::ComPtr<ID3D12Resource> blas;
+    Microsoft::WRL::ComPtr<ID3D12Resource> blasScratch;
+    Microsoft::WRL::ComPtr<ID3D12Resource> tlas;
+    Microsoft::WRL::ComPtr<ID3D12Resource> tlasScratch;
+    // Upload heap instance descriptions, written once.
+    Microsoft::WRL::ComPtr<ID3D12Resource> instanceBuffer;
+    UINT instanceCount;
+    // Width and height of the instance grid.
+    float extent;
+
+    // A uint per ray.
+    Microsoft::WRL::ComPtr<ID3D12Resource> outputBuffer;
+};
+
+// Check for raytracing support, then create the root signature, pipelines,
+// shader table and acceleration structures, and build them once. Requires
+// CreateGeometryResources(). Blocks until the builds are complete.
+void CreateRaytracing(Pipeline* pPipeline);
+
+// Record builds, refits or traces [firstDraw, firstDraw + drawCount), each
+// starting with UAV barriers on what the previous one wrote, so draws in
+// other threads' lists stay ordered too.
+void RecordRaytracing(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time full builds and refits of each level, and both kinds of ray through
+// both paths, `Options::raytracingSweepIterations` of each, and log build ms
+// and rays per second. The GPU must be idle; returns with the GPU idle.
+void RunRaytracingSweep(Pipeline* pPipeline);
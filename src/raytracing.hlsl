@@ -0,0 +1,163 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Rays against the TLAS of the raytracing workload, one per output element,
+// traced with DispatchRays() from a library or inline with RayQuery from a
+// compute shader. Primary rays leave a pinhole camera through a grid, so
+// neighbouring rays hit neighbouring triangles; incoherent rays start
+// anywhere in front of the scene and go anywhere into it.
+//
+// The file compiles twice: with RAYTRACING_LIBRARY as a lib_6_3 library,
+// else for the compute entry points, which need shader model 6.5.
+
+cbuffer RaytracingConstants : register(b0)
+{
+    // Rays per dispatch, as a grid.
+    uint width;
+    uint height;
+    uint vertexCount;
+    // Changes every dispatch.
+    uint seed;
+    // Width and height of the instance grid the camera covers.
+    float extent;
+    // Whether CSRayQuery traces incoherent rays.
+    uint incoherent;
+    uint2 padding;
+};
+
+RaytracingAccelerationStructure scene : register(t0);
+// The geometry workload's vertices, 32 bytes each, position first.
+ByteAddressBuffer sourceVertices : register(t1);
+// Positions the BLAS is built from, 12 bytes each.
+RWByteAddressBuffer deformedVertices : register(u0);
+// What every ray hit: the primitive index plus one, 0 for a miss.
+RWByteAddressBuffer output : register(u1);
+
+uint Hash(uint value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352d;
+    value ^= value >> 15;
+    value *= 0x846ca68b;
+    value ^= value >> 16;
+    return value;
+}
+
+float Random(inout uint state)
+{
+    state = Hash(state);
+    return (state >> 8) * (1.0 / 16777216.0);
+}
+
+RayDesc GetPrimaryRay(uint2 index)
+{
+    const float2 uv = (index + 0.5) / float2(width, height);
+
+    RayDesc ray;
+    ray.Origin = float3(0.0, 0.0, -extent);
+    ray.Direction = normalize(float3((uv * 2.0 - 1.0) * (0.5 * extent), 0.5 + extent));
+    ray.TMin = 0.0;
+    ray.TMax = 4.0 * extent;
+    return ray;
+}
+
+RayDesc GetIncoherentRay(uint2 index)
+{
+    uint state = Hash(index.y * width + index.x) ^ seed;
+
+    const float z = Random(state);
+    const float phi = 6.2831853 * Random(state);
+    const float r = sqrt(1.0 - z * z);
+
+    RayDesc ray;
+    ray.Origin = float3((float2(Random(state), Random(state)) - 0.5) * extent, -0.5);
+    ray.Direction = float3(r * cos(phi), r * sin(phi), z);
+    ray.TMin = 0.0;
+    ray.TMax = 4.0 * extent;
+    return ray;
+}
+
+void WriteHit(uint2 index, uint hit)
+{
+    output.Store((index.y * width + index.x) * 4, hit);
+}
+
+#if defined(RAYTRACING_LIBRARY)
+
+struct RayPayload
+{
+    uint hit;
+};
+
+void Trace(uint2 index, RayDesc ray)
+{
+    RayPayload payload = { 0 };
+    TraceRay(scene, RAY_FLAG_FORCE_OPAQUE, 0xff, 0, 1, 0, ray, payload);
+    WriteHit(index, payload.hit);
+}
+
+[shader("raygeneration")]
+void RayGenPrimary()
+{
+    const uint2 index = DispatchRaysIndex().xy;
+    Trace(index, GetPrimaryRay(index));
+}
+
+[shader("raygeneration")]
+void RayGenIncoherent()
+{
+    const uint2 index = DispatchRaysIndex().xy;
+    Trace(index, GetIncoherentRay(index));
+}
+
+[shader("miss")]
+void Miss(inout RayPayload payload)
+{
+    payload.hit = 0;
+}
+
+[shader("closesthit")]
+void ClosestHit(inout RayPayload payload, in BuiltInTriangleIntersectionAttributes attributes)
+{
+    payload.hit = PrimitiveIndex() + 1;
+}
+
+#else
+
+[numthreads(8, 8, 1)]
+void CSRayQuery(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint2 index = dispatchThreadId.xy;
+    if (index.x >= width || index.y >= height)
+    {
+        return;
+    }
+
+    const RayDesc ray = incoherent ? GetIncoherentRay(index) : GetPrimaryRay(index);
+
+    // Opaque triangles only, so one Proceed() finds the closest hit.
+    RayQuery<RAY_FLAG_FORCE_OPAQUE> query;
+    query.TraceRayInline(scene, RAY_FLAG_NONE, 0xff, ray);
+    query.Proceed();
+
+    const bool hit = query.CommittedStatus() == COMMITTED_TRIANGLE_HIT;
+    WriteHit(index, hit ? query.CommittedPrimitiveIndex() + 1 : 0);
+}
+
+// Ripple the mesh, so refits have something to do.
+[numthreads(64, 1, 1)]
+void CSDeform(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint vertex = dispatchThreadId.x;
+    if (vertex >= vertexCount)
+    {
+        return;
+    }
+
+    float3 position = asfloat(sourceVertices.Load3(vertex * 32));
+    const float phase = (seed % 1024) * (6.2831853 / 1024.0);
+    position.z += 0.05 * sin(phase + 20.0 * position.x) * cos(phase + 20.0 * position.y);
+
+    deformedVertices.Store3(vertex * 12, asuint(position));
+}
+
+#endif
@@ -0,0 +1,167 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "record-cache.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <stdio.h>
+
+using namespace DirectX;
+
+void CreateRecordCache(Pipeline* pPipeline)
+{
+    RecordCache* pCache = &pPipeline->recordCache;
+    const Options& options = pPipeline->options;
+
+    pCache->mode = RecordMode::Record;
+    pCache->supported = options.workload == Workload::Triangle && options.recordThreadCount == 0;
+
+    if (options.recordMode == RecordMode::Record)
+    {
+        return;
+    }
+
+    if (!pCache->supported)
+    {
+        LogMessage(
+            "record mode %s needs the triangle workload without record threads, re-recording instead\n",
+            GetRecordModeName(options.recordMode));
+        return;
+    }
+
+    pCache->mode = options.recordMode;
+
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_BUNDLE,
+        IID_PPV_ARGS(&pCache->bundleAlloc)));
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_BUNDLE,
+        pCache->bundleAlloc.Get(),
+        pPipeline->pipelineState.Get(),
+        IID_PPV_ARGS(&pCache->bundle)));
+
+    // Bundles can't set descriptor heaps of their own or render targets, the
+    // triangle draws need neither.
+    RecordDraws(pPipeline, pCache->bundle.Get(), 0, options.drawCount);
+    ThrowIfFailed(pCache->bundle->Close());
+
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pCache->drawDataBuffer)));
+
+    DrawData* pDrawData;
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pCache->drawDataBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pDrawData)));
+    pDrawData->color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    pCache->drawDataBuffer->Unmap(0, nullptr);
+}
+
+void ExecuteRecordCacheBundle(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    pCmdList->ExecuteBundle(pPipeline->recordCache.bundle.Get());
+}
+
+ID3D12GraphicsCommandList* GetRecordCacheList(Pipeline* pPipeline)
+{
+    RecordCache* pCache = &pPipeline->recordCache;
+    const UINT frame = pPipeline->frameResourceIndex;
+    const UINT backBuffer = pPipeline->backBufferIndex;
+
+    ComPtr<ID3D12GraphicsCommandList>& cmdList = pCache->cmdLists[frame][backBuffer];
+    if (cmdList)
+    {
+        return cmdList.Get();
+    }
+
+    ComPtr<ID3D12CommandAllocator>& cmdAlloc = pCache->cmdAllocs[frame][backBuffer];
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        pPipeline->pipelineState.Get(),
+        IID_PPV_ARGS(&cmdList)));
+
+    // The frame's constant buffer table and render target are fixed by the
+    // pair. SetDrawState()'s draw data comes from the upload ring, which
+    // later frames overwrite, so bind data that lasts instead.
+    SetDrawState(pPipeline, cmdList.Get());
+    cmdList->SetGraphicsRootConstantBufferView(
+        s_RootParamDrawData,
+        pCache->drawDataBuffer->GetGPUVirtualAddress());
+    RecordDraws(pPipeline, cmdList.Get(), 0, pPipeline->options.drawCount);
+    ThrowIfFailed(cmdList->Close());
+
+    return cmdList.Get();
+}
+
+// CPU time recording and submitting a frame, and wall time per frame, in
+// `mode`. The frames aren't presented, so they run as fast as the slower of
+// the CPU and GPU allows.
+static void MeasureRecordMode(Pipeline* pPipeline, RecordMode mode, double* pCpuMs, double* pFrameMs)
+{
+    const UINT frameCount = pPipeline->options.recordSweepFrames;
+
+    pPipeline->recordCache.mode = mode;
+
+    // Warm up so the first frames' costs, recording the reused lists among
+    // them, stay out of the measurement.
+    RenderFrames(pPipeline, pPipeline->options.frameCount * pPipeline->options.frameCount);
+
+    const UINT64 startTicks = GetCpuTicks();
+    const UINT64 cpuTicks = RenderFrames(pPipeline, frameCount);
+    const double elapsedMs = CpuTicksToMs(GetCpuTicks() - startTicks);
+
+    *pCpuMs = CpuTicksToMs(cpuTicks) / frameCount;
+    *pFrameMs = elapsedMs / frameCount;
+}
+
+void RunRecordCacheSweep(Pipeline* pPipeline)
+{
+    RecordCache* pCache = &pPipeline->recordCache;
+
+    double recordCpuMs = 0.0;
+    char name[64];
+
+    for (UINT mode = 0; mode < s_RecordModeCount; ++mode)
+    {
+        double cpuMs = 0.0;
+        double frameMs = 0.0;
+        MeasureRecordMode(pPipeline, (RecordMode)mode, &cpuMs, &frameMs);
+
+        if ((RecordMode)mode == RecordMode::Record)
+        {
+            recordCpuMs = cpuMs;
+        }
+
+        // How much of re-recording's CPU time caching saves.
+        const double savedPercent = (recordCpuMs > 0.0) ? (1.0 - cpuMs / recordCpuMs) * 100.0 : 0.0;
+        const char* modeName = GetRecordModeName((RecordMode)mode);
+
+        LogMessage(
+            "record %s: %.3f CPU ms/frame, %.3f ms/frame, %.1f%% CPU saved\n",
+            modeName,
+            cpuMs,
+            frameMs,
+            savedPercent);
+
+        snprintf(name, sizeof(name), "record %s cpu", modeName);
+        ReportSweepResult(pPipeline, name, cpuMs, "ms/frame", frameMs);
+        snprintf(name, sizeof(name), "record %s frame", modeName);
+        ReportSweepResult(pPipeline, name, frameMs, "ms/frame", frameMs);
+        snprintf(name, sizeof(name), "record %s saved", modeName);
+        ReportSweepResult(pPipeline, name, savedPercent, "%", frameMs);
+    }
+
+    // Restore the frame loop's configuration.
+    pCache->mode = pPipeline->options.recordMode;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Draws recorded once and replayed every frame, to measure what re-recording
+// costs. The frame's own list still records its prologue and epilogue; only
+// the draws are cached, either in a bundle the list executes or in closed
+// direct lists executed between `cmdList` and `postCmdList`.
+//
+// Only the triangle workload's draws are the same every frame, and worker
+// threads record a fresh list each frame by design, so other
+// configurations re-record.
+struct RecordCache
+{
+    // Mode of the frames being recorded. The sweep switches through all of
+    // them.
+    RecordMode mode;
+    // Set when the draws can be cached at all.
+    bool supported;
+
+    // Inherits the root signature and its bindings from the list executing
+    // it.
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> bundleAlloc;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> bundle;
+
+    // Per frame resource and back buffer, recorded the first time the pair
+    // comes up and never reset after. Each has an allocator of its own.
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> cmdAllocs[s_MaxFrameCount][s_MaxFrameCount];
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> cmdLists[s_MaxFrameCount][s_MaxFrameCount];
+    // Neutral `DrawData` for the reused lists; upload ring slices only last
+    // a frame.
+    Microsoft::WRL::ComPtr<ID3D12Resource> drawDataBuffer;
+};
+
+// Record the bundle and create the draw data. Requires the main PSO, root
+// signature and vertex buffer. Falls back to re-recording, with a message,
+// when the configuration's draws can't be cached.
+void CreateRecordCache(Pipeline* pPipeline);
+
+// Bundle mode: execute the frame's draws from the bundle. The list must have
+// the draw state set.
+void ExecuteRecordCacheBundle(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList);
+
+// Reuse mode: the closed list of the current frame resource and back buffer,
+// recorded on first use.
+ID3D12GraphicsCommandList* GetRecordCacheList(Pipeline* pPipeline);
+
+// Render frames in every mode and log CPU and wall time per frame next to
+// re-recording. Runs when `Options::recordMode` caches and the
+// configuration supports it. The GPU must be idle; returns with the GPU
+// idle.
+void RunRecordCacheSweep(Pipeline* pPipeline);
@@ -0,0 +1,210 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "record-threads.h"
+#include "pipeline.h"
+
+static void RecordThreadCommandList(RecordThread* pThread)
+{
+    Pipeline* pPipeline = pThread->pPool->pPipeline;
+    const UINT64 recordTicks = BeginTelemetryMarker(pPipeline, TelemetryMarker::Record);
+
+    // The main thread has already waited on this frame resource's fence, so
+    // the allocator is no longer referenced by the GPU.
+    ID3D12CommandAllocator* pCmdAlloc =
+        pThread->cmdAllocs[pPipeline->frameResourceIndex].Get();
+    ThrowIfFailed(pCmdAlloc->Reset());
+
+    ThrowIfFailed(pThread->cmdList->Reset(
+        pCmdAlloc,
+        pPipeline->pipelineState.Get()));
+
+    SetDrawState(pPipeline, pThread->cmdList.Get());
+    RecordDraws(pPipeline, pThread->cmdList.Get(), pThread->firstDraw, pThread->drawCount);
+
+    ThrowIfFailed(pThread->cmdList->Close());
+
+    EndTelemetryMarker(pPipeline, 1 + pThread->threadIndex, TelemetryMarker::Record, recordTicks);
+}
+
+static DWORD WINAPI RecordThreadProc(LPVOID pParam)
+{
+    RecordThread* pThread = reinterpret_cast<RecordThread*>(pParam);
+
+    for (;;)
+    {
+        WaitForSingleObject(pThread->beginEvent, INFINITE);
+
+        if (pThread->pPool->quit)
+        {
+            break;
+        }
+
+        // Anything escaping here would terminate the process before the main
+        // thread could report the failure.
+        try
+        {
+            RecordThreadCommandList(pThread);
+            pThread->result = S_OK;
+        }
+        catch (const HResultException& e)
+        {
+            pThread->result = e.hr;
+        }
+        catch (const std::exception&)
+        {
+            pThread->result = E_FAIL;
+        }
+
+        SetEvent(pThread->finishEvent);
+    }
+
+    return 0;
+}
+
+static void CloseRecordThreadEvents(RecordThread* pThread)
+{
+    if (pThread->beginEvent != nullptr)
+    {
+        CloseHandle(pThread->beginEvent);
+        pThread->beginEvent = nullptr;
+    }
+    if (pThread->finishEvent != nullptr)
+    {
+        CloseHandle(pThread->finishEvent);
+        pThread->finishEvent = nullptr;
+    }
+}
+
+void CreateRecordThreads(Pipeline* pPipeline)
+{
+    RecordThreadPool* pPool = &pPipeline->recordThreads;
+    pPool->pPipeline = pPipeline;
+    pPool->quit = false;
+
+    // Counts only the threads that are running, so that if creation throws
+    // DestroyRecordThreads() joins exactly those.
+    pPool->threadCount = 0;
+
+    for (UINT i = 0; i < pPipeline->options.recordThreadCount; ++i)
+    {
+        RecordThread* pThread = &pPool->threads[i];
+        pThread->pPool = pPool;
+        pThread->threadIndex = i;
+        pThread->result = S_OK;
+
+        for (UINT frame = 0; frame < pPipeline->options.frameCount; ++frame)
+        {
+            ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+                D3D12_COMMAND_LIST_TYPE_DIRECT,
+                IID_PPV_ARGS(&pThread->cmdAllocs[frame])));
+        }
+
+        ThrowIfFailed(pPipeline->device->CreateCommandList(
+            0,
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            pThread->cmdAllocs[0].Get(),
+            pPipeline->pipelineState.Get(),
+            IID_PPV_ARGS(&pThread->cmdList)));
+
+        // Command lists are created in the recording state, the worker resets
+        // it at the start of every frame.
+        ThrowIfFailed(pThread->cmdList->Close());
+
+        // Auto-reset events, each signal wakes the waiter exactly once.
+        pThread->beginEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        pThread->finishEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (pThread->beginEvent == nullptr || pThread->finishEvent == nullptr)
+        {
+            const HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            CloseRecordThreadEvents(pThread);
+            ThrowIfFailed(hr);
+        }
+        pPool->finishEvents[i] = pThread->finishEvent;
+
+        pThread->thread = CreateThread(
+            nullptr,
+            0,
+            RecordThreadProc,
+            pThread,
+            0,
+            nullptr);
+        if (pThread->thread == nullptr)
+        {
+            const HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            CloseRecordThreadEvents(pThread);
+            ThrowIfFailed(hr);
+        }
+
+        pPool->threadCount += 1;
+    }
+}
+
+void BeginRecordThreads(Pipeline* pPipeline)
+{
+    RecordThreadPool* pPool = &pPipeline->recordThreads;
+
+    // Give every thread an equal share of the draws, the first threads pick
+    // up the remainder.
+    const UINT drawCount = pPipeline->frameDrawCount;
+    const UINT drawsPerThread = drawCount / pPool->threadCount;
+    const UINT remainder = drawCount % pPool->threadCount;
+
+    UINT firstDraw = 0;
+    for (UINT i = 0; i < pPool->threadCount; ++i)
+    {
+        RecordThread* pThread = &pPool->threads[i];
+        pThread->firstDraw = firstDraw;
+        pThread->drawCount = drawsPerThread + (i < remainder ? 1 : 0);
+        firstDraw += pThread->drawCount;
+
+        SetEvent(pThread->beginEvent);
+    }
+}
+
+UINT FinishRecordThreads(Pipeline* pPipeline, ID3D12CommandList** ppCmdLists)
+{
+    RecordThreadPool* pPool = &pPipeline->recordThreads;
+
+    WaitForMultipleObjects(pPool->threadCount, pPool->finishEvents, TRUE, INFINITE);
+
+    for (UINT i = 0; i < pPool->threadCount; ++i)
+    {
+        ThrowIfFailed(pPool->threads[i].result);
+    }
+
+    for (UINT i = 0; i < pPool->threadCount; ++i)
+    {
+        ppCmdLists[i] = pPool->threads[i].cmdList.Get();
+    }
+
+    return pPool->threadCount;
+}
+
+void DestroyRecordThreads(Pipeline* pPipeline)
+{
+    RecordThreadPool* pPool = &pPipeline->recordThreads;
+    if (pPool->threadCount == 0)
+    {
+        return;
+    }
+
+    pPool->quit = true;
+
+    HANDLE threads[s_MaxRecordThreadCount];
+    for (UINT i = 0; i < pPool->threadCount; ++i)
+    {
+        SetEvent(pPool->threads[i].beginEvent);
+        threads[i] = pPool->threads[i].thread;
+    }
+
+    WaitForMultipleObjects(pPool->threadCount, threads, TRUE, INFINITE);
+
+    for (UINT i = 0; i < pPool->threadCount; ++i)
+    {
+        RecordThread* pThread = &pPool->threads[i];
+        CloseHandle(pThread->thread);
+        CloseRecordThreadEvents(pThread);
+    }
+
+    pPool->threadCount = 0;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+struct RecordThreadPool;
+
+// A worker thread that records a contiguous range of the frame's draws into
+// command lists it owns.
+struct RecordThread
+{
+    RecordThreadPool* pPool;
+    UINT threadIndex;
+    HANDLE thread;
+
+    // Signaled by the main thread when a frame is ready to be recorded.
+    HANDLE beginEvent;
+    // Signaled by the worker once its command list is closed.
+    HANDLE finishEvent;
+
+    // One allocator per frame resource, the list is reset onto the allocator
+    // of the frame being recorded.
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> cmdAllocs[s_MaxFrameCount];
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> cmdList;
+
+    // Work assigned for the current frame.
+    UINT firstDraw;
+    UINT drawCount;
+
+    // What the last frame's recording threw, S_OK if nothing. Exceptions
+    // can't leave the thread proc, FinishRecordThreads() rethrows it on the
+    // main thread instead.
+    HRESULT result;
+};
+
+struct RecordThreadPool
+{
+    Pipeline* pPipeline;
+    UINT threadCount;
+    RecordThread threads[s_MaxRecordThreadCount];
+    HANDLE finishEvents[s_MaxRecordThreadCount];
+
+    // Set before waking the workers for the last time.
+    volatile bool quit;
+};
+
+void CreateRecordThreads(Pipeline* pPipeline);
+
+// Split the frame's draws across the workers and wake them. The main thread
+// is free to record its own command lists until FinishRecordThreads().
+void BeginRecordThreads(Pipeline* pPipeline);
+
+// Wait until all workers have closed their command lists. The lists are
+// appended to `ppCmdLists` in draw order; returns the number appended.
+// Throws what the first failed worker threw, once all of them are done.
+UINT FinishRecordThreads(Pipeline* pPipeline, ID3D12CommandList** ppCmdLists);
+
+void DestroyRecordThreads(Pipeline* pPipeline);
@@ -0,0 +1,579 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "report.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <math.h>
+
+// Growth of each histogram bin over the previous one.
+static double GetHistogramBinRatio()
+{
+    return pow(s_HistogramMaxMs / s_HistogramMinMs, 1.0 / s_HistogramBinCount);
+}
+
+static double GetHistogramBinUpperMs(UINT bin)
+{
+    return s_HistogramMinMs * pow(GetHistogramBinRatio(), (double)(bin + 1));
+}
+
+void AddFrameTime(FrameTimeHistogram* pHistogram, double ms)
+{
+    // Out of range samples land in the first or last bin; the max is exact.
+    UINT bin = 0;
+    if (ms > s_HistogramMinMs)
+    {
+        const double index = log(ms / s_HistogramMinMs) / log(GetHistogramBinRatio());
+        bin = (UINT)min(index, (double)(s_HistogramBinCount - 1));
+    }
+
+    pHistogram->binCounts[bin] += 1;
+    pHistogram->sampleCount += 1;
+    pHistogram->totalMs += ms;
+    pHistogram->maxMs = max(pHistogram->maxMs, ms);
+}
+
+double GetFrameTimePercentile(const FrameTimeHistogram& histogram, double percentile)
+{
+    if (histogram.sampleCount == 0)
+    {
+        return 0.0;
+    }
+
+    // Rank of the sample, 1-based.
+    const UINT64 rank = max((UINT64)ceil(percentile / 100.0 * histogram.sampleCount), 1ull);
+
+    UINT64 count = 0;
+    for (UINT bin = 0; bin < s_HistogramBinCount; ++bin)
+    {
+        count += histogram.binCounts[bin];
+        if (count >= rank)
+        {
+            return min(GetHistogramBinUpperMs(bin), histogram.maxMs);
+        }
+    }
+
+    return histogram.maxMs;
+}
+
+// Records are written field by field. JSON records are objects on one line;
+// CSV records other than frames are `#` comment lines of `key=value` fields.
+static void BeginRecord(Report* pReport, const char* type)
+{
+    EnterCriticalSection(&pReport->lock);
+
+    if (pReport->format == ReportFormat::Json)
+    {
+        fprintf(pReport->file, "{\"type\":\"%s\"", type);
+    }
+    else
+    {
+        fprintf(pReport->file, "# %s", type);
+    }
+}
+
+static void EndRecord(Report* pReport)
+{
+    if (pReport->format == ReportFormat::Json)
+    {
+        fputs("}\n", pReport->file);
+    }
+    else
+    {
+        fputs("\n", pReport->file);
+    }
+
+    LeaveCriticalSection(&pReport->lock);
+}
+
+static void WriteKey(Report* pReport, const char* key)
+{
+    if (pReport->format == ReportFormat::Json)
+    {
+        fprintf(pReport->file, ",\"%s\":", key);
+    }
+    else
+    {
+        fprintf(pReport->file, ",%s=", key);
+    }
+}
+
+static void WriteUintField(Report* pReport, const char* key, UINT64 value)
+{
+    WriteKey(pReport, key);
+    fprintf(pReport->file, "%llu", value);
+}
+
+static void WriteDoubleField(Report* pReport, const char* key, double value)
+{
+    WriteKey(pReport, key);
+    fprintf(pReport->file, "%.6g", value);
+}
+
+static void WriteBoolField(Report* pReport, const char* key, bool value)
+{
+    WriteKey(pReport, key);
+    fputs(value ? "true" : "false", pReport->file);
+}
+
+// Strings are quoted in both formats. JSON escapes quotes and control
+// characters; CSV doubles its quotes.
+static void WriteStringField(Report* pReport, const char* key, const char* value)
+{
+    WriteKey(pReport, key);
+
+    fputc('"', pReport->file);
+    for (const char* c = value; *c != '\0'; ++c)
+    {
+        if (pReport->format == ReportFormat::Csv)
+        {
+            if (*c == '"')
+            {
+                fputc('"', pReport->file);
+            }
+            fputc(*c, pReport->file);
+        }
+        else if (*c == '"' || *c == '\\')
+        {
+            fprintf(pReport->file, "\\%c", *c);
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            fprintf(pReport->file, "\\u%04x", (unsigned char)*c);
+        }
+        else
+        {
+            fputc(*c, pReport->file);
+        }
+    }
+    fputc('"', pReport->file);
+}
+
+// Non-empty bins as [upper edge ms, count] pairs in JSON, or `ms:count`
+// pairs in CSV.
+static void WriteHistogramField(Report* pReport, const char* key, const FrameTimeHistogram& histogram)
+{
+    const bool json = pReport->format == ReportFormat::Json;
+    bool first = true;
+
+    WriteKey(pReport, key);
+    fputs(json ? "[" : "\"", pReport->file);
+
+    for (UINT bin = 0; bin < s_HistogramBinCount; ++bin)
+    {
+        if (histogram.binCounts[bin] == 0)
+        {
+            continue;
+        }
+
+        fprintf(
+            pReport->file,
+            json ? "%s[%.6g,%llu]" : "%s%.6g:%llu",
+            first ? "" : (json ? "," : " "),
+            GetHistogramBinUpperMs(bin),
+            histogram.binCounts[bin]);
+        first = false;
+    }
+
+    fputs(json ? "]" : "\"", pReport->file);
+}
+
+static void WriteFrameTimeSummary(Report* pReport, const char* prefix, const FrameTimeHistogram& histogram)
+{
+    struct Statistic
+    {
+        const char* name;
+        double value;
+    };
+
+    const double meanMs = histogram.sampleCount > 0 ? histogram.totalMs / histogram.sampleCount : 0.0;
+    const Statistic statistics[] =
+    {
+        { "MeanMs", meanMs },
+        { "P50Ms", GetFrameTimePercentile(histogram, 50.0) },
+        { "P95Ms", GetFrameTimePercentile(histogram, 95.0) },
+        { "P99Ms", GetFrameTimePercentile(histogram, 99.0) },
+        { "MaxMs", histogram.maxMs },
+    };
+
+    for (const Statistic& statistic : statistics)
+    {
+        char key[64];
+        snprintf(key, sizeof(key), "%s%s", prefix, statistic.name);
+        WriteDoubleField(pReport, key, statistic.value);
+    }
+
+    char key[64];
+    snprintf(key, sizeof(key), "%sHistogram", prefix);
+    WriteHistogramField(pReport, key, histogram);
+
+    LogMessage(
+        "%s ms/frame: mean %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f\n",
+        prefix,
+        statistics[0].value,
+        statistics[1].value,
+        statistics[2].value,
+        statistics[3].value,
+        statistics[4].value);
+}
+
+static void WriteRunRecord(Pipeline* pPipeline)
+{
+    Report* pReport = &pPipeline->report;
+    const Options& options = pPipeline->options;
+    const DXGI_ADAPTER_DESC1& adapterDesc = pPipeline->adapterDesc;
+
+    char adapterName[256] = {};
+    WideCharToMultiByte(
+        CP_UTF8,
+        0,
+        adapterDesc.Description,
+        -1,
+        adapterName,
+        sizeof(adapterName),
+        nullptr,
+        nullptr);
+
+    // The user-mode driver version, as shown by the device manager.
+    char driverVersion[64] = "unknown";
+    LARGE_INTEGER umdVersion = {};
+    if (SUCCEEDED(pPipeline->adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion)))
+    {
+        snprintf(
+            driverVersion,
+            sizeof(driverVersion),
+            "%u.%u.%u.%u",
+            (UINT)HIWORD(umdVersion.HighPart),
+            (UINT)LOWORD(umdVersion.HighPart),
+            (UINT)HIWORD(umdVersion.LowPart),
+            (UINT)LOWORD(umdVersion.LowPart));
+    }
+
+    BeginRecord(pReport, "run");
+
+    WriteStringField(pReport, "adapter", adapterName);
+    WriteUintField(pReport, "adapterIndex", options.adapterIndex);
+    WriteUintField(pReport, "adapterLuid", GetLuidValue(adapterDesc.AdapterLuid));
+    WriteUintField(pReport, "vendorId", adapterDesc.VendorId);
+    WriteUintField(pReport, "deviceId", adapterDesc.DeviceId);
+    WriteUintField(pReport, "subSysId", adapterDesc.SubSysId);
+    WriteUintField(pReport, "revision", adapterDesc.Revision);
+    WriteUintField(pReport, "dedicatedVideoMemory", adapterDesc.DedicatedVideoMemory);
+    WriteUintField(pReport, "sharedSystemMemory", adapterDesc.SharedSystemMemory);
+    WriteStringField(pReport, "driverVersion", driverVersion);
+    WriteDoubleField(pReport, "timestampFrequency", (double)pPipeline->gpuTimer.frequency);
+
+    WriteStringField(pReport, "scenarioPhase", (options.scenarioPhase != nullptr) ? options.scenarioPhase : "");
+    WriteStringField(pReport, "workload", GetWorkloadName(options.workload));
+    WriteUintField(pReport, "width", options.width);
+    WriteUintField(pReport, "height", options.height);
+    WriteBoolField(pReport, "headless", options.headless);
+    WriteBoolField(pReport, "vsync", options.vsync);
+    WriteBoolField(pReport, "tearing", options.tearing);
+    WriteBoolField(pReport, "waitableSwapchain", options.waitableSwapchain);
+    WriteUintField(pReport, "maxFrameLatency", options.maxFrameLatency);
+    WriteUintField(pReport, "frameCount", options.frameCount);
+    WriteUintField(pReport, "drawCount", options.drawCount);
+    WriteUintField(pReport, "recordThreadCount", options.recordThreadCount);
+    WriteStringField(pReport, "recordMode", GetRecordModeName(options.recordMode));
+    WriteUintField(pReport, "recordSweepFrames", options.recordSweepFrames);
+    WriteUintField(pReport, "rootConstantInterval", options.rootConstantInterval);
+    WriteUintField(pReport, "descriptorTableInterval", options.descriptorTableInterval);
+    WriteUintField(pReport, "psoInterval", options.psoInterval);
+    WriteUintField(pReport, "vertexBufferInterval", options.vertexBufferInterval);
+    WriteUintField(pReport, "rootCbvInterval", options.rootCbvInterval);
+    WriteUintField(pReport, "uploadBytesPerDraw", options.uploadBytesPerDraw);
+    WriteUintField(pReport, "uploadRingMB", options.uploadRingMB);
+    WriteUintField(pReport, "fillLayers", options.fillLayers);
+    WriteUintField(pReport, "fillSweepIterations", options.fillSweepIterations);
+    WriteStringField(pReport, "bandwidthKernel", GetBandwidthKernelName(options.bandwidthKernel));
+    WriteUintField(pReport, "bandwidthBufferMB", options.bandwidthBufferMB);
+    WriteUintField(pReport, "bandwidthStride", options.bandwidthStride);
+    WriteUintField(pReport, "bandwidthSweepIterations", options.bandwidthSweepIterations);
+    WriteDoubleField(pReport, "peakBandwidth", options.peakBandwidth);
+    WriteStringField(pReport, "waveKernel", GetWaveKernelName(options.waveKernel));
+    WriteUintField(pReport, "waveSize", options.waveSize);
+    WriteUintField(pReport, "waveIterations", options.waveIterations);
+    WriteUintField(pReport, "waveSweepIterations", options.waveSweepIterations);
+    WriteUintField(pReport, "geometryTriangles", options.geometryTriangles);
+    WriteUintField(pReport, "geometryInstances", options.geometryInstances);
+    WriteUintField(pReport, "geometrySweepIterations", options.geometrySweepIterations);
+    WriteStringField(pReport, "geometryPath", GetGeometryPathName(options.geometryPath));
+    WriteUintField(pReport, "geometryMeshletVertices", options.geometryMeshletVertices);
+    WriteUintField(pReport, "geometryMeshletPrimitives", options.geometryMeshletPrimitives);
+    WriteUintField(pReport, "geometryVisiblePercent", options.geometryVisiblePercent);
+    WriteUintField(pReport, "residencyOversubscribe", options.residencyOversubscribe);
+    WriteUintField(pReport, "residencyHeapMB", options.residencyHeapMB);
+    WriteUintField(pReport, "residencyWorkingSetMB", options.residencyWorkingSetMB);
+    WriteUintField(pReport, "bindlessDescriptorCount", options.bindlessDescriptorCount);
+    WriteUintField(pReport, "bindlessTextureCount", options.bindlessTextureCount);
+    WriteUintField(pReport, "bindlessDivergence", options.bindlessDivergence);
+    WriteUintField(pReport, "bindlessSamples", options.bindlessSamples);
+    WriteUintField(pReport, "bindlessSweepIterations", options.bindlessSweepIterations);
+    WriteStringField(pReport, "samplingFormat", GetSamplingFormatName(options.samplingFormat));
+    WriteStringField(pReport, "samplingDimension", GetSamplingDimensionName(options.samplingDimension));
+    WriteStringField(pReport, "samplingFilter", GetSamplingFilterName(options.samplingFilter));
+    WriteStringField(pReport, "samplingPattern", GetSamplingPatternName(options.samplingPattern));
+    WriteUintField(pReport, "samplingTextureSize", options.samplingTextureSize);
+    WriteUintField(pReport, "samplingLod", options.samplingLod);
+    WriteUintField(pReport, "samplingSamples", options.samplingSamples);
+    WriteUintField(pReport, "samplingSweepIterations", options.samplingSweepIterations);
+    WriteStringField(pReport, "faultAccess", GetFaultAccessName(options.faultAccess));
+    WriteStringField(pReport, "faultStage", GetFaultStageName(options.faultStage));
+    WriteStringField(pReport, "faultBinding", GetFaultBindingName(options.faultBinding));
+    WriteUintField(pReport, "faultIndex", options.faultIndex);
+    WriteUintField(pReport, "faultIterations", options.faultIterations);
+    WriteBoolField(pReport, "faultUnbounded", options.faultUnbounded);
+    WriteUintField(pReport, "faultSweepIterations", options.faultSweepIterations);
+    WriteUintField(pReport, "indirectVisiblePercent", options.indirectVisiblePercent);
+    WriteUintField(pReport, "transferFrameKB", options.transferFrameKB);
+    WriteUintField(pReport, "transferMaxMB", options.transferMaxMB);
+    WriteUintField(pReport, "transferInFlight", options.transferInFlight);
+    WriteUintField(pReport, "transferSweepIterations", options.transferSweepIterations);
+    WriteStringField(pReport, "barrierMode", GetBarrierModeName(options.barrierMode));
+    WriteUintField(pReport, "barrierResourceCount", options.barrierResourceCount);
+    WriteUintField(pReport, "barrierResourceKB", options.barrierResourceKB);
+    WriteUintField(pReport, "barrierSweepRounds", options.barrierSweepRounds);
+    WriteStringField(pReport, "raytracingMode", GetRaytracingModeName(options.raytracingMode));
+    WriteBoolField(pReport, "raytracingIncoherent", options.raytracingIncoherent);
+    WriteUintField(pReport, "raytracingInstances", options.raytracingInstances);
+    WriteUintField(pReport, "raytracingSweepIterations", options.raytracingSweepIterations);
+    WriteStringField(pReport, "aluOp", GetAluOpName(options.aluOp));
+    WriteStringField(pReport, "aluStage", GetAluStageName(options.aluStage));
+    WriteUintField(pReport, "aluRegisters", options.aluRegisters);
+    WriteUintField(pReport, "aluIterations", options.aluIterations);
+    WriteUintField(pReport, "aluSweepIterations", options.aluSweepIterations);
+    WriteDoubleField(pReport, "peakTflops", options.peakTflops);
+    WriteBoolField(pReport, "asyncCompute", options.asyncCompute);
+    WriteBoolField(pReport, "asyncCopy", options.asyncCopy);
+    WriteUintField(pReport, "asyncDispatchCount", options.asyncDispatchCount);
+    WriteUintField(pReport, "asyncIterations", options.asyncIterations);
+    WriteUintField(pReport, "asyncCopyMB", options.asyncCopyMB);
+    WriteBoolField(pReport, "telemetry", options.telemetry);
+    WriteUintField(pReport, "exitFrameCount", options.exitFrameCount);
+    WriteDoubleField(pReport, "exitSeconds", options.exitSeconds);
+    WriteUintField(pReport, "soakWindowSeconds", options.soakWindowSeconds);
+    WriteUintField(pReport, "soakThrottlePercent", options.soakThrottlePercent);
+    WriteUintField(pReport, "soakThrottleWindows", options.soakThrottleWindows);
+    WriteUintField(pReport, "loadTargetPercent", options.loadTargetPercent);
+    WriteDoubleField(pReport, "loadPeriodMs", options.loadPeriodMs);
+    WriteDoubleField(pReport, "loadTargetMs", options.loadTargetMs);
+
+    EndRecord(pReport);
+
+    if (pReport->format == ReportFormat::Csv)
+    {
+        fputs("frame,cpu_ms,gpu_ms\n", pReport->file);
+    }
+}
+
+void OpenReport(Pipeline* pPipeline)
+{
+    Report* pReport = &pPipeline->report;
+    const char* path = pPipeline->options.reportPath;
+
+    if (path == nullptr)
+    {
+        return;
+    }
+
+    if (fopen_s(&pReport->file, path, "w") != 0)
+    {
+        LogMessage("Failed to open report %s\n", path);
+        pReport->file = nullptr;
+        return;
+    }
+
+    pReport->format = pPipeline->options.reportFormat;
+    InitializeCriticalSection(&pReport->lock);
+
+    WriteRunRecord(pPipeline);
+
+    // The run description is worth having even if the first frame hangs.
+    fflush(pReport->file);
+    pReport->lastFlushTicks = GetCpuTicks();
+}
+
+void ReportSweepResult(
+    Pipeline* pPipeline,
+    const char* name,
+    double value,
+    const char* unit,
+    double gpuMs)
+{
+    Report* pReport = &pPipeline->report;
+
+    if (pReport->file == nullptr)
+    {
+        return;
+    }
+
+    BeginRecord(pReport, "sweep");
+    WriteStringField(pReport, "name", name);
+    WriteDoubleField(pReport, "value", value);
+    WriteStringField(pReport, "unit", unit);
+    WriteDoubleField(pReport, "gpuMs", gpuMs);
+    EndRecord(pReport);
+
+    fflush(pReport->file);
+}
+
+void ReportFrame(Pipeline* pPipeline, UINT64 frameNumber, double cpuMs, double gpuMs)
+{
+    Report* pReport = &pPipeline->report;
+
+    AddFrameTime(&pReport->cpuHistogram, cpuMs);
+    AddFrameTime(&pReport->gpuHistogram, gpuMs);
+
+    if (pReport->file == nullptr)
+    {
+        return;
+    }
+
+    EnterCriticalSection(&pReport->lock);
+
+    if (pReport->format == ReportFormat::Json)
+    {
+        fprintf(
+            pReport->file,
+            "{\"type\":\"frame\",\"frame\":%llu,\"cpuMs\":%.6g,\"gpuMs\":%.6g}\n",
+            frameNumber,
+            cpuMs,
+            gpuMs);
+    }
+    else
+    {
+        fprintf(pReport->file, "%llu,%.6g,%.6g\n", frameNumber, cpuMs, gpuMs);
+    }
+
+    LeaveCriticalSection(&pReport->lock);
+
+    // Flushing every frame would cost more than some of the frames.
+    const UINT64 nowTicks = GetCpuTicks();
+    if (CpuTicksToMs(nowTicks - pReport->lastFlushTicks) >= 1000.0)
+    {
+        fflush(pReport->file);
+        pReport->lastFlushTicks = nowTicks;
+    }
+}
+
+void ReportPresentLatency(Pipeline* pPipeline, double latencyMs)
+{
+    AddFrameTime(&pPipeline->report.presentHistogram, latencyMs);
+}
+
+void ReportSoakWindow(Pipeline* pPipeline, const SoakWindow& window)
+{
+    Report* pReport = &pPipeline->report;
+
+    if (pReport->file == nullptr)
+    {
+        return;
+    }
+
+    BeginRecord(pReport, "soak");
+    WriteUintField(pReport, "window", window.index);
+    WriteDoubleField(pReport, "seconds", window.seconds);
+    WriteUintField(pReport, "frames", window.frameCount);
+    WriteDoubleField(pReport, "framesPerSecond", window.framesPerSecond);
+    WriteDoubleField(pReport, "gpuMsPerFrame", window.gpuMsPerFrame);
+    WriteDoubleField(pReport, "relativeThroughput", window.relativeThroughput);
+    WriteUintField(pReport, "engineFrequency", window.sensors.engineFrequency);
+    WriteUintField(pReport, "maxEngineFrequency", window.sensors.maxEngineFrequency);
+    WriteUintField(pReport, "memoryFrequency", window.sensors.memoryFrequency);
+    WriteUintField(pReport, "maxMemoryFrequency", window.sensors.maxMemoryFrequency);
+    WriteDoubleField(pReport, "powerPercent", window.sensors.powerPercent);
+    WriteDoubleField(pReport, "temperatureC", window.sensors.temperatureC);
+    WriteUintField(pReport, "fanRpm", window.sensors.fanRpm);
+    WriteBoolField(pReport, "throttling", window.throttling);
+    EndRecord(pReport);
+
+    fflush(pReport->file);
+}
+
+void ReportTelemetryWindow(Pipeline* pPipeline, double seconds)
+{
+    Report* pReport = &pPipeline->report;
+    const Telemetry& telemetry = pPipeline->telemetry;
+
+    if (pReport->file == nullptr)
+    {
+        return;
+    }
+
+    for (UINT thread = 0; thread < telemetry.threadCount; ++thread)
+    {
+        for (UINT marker = 0; marker < s_TelemetryMarkerCount; ++marker)
+        {
+            const TelemetryStats& stats = telemetry.stats[thread][marker];
+            if (stats.count == 0 && stats.droppedCount == 0)
+            {
+                continue;
+            }
+
+            const double totalMs = CpuTicksToMs(stats.totalTicks);
+
+            BeginRecord(pReport, "telemetry");
+            WriteUintField(pReport, "window", telemetry.windowIndex);
+            WriteDoubleField(pReport, "seconds", seconds);
+            WriteUintField(pReport, "thread", thread);
+            WriteStringField(pReport, "marker", GetTelemetryMarkerName((TelemetryMarker)marker));
+            WriteUintField(pReport, "count", stats.count);
+            WriteDoubleField(pReport, "totalMs", totalMs);
+            WriteDoubleField(pReport, "meanMs", stats.count > 0 ? totalMs / stats.count : 0.0);
+            WriteDoubleField(pReport, "maxMs", CpuTicksToMs(stats.maxTicks));
+            WriteUintField(pReport, "dropped", stats.droppedCount);
+            EndRecord(pReport);
+        }
+    }
+
+    fflush(pReport->file);
+}
+
+void ReportFailure(Pipeline* pPipeline, HRESULT hr, HRESULT removedReason)
+{
+    Report* pReport = &pPipeline->report;
+
+    if (pReport->file == nullptr)
+    {
+        return;
+    }
+
+    char hrText[16];
+    snprintf(hrText, sizeof(hrText), "0x%08x", (UINT)hr);
+    char removedReasonText[16];
+    snprintf(removedReasonText, sizeof(removedReasonText), "0x%08x", (UINT)removedReason);
+
+    BeginRecord(pReport, "failure");
+    WriteUintField(pReport, "frame", pPipeline->frameNumber);
+    WriteStringField(pReport, "hresult", hrText);
+    WriteBoolField(pReport, "deviceRemoved", FAILED(removedReason));
+    WriteStringField(pReport, "removedReason", removedReasonText);
+    WriteStringField(pReport, "removedReasonName", GetDeviceRemovedReasonName(removedReason));
+    EndRecord(pReport);
+
+    fflush(pReport->file);
+}
+
+void CloseReport(Pipeline* pPipeline)
+{
+    Report* pReport = &pPipeline->report;
+
+    if (pReport->file == nullptr)
+    {
+        return;
+    }
+
+    BeginRecord(pReport, "summary");
+    WriteUintField(pReport, "frames", pReport->cpuHistogram.sampleCount);
+    WriteFrameTimeSummary(pReport, "cpu", pReport->cpuHistogram);
+    WriteFrameTimeSummary(pReport, "gpu", pReport->gpuHistogram);
+    if (pReport->presentHistogram.sampleCount > 0)
+    {
+        WriteFrameTimeSummary(pReport, "present", pReport->presentHistogram);
+    }
+    EndRecord(pReport);
+
+    fclose(pReport->file);
+    pReport->file = nullptr;
+    DeleteCriticalSection(&pReport->lock);
+}
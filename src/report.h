@@ -0,0 +1,94 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <stdio.h>
+#include "options.h"
+#include "soak.h"
+#include "telemetry.h"
+
+struct Pipeline;
+
+// Log-spaced bins from s_HistogramMinMs up, each s_HistogramBinRatio wider
+// than the previous one. 512 bins cover 1us to 10s at ~3% resolution, so
+// percentiles are accurate to a bin without keeping every sample.
+static const UINT s_HistogramBinCount = 512;
+static const double s_HistogramMinMs = 0.001;
+static const double s_HistogramMaxMs = 10000.0;
+
+struct FrameTimeHistogram
+{
+    UINT64 binCounts[s_HistogramBinCount];
+    UINT64 sampleCount;
+    double totalMs;
+    double maxMs;
+};
+
+void AddFrameTime(FrameTimeHistogram* pHistogram, double ms);
+
+// Upper edge of the bin holding the `percentile` sample, in [0, 100], capped
+// to the largest sample.
+double GetFrameTimePercentile(const FrameTimeHistogram& histogram, double percentile);
+
+// Results streamed to `Options::reportPath` while running.
+//
+// The JSON format writes one object per line, so a file cut short by a hang
+// or a device removal stays parseable up to its last line:
+//   {"type":"run", ...}      adapter, driver version and options
+//   {"type":"sweep", ...}    one per sweep case
+//   {"type":"frame", ...}    CPU and GPU time of every frame
+//   {"type":"soak", ...}     throughput and sensors per soak window
+//   {"type":"telemetry", ...} CPU marker times per thread and window
+//   {"type":"failure", ...}  the error a run stopped on
+//   {"type":"summary", ...}  percentiles and histograms, at exit
+//
+// The CSV format writes a `frame,cpu_ms,gpu_ms` row per frame; everything
+// else goes into `#` comment lines.
+struct Report
+{
+    FILE* file;
+    ReportFormat format;
+
+    FrameTimeHistogram cpuHistogram;
+    FrameTimeHistogram gpuHistogram;
+    // Present-to-display latency, windowed runs only.
+    FrameTimeHistogram presentHistogram;
+
+    UINT64 lastFlushTicks;
+
+    // Held while a record is written; the telemetry thread writes records
+    // too.
+    CRITICAL_SECTION lock;
+};
+
+// Open the report and write the run description. Does nothing without
+// `Options::reportPath`. Call once the device is created.
+void OpenReport(Pipeline* pPipeline);
+
+void ReportSweepResult(
+    Pipeline* pPipeline,
+    const char* name,
+    double value,
+    const char* unit,
+    double gpuMs);
+
+// Record one frame, once its GPU time is known. The file is flushed about
+// once per second.
+void ReportFrame(Pipeline* pPipeline, UINT64 frameNumber, double cpuMs, double gpuMs);
+
+// Add a present-to-display latency to the summary.
+void ReportPresentLatency(Pipeline* pPipeline, double latencyMs);
+
+void ReportSoakWindow(Pipeline* pPipeline, const SoakWindow& window);
+
+// Record the markers of `Pipeline::telemetry`'s window, `seconds` long, a
+// record per thread and marker seen. Called from the telemetry thread.
+void ReportTelemetryWindow(Pipeline* pPipeline, double seconds);
+
+// Record the HRESULT the run failed with, and the device removed reason if
+// the device is gone. Flushed at once; the process may not get much further.
+void ReportFailure(Pipeline* pPipeline, HRESULT hr, HRESULT removedReason);
+
+// Write the summary and close the file.
+void CloseReport(Pipeline* pPipeline);
@@ -0,0 +1,285 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "residency.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <stdio.h>
+
+// Bytes every residency draw copies out of a buffer.
+static const UINT64 s_ResidencyTouchSize = 1024 * 1024;
+
+// Heaps made resident at once by the sweep.
+static const UINT s_ResidencySweepBatchSizes[] = { 1, 4, 16 };
+
+static const double s_Megabyte = 1024.0 * 1024.0;
+
+static bool QueryLocalMemory(Pipeline* pPipeline, DXGI_QUERY_VIDEO_MEMORY_INFO* pInfo)
+{
+    ComPtr<IDXGIAdapter3> adapter3;
+    return SUCCEEDED(pPipeline->adapter.As(&adapter3)) &&
+        SUCCEEDED(adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, pInfo));
+}
+
+void CreateResidency(Pipeline* pPipeline)
+{
+    Residency* pResidency = &pPipeline->residency;
+    const Options& options = pPipeline->options;
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+    if (QueryLocalMemory(pPipeline, &memoryInfo))
+    {
+        pResidency->budget = memoryInfo.Budget;
+    }
+    else
+    {
+        pResidency->budget = pPipeline->adapterDesc.DedicatedVideoMemory;
+    }
+
+    const UINT64 heapSize = (UINT64)options.residencyHeapMB * 1024 * 1024;
+    const UINT64 targetSize = pResidency->budget / 100 * options.residencyOversubscribe;
+    UINT heapCount = (UINT)min((targetSize + heapSize - 1) / heapSize, (UINT64)s_MaxPoolHeapCount);
+
+    InitHeapPool(&pResidency->pool, D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, heapSize);
+    pResidency->bufferSize = heapSize / s_ResidencyBuffersPerHeap;
+
+    // Past the budget the OS demotes heaps to system memory on its own; keep
+    // going until creation fails outright.
+    for (UINT i = 0; i < heapCount * s_ResidencyBuffersPerHeap; ++i)
+    {
+        UINT heapIndex = 0;
+        if (!CreatePooledBuffer(
+            pPipeline,
+            &pResidency->pool,
+            pResidency->bufferSize,
+            D3D12_RESOURCE_FLAG_NONE,
+            D3D12_RESOURCE_STATE_COMMON,
+            &pResidency->buffers[i],
+            &heapIndex))
+        {
+            break;
+        }
+        pResidency->bufferCount = i + 1;
+    }
+
+    // Only whole heaps take part.
+    heapCount = pResidency->bufferCount / s_ResidencyBuffersPerHeap;
+    pResidency->bufferCount = heapCount * s_ResidencyBuffersPerHeap;
+
+    LogMessage(
+        "residency: %u heaps of %u MB, %.0f MB against a %.0f MB budget (%.0f%%)\n",
+        heapCount,
+        options.residencyHeapMB,
+        (double)heapCount * heapSize / s_Megabyte,
+        pResidency->budget / s_Megabyte,
+        100.0 * heapCount * heapSize / (double)max(pResidency->budget, 1ull));
+
+    if (heapCount == 0)
+    {
+        return;
+    }
+
+    pResidency->windowHeapCount = max(1u, min(options.residencyWorkingSetMB / options.residencyHeapMB, heapCount));
+
+    // Start from nothing resident, the frames page in what they use.
+    ID3D12Pageable* ppHeaps[s_MaxPoolHeapCount];
+    for (UINT i = 0; i < heapCount; ++i)
+    {
+        ppHeaps[i] = pResidency->pool.heaps[i].Get();
+        pResidency->heapResident[i] = false;
+    }
+    ThrowIfFailed(pPipeline->device->Evict(heapCount, ppHeaps));
+
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC scratchDesc = CD3DX12_RESOURCE_DESC::Buffer(s_ResidencyTouchSize);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &scratchDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&pResidency->scratchBuffer)));
+}
+
+static UINT GetResidencyHeapCount(const Residency* pResidency)
+{
+    return pResidency->bufferCount / s_ResidencyBuffersPerHeap;
+}
+
+void UpdateResidency(Pipeline* pPipeline)
+{
+    Residency* pResidency = &pPipeline->residency;
+    const UINT heapCount = GetResidencyHeapCount(pResidency);
+
+    if (heapCount == 0)
+    {
+        return;
+    }
+
+    const UINT64 frame = pPipeline->frameNumber;
+    const UINT64 frameCount = pPipeline->options.frameCount;
+    pResidency->windowFirstHeap = (UINT)((frame * pResidency->windowHeapCount) % heapCount);
+
+    ID3D12Pageable* ppResident[s_MaxPoolHeapCount];
+    UINT residentCount = 0;
+    for (UINT i = 0; i < pResidency->windowHeapCount; ++i)
+    {
+        const UINT heap = (pResidency->windowFirstHeap + i) % heapCount;
+        if (!pResidency->heapResident[heap])
+        {
+            ppResident[residentCount++] = pResidency->pool.heaps[heap].Get();
+            pResidency->heapResident[heap] = true;
+        }
+        pResidency->heapLastUsedFrames[heap] = frame;
+    }
+
+    // Frames up to `frame - frameCount` are complete: the frame resource
+    // being recorded was last used by that frame, and its fence was reached.
+    ID3D12Pageable* ppEvicted[s_MaxPoolHeapCount];
+    UINT evictedCount = 0;
+    for (UINT heap = 0; heap < heapCount; ++heap)
+    {
+        if (pResidency->heapResident[heap] && pResidency->heapLastUsedFrames[heap] + frameCount <= frame)
+        {
+            ppEvicted[evictedCount++] = pResidency->pool.heaps[heap].Get();
+            pResidency->heapResident[heap] = false;
+        }
+    }
+
+    // Evict first, so the budget has room for the new window.
+    if (evictedCount > 0)
+    {
+        const UINT64 startTicks = GetCpuTicks();
+        ThrowIfFailed(pPipeline->device->Evict(evictedCount, ppEvicted));
+        pResidency->evictTicks += GetCpuTicks() - startTicks;
+        pResidency->evictedBytes += (UINT64)evictedCount * pResidency->pool.heapSize;
+    }
+
+    // Blocks until the heaps are paged in.
+    if (residentCount > 0)
+    {
+        const UINT64 startTicks = GetCpuTicks();
+        ThrowIfFailed(pPipeline->device->MakeResident(residentCount, ppResident));
+        pResidency->residentTicks += GetCpuTicks() - startTicks;
+        pResidency->residentBytes += (UINT64)residentCount * pResidency->pool.heapSize;
+    }
+}
+
+void RecordResidency(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    Residency* pResidency = &pPipeline->residency;
+    const UINT heapCount = GetResidencyHeapCount(pResidency);
+
+    if (heapCount == 0)
+    {
+        return;
+    }
+
+    // Buffers of a heap are consecutive in `buffers`.
+    const UINT windowBufferCount = pResidency->windowHeapCount * s_ResidencyBuffersPerHeap;
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT buffer = (pResidency->windowFirstHeap * s_ResidencyBuffersPerHeap + draw % windowBufferCount) %
+            pResidency->bufferCount;
+
+        // Copies promote buffers from the common state, and the copies all
+        // write the same bytes, so no barriers are needed.
+        pCmdList->CopyBufferRegion(
+            pResidency->scratchBuffer.Get(),
+            0,
+            pResidency->buffers[buffer].Get(),
+            0,
+            min(s_ResidencyTouchSize, pResidency->bufferSize));
+    }
+}
+
+void LogResidencyStats(Pipeline* pPipeline)
+{
+    Residency* pResidency = &pPipeline->residency;
+
+    if (GetResidencyHeapCount(pResidency) == 0)
+    {
+        return;
+    }
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+    QueryLocalMemory(pPipeline, &memoryInfo);
+
+    const double residentMs = CpuTicksToMs(pResidency->residentTicks);
+    LogMessage(
+        "adapter %u: paged in %.0f MB in %.1f ms (%.2f GB/s), evicted %.0f MB in %.1f ms, usage %.0f of %.0f MB\n",
+        pPipeline->options.adapterIndex,
+        pResidency->residentBytes / s_Megabyte,
+        residentMs,
+        GetRate((double)pResidency->residentBytes, residentMs, 1.0e9),
+        pResidency->evictedBytes / s_Megabyte,
+        CpuTicksToMs(pResidency->evictTicks),
+        memoryInfo.CurrentUsage / s_Megabyte,
+        memoryInfo.Budget / s_Megabyte);
+
+    pResidency->residentBytes = 0;
+    pResidency->residentTicks = 0;
+    pResidency->evictedBytes = 0;
+    pResidency->evictTicks = 0;
+}
+
+void RunResidencySweep(Pipeline* pPipeline)
+{
+    Residency* pResidency = &pPipeline->residency;
+    const UINT heapCount = GetResidencyHeapCount(pResidency);
+
+    ID3D12Pageable* ppHeaps[s_MaxPoolHeapCount];
+    for (UINT i = 0; i < heapCount; ++i)
+    {
+        ppHeaps[i] = pResidency->pool.heaps[i].Get();
+    }
+
+    for (UINT batchSize : s_ResidencySweepBatchSizes)
+    {
+        if (batchSize > heapCount)
+        {
+            break;
+        }
+
+        // Page the whole pool through in batches, so the later batches also
+        // pay for the OS evicting what the earlier ones brought in.
+        const UINT batchCount = heapCount / batchSize;
+        UINT64 residentTicks = 0;
+        UINT64 evictTicks = 0;
+        for (UINT batch = 0; batch < batchCount; ++batch)
+        {
+            ID3D12Pageable** ppBatch = &ppHeaps[batch * batchSize];
+
+            UINT64 startTicks = GetCpuTicks();
+            ThrowIfFailed(pPipeline->device->MakeResident(batchSize, ppBatch));
+            residentTicks += GetCpuTicks() - startTicks;
+
+            startTicks = GetCpuTicks();
+            ThrowIfFailed(pPipeline->device->Evict(batchSize, ppBatch));
+            evictTicks += GetCpuTicks() - startTicks;
+        }
+
+        const double bytes = (double)batchCount * batchSize * pResidency->pool.heapSize;
+        const double residentMs = CpuTicksToMs(residentTicks);
+        const double evictMs = CpuTicksToMs(evictTicks);
+        const double gigabytesPerSecond = GetRate(bytes, residentMs, 1.0e9);
+
+        LogMessage(
+            "residency %u heaps per batch: make resident %.2f GB/s (%.1f ms), evict %.1f ms for %.0f MB\n",
+            batchSize,
+            gigabytesPerSecond,
+            residentMs,
+            evictMs,
+            bytes / s_Megabyte);
+
+        // CPU-side timings, there is no GPU time.
+        char name[64];
+        snprintf(name, sizeof(name), "residency make-resident x%u", batchSize);
+        ReportSweepResult(pPipeline, name, gigabytesPerSecond, "GB/s", 0.0);
+        snprintf(name, sizeof(name), "residency evict x%u", batchSize);
+        ReportSweepResult(pPipeline, name, evictMs / batchCount, "ms/batch", 0.0);
+    }
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "heap-pool.h"
+
+struct Pipeline;
+
+// Buffers placed in each heap of the residency pool.
+static const UINT s_ResidencyBuffersPerHeap = 4;
+
+// VRAM oversubscription: heaps totaling `Options::residencyOversubscribe`
+// percent of the adapter's local memory budget, of which every frame uses a
+// different window. The frame makes its window resident and evicts the heaps
+// no frame in flight uses anymore, so the heaps are paged in and out of
+// video memory continuously.
+struct Residency
+{
+    HeapPool pool;
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffers[s_MaxPoolHeapCount * s_ResidencyBuffersPerHeap];
+    UINT bufferCount;
+    UINT64 bufferSize;
+
+    // Residency state we asked for, per heap.
+    bool heapResident[s_MaxPoolHeapCount];
+    // Last frame whose window included the heap.
+    UINT64 heapLastUsedFrames[s_MaxPoolHeapCount];
+    // Heaps per frame window.
+    UINT windowHeapCount;
+    // First heap of the current frame's window.
+    UINT windowFirstHeap;
+
+    // Destination of the copies touching the window's buffers.
+    Microsoft::WRL::ComPtr<ID3D12Resource> scratchBuffer;
+
+    // Local memory budget when the heaps were created.
+    UINT64 budget;
+
+    // Paging done since the last `LogResidencyStats()`.
+    UINT64 residentBytes;
+    UINT64 residentTicks;
+    UINT64 evictedBytes;
+    UINT64 evictTicks;
+};
+
+// Allocate the heaps past budget, then evict them all.
+void CreateResidency(Pipeline* pPipeline);
+
+// Make the current frame's window resident and evict the heaps only
+// completed frames used. Call before the frame's lists are recorded, once
+// the frame resource's fence is reached. Measures the time MakeResident()
+// blocks for.
+void UpdateResidency(Pipeline* pPipeline);
+
+// Record draws [firstDraw, firstDraw + drawCount), each a copy out of one
+// buffer of the current window, so the GPU touches every heap it pages in.
+void RecordResidency(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Log the paging rate and memory usage since the last call.
+void LogResidencyStats(Pipeline* pPipeline);
+
+// Time MakeResident() and Evict() of growing batches of heaps and log the
+// paging bandwidth. The GPU must be idle; returns with every heap evicted.
+void RunResidencySweep(Pipeline* pPipeline);
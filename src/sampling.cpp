@@ -0,0 +1,754 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "sampling.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <math.h>
+#include <stdio.h>
+
+// Compute dispatches cover a grid of 256x256 threads in 8x8 groups.
+static const UINT s_SamplingGridSize = 256;
+static const UINT s_SamplingThreadGroupSize = 8;
+
+static const UINT s_SamplingArrayLayerCount = 4;
+// Subresources of the largest texture, every mip of every array layer.
+static const UINT s_SamplingMaxSubresourceCount = 16 * s_SamplingArrayLayerCount;
+
+// Smallest mip of the 2D texture the sweep samples.
+static const UINT s_SamplingSweepMinSize = 16;
+
+// Major to minor axis ratio of the anisotropic footprint.
+static const float s_SamplingAnisotropy = 4.0f;
+
+// Root parameter slots of `Sampling::rootSignature`.
+static const UINT s_SamplingRootParamConstants = 0;
+static const UINT s_SamplingRootParamTexture = 1;
+static const UINT s_SamplingRootParamOutput = 2;
+static const UINT s_SamplingRootParamCount = 3;
+
+// Matches `SamplingConstants` in sampling.hlsl.
+struct SamplingConstants
+{
+    float gradient[2];
+    float texelSize;
+    float sampleStride;
+    UINT filter;
+    UINT pattern;
+    UINT sampleCount;
+    UINT layerCount;
+    UINT seed;
+};
+
+static const DXGI_FORMAT s_SamplingFormats[s_SamplingFormatCount] =
+{
+    DXGI_FORMAT_R8G8B8A8_UNORM,
+    DXGI_FORMAT_R16G16B16A16_FLOAT,
+    DXGI_FORMAT_BC1_UNORM,
+    DXGI_FORMAT_BC7_UNORM,
+};
+
+static const D3D12_FILTER s_SamplingFilters[s_SamplingFilterCount] =
+{
+    D3D12_FILTER_MIN_MAG_MIP_POINT,
+    D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT,
+    D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+    D3D12_FILTER_ANISOTROPIC,
+};
+
+static UINT Hash(UINT x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+void CreateSamplingPipelineStates(Pipeline* pPipeline)
+{
+    Sampling* pSampling = &pPipeline->sampling;
+
+    // Create the root signature.
+    {
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[1] = {};
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_SamplingRootParamCount] = {};
+
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+        rootParameters[s_SamplingRootParamConstants].InitAsConstants(
+            sizeof(SamplingConstants) / 4,
+            0);
+        rootParameters[s_SamplingRootParamTexture].InitAsDescriptorTable(1, &ranges[0]);
+        rootParameters[s_SamplingRootParamOutput].InitAsUnorderedAccessView(0);
+
+        CD3DX12_STATIC_SAMPLER_DESC samplerDescs[s_SamplingFilterCount];
+        for (UINT i = 0; i < s_SamplingFilterCount; ++i)
+        {
+            samplerDescs[i].Init(i, s_SamplingFilters[i]);
+        }
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            _countof(samplerDescs),
+            samplerDescs,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pSampling->rootSignature);
+    }
+
+    // Sampler arrays need shader model 5.1.
+    const D3D_SHADER_MACRO arrayDefines[] = { { "SAMPLING_ARRAY", "1" }, { nullptr, nullptr } };
+    const D3D_SHADER_MACRO volumeDefines[] = { { "SAMPLING_3D", "1" }, { nullptr, nullptr } };
+    const D3D_SHADER_MACRO* dimensionDefines[s_SamplingDimensionCount] = { nullptr, arrayDefines, volumeDefines };
+
+    for (UINT i = 0; i < s_SamplingDimensionCount; ++i)
+    {
+        ComPtr<ID3DBlob> computeShader;
+        CompileShader(L"sampling.hlsl", "CSMain", "cs_5_1", dimensionDefines[i], &computeShader);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pSampling->rootSignature.Get();
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+        CreateComputePipelineState(pPipeline, L"sampling", psoDesc, &pSampling->computePipelineStates[i]);
+    }
+
+    {
+        ComPtr<ID3DBlob> vertexShader;
+        ComPtr<ID3DBlob> pixelShader;
+        CompileShader(L"sampling.hlsl", "VSMain", "vs_5_1", nullptr, &vertexShader);
+        CompileShader(L"sampling.hlsl", "PSMain", "ps_5_1", nullptr, &pixelShader);
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = pSampling->rootSignature.Get();
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+        psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+        psoDesc.DepthStencilState.DepthEnable = FALSE;
+        psoDesc.DepthStencilState.StencilEnable = FALSE;
+        psoDesc.SampleMask = UINT_MAX;
+        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        psoDesc.NumRenderTargets = 1;
+        psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        psoDesc.SampleDesc.Count = 1;
+        CreateGraphicsPipelineState(pPipeline, L"sampling", psoDesc, &pSampling->pixelPipelineState);
+    }
+}
+
+static D3D12_RESOURCE_DESC GetSamplingTextureDesc(Pipeline* pPipeline, SamplingFormat format, SamplingDimension dimension)
+{
+    UINT size = s_SamplingSweepMinSize;
+    while (size < pPipeline->options.samplingTextureSize)
+    {
+        size *= 2;
+    }
+
+    // Full mip chains.
+    const DXGI_FORMAT dxgiFormat = s_SamplingFormats[(UINT)format];
+    switch (dimension)
+    {
+    case SamplingDimension::Texture2DArray:
+        return CD3DX12_RESOURCE_DESC::Tex2D(dxgiFormat, size, size, s_SamplingArrayLayerCount, 0);
+
+    case SamplingDimension::Texture3D:
+    {
+        // The largest power of two edge whose volume has no more texels than
+        // the array, so the two cost about the same memory at every size.
+        const UINT64 arrayTexelCount = (UINT64)size * size * s_SamplingArrayLayerCount;
+        UINT volumeSize = s_SamplingSweepMinSize;
+        while ((UINT64)volumeSize * 2 * volumeSize * 2 * volumeSize * 2 <= arrayTexelCount)
+        {
+            volumeSize *= 2;
+        }
+        return CD3DX12_RESOURCE_DESC::Tex3D(dxgiFormat, volumeSize, volumeSize, (UINT16)volumeSize, 0);
+    }
+
+    default:
+        return CD3DX12_RESOURCE_DESC::Tex2D(dxgiFormat, size, size, 1, 0);
+    }
+}
+
+static UINT GetSubresourceCount(const D3D12_RESOURCE_DESC& desc)
+{
+    return (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) ?
+        desc.MipLevels : desc.MipLevels * desc.DepthOrArraySize;
+}
+
+// Fill every subresource laid out in `pLayouts` with random texels. FP16
+// texels stay within [0.5, 1), clear of NaNs and denormals.
+static void GenerateTexels(
+    UINT8* pDst,
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
+    const UINT* pRowCounts,
+    const UINT64* pRowSizes,
+    UINT subresourceCount,
+    bool halfFloat)
+{
+    UINT counter = 0;
+    for (UINT subresource = 0; subresource < subresourceCount; ++subresource)
+    {
+        const D3D12_SUBRESOURCE_FOOTPRINT& footprint = pLayouts[subresource].Footprint;
+        for (UINT row = 0; row < footprint.Depth * pRowCounts[subresource]; ++row)
+        {
+            UINT8* pRow = pDst + pLayouts[subresource].Offset + (UINT64)row * footprint.RowPitch;
+            if (halfFloat)
+            {
+                UINT16* pHalves = (UINT16*)pRow;
+                for (UINT64 i = 0; i < pRowSizes[subresource] / 2; ++i)
+                {
+                    pHalves[i] = (UINT16)(0x3800 | (Hash(counter++) & 0x3ff));
+                }
+            }
+            else
+            {
+                UINT* pWords = (UINT*)pRow;
+                for (UINT64 i = 0; i < pRowSizes[subresource] / 4; ++i)
+                {
+                    pWords[i] = Hash(counter++);
+                }
+            }
+        }
+    }
+}
+
+// Copy queue and staging buffer, only alive while the textures upload.
+struct SamplingUploader
+{
+    ComPtr<ID3D12CommandQueue> queue;
+    ComPtr<ID3D12Fence> fence;
+    UINT64 fenceValue;
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+
+    ComPtr<ID3D12Resource> stagingBuffer;
+    UINT8* pStagingData;
+};
+
+static void CreateSamplingUploader(Pipeline* pPipeline, UINT64 stagingSize, SamplingUploader* pUploader)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    ThrowIfFailed(pPipeline->device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&pUploader->queue)));
+
+    ThrowIfFailed(pPipeline->device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pUploader->fence)));
+
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_COPY,
+        IID_PPV_ARGS(&pUploader->cmdAlloc)));
+
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_COPY,
+        pUploader->cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&pUploader->cmdList)));
+    ThrowIfFailed(pUploader->cmdList->Close());
+
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC stagingDesc = CD3DX12_RESOURCE_DESC::Buffer(stagingSize);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &stagingDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pUploader->stagingBuffer)));
+
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pUploader->stagingBuffer->Map(
+        0,
+        &readRange,
+        reinterpret_cast<void**>(&pUploader->pStagingData)));
+}
+
+// Generate every subresource of `pTexture` into the staging buffer and copy
+// them on the copy queue. Waits for the previous texture's copies first.
+static void UploadSamplingTexture(
+    Pipeline* pPipeline,
+    SamplingUploader* pUploader,
+    ID3D12Resource* pTexture,
+    bool halfFloat)
+{
+    const D3D12_RESOURCE_DESC textureDesc = pTexture->GetDesc();
+    const UINT subresourceCount = GetSubresourceCount(textureDesc);
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[s_SamplingMaxSubresourceCount];
+    UINT rowCounts[s_SamplingMaxSubresourceCount];
+    UINT64 rowSizes[s_SamplingMaxSubresourceCount];
+    pPipeline->device->GetCopyableFootprints(
+        &textureDesc,
+        0,
+        subresourceCount,
+        0,
+        layouts,
+        rowCounts,
+        rowSizes,
+        nullptr);
+
+    ThrowIfFailed(pUploader->fence->SetEventOnCompletion(pUploader->fenceValue, nullptr));
+    GenerateTexels(pUploader->pStagingData, layouts, rowCounts, rowSizes, subresourceCount, halfFloat);
+
+    ThrowIfFailed(pUploader->cmdAlloc->Reset());
+    ThrowIfFailed(pUploader->cmdList->Reset(pUploader->cmdAlloc.Get(), nullptr));
+    for (UINT subresource = 0; subresource < subresourceCount; ++subresource)
+    {
+        CD3DX12_TEXTURE_COPY_LOCATION dst(pTexture, subresource);
+        CD3DX12_TEXTURE_COPY_LOCATION src(pUploader->stagingBuffer.Get(), layouts[subresource]);
+        pUploader->cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    }
+    ThrowIfFailed(pUploader->cmdList->Close());
+
+    ID3D12CommandList* ppCommandLists[] = { pUploader->cmdList.Get() };
+    pUploader->queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+    pUploader->fenceValue += 1;
+    ThrowIfFailed(pUploader->queue->Signal(pUploader->fence.Get(), pUploader->fenceValue));
+}
+
+void CreateSamplingResources(Pipeline* pPipeline)
+{
+    Sampling* pSampling = &pPipeline->sampling;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    // Create the textures in the common state: the copy queue promotes them
+    // to copy destination, and the sampling lists to shader resource.
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    UINT64 stagingSize = 0;
+    UINT64 totalSize = 0;
+    for (UINT i = 0; i < s_SamplingFormatCount; ++i)
+    {
+        for (UINT j = 0; j < s_SamplingDimensionCount; ++j)
+        {
+            const D3D12_RESOURCE_DESC textureDesc =
+                GetSamplingTextureDesc(pPipeline, (SamplingFormat)i, (SamplingDimension)j);
+            ThrowIfFailed(pDevice->CreateCommittedResource(
+                &defaultHeapProps,
+                D3D12_HEAP_FLAG_NONE,
+                &textureDesc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&pSampling->textures[i][j])));
+
+            // Mip counts are only known once created.
+            const D3D12_RESOURCE_DESC createdDesc = pSampling->textures[i][j]->GetDesc();
+            UINT64 textureStagingSize = 0;
+            pDevice->GetCopyableFootprints(
+                &createdDesc,
+                0,
+                GetSubresourceCount(createdDesc),
+                0,
+                nullptr,
+                nullptr,
+                nullptr,
+                &textureStagingSize);
+            stagingSize = max(stagingSize, textureStagingSize);
+            totalSize += textureStagingSize;
+        }
+    }
+
+    const UINT64 startTicks = GetCpuTicks();
+
+    SamplingUploader uploader = {};
+    CreateSamplingUploader(pPipeline, stagingSize, &uploader);
+    for (UINT i = 0; i < s_SamplingFormatCount; ++i)
+    {
+        for (UINT j = 0; j < s_SamplingDimensionCount; ++j)
+        {
+            UploadSamplingTexture(
+                pPipeline,
+                &uploader,
+                pSampling->textures[i][j].Get(),
+                (SamplingFormat)i == SamplingFormat::Rgba16f);
+        }
+    }
+    ThrowIfFailed(uploader.fence->SetEventOnCompletion(uploader.fenceValue, nullptr));
+
+    LogMessage(
+        "sampling: %u textures, %.1f MB uploaded in %.1f ms\n",
+        s_SamplingFormatCount * s_SamplingDimensionCount,
+        totalSize / (1024.0 * 1024.0),
+        CpuTicksToMs(GetCpuTicks() - startTicks));
+
+    // Create the SRVs.
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+        heapDesc.NumDescriptors = s_SamplingFormatCount * s_SamplingDimensionCount;
+        heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        ThrowIfFailed(pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&pSampling->descriptorHeap)));
+        pSampling->descriptorSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE handle(pSampling->descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+        for (UINT i = 0; i < s_SamplingFormatCount; ++i)
+        {
+            for (UINT j = 0; j < s_SamplingDimensionCount; ++j)
+            {
+                pDevice->CreateShaderResourceView(pSampling->textures[i][j].Get(), nullptr, handle);
+                handle.Offset(1, pSampling->descriptorSize);
+            }
+        }
+    }
+
+    // One float4 per thread.
+    CD3DX12_RESOURCE_DESC outputDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)s_SamplingGridSize * s_SamplingGridSize * 16,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &outputDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pSampling->outputBuffer)));
+}
+
+// A texture, and how it is sampled.
+struct SamplingCase
+{
+    SamplingFormat format;
+    SamplingDimension dimension;
+    SamplingFilter filter;
+    SamplingPattern pattern;
+    UINT lod;
+};
+
+// Width in texels of the sampled mip, which sets the footprint.
+static UINT GetSamplingMipSize(Pipeline* pPipeline, const SamplingCase& samplingCase)
+{
+    const D3D12_RESOURCE_DESC desc =
+        pPipeline->sampling.textures[(UINT)samplingCase.format][(UINT)samplingCase.dimension]->GetDesc();
+    const UINT lod = min(samplingCase.lod, (UINT)desc.MipLevels - 1);
+    return max(1u, (UINT)desc.Width >> lod);
+}
+
+static SamplingConstants GetSamplingConstants(
+    Pipeline* pPipeline,
+    const SamplingCase& samplingCase,
+    UINT gridWidth,
+    UINT seed)
+{
+    const D3D12_RESOURCE_DESC desc =
+        pPipeline->sampling.textures[(UINT)samplingCase.format][(UINT)samplingCase.dimension]->GetDesc();
+    const UINT lod = min(samplingCase.lod, (UINT)desc.MipLevels - 1);
+    const float texelSize = 1.0f / GetSamplingMipSize(pPipeline, samplingCase);
+
+    SamplingConstants constants = {};
+    constants.texelSize = texelSize;
+    constants.sampleStride = gridWidth * texelSize;
+    constants.filter = (UINT)samplingCase.filter;
+    constants.pattern = (UINT)samplingCase.pattern;
+    constants.sampleCount = pPipeline->options.samplingSamples;
+    constants.seed = seed;
+
+    // A texel per pixel picks the mip itself; trilinear sits between it and
+    // the next one, and anisotropic stretches the footprint along x.
+    constants.gradient[0] = texelSize;
+    constants.gradient[1] = texelSize;
+    if (samplingCase.filter == SamplingFilter::Trilinear)
+    {
+        constants.gradient[0] = texelSize * sqrtf(2.0f);
+        constants.gradient[1] = texelSize * sqrtf(2.0f);
+    }
+    else if (samplingCase.filter == SamplingFilter::Anisotropic)
+    {
+        constants.gradient[0] = texelSize * s_SamplingAnisotropy;
+    }
+
+    switch (samplingCase.dimension)
+    {
+    case SamplingDimension::Texture2DArray:
+        constants.layerCount = desc.DepthOrArraySize;
+        break;
+
+    case SamplingDimension::Texture3D:
+        constants.layerCount = max(1u, (UINT)desc.DepthOrArraySize >> lod);
+        break;
+
+    default:
+        constants.layerCount = 1;
+        break;
+    }
+
+    return constants;
+}
+
+static D3D12_GPU_DESCRIPTOR_HANDLE GetSamplingTextureHandle(Pipeline* pPipeline, const SamplingCase& samplingCase)
+{
+    Sampling* pSampling = &pPipeline->sampling;
+
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(
+        pSampling->descriptorHeap->GetGPUDescriptorHandleForHeapStart(),
+        (UINT)samplingCase.format * s_SamplingDimensionCount + (UINT)samplingCase.dimension,
+        pSampling->descriptorSize);
+}
+
+static void SetSamplingComputeState(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    const SamplingCase& samplingCase)
+{
+    Sampling* pSampling = &pPipeline->sampling;
+
+    ID3D12DescriptorHeap* ppHeaps[] = { pSampling->descriptorHeap.Get() };
+    pCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    pCmdList->SetComputeRootSignature(pSampling->rootSignature.Get());
+    pCmdList->SetComputeRootDescriptorTable(
+        s_SamplingRootParamTexture,
+        GetSamplingTextureHandle(pPipeline, samplingCase));
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_SamplingRootParamOutput,
+        pSampling->outputBuffer->GetGPUVirtualAddress());
+    pCmdList->SetPipelineState(pSampling->computePipelineStates[(UINT)samplingCase.dimension].Get());
+}
+
+static void RecordSamplingDispatch(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    const SamplingCase& samplingCase,
+    UINT seed)
+{
+    const SamplingConstants constants = GetSamplingConstants(pPipeline, samplingCase, s_SamplingGridSize, seed);
+    pCmdList->SetComputeRoot32BitConstants(
+        s_SamplingRootParamConstants,
+        sizeof(SamplingConstants) / 4,
+        &constants,
+        0);
+
+    const UINT groupCount = s_SamplingGridSize / s_SamplingThreadGroupSize;
+    pCmdList->Dispatch(groupCount, groupCount, 1);
+}
+
+static SamplingCase GetFrameSamplingCase(Pipeline* pPipeline)
+{
+    const Options& options = pPipeline->options;
+
+    SamplingCase samplingCase = {};
+    samplingCase.format = options.samplingFormat;
+    samplingCase.dimension = options.samplingDimension;
+    samplingCase.filter = options.samplingFilter;
+    samplingCase.pattern = options.samplingPattern;
+    samplingCase.lod = options.samplingLod;
+    return samplingCase;
+}
+
+void RecordSampling(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    const SamplingCase samplingCase = GetFrameSamplingCase(pPipeline);
+    SetSamplingComputeState(pPipeline, pCmdList, samplingCase);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordSamplingDispatch(pPipeline, pCmdList, samplingCase, seed);
+    }
+}
+
+// Reusable list of the sweep, run twice per case.
+struct SamplingSweepContext
+{
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+};
+
+static double ExecuteSamplingSweepList(Pipeline* pPipeline, SamplingSweepContext* pContext)
+{
+    ThrowIfFailed(pContext->cmdList->Close());
+    return ExecuteTimedSweepList(pPipeline, pContext->cmdList.Get());
+}
+
+static void ReportSamplingCase(
+    Pipeline* pPipeline,
+    const char* name,
+    double samples,
+    double elapsedMs)
+{
+    // One filtered lookup per sample, however many texels the filter reads.
+    const double gigaTexelsPerSecond = GetRate(samples, elapsedMs, 1.0e9);
+
+    LogMessage("%s: %.2f Gtexels/s (%.3f ms)\n", name, gigaTexelsPerSecond, elapsedMs);
+    ReportSweepResult(pPipeline, name, gigaTexelsPerSecond, "Gtexels/s", elapsedMs);
+}
+
+static void RunSamplingComputeCase(
+    Pipeline* pPipeline,
+    SamplingSweepContext* pContext,
+    const SamplingCase& samplingCase,
+    const char* name)
+{
+    const UINT iterations = pPipeline->options.samplingSweepIterations;
+
+    ThrowIfFailed(pContext->cmdAlloc->Reset());
+    ThrowIfFailed(pContext->cmdList->Reset(pContext->cmdAlloc.Get(), nullptr));
+    SetSamplingComputeState(pPipeline, pContext->cmdList.Get(), samplingCase);
+    BeginGpuMeasurement(pPipeline, pContext->cmdList.Get());
+    for (UINT iteration = 0; iteration < iterations; ++iteration)
+    {
+        RecordSamplingDispatch(pPipeline, pContext->cmdList.Get(), samplingCase, iteration);
+    }
+    EndGpuMeasurement(pPipeline, pContext->cmdList.Get());
+    const double elapsedMs = ExecuteSamplingSweepList(pPipeline, pContext);
+
+    const double samples = (double)s_SamplingGridSize * s_SamplingGridSize *
+        pPipeline->options.samplingSamples * iterations;
+    ReportSamplingCase(pPipeline, name, samples, elapsedMs);
+}
+
+static void RunSamplingPixelCase(
+    Pipeline* pPipeline,
+    SamplingSweepContext* pContext,
+    const SamplingCase& samplingCase,
+    const char* name)
+{
+    Sampling* pSampling = &pPipeline->sampling;
+    ID3D12GraphicsCommandList* pCmdList = pContext->cmdList.Get();
+    ID3D12Resource* pRenderTarget = pPipeline->renderTargets[pPipeline->backBufferIndex].Get();
+    const UINT iterations = pPipeline->options.samplingSweepIterations;
+    const UINT width = (UINT)pPipeline->viewport.Width;
+    const UINT height = (UINT)pPipeline->viewport.Height;
+
+    ThrowIfFailed(pContext->cmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pContext->cmdAlloc.Get(), pSampling->pixelPipelineState.Get()));
+
+    // Draw into the current back buffer, it isn't presented before the frame
+    // loop renders over it.
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_PRESENT,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+        pCmdList->ResourceBarrier(1, &barrier);
+    }
+
+    ID3D12DescriptorHeap* ppHeaps[] = { pSampling->descriptorHeap.Get() };
+    pCmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    pCmdList->SetGraphicsRootSignature(pSampling->rootSignature.Get());
+    pCmdList->SetGraphicsRootDescriptorTable(
+        s_SamplingRootParamTexture,
+        GetSamplingTextureHandle(pPipeline, samplingCase));
+    pCmdList->RSSetViewports(1, &pPipeline->viewport);
+    pCmdList->RSSetScissorRects(1, &pPipeline->scissorRect);
+    pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(
+        pPipeline->rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+        pPipeline->backBufferIndex,
+        pPipeline->rtvDescriptorSize);
+    pCmdList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+
+    BeginGpuMeasurement(pPipeline, pCmdList);
+    for (UINT iteration = 0; iteration < iterations; ++iteration)
+    {
+        const SamplingConstants constants = GetSamplingConstants(pPipeline, samplingCase, width, iteration);
+        pCmdList->SetGraphicsRoot32BitConstants(
+            s_SamplingRootParamConstants,
+            sizeof(SamplingConstants) / 4,
+            &constants,
+            0);
+        pCmdList->DrawInstanced(3, 1, 0, 0);
+    }
+    EndGpuMeasurement(pPipeline, pCmdList);
+
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pRenderTarget,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PRESENT);
+        pCmdList->ResourceBarrier(1, &barrier);
+    }
+    const double elapsedMs = ExecuteSamplingSweepList(pPipeline, pContext);
+
+    const double samples = (double)width * height * pPipeline->options.samplingSamples * iterations;
+    ReportSamplingCase(pPipeline, name, samples, elapsedMs);
+}
+
+void RunSamplingSweep(Pipeline* pPipeline)
+{
+    SamplingSweepContext context = {};
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&context.cmdAlloc)));
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        context.cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&context.cmdList)));
+    ThrowIfFailed(context.cmdList->Close());
+
+    char caseName[96];
+    char name[128];
+    SamplingCase samplingCase = {};
+    samplingCase.lod = pPipeline->options.samplingLod;
+
+    // Every texture, filter and pattern, in both stages for 2D textures.
+    for (UINT dimension = 0; dimension < s_SamplingDimensionCount; ++dimension)
+    {
+        for (UINT format = 0; format < s_SamplingFormatCount; ++format)
+        {
+            for (UINT filter = 0; filter < s_SamplingFilterCount; ++filter)
+            {
+                for (UINT pattern = 0; pattern < s_SamplingPatternCount; ++pattern)
+                {
+                    samplingCase.dimension = (SamplingDimension)dimension;
+                    samplingCase.format = (SamplingFormat)format;
+                    samplingCase.filter = (SamplingFilter)filter;
+                    samplingCase.pattern = (SamplingPattern)pattern;
+
+                    snprintf(
+                        caseName,
+                        sizeof(caseName),
+                        "%s %s %s %s",
+                        GetSamplingDimensionName(samplingCase.dimension),
+                        GetSamplingFormatName(samplingCase.format),
+                        GetSamplingFilterName(samplingCase.filter),
+                        GetSamplingPatternName(samplingCase.pattern));
+
+                    snprintf(name, sizeof(name), "sampling cs %s", caseName);
+                    RunSamplingComputeCase(pPipeline, &context, samplingCase, name);
+
+                    if (samplingCase.dimension == SamplingDimension::Texture2D)
+                    {
+                        snprintf(name, sizeof(name), "sampling ps %s", caseName);
+                        RunSamplingPixelCase(pPipeline, &context, samplingCase, name);
+                    }
+                }
+            }
+        }
+    }
+
+    // Cache locality: the same kernel over shrinking footprints, one mip at
+    // a time, until the texture fits in the smallest caches.
+    samplingCase.dimension = SamplingDimension::Texture2D;
+    samplingCase.format = SamplingFormat::Rgba8;
+    samplingCase.filter = SamplingFilter::Bilinear;
+    for (UINT lod = 0; ; ++lod)
+    {
+        samplingCase.lod = lod;
+        const UINT mipSize = GetSamplingMipSize(pPipeline, samplingCase);
+        if (mipSize < s_SamplingSweepMinSize)
+        {
+            break;
+        }
+
+        for (UINT pattern = 0; pattern < s_SamplingPatternCount; ++pattern)
+        {
+            samplingCase.pattern = (SamplingPattern)pattern;
+            snprintf(
+                name,
+                sizeof(name),
+                "sampling cs 2d rgba8 bilinear %s %ux%u",
+                GetSamplingPatternName(samplingCase.pattern),
+                mipSize,
+                mipSize);
+            RunSamplingComputeCase(pPipeline, &context, samplingCase, name);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Texture sampling throughput: a texture of every format and dimension, with
+// a full mip chain of random texels, sampled by compute and pixel shaders
+// with every filter in coherent and random patterns, see sampling.hlsl.
+//
+// The workload binds its own descriptor heap, so it replaces the frame's
+// CBV heap for the rest of the list it is recorded into.
+struct Sampling
+{
+    // Root signature shared by both stages: root constants at b0, a one-SRV
+    // table at t0, the output buffer as a root UAV at u0, and a static
+    // sampler per filter at s0-s3.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    // Compute PSOs per dimension.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> computePipelineStates[s_SamplingDimensionCount];
+    // Full-screen 2D sampling into the back buffer.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pixelPipelineState;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> textures[s_SamplingFormatCount][s_SamplingDimensionCount];
+    // One SRV per texture, in `textures` order.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    UINT descriptorSize;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> outputBuffer;
+};
+
+// Create the root signature and PSOs.
+void CreateSamplingPipelineStates(Pipeline* pPipeline);
+
+// Create the textures and upload their random texels through a copy queue.
+void CreateSamplingResources(Pipeline* pPipeline);
+
+// Record dispatches [firstDraw, firstDraw + drawCount) sampling the texture
+// and with the filter and pattern of the options.
+void RecordSampling(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time compute sampling of every texture with every filter and pattern,
+// pixel shader sampling of the 2D textures, and compute sampling of every mip
+// of the RGBA8 2D texture, and log texels per second. The GPU must be idle;
+// returns with the GPU idle.
+void RunSamplingSweep(Pipeline* pPipeline);
@@ -0,0 +1,115 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Texture sampling kernels. Every thread or pixel takes `sampleCount`
+// filtered samples of one texture, with explicit gradients so both stages
+// and both patterns sample the same mip and anisotropy. SAMPLING_ARRAY and
+// SAMPLING_3D select the texture type, 2D by default.
+
+cbuffer SamplingConstants : register(b0)
+{
+    // UV gradient along x and y, which sets the mip and anisotropy.
+    float2 gradient;
+    // UV distance between neighbouring threads in the coherent pattern, one
+    // texel of the sampled mip.
+    float texelSize;
+    // UV distance between consecutive samples of a thread in the coherent
+    // pattern, one grid width of texels.
+    float sampleStride;
+    // Index into `samplers`.
+    uint filter;
+    // 0 coherent, 1 random.
+    uint pattern;
+    uint sampleCount;
+    // Array layers or depth slices.
+    uint layerCount;
+    // Changes every dispatch so random samples do.
+    uint seed;
+};
+
+#if defined(SAMPLING_3D)
+Texture3D<float4> tex : register(t0);
+#elif defined(SAMPLING_ARRAY)
+Texture2DArray<float4> tex : register(t0);
+#else
+Texture2D<float4> tex : register(t0);
+#endif
+
+// Point, bilinear, trilinear and anisotropic static samplers.
+SamplerState samplers[4] : register(s0);
+RWStructuredBuffer<float4> output : register(u0);
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+float4 SampleTexture(uint2 position, uint i)
+{
+    float2 uv;
+    // Layer, or depth coordinate of 3D textures.
+    float layer;
+
+    if (pattern == 0)
+    {
+        uv = (float2(position) + 0.5f) * texelSize + float2(i * sampleStride, 0.0f);
+        layer = i % layerCount;
+    }
+    else
+    {
+        const uint h = Hash(seed + ((position.y << 12) + position.x) * sampleCount + i);
+        uv = float2(h & 0xffff, h >> 16) / 65536.0f;
+        layer = Hash(h) % layerCount;
+    }
+
+#if defined(SAMPLING_3D)
+    return tex.SampleGrad(
+        samplers[filter],
+        float3(uv, (layer + 0.5f) / layerCount),
+        float3(gradient.x, 0.0f, 0.0f),
+        float3(0.0f, gradient.y, 0.0f));
+#elif defined(SAMPLING_ARRAY)
+    return tex.SampleGrad(samplers[filter], float3(uv, layer), float2(gradient.x, 0.0f), float2(0.0f, gradient.y));
+#else
+    return tex.SampleGrad(samplers[filter], uv, float2(gradient.x, 0.0f), float2(0.0f, gradient.y));
+#endif
+}
+
+float4 SampleLoop(uint2 position)
+{
+    float4 sum = 0.0f;
+    for (uint i = 0; i < sampleCount; ++i)
+    {
+        sum += SampleTexture(position, i);
+    }
+    return sum;
+}
+
+[numthreads(8, 8, 1)]
+void CSMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const float4 sum = SampleLoop(dispatchThreadId.xy);
+
+    // Keep the samples alive without paying for a write per thread: the
+    // textures are unorm or positive, so the sum never is negative.
+    if (sum.x < 0.0f)
+    {
+        output[dispatchThreadId.y * 256 + dispatchThreadId.x] = sum;
+    }
+}
+
+// Full-screen triangle.
+float4 VSMain(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    const float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+
+float4 PSMain(float4 position : SV_POSITION) : SV_TARGET
+{
+    return SampleLoop((uint2)position.xy) / sampleCount;
+}
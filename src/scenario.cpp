@@ -0,0 +1,166 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "scenario.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Upper bound of the tokens of a line, the phase name included.
+static const UINT s_MaxScenarioTokenCount = 256;
+
+static char* ReadTextFile(const char* path)
+{
+    FILE* pFile = fopen(path, "rb");
+    if (pFile == nullptr)
+    {
+        return nullptr;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    const long size = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    char* pText = (size >= 0) ? (char*)malloc((size_t)size + 1) : nullptr;
+    if (pText != nullptr)
+    {
+        const size_t readSize = fread(pText, 1, (size_t)size, pFile);
+        pText[readSize] = '\0';
+    }
+
+    fclose(pFile);
+    return pText;
+}
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Split `pLine` in place at whitespace, up to the first '#'. Returns the
+// token count.
+static UINT TokenizeLine(char* pLine, char** ppTokens, UINT maxTokenCount)
+{
+    char* pComment = strchr(pLine, '#');
+    if (pComment != nullptr)
+    {
+        *pComment = '\0';
+    }
+
+    UINT tokenCount = 0;
+    char* c = pLine;
+    while (*c != '\0' && tokenCount < maxTokenCount)
+    {
+        while (IsSpace(*c))
+        {
+            *c++ = '\0';
+        }
+
+        if (*c == '\0')
+        {
+            break;
+        }
+
+        ppTokens[tokenCount++] = c;
+        while (*c != '\0' && !IsSpace(*c))
+        {
+            ++c;
+        }
+    }
+
+    return tokenCount;
+}
+
+bool LoadScenario(const char* path, const Options& baseOptions, Scenario* pScenario)
+{
+    pScenario->phaseCount = 0;
+    pScenario->pText = ReadTextFile(path);
+    if (pScenario->pText == nullptr)
+    {
+        LogMessage("scenario: can't read %s\n", path);
+        return false;
+    }
+
+    UINT lineNumber = 0;
+    char* pNextLine = pScenario->pText;
+    while (pNextLine != nullptr)
+    {
+        char* pLine = pNextLine;
+        pNextLine = strchr(pLine, '\n');
+        if (pNextLine != nullptr)
+        {
+            *pNextLine++ = '\0';
+        }
+        ++lineNumber;
+
+        char* ppTokens[s_MaxScenarioTokenCount];
+        const UINT tokenCount = TokenizeLine(pLine, ppTokens, s_MaxScenarioTokenCount);
+        if (tokenCount == 0)
+        {
+            continue;
+        }
+
+        if (ppTokens[0][0] == '-' || strlen(ppTokens[0]) >= s_MaxScenarioPhaseNameLength)
+        {
+            LogMessage("scenario: %s(%u): expected a phase name, got %s\n", path, lineNumber, ppTokens[0]);
+            FreeScenario(pScenario);
+            return false;
+        }
+
+        if (pScenario->phaseCount == s_MaxScenarioPhaseCount)
+        {
+            LogMessage("scenario: %s(%u): more than %u phases\n", path, lineNumber, s_MaxScenarioPhaseCount);
+            FreeScenario(pScenario);
+            return false;
+        }
+
+        // Parsed like a command line, the name standing in for the program.
+        ScenarioPhase* pPhase = &pScenario->phases[pScenario->phaseCount];
+        strcpy_s(pPhase->name, ppTokens[0]);
+        pPhase->options = baseOptions;
+        // Running the phase with a typo'd option left at its base value would
+        // report the wrong configuration.
+        if (!ParseOptions((int)tokenCount, ppTokens, &pPhase->options))
+        {
+            LogMessage("scenario: %s(%u): bad options in phase %s\n", path, lineNumber, pPhase->name);
+            FreeScenario(pScenario);
+            return false;
+        }
+
+        // Taken from the command line, see Scenario.
+        pPhase->options.adapterIndex = baseOptions.adapterIndex;
+        pPhase->options.adapterLuid = baseOptions.adapterLuid;
+        pPhase->options.shaderDirectory = baseOptions.shaderDirectory;
+        pPhase->options.headless = true;
+        pPhase->options.scenarioPhase = pPhase->name;
+
+        if (pPhase->options.exitFrameCount == 0 && pPhase->options.exitSeconds <= 0.0)
+        {
+            LogMessage(
+                "scenario: %s(%u): phase %s needs -exit-frames or -exit-seconds\n",
+                path,
+                lineNumber,
+                pPhase->name);
+            FreeScenario(pScenario);
+            return false;
+        }
+
+        pScenario->phaseCount += 1;
+    }
+
+    if (pScenario->phaseCount == 0)
+    {
+        LogMessage("scenario: %s has no phases\n", path);
+        FreeScenario(pScenario);
+        return false;
+    }
+
+    return true;
+}
+
+void FreeScenario(Scenario* pScenario)
+{
+    free(pScenario->pText);
+    pScenario->pText = nullptr;
+    pScenario->phaseCount = 0;
+}
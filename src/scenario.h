@@ -0,0 +1,46 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include "options.h"
+
+// Upper bound of phases in a scenario file.
+static const UINT s_MaxScenarioPhaseCount = 64;
+
+// Upper bound of the length of a phase name, including the terminator.
+static const UINT s_MaxScenarioPhaseNameLength = 64;
+
+struct ScenarioPhase
+{
+    // Names the phase in logs, and in its report file.
+    char name[s_MaxScenarioPhaseNameLength];
+    Options options;
+};
+
+// A sequence of phases run back to back on one device, read from a text
+// file. Every line holds a phase name followed by options in command-line
+// syntax, applied on top of the command line:
+//
+//     # name     options
+//     warmup     -workload triangle -exit-seconds 5
+//     bandwidth  -workload bandwidth -bandwidth-mb 512 -exit-seconds 30
+//     overlap    -workload fill-rate -async-compute -frame-count 2 -exit-frames 600
+//
+// Text after '#' is a comment, and values can't contain spaces. Every phase
+// needs `-exit-frames` or `-exit-seconds`. The adapter, shader directory and
+// headless mode are taken from the command line only.
+struct Scenario
+{
+    ScenarioPhase phases[s_MaxScenarioPhaseCount];
+    UINT phaseCount;
+    // File contents, which string options point into.
+    char* pText;
+};
+
+// Read and parse `path`, starting every phase from `baseOptions`. Logs the
+// problem and returns false when the file can't be read or a phase is
+// malformed.
+bool LoadScenario(const char* path, const Options& baseOptions, Scenario* pScenario);
+
+void FreeScenario(Scenario* pScenario);
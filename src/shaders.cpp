@@ -0,0 +1,428 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "shaders.h"
+#include "utils.h"
+#include <d3dcompiler.h>
+#include <dxcapi.h>
+#include <exception>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+using namespace Microsoft::WRL;
+
+#define WIDEN2(x) L ## x
+#define WIDEN(x) WIDEN2(x)
+
+// Bump to invalidate every cached shader, e.g. when the cache file layout
+// changes.
+static const UINT s_ShaderCacheVersion = 2;
+
+static wchar_t s_ShaderDirectory[MAX_PATH];
+static wchar_t s_ShaderCacheDirectory[MAX_PATH];
+
+// DXC is loaded at run time, so the FXC workloads still run on machines
+// without dxcompiler.dll. dxcompiler.dll loads dxil.dll from its own
+// directory to sign the DXIL; unsigned DXIL is rejected by the runtime.
+static DxcCreateInstanceProc s_DxcCreateInstance = nullptr;
+
+static bool DirectoryExists(const wchar_t* path)
+{
+    const DWORD attributes = GetFileAttributesW(path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+void InitShaders(const char* shaderDirectory)
+{
+    wchar_t executableDirectory[MAX_PATH];
+    GetExecutableDirectory(executableDirectory, MAX_PATH);
+
+    if (shaderDirectory != nullptr)
+    {
+        wchar_t directory[MAX_PATH] = {};
+        MultiByteToWideChar(CP_ACP, 0, shaderDirectory, -1, directory, MAX_PATH - 1);
+
+        const size_t length = wcslen(directory);
+        const bool hasSeparator = length > 0 &&
+            (directory[length - 1] == L'/' || directory[length - 1] == L'\\');
+        swprintf(s_ShaderDirectory, MAX_PATH, L"%ls%ls", directory, hasSeparator ? L"" : L"/");
+    }
+    else
+    {
+        // The build copies the sources next to the executable.
+        swprintf(s_ShaderDirectory, MAX_PATH, L"%lsshaders/", executableDirectory);
+
+#if defined(GPUTRASHER_SHADER_SOURCE_DIR)
+        // Running from a build tree that wasn't copied.
+        if (!DirectoryExists(s_ShaderDirectory))
+        {
+            swprintf(s_ShaderDirectory, MAX_PATH, L"%ls", WIDEN(GPUTRASHER_SHADER_SOURCE_DIR));
+        }
+#endif
+    }
+
+    swprintf(s_ShaderCacheDirectory, MAX_PATH, L"%lsshader-cache/", executableDirectory);
+    if (!DirectoryExists(s_ShaderCacheDirectory) && !CreateDirectoryW(s_ShaderCacheDirectory, nullptr))
+    {
+        // Compile every time rather than fail.
+        LogMessage("Shader cache disabled, can't create %ls\n", s_ShaderCacheDirectory);
+        s_ShaderCacheDirectory[0] = L'\0';
+    }
+
+    HMODULE dxcModule = LoadLibraryW(L"dxcompiler.dll");
+    if (dxcModule != nullptr)
+    {
+        s_DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(dxcModule, "DxcCreateInstance");
+    }
+    if (s_DxcCreateInstance == nullptr)
+    {
+        LogMessage("dxcompiler.dll not found, shader model 6 workloads are disabled\n");
+    }
+}
+
+bool IsDxcAvailable()
+{
+    return s_DxcCreateInstance != nullptr;
+}
+
+const wchar_t* GetShaderCacheDirectory()
+{
+    return s_ShaderCacheDirectory;
+}
+
+bool ReadFileBlob(const wchar_t* path, ComPtr<ID3DBlob>* pBlob)
+{
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path, L"rb") != 0)
+    {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    bool result = size > 0 && SUCCEEDED(D3DCreateBlob((SIZE_T)size, pBlob->ReleaseAndGetAddressOf()));
+    if (result)
+    {
+        result = fread((*pBlob)->GetBufferPointer(), 1, (size_t)size, file) == (size_t)size;
+    }
+
+    fclose(file);
+    return result;
+}
+
+// Write through a file unique to the thread, then move it in place, so
+// pipelines compiling on several threads never see a partial file.
+bool WriteFileAtomically(const wchar_t* path, const void* pData, size_t size)
+{
+    wchar_t tempPath[MAX_PATH];
+    swprintf(tempPath, MAX_PATH, L"%ls.%lu.tmp", path, GetCurrentThreadId());
+
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, tempPath, L"wb") != 0)
+    {
+        return false;
+    }
+
+    const bool written = fwrite(pData, 1, size, file) == size;
+    fclose(file);
+
+    if (!written || !MoveFileExW(tempPath, path, MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(tempPath);
+        return false;
+    }
+
+    return true;
+}
+
+static void ReportCompileError(ID3DBlob* pError)
+{
+    if (pError)
+    {
+        OutputDebugStringA((char*)pError->GetBufferPointer());
+    }
+    throw std::exception();
+}
+
+// Shader model 6 targets, e.g. "cs_6_0".
+static bool IsDxilTarget(const char* target)
+{
+    const char* version = strchr(target, '_');
+    return version != nullptr && atoi(version + 1) >= 6;
+}
+
+static const UINT s_MaxDxcDefineCount = 16;
+
+// Command line of a DXC invocation, with storage for the strings it points
+// to.
+struct DxcArguments
+{
+    const wchar_t* arguments[8 + 2 * s_MaxDxcDefineCount];
+    UINT count;
+    wchar_t sourceName[MAX_PATH];
+    wchar_t entryPoint[64];
+    wchar_t target[16];
+    wchar_t defines[s_MaxDxcDefineCount][128];
+};
+
+static void InitDxcArguments(
+    const wchar_t* sourceName,
+    const char* entryPoint,
+    const char* target,
+    UINT shaderFlags,
+    DxcArguments* pArguments)
+{
+    wcscpy_s(pArguments->sourceName, sourceName);
+    MultiByteToWideChar(CP_ACP, 0, entryPoint, -1, pArguments->entryPoint, _countof(pArguments->entryPoint) - 1);
+    MultiByteToWideChar(CP_ACP, 0, target, -1, pArguments->target, _countof(pArguments->target) - 1);
+
+    UINT count = 0;
+    // Names the source in errors, and resolves includes relative to it.
+    pArguments->arguments[count++] = pArguments->sourceName;
+    // Libraries, e.g. "lib_6_3", export every shader they define and take no
+    // entry point.
+    if (strncmp(target, "lib_", 4) != 0)
+    {
+        pArguments->arguments[count++] = L"-E";
+        pArguments->arguments[count++] = pArguments->entryPoint;
+    }
+    pArguments->arguments[count++] = L"-T";
+    pArguments->arguments[count++] = pArguments->target;
+    // Match FXC's default optimization level.
+    pArguments->arguments[count++] = L"-O3";
+    if (shaderFlags & s_ShaderFlag16BitTypes)
+    {
+        pArguments->arguments[count++] = L"-enable-16bit-types";
+    }
+    pArguments->count = count;
+}
+
+// Run DXC and copy its `kind` output into a D3D blob, so DXIL is cached and
+// used just like DXBC.
+static void RunDxc(
+    ID3DBlob* pSource,
+    const DxcArguments& arguments,
+    IDxcIncludeHandler* pIncludeHandler,
+    DXC_OUT_KIND kind,
+    ComPtr<ID3DBlob>* pOutput)
+{
+    // A compiler instance isn't thread safe, pipelines compile on several
+    // threads with `-all-adapters`.
+    ComPtr<IDxcCompiler3> compiler;
+    if (FAILED(s_DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler))))
+    {
+        throw std::exception();
+    }
+
+    DxcBuffer source = {};
+    source.Ptr = pSource->GetBufferPointer();
+    source.Size = pSource->GetBufferSize();
+    source.Encoding = DXC_CP_ACP;
+
+    ComPtr<IDxcResult> result;
+    if (FAILED(compiler->Compile(
+        &source,
+        (LPCWSTR*)arguments.arguments,
+        arguments.count,
+        pIncludeHandler,
+        IID_PPV_ARGS(&result))))
+    {
+        throw std::exception();
+    }
+
+    HRESULT hr = E_FAIL;
+    result->GetStatus(&hr);
+    if (FAILED(hr))
+    {
+        ComPtr<IDxcBlobUtf8> error;
+        if (SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&error), nullptr)) && error)
+        {
+            OutputDebugStringA(error->GetStringPointer());
+        }
+        throw std::exception();
+    }
+
+    ComPtr<IDxcBlob> output;
+    if (FAILED(result->GetOutput(kind, IID_PPV_ARGS(&output), nullptr)) || !output)
+    {
+        throw std::exception();
+    }
+
+    // Preprocessed text is null terminated, leave the terminator out.
+    SIZE_T size = output->GetBufferSize();
+    const char* pData = (const char*)output->GetBufferPointer();
+    if (kind == DXC_OUT_HLSL && size > 0 && pData[size - 1] == '\0')
+    {
+        size -= 1;
+    }
+
+    if (FAILED(D3DCreateBlob(size, pOutput->ReleaseAndGetAddressOf())))
+    {
+        throw std::exception();
+    }
+    memcpy((*pOutput)->GetBufferPointer(), pData, size);
+}
+
+// DXC preprocesses itself: its predefined macros, like
+// `__HLSL_ENABLE_16_BIT` or `__SHADER_TARGET_MINOR`, must be visible to the
+// source.
+static void PreprocessDxil(
+    ID3DBlob* pSource,
+    const wchar_t* sourceName,
+    const char* entryPoint,
+    const char* target,
+    const D3D_SHADER_MACRO* pDefines,
+    UINT shaderFlags,
+    ComPtr<ID3DBlob>* pPreprocessed)
+{
+    if (s_DxcCreateInstance == nullptr)
+    {
+        LogMessage("Can't compile %s for %s without dxcompiler.dll\n", entryPoint, target);
+        throw std::exception();
+    }
+
+    DxcArguments arguments = {};
+    InitDxcArguments(sourceName, entryPoint, target, shaderFlags, &arguments);
+    arguments.arguments[arguments.count++] = L"-P";
+
+    for (UINT i = 0; pDefines != nullptr && pDefines[i].Name != nullptr; ++i)
+    {
+        if (i == s_MaxDxcDefineCount)
+        {
+            LogMessage("Too many defines for %s\n", entryPoint);
+            throw std::exception();
+        }
+
+        swprintf(
+            arguments.defines[i],
+            _countof(arguments.defines[i]),
+            L"%hs=%hs",
+            pDefines[i].Name,
+            pDefines[i].Definition != nullptr ? pDefines[i].Definition : "");
+        arguments.arguments[arguments.count++] = L"-D";
+        arguments.arguments[arguments.count++] = arguments.defines[i];
+    }
+
+    // Let shaders include their neighbours.
+    ComPtr<IDxcUtils> utils;
+    ComPtr<IDxcIncludeHandler> includeHandler;
+    if (FAILED(s_DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils))) ||
+        FAILED(utils->CreateDefaultIncludeHandler(&includeHandler)))
+    {
+        throw std::exception();
+    }
+
+    RunDxc(pSource, arguments, includeHandler.Get(), DXC_OUT_HLSL, pPreprocessed);
+}
+
+void CompileShader(
+    const wchar_t* fileName,
+    const char* entryPoint,
+    const char* target,
+    const D3D_SHADER_MACRO* pDefines,
+    ComPtr<ID3DBlob>* pShader,
+    UINT shaderFlags)
+{
+#if defined(_DEBUG)
+    // Enable better shader debugging with the graphics debugging tools.
+    UINT compileFlags = 0; // D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+    UINT compileFlags = 0;
+#endif
+
+    wchar_t filePath[MAX_PATH];
+    swprintf(filePath, MAX_PATH, L"%ls%ls", s_ShaderDirectory, fileName);
+
+    // The compiler takes the source name as a narrow string; it is used to
+    // resolve includes relative to the file.
+    char sourceName[MAX_PATH] = {};
+    WideCharToMultiByte(CP_ACP, 0, filePath, -1, sourceName, MAX_PATH - 1, nullptr, nullptr);
+
+    ComPtr<ID3DBlob> source;
+    if (!ReadFileBlob(filePath, &source))
+    {
+        LogMessage("Can't read shader %ls\n", filePath);
+        throw std::exception();
+    }
+
+    const bool dxil = IsDxilTarget(target);
+
+    // Expand includes and defines first, so the cache key covers everything
+    // the compiler will see.
+    ComPtr<ID3DBlob> preprocessed;
+    ComPtr<ID3DBlob> error;
+    HRESULT hr = S_OK;
+    if (dxil)
+    {
+        PreprocessDxil(source.Get(), filePath, entryPoint, target, pDefines, shaderFlags, &preprocessed);
+    }
+    else
+    {
+        hr = D3DPreprocess(
+            source->GetBufferPointer(),
+            source->GetBufferSize(),
+            sourceName,
+            pDefines,
+            // Let shaders include their neighbours.
+            D3D_COMPILE_STANDARD_FILE_INCLUDE,
+            &preprocessed,
+            &error);
+        if (FAILED(hr))
+        {
+            ReportCompileError(error.Get());
+        }
+    }
+
+    UINT64 hash = s_Fnv1aOffsetBasis;
+    hash = HashBytes(hash, &s_ShaderCacheVersion, sizeof(s_ShaderCacheVersion));
+    hash = HashBytes(hash, preprocessed->GetBufferPointer(), preprocessed->GetBufferSize());
+    hash = HashBytes(hash, entryPoint, strlen(entryPoint));
+    hash = HashBytes(hash, target, strlen(target));
+    hash = HashBytes(hash, &compileFlags, sizeof(compileFlags));
+    hash = HashBytes(hash, &shaderFlags, sizeof(shaderFlags));
+
+    wchar_t cachePath[MAX_PATH] = {};
+    if (s_ShaderCacheDirectory[0] != L'\0')
+    {
+        swprintf(cachePath, MAX_PATH, L"%ls%016llx.cso", s_ShaderCacheDirectory, hash);
+
+        if (ReadFileBlob(cachePath, pShader))
+        {
+            return;
+        }
+    }
+
+    if (dxil)
+    {
+        DxcArguments arguments = {};
+        InitDxcArguments(filePath, entryPoint, target, shaderFlags, &arguments);
+        RunDxc(preprocessed.Get(), arguments, nullptr, DXC_OUT_OBJECT, pShader);
+    }
+    else
+    {
+        hr = D3DCompile(
+            preprocessed->GetBufferPointer(),
+            preprocessed->GetBufferSize(),
+            sourceName,
+            nullptr,
+            nullptr,
+            entryPoint,
+            target,
+            compileFlags,
+            0,
+            pShader->ReleaseAndGetAddressOf(),
+            error.ReleaseAndGetAddressOf());
+        if (FAILED(hr))
+        {
+            ReportCompileError(error.Get());
+        }
+    }
+
+    if (cachePath[0] != L'\0')
+    {
+        WriteFileAtomically(cachePath, (*pShader)->GetBufferPointer(), (*pShader)->GetBufferSize());
+    }
+}
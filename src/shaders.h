@@ -0,0 +1,50 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3dcommon.h>
+
+// Find the shader sources in `shaderDirectory` when it isn't null, else in the
+// `shaders` directory the build copies next to the executable, else in the
+// source tree the executable was built from. Compiled shaders are cached in
+// `shader-cache` next to the executable. Call once, before any other thread
+// compiles.
+void InitShaders(const char* shaderDirectory);
+
+// Directory of the compiled shader cache, with a trailing separator, or an
+// empty string when it couldn't be created.
+const wchar_t* GetShaderCacheDirectory();
+
+// Read a whole file into a new blob. Returns false if it can't be read or is
+// empty.
+bool ReadFileBlob(const wchar_t* path, Microsoft::WRL::ComPtr<ID3DBlob>* pBlob);
+
+// Replace `path` with `size` bytes without ever leaving a partial file, even
+// with several threads writing the same path.
+bool WriteFileAtomically(const wchar_t* path, const void* pData, size_t size);
+
+// `CompileShader` flags.
+// Native 16-bit types (`float16_t`, `int16_t`), shader model 6.2 and up.
+static const UINT s_ShaderFlag16BitTypes = 0x1;
+
+// Whether dxcompiler.dll was found, i.e. shader model 6 targets compile.
+bool IsDxcAvailable();
+
+// Compile `entryPoint` of the HLSL file `fileName` (relative to the shader
+// directory) for `target`, e.g. "vs_5_0". Shader model 5 targets compile to
+// DXBC with FXC, shader model 6 targets to DXIL with DXC. Library targets,
+// e.g. "lib_6_3", compile the whole file; `entryPoint` only names it in
+// messages and the cache key. `pDefines` is an
+// optional null-terminated macro list. The bytecode is cached on disk under a
+// hash of the preprocessed source, entry point, target and flags, so
+// unchanged shaders compile once. Compile errors go to the debugger output
+// and throw.
+void CompileShader(
+    const wchar_t* fileName,
+    const char* entryPoint,
+    const char* target,
+    const D3D_SHADER_MACRO* pDefines,
+    Microsoft::WRL::ComPtr<ID3DBlob>* pShader,
+    UINT shaderFlags = 0);
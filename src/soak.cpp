@@ -0,0 +1,187 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "soak.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <winternl.h>
+#include <d3dkmthk.h>
+
+static void OpenKmtAdapter(Pipeline* pPipeline)
+{
+    Soak* pSoak = &pPipeline->soak;
+
+    D3DKMT_OPENADAPTERFROMLUID openAdapter = {};
+    openAdapter.AdapterLuid = pPipeline->adapterDesc.AdapterLuid;
+    if (D3DKMTOpenAdapterFromLuid(&openAdapter) >= 0)
+    {
+        pSoak->kmtAdapter = openAdapter.hAdapter;
+    }
+}
+
+static bool QueryKmtAdapterInfo(UINT kmtAdapter, KMTQUERYADAPTERINFOTYPE type, void* pData, UINT dataSize)
+{
+    D3DKMT_QUERYADAPTERINFO queryInfo = {};
+    queryInfo.hAdapter = kmtAdapter;
+    queryInfo.Type = type;
+    queryInfo.pPrivateDriverData = pData;
+    queryInfo.PrivateDriverDataSize = dataSize;
+    return D3DKMTQueryAdapterInfo(&queryInfo) >= 0;
+}
+
+// Needs WDDM 2.4; older drivers leave everything at zero.
+static void QueryAdapterSensors(Pipeline* pPipeline, AdapterSensors* pSensors)
+{
+    const UINT kmtAdapter = pPipeline->soak.kmtAdapter;
+
+    *pSensors = {};
+
+    if (kmtAdapter == 0)
+    {
+        return;
+    }
+
+    D3DKMT_NODE_PERFDATA nodePerfData = {};
+    nodePerfData.NodeOrdinal = 0;
+    if (QueryKmtAdapterInfo(kmtAdapter, KMTQAITYPE_NODEPERFDATA, &nodePerfData, sizeof(nodePerfData)))
+    {
+        pSensors->engineFrequency = nodePerfData.Frequency;
+        pSensors->maxEngineFrequency = nodePerfData.MaxFrequency;
+    }
+
+    D3DKMT_ADAPTER_PERFDATA adapterPerfData = {};
+    if (QueryKmtAdapterInfo(kmtAdapter, KMTQAITYPE_ADAPTERPERFDATA, &adapterPerfData, sizeof(adapterPerfData)))
+    {
+        pSensors->memoryFrequency = adapterPerfData.MemoryFrequency;
+        pSensors->maxMemoryFrequency = adapterPerfData.MaxMemoryFrequency;
+        // Reported in tenths of a percent and tenths of a degree.
+        pSensors->powerPercent = adapterPerfData.Power / 10.0;
+        pSensors->temperatureC = adapterPerfData.Temperature / 10.0;
+        pSensors->fanRpm = adapterPerfData.FanRPM;
+    }
+}
+
+void CreateSoak(Pipeline* pPipeline)
+{
+    if (pPipeline->options.soakWindowSeconds == 0)
+    {
+        return;
+    }
+
+    OpenKmtAdapter(pPipeline);
+
+    AdapterSensors sensors;
+    QueryAdapterSensors(pPipeline, &sensors);
+    LogMessage(
+        "adapter %u: soak windows of %u s, engine clock %s (%.0f MHz max), power %s\n",
+        pPipeline->options.adapterIndex,
+        pPipeline->options.soakWindowSeconds,
+        (sensors.engineFrequency > 0) ? "reported" : "not reported",
+        sensors.maxEngineFrequency / 1.0e6,
+        (sensors.powerPercent > 0.0) ? "reported" : "not reported");
+}
+
+static void EndSoakWindow(Pipeline* pPipeline, double windowMs)
+{
+    Soak* pSoak = &pPipeline->soak;
+    const Options& options = pPipeline->options;
+
+    SoakWindow window = {};
+    window.index = pSoak->windowIndex;
+    window.seconds = windowMs / 1000.0;
+    window.frameCount = pSoak->windowFrameCount;
+    window.framesPerSecond = pSoak->windowFrameCount * 1000.0 / windowMs;
+    window.gpuMsPerFrame = pSoak->windowGpuMs / pSoak->windowFrameCount;
+    QueryAdapterSensors(pPipeline, &window.sensors);
+
+    if (pSoak->windowIndex == 0)
+    {
+        pSoak->baselineGpuMsPerFrame = window.gpuMsPerFrame;
+    }
+    // Without GPU times there is nothing to compare, and nothing is flagged.
+    window.relativeThroughput = (window.gpuMsPerFrame > 0.0 && pSoak->baselineGpuMsPerFrame > 0.0) ?
+        pSoak->baselineGpuMsPerFrame / window.gpuMsPerFrame : 1.0;
+
+    // A single slow window is noise, a run of them is the adapter slowing
+    // down.
+    if (window.relativeThroughput < 1.0 - options.soakThrottlePercent / 100.0)
+    {
+        pSoak->slowWindowCount += 1;
+    }
+    else
+    {
+        pSoak->slowWindowCount = 0;
+    }
+
+    const bool throttling = pSoak->slowWindowCount >= options.soakThrottleWindows;
+    if (throttling != pSoak->throttling)
+    {
+        LogMessage(
+            throttling ?
+                "adapter %u: THROTTLING at soak window %u, %.1f%% of the first window's throughput\n" :
+                "adapter %u: recovered at soak window %u, %.1f%% of the first window's throughput\n",
+            options.adapterIndex,
+            window.index,
+            window.relativeThroughput * 100.0);
+        pSoak->throttling = throttling;
+    }
+    window.throttling = throttling;
+
+    LogMessage(
+        "adapter %u: soak window %u: %.1f frames/s, %.3f GPU ms/frame (%.1f%%), "
+        "engine %.0f MHz, memory %.0f MHz, power %.1f%%, %.1f C\n",
+        options.adapterIndex,
+        window.index,
+        window.framesPerSecond,
+        window.gpuMsPerFrame,
+        window.relativeThroughput * 100.0,
+        window.sensors.engineFrequency / 1.0e6,
+        window.sensors.memoryFrequency / 1.0e6,
+        window.sensors.powerPercent,
+        window.sensors.temperatureC);
+
+    ReportSoakWindow(pPipeline, window);
+
+    pSoak->windowIndex += 1;
+}
+
+void UpdateSoak(Pipeline* pPipeline, double gpuMs)
+{
+    Soak* pSoak = &pPipeline->soak;
+
+    if (pPipeline->options.soakWindowSeconds == 0)
+    {
+        return;
+    }
+
+    const UINT64 nowTicks = GetCpuTicks();
+    if (pSoak->windowStartTicks == 0)
+    {
+        pSoak->windowStartTicks = nowTicks;
+    }
+
+    pSoak->windowFrameCount += 1;
+    pSoak->windowGpuMs += gpuMs;
+
+    const double windowMs = CpuTicksToMs(nowTicks - pSoak->windowStartTicks);
+    if (windowMs >= pPipeline->options.soakWindowSeconds * 1000.0)
+    {
+        EndSoakWindow(pPipeline, windowMs);
+
+        pSoak->windowStartTicks = nowTicks;
+        pSoak->windowFrameCount = 0;
+        pSoak->windowGpuMs = 0.0;
+    }
+}
+
+void DestroySoak(Pipeline* pPipeline)
+{
+    Soak* pSoak = &pPipeline->soak;
+
+    if (pSoak->kmtAdapter != 0)
+    {
+        D3DKMT_CLOSEADAPTER closeAdapter = {};
+        closeAdapter.hAdapter = pSoak->kmtAdapter;
+        D3DKMTCloseAdapter(&closeAdapter);
+        pSoak->kmtAdapter = 0;
+    }
+}
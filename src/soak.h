@@ -0,0 +1,75 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+
+struct Pipeline;
+
+// Clock, power and temperature readings of the adapter, from the kernel-mode
+// driver's performance data (what the task manager shows). Zero when the
+// driver doesn't report the value.
+struct AdapterSensors
+{
+    // Of the 3D engine, node 0.
+    UINT64 engineFrequency;
+    UINT64 maxEngineFrequency;
+    UINT64 memoryFrequency;
+    UINT64 maxMemoryFrequency;
+    // Percent of the adapter's power limit.
+    double powerPercent;
+    double temperatureC;
+    UINT fanRpm;
+};
+
+// One soak window, as logged and reported.
+struct SoakWindow
+{
+    UINT index;
+    double seconds;
+    UINT64 frameCount;
+    double framesPerSecond;
+    double gpuMsPerFrame;
+    // GPU time per frame of the first window over this one's. Frames per
+    // second would stay at the refresh rate with vsync while the GPU slows
+    // underneath.
+    double relativeThroughput;
+    AdapterSensors sensors;
+    bool throttling;
+};
+
+// Long-run drift monitor. The frame loop's frames are counted over windows of
+// `Options::soakWindowSeconds`; every window is logged and reported with the
+// adapter's clocks and power when available, and compared against the first
+// window. GPU throughput more than `Options::soakThrottlePercent` below it for
+// `Options::soakThrottleWindows` windows in a row is flagged as throttling,
+// and so is the recovery.
+//
+// The workload is whatever the options select, unchanged for the whole run,
+// so GPU time per frame is comparable across windows even when the driver
+// reports no clocks.
+struct Soak
+{
+    // Kernel-mode adapter handle for the sensor queries, 0 if it can't be
+    // opened.
+    UINT kmtAdapter;
+
+    UINT64 windowStartTicks;
+    UINT64 windowFrameCount;
+    double windowGpuMs;
+    UINT windowIndex;
+
+    double baselineGpuMsPerFrame;
+    // Consecutive windows below the throttling threshold.
+    UINT slowWindowCount;
+    bool throttling;
+};
+
+// Does nothing without `Options::soakWindowSeconds`.
+void CreateSoak(Pipeline* pPipeline);
+
+// Count a frame of the frame loop, once its GPU time is known, and close the
+// window when it's over.
+void UpdateSoak(Pipeline* pPipeline, double gpuMs);
+
+void DestroySoak(Pipeline* pPipeline);
@@ -0,0 +1,230 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "telemetry.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <malloc.h>
+#include <string.h>
+
+#if defined(GPUTRASHER_PIX)
+#define USE_PIX
+#include <pix3.h>
+#endif
+
+// How often the drain thread empties the rings; well under the time a busy
+// thread takes to fill one.
+static const DWORD s_TelemetryDrainMs = 10;
+static const double s_TelemetryWindowMs = 1000.0;
+
+static const char* s_TelemetryMarkerNames[s_TelemetryMarkerCount] =
+{
+    "populate",
+    "record",
+    "record-wait",
+    "execute",
+    "present",
+    "fence-wait",
+};
+
+const char* GetTelemetryMarkerName(TelemetryMarker marker)
+{
+    return s_TelemetryMarkerNames[(UINT)marker];
+}
+
+// Fold every event published since the last drain into the window's stats,
+// then hand the slots back to the producers.
+static void DrainTelemetryRings(Telemetry* pTelemetry)
+{
+    for (UINT thread = 0; thread < pTelemetry->threadCount; ++thread)
+    {
+        TelemetryRing* pRing = &pTelemetry->pRings[thread];
+
+        const LONG64 writeIndex = ReadAcquire64(&pRing->writeIndex);
+        for (LONG64 i = pRing->readIndex; i < writeIndex; ++i)
+        {
+            const TelemetryEvent& event = pRing->events[i % s_TelemetryRingSize];
+            const UINT64 ticks = event.endTicks - event.startTicks;
+
+            TelemetryStats* pStats = &pTelemetry->stats[thread][(UINT)event.marker];
+            pStats->count += 1;
+            pStats->totalTicks += ticks;
+            pStats->maxTicks = max(pStats->maxTicks, ticks);
+        }
+
+        WriteRelease64(&pRing->readIndex, writeIndex);
+    }
+}
+
+static void FinishTelemetryWindow(Pipeline* pPipeline, UINT64 nowTicks)
+{
+    Telemetry* pTelemetry = &pPipeline->telemetry;
+
+    UINT64 droppedCount = 0;
+    for (UINT thread = 0; thread < pTelemetry->threadCount; ++thread)
+    {
+        for (UINT marker = 0; marker < s_TelemetryMarkerCount; ++marker)
+        {
+            const LONG64 dropped = pTelemetry->pRings[thread].droppedCounts[marker];
+            pTelemetry->stats[thread][marker].droppedCount =
+                (UINT64)(dropped - pTelemetry->reportedDroppedCounts[thread][marker]);
+            pTelemetry->reportedDroppedCounts[thread][marker] = dropped;
+
+            droppedCount += pTelemetry->stats[thread][marker].droppedCount;
+        }
+    }
+
+    if (droppedCount > 0)
+    {
+        LogMessage(
+            "adapter %u: telemetry dropped %llu markers to full rings\n",
+            pPipeline->options.adapterIndex,
+            droppedCount);
+    }
+
+    ReportTelemetryWindow(pPipeline, CpuTicksToMs(nowTicks - pTelemetry->windowStartTicks) / 1000.0);
+
+    memset(pTelemetry->stats, 0, sizeof(pTelemetry->stats));
+    pTelemetry->windowStartTicks = nowTicks;
+    pTelemetry->windowIndex += 1;
+}
+
+static DWORD WINAPI TelemetryThreadProc(LPVOID pParam)
+{
+    Pipeline* pPipeline = reinterpret_cast<Pipeline*>(pParam);
+    Telemetry* pTelemetry = &pPipeline->telemetry;
+
+    for (;;)
+    {
+        const bool quit = WaitForSingleObject(pTelemetry->quitEvent, s_TelemetryDrainMs) == WAIT_OBJECT_0;
+
+        DrainTelemetryRings(pTelemetry);
+
+        const UINT64 nowTicks = GetCpuTicks();
+        if (quit || CpuTicksToMs(nowTicks - pTelemetry->windowStartTicks) >= s_TelemetryWindowMs)
+        {
+            FinishTelemetryWindow(pPipeline, nowTicks);
+        }
+
+        if (quit)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+void CreateTelemetry(Pipeline* pPipeline)
+{
+    Telemetry* pTelemetry = &pPipeline->telemetry;
+
+    if (!pPipeline->options.telemetry)
+    {
+        return;
+    }
+
+    // Aligned so every ring's indices get cache lines of their own.
+    const UINT threadCount = 1 + pPipeline->options.recordThreadCount;
+    const size_t ringsSize = threadCount * sizeof(TelemetryRing);
+    TelemetryRing* pRings = reinterpret_cast<TelemetryRing*>(_aligned_malloc(ringsSize, 64));
+    if (pRings == nullptr)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+    memset(pRings, 0, ringsSize);
+
+    memset(pTelemetry->stats, 0, sizeof(pTelemetry->stats));
+    memset(pTelemetry->reportedDroppedCounts, 0, sizeof(pTelemetry->reportedDroppedCounts));
+    pTelemetry->windowStartTicks = GetCpuTicks();
+    pTelemetry->windowIndex = 0;
+    pTelemetry->threadCount = threadCount;
+
+    // Manual-reset, the thread may check it more than once on the way out.
+    pTelemetry->quitEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (pTelemetry->quitEvent == nullptr)
+    {
+        _aligned_free(pRings);
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    // Published before the thread starts, so it sees the rings.
+    pTelemetry->pRings = pRings;
+
+    pTelemetry->drainThread = CreateThread(
+        nullptr,
+        0,
+        TelemetryThreadProc,
+        pPipeline,
+        0,
+        nullptr);
+    if (pTelemetry->drainThread == nullptr)
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+}
+
+UINT64 BeginTelemetryMarker(Pipeline* pPipeline, TelemetryMarker marker)
+{
+#if defined(GPUTRASHER_PIX)
+    PIXBeginEvent(PIX_COLOR_INDEX((BYTE)marker), s_TelemetryMarkerNames[(UINT)marker]);
+#else
+    UNREFERENCED_PARAMETER(marker);
+#endif
+
+    return (pPipeline->telemetry.pRings != nullptr) ? GetCpuTicks() : 0;
+}
+
+void EndTelemetryMarker(Pipeline* pPipeline, UINT threadIndex, TelemetryMarker marker, UINT64 startTicks)
+{
+#if defined(GPUTRASHER_PIX)
+    PIXEndEvent();
+#endif
+
+    Telemetry* pTelemetry = &pPipeline->telemetry;
+    if (pTelemetry->pRings == nullptr)
+    {
+        return;
+    }
+
+    const UINT64 endTicks = GetCpuTicks();
+    TelemetryRing* pRing = &pTelemetry->pRings[threadIndex];
+
+    // Only this thread moves `writeIndex`. A full ring drops the marker, the
+    // hot path never waits for the drain thread.
+    const LONG64 writeIndex = pRing->writeIndex;
+    if (writeIndex - ReadAcquire64(&pRing->readIndex) >= s_TelemetryRingSize)
+    {
+        pRing->droppedCounts[(UINT)marker] += 1;
+        return;
+    }
+
+    TelemetryEvent* pEvent = &pRing->events[writeIndex % s_TelemetryRingSize];
+    pEvent->startTicks = startTicks;
+    pEvent->endTicks = endTicks;
+    pEvent->marker = marker;
+
+    // The drain thread may read the slot as soon as it sees the new index.
+    WriteRelease64(&pRing->writeIndex, writeIndex + 1);
+}
+
+void DestroyTelemetry(Pipeline* pPipeline)
+{
+    Telemetry* pTelemetry = &pPipeline->telemetry;
+
+    if (pTelemetry->pRings == nullptr)
+    {
+        return;
+    }
+
+    if (pTelemetry->drainThread != nullptr)
+    {
+        SetEvent(pTelemetry->quitEvent);
+        WaitForSingleObject(pTelemetry->drainThread, INFINITE);
+        CloseHandle(pTelemetry->drainThread);
+        pTelemetry->drainThread = nullptr;
+    }
+
+    CloseHandle(pTelemetry->quitEvent);
+    _aligned_free(pTelemetry->pRings);
+    pTelemetry->pRings = nullptr;
+}
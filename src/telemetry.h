@@ -0,0 +1,107 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include "options.h"
+
+struct Pipeline;
+
+// CPU-side spans of the frame loop's hot path.
+enum class TelemetryMarker
+{
+    // PopulateCommandList() on the main thread.
+    Populate,
+    // A worker thread recording its share of the draws.
+    Record,
+    // The main thread waiting for the workers to close their lists.
+    RecordWait,
+    ExecuteCommandLists,
+    Present,
+    // Blocked in WaitForFenceValue(); calls that find the fence passed
+    // aren't marked.
+    FenceWait,
+};
+static const UINT s_TelemetryMarkerCount = 6;
+
+// Ring of the main thread; worker thread `i` of `Pipeline::recordThreads`
+// writes to ring `i + 1`.
+static const UINT s_TelemetryMainThread = 0;
+static const UINT s_MaxTelemetryThreadCount = s_MaxRecordThreadCount + 1;
+
+// Markers a ring holds between drains, ~4 ms of a thread emitting 1M/s.
+static const UINT s_TelemetryRingSize = 4096;
+
+struct TelemetryEvent
+{
+    UINT64 startTicks;
+    UINT64 endTicks;
+    TelemetryMarker marker;
+};
+
+// Single producer, single consumer: only the owning thread moves
+// `writeIndex`, only the drain thread moves `readIndex`. Both only grow; the
+// slot of index `i` is `i % s_TelemetryRingSize`. The indices sit on their
+// own cache lines so the drain doesn't slow down the producer.
+struct TelemetryRing
+{
+    volatile LONG64 writeIndex;
+    // Markers lost to a full ring, written by the owning thread only.
+    volatile LONG64 droppedCounts[s_TelemetryMarkerCount];
+    UINT8 producerPadding[64 - (s_TelemetryMarkerCount + 1) * sizeof(LONG64) % 64];
+
+    volatile LONG64 readIndex;
+    UINT8 consumerPadding[64 - sizeof(LONG64)];
+
+    TelemetryEvent events[s_TelemetryRingSize];
+};
+
+// Markers of one kind from one thread over a window.
+struct TelemetryStats
+{
+    UINT64 count;
+    UINT64 totalTicks;
+    UINT64 maxTicks;
+    UINT64 droppedCount;
+};
+
+// Scoped CPU markers around the frame loop's hot path, on with
+// `Options::telemetry`. Every thread writes its markers into a ring of its
+// own, without locks; a background thread drains the rings every few
+// milliseconds and writes count, mean and max of every thread's markers to
+// the report about once per second. Built with `GPUTRASHER_PIX`, every
+// marker is also a PIX event, whether or not the rings are on, so captures
+// show the same spans.
+struct Telemetry
+{
+    // `threadCount` rings, null while telemetry is off.
+    TelemetryRing* pRings;
+    UINT threadCount;
+
+    HANDLE drainThread;
+    // Set to stop the drain thread, which drains once more on the way out.
+    HANDLE quitEvent;
+
+    // Accumulated by the drain thread since `windowStartTicks`.
+    TelemetryStats stats[s_MaxTelemetryThreadCount][s_TelemetryMarkerCount];
+    LONG64 reportedDroppedCounts[s_MaxTelemetryThreadCount][s_TelemetryMarkerCount];
+    UINT64 windowStartTicks;
+    UINT windowIndex;
+};
+
+// Allocate a ring per thread and start the drain thread. Does nothing
+// without `Options::telemetry`. Call once the report is open.
+void CreateTelemetry(Pipeline* pPipeline);
+
+// Start a marker. Returns the start time to pass to EndTelemetryMarker().
+UINT64 BeginTelemetryMarker(Pipeline* pPipeline, TelemetryMarker marker);
+
+// Write the marker to the ring of `threadIndex`, which must be the calling
+// thread's.
+void EndTelemetryMarker(Pipeline* pPipeline, UINT threadIndex, TelemetryMarker marker, UINT64 startTicks);
+
+const char* GetTelemetryMarkerName(TelemetryMarker marker);
+
+// Stop the drain thread, reporting the markers still in the rings. Call
+// before CloseReport() and after the threads writing markers have stopped.
+void DestroyTelemetry(Pipeline* pPipeline);
@@ -0,0 +1,436 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "transfer.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest transfer of the sweep; every next one is 4 times larger.
+static const UINT64 s_TransferMinSize = 4096;
+
+// Video memory left for everything else when sizing the buffers.
+static const UINT64 s_TransferVideoMemoryReserve = 256ull * 1024 * 1024;
+
+// Every sweep case moves at least this much, so small transfers repeat
+// enough to be timed.
+static const UINT64 s_TransferMinBytesPerCase = 64ull * 1024 * 1024;
+
+enum class TransferPath
+{
+    // CPU memcpy() from system memory into the upload heap.
+    UploadWrite,
+    // CPU memcpy() from the readback heap into system memory.
+    ReadbackRead,
+    // CPU memcpy() from system memory into CPU-visible video memory.
+    CpuVisibleWrite,
+    // CopyBufferRegion() from the upload to the default heap.
+    UploadCopy,
+    // CopyBufferRegion() from the default to the readback heap.
+    ReadbackCopy,
+};
+
+static const char* s_TransferPathNames[] =
+{
+    "upload-write",
+    "readback-read",
+    "cpu-visible-write",
+    "upload-copy",
+    "readback-copy",
+};
+
+// Create the buffer the CPU writes straight into video memory, if the
+// adapter has such memory.
+static void CreateCpuVisibleBuffer(Pipeline* pPipeline, const D3D12_RESOURCE_DESC& bufferDesc)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    D3D12_FEATURE_DATA_ARCHITECTURE architecture = {};
+    ThrowIfFailed(pDevice->CheckFeatureSupport(D3D12_FEATURE_ARCHITECTURE, &architecture, sizeof(architecture)));
+
+    D3D12_HEAP_PROPERTIES heapProps = {};
+    if (architecture.UMA)
+    {
+        // All memory is the GPU's, so a write-combined custom heap in L0 is
+        // what a discrete adapter's BAR would be.
+        heapProps.Type = D3D12_HEAP_TYPE_CUSTOM;
+        heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+        heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+    }
+    else
+    {
+        // Discrete adapters don't allow CPU access to L1 through custom
+        // heaps; GPU upload heaps map video memory through resizable BAR.
+#if defined(D3D12_SDK_VERSION) && D3D12_SDK_VERSION >= 611
+        D3D12_FEATURE_DATA_D3D12_OPTIONS16 options16 = {};
+        if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS16, &options16, sizeof(options16))) ||
+            !options16.GPUUploadHeapSupported)
+        {
+            LogMessage("transfer: no resizable BAR, skipping CPU-visible video memory\n");
+            return;
+        }
+        heapProps.Type = D3D12_HEAP_TYPE_GPU_UPLOAD;
+#else
+        LogMessage("transfer: built without GPU upload heaps, skipping CPU-visible video memory\n");
+        return;
+#endif
+    }
+
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&pTransfer->cpuVisibleBuffer)));
+
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pTransfer->cpuVisibleBuffer->Map(
+        0,
+        &readRange,
+        reinterpret_cast<void**>(&pTransfer->pCpuVisibleData)));
+}
+
+void CreateTransfer(Pipeline* pPipeline)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    // The default and CPU-visible buffers live in video memory; the upload,
+    // readback and host buffers in system memory.
+    {
+        const UINT64 megabyte = 1024ull * 1024;
+        const UINT64 videoMemory = pPipeline->adapterDesc.DedicatedVideoMemory;
+        const UINT64 systemMemory = pPipeline->adapterDesc.SharedSystemMemory;
+        const UINT64 maxVideoSize = (videoMemory > s_TransferVideoMemoryReserve) ?
+            (videoMemory - s_TransferVideoMemoryReserve) / 2 : 64 * megabyte;
+        const UINT64 maxSystemSize = systemMemory / 4;
+
+        UINT64 bufferSize = (UINT64)pPipeline->options.transferMaxMB * megabyte;
+        if (bufferSize > maxVideoSize || bufferSize > maxSystemSize)
+        {
+            bufferSize = min(maxVideoSize, maxSystemSize) & ~(megabyte - 1);
+            LogMessage(
+                "transfer: buffer size clamped to %llu MB, adapter has %llu MB of video and %llu MB of shared memory\n",
+                bufferSize / megabyte,
+                videoMemory / megabyte,
+                systemMemory / megabyte);
+        }
+        pTransfer->bufferSize = max(bufferSize, s_TransferMinSize);
+    }
+
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(pTransfer->bufferSize);
+
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pTransfer->uploadBuffer)));
+
+    CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &readbackHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&pTransfer->readbackBuffer)));
+
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&pTransfer->defaultBuffer)));
+
+    CreateCpuVisibleBuffer(pPipeline, bufferDesc);
+
+    // Keep the upload and readback heaps mapped for their lifetime, like the
+    // constant buffer.
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pTransfer->uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pTransfer->pUploadData)));
+    ThrowIfFailed(pTransfer->readbackBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pTransfer->pReadbackData)));
+
+    // Touch every page up front, so the first case doesn't pay for faulting
+    // them in.
+    pTransfer->pHostData = (UINT8*)malloc((size_t)pTransfer->bufferSize);
+    if (pTransfer->pHostData == nullptr)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+    memset(pTransfer->pHostData, 0x5a, (size_t)pTransfer->bufferSize);
+    memcpy(pTransfer->pUploadData, pTransfer->pHostData, (size_t)pTransfer->bufferSize);
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    ThrowIfFailed(pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&pTransfer->copyQueue)));
+    ThrowIfFailed(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pTransfer->copyFence)));
+    pTransfer->copyFenceValue = 0;
+}
+
+void RecordTransfer(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+    const UINT64 copySize = min((UINT64)pPipeline->options.transferFrameKB * 1024, pTransfer->bufferSize);
+    const UINT64 copiesPerBuffer = pTransfer->bufferSize / copySize;
+
+    // Consecutive draws copy consecutive ranges, wrapping around the buffer,
+    // so lists recorded on different threads write different ranges.
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT64 offset = (draw % copiesPerBuffer) * copySize;
+        pCmdList->CopyBufferRegion(
+            pTransfer->defaultBuffer.Get(),
+            offset,
+            pTransfer->uploadBuffer.Get(),
+            offset,
+            copySize);
+    }
+}
+
+void DestroyTransfer(Pipeline* pPipeline)
+{
+    free(pPipeline->transfer.pHostData);
+    pPipeline->transfer.pHostData = nullptr;
+}
+
+// How often a case of `size` bytes repeats.
+static UINT GetTransferRepeatCount(Pipeline* pPipeline, UINT64 size)
+{
+    const UINT64 minRepeats = (s_TransferMinBytesPerCase + size - 1) / size;
+    return (UINT)max((UINT64)pPipeline->options.transferSweepIterations, minRepeats);
+}
+
+// Milliseconds `repeats` CPU copies of `size` bytes take.
+static double MeasureCpuTransfer(Pipeline* pPipeline, TransferPath path, UINT64 size, UINT repeats)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+
+    UINT8* pDst = nullptr;
+    const UINT8* pSrc = nullptr;
+    switch (path)
+    {
+    case TransferPath::UploadWrite:
+        pDst = pTransfer->pUploadData;
+        pSrc = pTransfer->pHostData;
+        break;
+    case TransferPath::ReadbackRead:
+        pDst = pTransfer->pHostData;
+        pSrc = pTransfer->pReadbackData;
+        break;
+    default:
+        pDst = pTransfer->pCpuVisibleData;
+        pSrc = pTransfer->pHostData;
+        break;
+    }
+
+    // Warm up once, then time.
+    memcpy(pDst, pSrc, (size_t)size);
+
+    const UINT64 startTicks = GetCpuTicks();
+    for (UINT i = 0; i < repeats; ++i)
+    {
+        memcpy(pDst, pSrc, (size_t)size);
+    }
+    return CpuTicksToMs(GetCpuTicks() - startTicks);
+}
+
+// Reusable lists of the sweep, one per queue.
+struct TransferSweepContext
+{
+    ComPtr<ID3D12CommandAllocator> directCmdAlloc;
+    ComPtr<ID3D12GraphicsCommandList> directCmdList;
+    ComPtr<ID3D12CommandAllocator> copyCmdAlloc;
+    ComPtr<ID3D12GraphicsCommandList> copyCmdList;
+};
+
+static void CreateTransferSweepList(
+    Pipeline* pPipeline,
+    D3D12_COMMAND_LIST_TYPE type,
+    ComPtr<ID3D12CommandAllocator>* pCmdAlloc,
+    ComPtr<ID3D12GraphicsCommandList>* pCmdList)
+{
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        type,
+        IID_PPV_ARGS(pCmdAlloc->ReleaseAndGetAddressOf())));
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        type,
+        pCmdAlloc->Get(),
+        nullptr,
+        IID_PPV_ARGS(pCmdList->ReleaseAndGetAddressOf())));
+    ThrowIfFailed((*pCmdList)->Close());
+}
+
+// Execute `pCmdList` on the direct or the copy queue and wait for it.
+static void ExecuteTransferList(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList, bool copyQueue)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+    ID3D12CommandList* ppCommandLists[] = { pCmdList };
+
+    if (!copyQueue)
+    {
+        pPipeline->cmdQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+        WaitForFenceValue(pPipeline, SignalFence(pPipeline));
+        return;
+    }
+
+    pTransfer->copyQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    pTransfer->copyFenceValue += 1;
+    ThrowIfFailed(pTransfer->copyQueue->Signal(pTransfer->copyFence.Get(), pTransfer->copyFenceValue));
+
+    // A null event blocks until the fence is reached.
+    ThrowIfFailed(pTransfer->copyFence->SetEventOnCompletion(pTransfer->copyFenceValue, nullptr));
+}
+
+// Milliseconds `repeats` GPU copies of `size` bytes take, each split into
+// `inFlight` copies of adjacent ranges with no barriers between them, from
+// submission to the fence.
+static double MeasureGpuTransfer(
+    Pipeline* pPipeline,
+    TransferSweepContext* pContext,
+    TransferPath path,
+    bool copyQueue,
+    UINT64 size,
+    UINT repeats,
+    UINT inFlight)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+    ID3D12CommandAllocator* pCmdAlloc = copyQueue ? pContext->copyCmdAlloc.Get() : pContext->directCmdAlloc.Get();
+    ID3D12GraphicsCommandList* pCmdList = copyQueue ? pContext->copyCmdList.Get() : pContext->directCmdList.Get();
+
+    // The default buffer promotes from the common state either way, and the
+    // readback buffer stays a copy destination.
+    ID3D12Resource* pDst = (path == TransferPath::UploadCopy) ?
+        pTransfer->defaultBuffer.Get() : pTransfer->readbackBuffer.Get();
+    ID3D12Resource* pSrc = (path == TransferPath::UploadCopy) ?
+        pTransfer->uploadBuffer.Get() : pTransfer->defaultBuffer.Get();
+
+    const UINT64 chunkSize = size / inFlight;
+
+    ThrowIfFailed(pCmdAlloc->Reset());
+    ThrowIfFailed(pCmdList->Reset(pCmdAlloc, nullptr));
+    for (UINT i = 0; i < repeats; ++i)
+    {
+        for (UINT chunk = 0; chunk < inFlight; ++chunk)
+        {
+            // The last copy takes the remainder.
+            const UINT64 offset = chunk * chunkSize;
+            const UINT64 copySize = (chunk + 1 == inFlight) ? size - offset : chunkSize;
+            pCmdList->CopyBufferRegion(pDst, offset, pSrc, offset, copySize);
+        }
+    }
+    ThrowIfFailed(pCmdList->Close());
+
+    // Warm up once, then time a second run.
+    ExecuteTransferList(pPipeline, pCmdList, copyQueue);
+
+    const UINT64 startTicks = GetCpuTicks();
+    ExecuteTransferList(pPipeline, pCmdList, copyQueue);
+    return CpuTicksToMs(GetCpuTicks() - startTicks);
+}
+
+// "4KB", "16MB", "1GB".
+static void FormatTransferSize(UINT64 size, char* pBuffer, size_t bufferSize)
+{
+    if (size >= 1024ull * 1024 * 1024)
+    {
+        snprintf(pBuffer, bufferSize, "%lluGB", size / (1024ull * 1024 * 1024));
+    }
+    else if (size >= 1024ull * 1024)
+    {
+        snprintf(pBuffer, bufferSize, "%lluMB", size / (1024ull * 1024));
+    }
+    else
+    {
+        snprintf(pBuffer, bufferSize, "%lluKB", size / 1024);
+    }
+}
+
+static void ReportTransferResult(Pipeline* pPipeline, const char* name, UINT64 size, UINT repeats, double elapsedMs)
+{
+    const double gigabytesPerSecond = GetRate((double)size * repeats, elapsedMs, 1.0e9);
+
+    LogMessage("%s: %.2f GB/s (%.3f ms)\n", name, gigabytesPerSecond, elapsedMs);
+    ReportSweepResult(pPipeline, name, gigabytesPerSecond, "GB/s", elapsedMs);
+}
+
+void RunTransferSweep(Pipeline* pPipeline)
+{
+    Transfer* pTransfer = &pPipeline->transfer;
+    const UINT inFlight = pPipeline->options.transferInFlight;
+
+    TransferSweepContext context = {};
+    CreateTransferSweepList(pPipeline, D3D12_COMMAND_LIST_TYPE_DIRECT, &context.directCmdAlloc, &context.directCmdList);
+    CreateTransferSweepList(pPipeline, D3D12_COMMAND_LIST_TYPE_COPY, &context.copyCmdAlloc, &context.copyCmdList);
+
+    char sizeName[16];
+    char name[128];
+
+    for (UINT64 size = s_TransferMinSize; size <= pTransfer->bufferSize; size *= 4)
+    {
+        FormatTransferSize(size, sizeName, sizeof(sizeName));
+        const UINT repeats = GetTransferRepeatCount(pPipeline, size);
+
+        for (UINT path = 0; path <= (UINT)TransferPath::CpuVisibleWrite; ++path)
+        {
+            if ((TransferPath)path == TransferPath::CpuVisibleWrite && !pTransfer->cpuVisibleBuffer)
+            {
+                continue;
+            }
+
+            const double elapsedMs = MeasureCpuTransfer(pPipeline, (TransferPath)path, size, repeats);
+            snprintf(name, sizeof(name), "transfer %s %s", s_TransferPathNames[path], sizeName);
+            ReportTransferResult(pPipeline, name, size, repeats, elapsedMs);
+        }
+
+        for (UINT path = (UINT)TransferPath::UploadCopy; path <= (UINT)TransferPath::ReadbackCopy; ++path)
+        {
+            for (UINT queue = 0; queue < 2; ++queue)
+            {
+                const bool copyQueue = queue == 1;
+
+                // One copy at a time, then several in flight.
+                const UINT depths[] = { 1, inFlight };
+                for (UINT depth = 0; depth < _countof(depths); ++depth)
+                {
+                    if (depth == 1 && inFlight == 1)
+                    {
+                        break;
+                    }
+
+                    const double elapsedMs = MeasureGpuTransfer(
+                        pPipeline,
+                        &context,
+                        (TransferPath)path,
+                        copyQueue,
+                        size,
+                        repeats,
+                        depths[depth]);
+
+                    snprintf(
+                        name,
+                        sizeof(name),
+                        "transfer %s %s %s x%u",
+                        s_TransferPathNames[path],
+                        copyQueue ? "copy" : "direct",
+                        sizeName,
+                        depths[depth]);
+                    ReportTransferResult(pPipeline, name, size, repeats, elapsedMs);
+                }
+            }
+        }
+    }
+}
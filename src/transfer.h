@@ -0,0 +1,63 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// Host and device transfers over the bus. The frame workload copies
+// `Options::transferFrameKB` per draw from an upload heap into a default heap
+// on the direct list. The sweep measures every path:
+//   - CPU writes into the write-combined upload heap,
+//   - CPU reads from the cached readback heap,
+//   - CPU writes into CPU-visible video memory, where the adapter has it,
+//   - upload to default and default to readback copies, on the direct and
+//     the copy queue, one copy at a time and `Options::transferInFlight`
+//     copies in flight.
+// Run with `-all-adapters` to see adapters sharing the bus starve each
+// other.
+struct Transfer
+{
+    // Persistently mapped.
+    Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> readbackBuffer;
+    UINT8* pUploadData;
+    UINT8* pReadbackData;
+    // In the common state; copies promote it and it decays after every
+    // ExecuteCommandLists().
+    Microsoft::WRL::ComPtr<ID3D12Resource> defaultBuffer;
+    // Video memory the CPU writes directly: a custom heap on UMA adapters,
+    // a GPU upload heap on discrete ones with resizable BAR. Null when the
+    // adapter has neither.
+    Microsoft::WRL::ComPtr<ID3D12Resource> cpuVisibleBuffer;
+    UINT8* pCpuVisibleData;
+    // System memory the CPU-side cases copy from and to.
+    UINT8* pHostData;
+    // Size of every buffer, the largest transfer of the sweep.
+    UINT64 bufferSize;
+
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue;
+    Microsoft::WRL::ComPtr<ID3D12Fence> copyFence;
+    UINT64 copyFenceValue;
+};
+
+// Create the buffers, clamped to the adapter's memory, and the copy queue.
+void CreateTransfer(Pipeline* pPipeline);
+
+// Record copies [firstDraw, firstDraw + drawCount), each of
+// `Options::transferFrameKB` from the upload to the default buffer.
+void RecordTransfer(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time every path at sizes from 4 KB to the buffer size, and log GB/s. GPU
+// copies are timed from submission to the fence, so small sizes show the
+// round trip. The GPU must be idle; returns with the GPU idle.
+void RunTransferSweep(Pipeline* pPipeline);
+
+void DestroyTransfer(Pipeline* pPipeline);
@@ -0,0 +1,157 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "upload-ring.h"
+#include "pipeline.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const UINT64 s_UploadAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+// Slice sizes of the upload sweep: a root CBV's worth of constants up to a
+// whole 64 KB constant buffer.
+static const UINT s_UploadSweepSliceSizes[] = { 256, 4096, 65536 };
+// Times the ring is filled per slice size, after one untimed fill.
+static const UINT s_UploadSweepPasses = 4;
+
+void CreateUploadRing(Pipeline* pPipeline)
+{
+    UploadRing* pRing = &pPipeline->uploadRing;
+
+    pRing->size = (UINT64)pPipeline->options.uploadRingMB * 1024 * 1024;
+
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(pRing->size);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&pRing->buffer)));
+
+    // Mapped until the app closes.
+    CD3DX12_RANGE readRange(0, 0); // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(pRing->buffer->Map(
+        0,
+        &readRange,
+        reinterpret_cast<void**>(&pRing->pMappedData)));
+    pRing->gpuAddress = pRing->buffer->GetGPUVirtualAddress();
+}
+
+void BeginUploadFrame(Pipeline* pPipeline)
+{
+    // The frame this resource held before is the oldest one that can have
+    // finished; every later frame may still be in flight.
+    const FrameResource* pFrame = &pPipeline->frameResources[pPipeline->frameResourceIndex];
+    pPipeline->uploadRing.tail = pFrame->uploadRingEnd;
+}
+
+void EndUploadFrame(Pipeline* pPipeline)
+{
+    FrameResource* pFrame = &pPipeline->frameResources[pPipeline->frameResourceIndex];
+    pFrame->uploadRingEnd = (UINT64)pPipeline->uploadRing.head;
+}
+
+UploadAllocation AllocateUpload(Pipeline* pPipeline, UINT64 size)
+{
+    UploadRing* pRing = &pPipeline->uploadRing;
+    size = (size + s_UploadAlignment - 1) & ~(s_UploadAlignment - 1);
+
+    UINT64 start;
+    for (;;)
+    {
+        const UINT64 head = (UINT64)pRing->head;
+
+        // Skip to the start of the buffer rather than straddle its end.
+        start = head;
+        if (start % pRing->size + size > pRing->size)
+        {
+            start += pRing->size - start % pRing->size;
+        }
+
+        if (start + size - pRing->tail > pRing->size)
+        {
+            LogMessage(
+                "Upload ring full: %llu MB in flight, increase -upload-ring-mb\n",
+                (head - pRing->tail) / (1024 * 1024));
+            throw std::exception();
+        }
+
+        if (InterlockedCompareExchange64(&pRing->head, (LONG64)(start + size), (LONG64)head) == (LONG64)head)
+        {
+            break;
+        }
+    }
+
+    InterlockedAdd64(&pRing->allocatedBytes, (LONG64)size);
+
+    const UINT64 offset = start % pRing->size;
+    UploadAllocation allocation = {};
+    allocation.pCpuAddress = pRing->pMappedData + offset;
+    allocation.gpuAddress = pRing->gpuAddress + offset;
+    return allocation;
+}
+
+void LogUploadStats(Pipeline* pPipeline, double windowMs)
+{
+    UploadRing* pRing = &pPipeline->uploadRing;
+
+    const LONG64 bytes = InterlockedExchange64(&pRing->allocatedBytes, 0);
+    if (bytes > 0)
+    {
+        LogMessage(
+            "adapter %u: %.1f MB/s uploaded through the ring\n",
+            pPipeline->options.adapterIndex,
+            GetRate((double)bytes, windowMs, 1024.0 * 1024.0));
+    }
+}
+
+void RunUploadSweep(Pipeline* pPipeline)
+{
+    UploadRing* pRing = &pPipeline->uploadRing;
+
+    const UINT maxSliceSize = s_UploadSweepSliceSizes[_countof(s_UploadSweepSliceSizes) - 1];
+    UINT8* pSource = (UINT8*)malloc(maxSliceSize);
+    for (UINT i = 0; i < maxSliceSize; ++i)
+    {
+        pSource[i] = (UINT8)i;
+    }
+
+    for (UINT sliceSize : s_UploadSweepSliceSizes)
+    {
+        const UINT64 sliceCount = pRing->size / sliceSize;
+        UINT64 startTicks = 0;
+
+        // The first fill also pages the buffer in.
+        for (UINT pass = 0; pass <= s_UploadSweepPasses; ++pass)
+        {
+            if (pass == 1)
+            {
+                startTicks = GetCpuTicks();
+            }
+
+            for (UINT64 slice = 0; slice < sliceCount; ++slice)
+            {
+                memcpy(pRing->pMappedData + slice * sliceSize, pSource, sliceSize);
+            }
+        }
+
+        const double elapsedMs = CpuTicksToMs(GetCpuTicks() - startTicks);
+        const double bytes = (double)(sliceCount * sliceSize) * s_UploadSweepPasses;
+        const double gigabytesPerSecond = GetRate(bytes, elapsedMs, 1.0e9);
+
+        LogMessage(
+            "upload %u B slices: %.2f GB/s write-combined (%.3f ms)\n",
+            sliceSize,
+            gigabytesPerSecond,
+            elapsedMs);
+
+        char name[64];
+        snprintf(name, sizeof(name), "upload %uB", sliceSize);
+        ReportSweepResult(pPipeline, name, gigabytesPerSecond, "GB/s", 0.0);
+    }
+
+    free(pSource);
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+struct Pipeline;
+
+// Linear allocator over a single persistently mapped upload heap buffer,
+// used as a ring by the frames in flight. Every frame allocates after the
+// previous one, and the space is reclaimed once the frame's fence is reached.
+// Nothing is created per allocation, so it measures the cost of writing
+// constants through write-combined memory and binding them.
+//
+// Positions are byte counts since creation, the buffer offset being
+// `position % size`. Allocations never straddle the end of the buffer.
+struct UploadRing
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+    // Write-combined: write whole slices sequentially, never read.
+    UINT8* pMappedData;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+    UINT64 size;
+
+    // Next free position. Bumped atomically by every thread recording the
+    // frame.
+    volatile LONG64 head;
+    // Start of the oldest frame the GPU may still be reading.
+    UINT64 tail;
+
+    // Bytes allocated since the last `LogUploadStats()`.
+    volatile LONG64 allocatedBytes;
+};
+
+struct UploadAllocation
+{
+    UINT8* pCpuAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+};
+
+// Create and map the `Options::uploadRingMB` buffer.
+void CreateUploadRing(Pipeline* pPipeline);
+
+// Reclaim the space of the frame the current frame resource last held. Call
+// before the frame's lists are recorded, once the frame resource's fence is
+// reached.
+void BeginUploadFrame(Pipeline* pPipeline);
+// Mark the end of the current frame's allocations. Call once every list of
+// the frame is recorded.
+void EndUploadFrame(Pipeline* pPipeline);
+
+// Allocate `size` bytes, rounded up to the 256-byte CBV placement alignment,
+// for the current frame. Safe to call from any recording thread. Throws when
+// the frames in flight use up the whole ring.
+UploadAllocation AllocateUpload(Pipeline* pPipeline, UINT64 size);
+
+// Log the upload rate since the last call, as `UpdateFrameStats()` does for
+// frames.
+void LogUploadStats(Pipeline* pPipeline, double windowMs);
+
+// Time CPU writes to the mapped ring for a few slice sizes and log the
+// write-combined bandwidth. The GPU must not be using the ring.
+void RunUploadSweep(Pipeline* pPipeline);
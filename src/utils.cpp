@@ -2,19 +2,24 @@
 
 #include "utils.h"
 #include <d3d12.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <wchar.h>
 
 using namespace Microsoft::WRL;
 
-HRESULT FindD3D12HardwareAdapter(
-    ComPtr<IDXGIFactory4> factory,
-    ComPtr<IDXGIAdapter1> outAdapter)
+UINT EnumD3D12HardwareAdapters(
+    IDXGIFactory4* pFactory,
+    ComPtr<IDXGIAdapter1>* pAdapters,
+    UINT maxAdapterCount)
 {
-    HRESULT hr = E_NOINTERFACE;
+    UINT adapterCount = 0;
 
     ComPtr<IDXGIAdapter1> adapter;
 
     for (UINT adapterIdx = 0;
-        SUCCEEDED(factory->EnumAdapters1(adapterIdx, &adapter));
+        adapterCount < maxAdapterCount &&
+        SUCCEEDED(pFactory->EnumAdapters1(adapterIdx, &adapter));
         ++adapterIdx)
     {
         DXGI_ADAPTER_DESC1 desc = {};
@@ -27,19 +32,166 @@ HRESULT FindD3D12HardwareAdapter(
         }
 
         // Check D3D12 support without creating a device.
-        hr = D3D12CreateDevice(
+        HRESULT hr = D3D12CreateDevice(
             adapter.Get(),
-            D3D_FEATURE_LEVEL_12_0,
+            D3D_FEATURE_LEVEL_11_0,
             _uuidof(ID3D12Device),
             nullptr);
 
         if (SUCCEEDED(hr))
         {
-            outAdapter = adapter.Detach();
-            hr = S_OK;
-            break;
+            pAdapters[adapterCount++] = adapter;
+        }
+    }
+
+    return adapterCount;
+}
+
+HRESULT FindD3D12HardwareAdapter(
+    IDXGIFactory4* pFactory,
+    UINT adapterIndex,
+    UINT64 adapterLuid,
+    ComPtr<IDXGIAdapter1>* pOutAdapter)
+{
+    ComPtr<IDXGIAdapter1> adapters[s_MaxAdapterCount];
+    const UINT adapterCount = EnumD3D12HardwareAdapters(pFactory, adapters, s_MaxAdapterCount);
+
+    for (UINT i = 0; i < adapterCount; ++i)
+    {
+        DXGI_ADAPTER_DESC1 desc = {};
+        adapters[i]->GetDesc1(&desc);
+
+        const bool found = (adapterLuid != 0)
+            ? GetLuidValue(desc.AdapterLuid) == adapterLuid
+            : i == adapterIndex;
+
+        if (found)
+        {
+            *pOutAdapter = adapters[i];
+            return S_OK;
         }
     }
 
-    return hr;
-}
\ No newline at end of file
+    return DXGI_ERROR_NOT_FOUND;
+}
+
+void PrintD3D12HardwareAdapters(IDXGIFactory4* pFactory)
+{
+    ComPtr<IDXGIAdapter1> adapters[s_MaxAdapterCount];
+    const UINT adapterCount = EnumD3D12HardwareAdapters(pFactory, adapters, s_MaxAdapterCount);
+
+    for (UINT i = 0; i < adapterCount; ++i)
+    {
+        DXGI_ADAPTER_DESC1 desc = {};
+        adapters[i]->GetDesc1(&desc);
+
+        char line[512];
+        snprintf(
+            line,
+            sizeof(line),
+            "adapter %u: %ls, luid 0x%016llx, %llu MB dedicated video memory\n",
+            i,
+            desc.Description,
+            GetLuidValue(desc.AdapterLuid),
+            (UINT64)desc.DedicatedVideoMemory / (1024ull * 1024));
+
+        fputs(line, stdout);
+        OutputDebugStringA(line);
+    }
+
+    if (adapterCount == 0)
+    {
+        fputs("no D3D12 hardware adapters\n", stdout);
+        OutputDebugStringA("no D3D12 hardware adapters\n");
+    }
+
+    fflush(stdout);
+}
+
+UINT64 GetLuidValue(const LUID& luid)
+{
+    return ((UINT64)(UINT)luid.HighPart << 32) | luid.LowPart;
+}
+
+const char* GetDeviceRemovedReasonName(HRESULT reason)
+{
+    switch (reason)
+    {
+    case S_OK:
+        return "none";
+    // The GPU took too long on a command list and the OS reset it (TDR).
+    case DXGI_ERROR_DEVICE_HUNG:
+        return "hung";
+    case DXGI_ERROR_DEVICE_REMOVED:
+        return "removed";
+    case DXGI_ERROR_DEVICE_RESET:
+        return "reset";
+    case DXGI_ERROR_DRIVER_INTERNAL_ERROR:
+        return "driver internal error";
+    case DXGI_ERROR_INVALID_CALL:
+        return "invalid call";
+    default:
+        return "unknown";
+    }
+}
+
+void GetExecutableDirectory(wchar_t* pPath, UINT pathSize)
+{
+    const DWORD length = GetModuleFileNameW(nullptr, pPath, pathSize);
+    if (length == 0 || length >= pathSize)
+    {
+        pPath[0] = L'\0';
+        return;
+    }
+
+    // Cut after the last separator.
+    wchar_t* pFileName = wcsrchr(pPath, L'\\');
+    if (pFileName != nullptr)
+    {
+        pFileName[1] = L'\0';
+    }
+}
+
+UINT64 HashBytes(UINT64 hash, const void* pData, size_t size)
+{
+    const UINT8* pBytes = (const UINT8*)pData;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= pBytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+void LogMessage(const char* format, ...)
+{
+    char message[1024];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    OutputDebugStringA(message);
+}
+
+UINT64 GetCpuTicks()
+{
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return (UINT64)ticks.QuadPart;
+}
+
+double CpuTicksToMs(UINT64 ticks)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return (double)ticks * 1000.0 / (double)frequency.QuadPart;
+}
+
+double GetRate(double count, double elapsedMs, double unit)
+{
+    return (elapsedMs > 0.0) ? count * 1000.0 / (elapsedMs * unit) : 0.0;
+}
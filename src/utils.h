@@ -1,8 +1,52 @@
 // Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
 
+#pragma once
+
 #include <wrl/client.h>
 #include <dxgi1_6.h>
+#include "options.h"
+
+// Hardware adapters that support D3D12, in DXGI enumeration order. Returns
+// how many were written to `pAdapters`, at most `maxAdapterCount`.
+UINT EnumD3D12HardwareAdapters(
+    IDXGIFactory4* pFactory,
+    Microsoft::WRL::ComPtr<IDXGIAdapter1>* pAdapters,
+    UINT maxAdapterCount);
 
+// Pick the adapter with `adapterLuid`, or when that is 0 the one at
+// `adapterIndex` in EnumD3D12HardwareAdapters() order.
 HRESULT FindD3D12HardwareAdapter(
-    Microsoft::WRL::ComPtr<IDXGIFactory4> factory,
-    Microsoft::WRL::ComPtr<IDXGIAdapter1> outAdapter);
+    IDXGIFactory4* pFactory,
+    UINT adapterIndex,
+    UINT64 adapterLuid,
+    Microsoft::WRL::ComPtr<IDXGIAdapter1>* pOutAdapter);
+
+// Print the index, name and LUID of every adapter FindD3D12HardwareAdapter()
+// can pick to stdout, and to the debugger output.
+void PrintD3D12HardwareAdapters(IDXGIFactory4* pFactory);
+
+// The LUID as one number, as taken by `-adapter-luid`.
+UINT64 GetLuidValue(const LUID& luid);
+
+// Name of a GetDeviceRemovedReason() result, "none" for S_OK.
+const char* GetDeviceRemovedReasonName(HRESULT reason);
+
+// Directory of the running executable, with a trailing separator.
+void GetExecutableDirectory(wchar_t* pPath, UINT pathSize);
+
+// 64-bit FNV-1a of `size` bytes, continuing from `hash`. Start with
+// s_Fnv1aOffsetBasis.
+static const UINT64 s_Fnv1aOffsetBasis = 0xcbf29ce484222325ull;
+UINT64 HashBytes(UINT64 hash, const void* pData, size_t size);
+
+// printf-style message to the debugger output.
+void LogMessage(const char* format, ...);
+
+// CPU timestamps from QueryPerformanceCounter().
+UINT64 GetCpuTicks();
+double CpuTicksToMs(UINT64 ticks);
+
+// `count` per second over `elapsedMs`, in units of `unit` per second (1.0e9
+// for GB/s from bytes). 0 when no time was measured, so a timestamp glitch
+// doesn't put inf or NaN into the report.
+double GetRate(double count, double elapsedMs, double unit);
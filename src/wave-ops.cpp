@@ -0,0 +1,383 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#include "wave-ops.h"
+#include "pipeline.h"
+#include "shaders.h"
+#include "utils.h"
+#include <stdio.h>
+
+static const UINT s_WaveThreadGroupSize = 256;
+static const UINT s_WaveThreadGroupCount = 1024;
+
+// Root parameter slots of `WaveOps::rootSignature`.
+static const UINT s_WaveRootParamConstants = 0;
+static const UINT s_WaveRootParamOutput = 1;
+static const UINT s_WaveRootParamCount = 2;
+
+// Matches `WaveConstants` in wave-ops.hlsl.
+struct WaveConstants
+{
+    UINT iterations;
+    UINT seed;
+    UINT padding[2];
+};
+
+static const char* s_WaveKernelEntryPoints[s_WaveKernelCount] =
+{
+    "CSActiveSum",
+    "CSPrefixSum",
+    "CSReadLaneAt",
+    "CSFma32",
+    "CSFma16",
+};
+
+// The runtime rejects shader models it doesn't know, so ask from the newest
+// one this code uses down.
+static D3D_SHADER_MODEL GetHighestShaderModel(ID3D12Device* pDevice)
+{
+    const D3D_SHADER_MODEL shaderModels[] =
+    {
+        D3D_SHADER_MODEL_6_6,
+        D3D_SHADER_MODEL_6_5,
+        D3D_SHADER_MODEL_6_4,
+        D3D_SHADER_MODEL_6_3,
+        D3D_SHADER_MODEL_6_2,
+        D3D_SHADER_MODEL_6_1,
+        D3D_SHADER_MODEL_6_0,
+    };
+
+    for (D3D_SHADER_MODEL shaderModel : shaderModels)
+    {
+        D3D12_FEATURE_DATA_SHADER_MODEL data = { shaderModel };
+        if (SUCCEEDED(pDevice->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &data, sizeof(data))))
+        {
+            return data.HighestShaderModel;
+        }
+    }
+
+    return D3D_SHADER_MODEL_5_1;
+}
+
+// Operations a thread runs per loop iteration, and what they are called in
+// results.
+static double GetOpsPerIteration(WaveKernel kernel)
+{
+    switch (kernel)
+    {
+    case WaveKernel::ActiveSum:
+    case WaveKernel::PrefixSum:
+    case WaveKernel::ReadLaneAt:
+        // One intrinsic on a uint4.
+        return 4.0;
+
+    case WaveKernel::Fma32:
+    case WaveKernel::Fma16:
+        // Eight FMAs, two flops each.
+        return 16.0;
+
+    default:
+        return 0.0;
+    }
+}
+
+static const char* GetOpsUnit(WaveKernel kernel)
+{
+    return (kernel == WaveKernel::Fma32 || kernel == WaveKernel::Fma16) ? "GFLOPS" : "Gops/s";
+}
+
+static bool QueryWaveSupport(Pipeline* pPipeline)
+{
+    WaveOps* pWaveOps = &pPipeline->waveOps;
+    ID3D12Device* pDevice = pPipeline->device.Get();
+
+    if (!IsDxcAvailable())
+    {
+        LogMessage("wave-ops: disabled, needs dxcompiler.dll\n");
+        return false;
+    }
+
+    pWaveOps->shaderModel = GetHighestShaderModel(pDevice);
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS1 options1 = {};
+    if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS1, &options1, sizeof(options1))) ||
+        !options1.WaveOps ||
+        pWaveOps->shaderModel < D3D_SHADER_MODEL_6_0)
+    {
+        LogMessage("wave-ops: disabled, the adapter doesn't support shader model 6 wave operations\n");
+        return false;
+    }
+    pWaveOps->waveLaneCountMin = options1.WaveLaneCountMin;
+    pWaveOps->waveLaneCountMax = options1.WaveLaneCountMax;
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS4 options4 = {};
+    pWaveOps->native16BitSupported =
+        pWaveOps->shaderModel >= D3D_SHADER_MODEL_6_2 &&
+        SUCCEEDED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS4, &options4, sizeof(options4))) &&
+        options4.Native16BitShaderOpsSupported;
+
+    LogMessage(
+        "wave-ops: shader model %u.%u, %u to %u lanes per wave, native 16-bit ops %s\n",
+        (UINT)pWaveOps->shaderModel >> 4,
+        (UINT)pWaveOps->shaderModel & 0xf,
+        pWaveOps->waveLaneCountMin,
+        pWaveOps->waveLaneCountMax,
+        pWaveOps->native16BitSupported ? "supported" : "unsupported");
+
+    return true;
+}
+
+static void SelectWaveSizes(Pipeline* pPipeline)
+{
+    WaveOps* pWaveOps = &pPipeline->waveOps;
+
+    pWaveOps->waveSizes[0] = 0;
+    pWaveOps->waveSizeCount = 1;
+
+    // Without [WaveSize] the driver picks one, e.g. between wave32 and
+    // wave64 on RDNA.
+    if (pWaveOps->shaderModel >= D3D_SHADER_MODEL_6_6)
+    {
+        for (UINT waveSize = 4; waveSize <= 128; waveSize *= 2)
+        {
+            if (waveSize >= pWaveOps->waveLaneCountMin && waveSize <= pWaveOps->waveLaneCountMax)
+            {
+                pWaveOps->waveSizes[pWaveOps->waveSizeCount++] = waveSize;
+            }
+        }
+    }
+
+    pWaveOps->frameWaveSizeIndex = 0;
+    for (UINT i = 0; i < pWaveOps->waveSizeCount; ++i)
+    {
+        if (pWaveOps->waveSizes[i] == pPipeline->options.waveSize)
+        {
+            pWaveOps->frameWaveSizeIndex = i;
+        }
+    }
+
+    if (pWaveOps->waveSizes[pWaveOps->frameWaveSizeIndex] != pPipeline->options.waveSize)
+    {
+        LogMessage(
+            "wave-ops: wave size %u unsupported, letting the driver choose\n",
+            pPipeline->options.waveSize);
+    }
+}
+
+void CreateWaveOps(Pipeline* pPipeline)
+{
+    WaveOps* pWaveOps = &pPipeline->waveOps;
+
+    if (!QueryWaveSupport(pPipeline))
+    {
+        return;
+    }
+    SelectWaveSizes(pPipeline);
+
+    // Create the compute root signature.
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[s_WaveRootParamCount] = {};
+        rootParameters[s_WaveRootParamConstants].InitAsConstants(
+            sizeof(WaveConstants) / 4,
+            0);
+        rootParameters[s_WaveRootParamOutput].InitAsUnorderedAccessView(0);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            0,
+            nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+        CreateRootSignature(pPipeline, rootSignatureDesc, &pWaveOps->rootSignature);
+    }
+
+    // Create a PSO per kernel and wave size.
+    for (UINT i = 0; i < s_WaveKernelCount; ++i)
+    {
+        const bool fma16 = (WaveKernel)i == WaveKernel::Fma16;
+        if (fma16 && !pWaveOps->native16BitSupported)
+        {
+            continue;
+        }
+
+        for (UINT j = 0; j < pWaveOps->waveSizeCount; ++j)
+        {
+            const UINT waveSize = pWaveOps->waveSizes[j];
+
+            char waveSizeValue[16];
+            snprintf(waveSizeValue, sizeof(waveSizeValue), "%u", waveSize);
+            const D3D_SHADER_MACRO defines[] =
+            {
+                { "WAVE_SIZE", waveSizeValue },
+                { nullptr, nullptr },
+            };
+
+            // The lowest shader model each kernel needs, so older drivers
+            // still run the rest.
+            const char* target = (waveSize != 0) ? "cs_6_6" : (fma16 ? "cs_6_2" : "cs_6_0");
+
+            ComPtr<ID3DBlob> computeShader;
+            CompileShader(
+                L"wave-ops.hlsl",
+                s_WaveKernelEntryPoints[i],
+                target,
+                (waveSize != 0) ? defines : nullptr,
+                &computeShader,
+                fma16 ? s_ShaderFlag16BitTypes : 0);
+
+            D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+            psoDesc.pRootSignature = pWaveOps->rootSignature.Get();
+            psoDesc.CS = CD3DX12_SHADER_BYTECODE(computeShader.Get());
+            CreateComputePipelineState(pPipeline, L"wave-ops", psoDesc, &pWaveOps->pipelineStates[i][j]);
+        }
+    }
+
+    // One uint4 per thread.
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC outputDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        (UINT64)s_WaveThreadGroupCount * s_WaveThreadGroupSize * 16,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    ThrowIfFailed(pPipeline->device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &outputDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        nullptr,
+        IID_PPV_ARGS(&pWaveOps->outputBuffer)));
+
+    pWaveOps->supported = true;
+}
+
+static void SetWaveOpsRootArguments(Pipeline* pPipeline, ID3D12GraphicsCommandList* pCmdList)
+{
+    WaveOps* pWaveOps = &pPipeline->waveOps;
+
+    pCmdList->SetComputeRootSignature(pWaveOps->rootSignature.Get());
+    pCmdList->SetComputeRootUnorderedAccessView(
+        s_WaveRootParamOutput,
+        pWaveOps->outputBuffer->GetGPUVirtualAddress());
+}
+
+static void RecordWaveOpsDispatch(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    ID3D12PipelineState* pPipelineState,
+    UINT seed)
+{
+    WaveConstants constants = {};
+    constants.iterations = pPipeline->options.waveIterations;
+    constants.seed = seed;
+
+    pCmdList->SetPipelineState(pPipelineState);
+    pCmdList->SetComputeRoot32BitConstants(
+        s_WaveRootParamConstants,
+        sizeof(WaveConstants) / 4,
+        &constants,
+        0);
+    pCmdList->Dispatch(s_WaveThreadGroupCount, 1, 1);
+}
+
+void RecordWaveOps(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount)
+{
+    WaveOps* pWaveOps = &pPipeline->waveOps;
+    ID3D12PipelineState* pPipelineState =
+        pWaveOps->pipelineStates[(UINT)pPipeline->options.waveKernel][pWaveOps->frameWaveSizeIndex].Get();
+
+    if (!pWaveOps->supported || pPipelineState == nullptr)
+    {
+        return;
+    }
+
+    SetWaveOpsRootArguments(pPipeline, pCmdList);
+
+    for (UINT draw = firstDraw; draw < firstDraw + drawCount; ++draw)
+    {
+        const UINT seed = GetDrawSeed(pPipeline, draw);
+        RecordWaveOpsDispatch(pPipeline, pCmdList, pPipelineState, seed);
+    }
+}
+
+void RunWaveOpsSweep(Pipeline* pPipeline)
+{
+    WaveOps* pWaveOps = &pPipeline->waveOps;
+
+    if (!pWaveOps->supported)
+    {
+        return;
+    }
+
+    ComPtr<ID3D12CommandAllocator> cmdAlloc;
+    ThrowIfFailed(pPipeline->device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&cmdAlloc)));
+
+    ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(pPipeline->device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        cmdAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&cmdList)));
+    ThrowIfFailed(cmdList->Close());
+
+    const UINT iterations = pPipeline->options.waveSweepIterations;
+    const double threadCount = (double)s_WaveThreadGroupCount * s_WaveThreadGroupSize;
+
+    for (UINT i = 0; i < s_WaveKernelCount; ++i)
+    {
+        const WaveKernel kernel = (WaveKernel)i;
+
+        for (UINT j = 0; j < pWaveOps->waveSizeCount; ++j)
+        {
+            ID3D12PipelineState* pPipelineState = pWaveOps->pipelineStates[i][j].Get();
+            if (pPipelineState == nullptr)
+            {
+                continue;
+            }
+
+            ThrowIfFailed(cmdAlloc->Reset());
+            ThrowIfFailed(cmdList->Reset(cmdAlloc.Get(), nullptr));
+            SetWaveOpsRootArguments(pPipeline, cmdList.Get());
+            BeginGpuMeasurement(pPipeline, cmdList.Get());
+            for (UINT iteration = 0; iteration < iterations; ++iteration)
+            {
+                RecordWaveOpsDispatch(pPipeline, cmdList.Get(), pPipelineState, iteration);
+            }
+            EndGpuMeasurement(pPipeline, cmdList.Get());
+            ThrowIfFailed(cmdList->Close());
+
+            const double elapsedMs = ExecuteTimedSweepList(pPipeline, cmdList.Get());
+
+            const double ops = threadCount * pPipeline->options.waveIterations *
+                GetOpsPerIteration(kernel) * iterations;
+            const double gigaOpsPerSecond = GetRate(ops, elapsedMs, 1.0e9);
+
+            char waveSizeName[16];
+            if (pWaveOps->waveSizes[j] != 0)
+            {
+                snprintf(waveSizeName, sizeof(waveSizeName), "wave%u", pWaveOps->waveSizes[j]);
+            }
+            else
+            {
+                snprintf(waveSizeName, sizeof(waveSizeName), "default");
+            }
+
+            LogMessage(
+                "wave-ops %s %s: %.1f %s (%.3f ms)\n",
+                GetWaveKernelName(kernel),
+                waveSizeName,
+                gigaOpsPerSecond,
+                GetOpsUnit(kernel),
+                elapsedMs);
+
+            char name[64];
+            snprintf(name, sizeof(name), "wave-ops %s %s", GetWaveKernelName(kernel), waveSizeName);
+            ReportSweepResult(pPipeline, name, gigaOpsPerSecond, GetOpsUnit(kernel), elapsedMs);
+        }
+    }
+}
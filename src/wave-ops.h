@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+#pragma once
+
+#include <Windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "options.h"
+
+struct Pipeline;
+
+// Wave sizes a kernel is compiled for: the driver's choice, plus every power
+// of two from 4 to 128 lanes.
+static const UINT s_MaxWaveSizeCount = 7;
+
+// Shader model 6 compute kernels looping over wave intrinsics or FMAs, see
+// wave-ops.hlsl. They are compiled with DXC once per wave size the adapter
+// supports.
+struct WaveOps
+{
+    // The adapter, driver and dxcompiler.dll can run shader model 6 wave
+    // intrinsics. Without it nothing is created or recorded.
+    bool supported;
+    bool native16BitSupported;
+    D3D_SHADER_MODEL shaderModel;
+    // Lanes per wave the adapter can run.
+    UINT waveLaneCountMin;
+    UINT waveLaneCountMax;
+
+    // Wave sizes there are PSOs for, 0 being the driver's choice. Forcing a
+    // size needs shader model 6.6.
+    UINT waveSizes[s_MaxWaveSizeCount];
+    UINT waveSizeCount;
+    // Index into `waveSizes` of `Options::waveSize`.
+    UINT frameWaveSizeIndex;
+
+    // Compute root signature: root constants at b0, the output buffer as a
+    // root UAV at u0.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    // Null for kernels the adapter doesn't support.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStates[s_WaveKernelCount][s_MaxWaveSizeCount];
+    Microsoft::WRL::ComPtr<ID3D12Resource> outputBuffer;
+};
+
+// Query the adapter's shader model and wave sizes, then create the root
+// signature, PSOs and output buffer of whatever it supports.
+void CreateWaveOps(Pipeline* pPipeline);
+
+// Record dispatches [firstDraw, firstDraw + drawCount) of
+// `Options::waveKernel` at `Options::waveSize`.
+void RecordWaveOps(
+    Pipeline* pPipeline,
+    ID3D12GraphicsCommandList* pCmdList,
+    UINT firstDraw,
+    UINT drawCount);
+
+// Time every kernel at every supported wave size in isolation and log its
+// throughput. The GPU must be idle; returns with the GPU idle.
+void RunWaveOpsSweep(Pipeline* pPipeline);
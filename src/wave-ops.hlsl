@@ -0,0 +1,118 @@
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+// Shader model 6 ALU kernels, compiled with DXC. Each thread runs a dependent
+// chain of `iterations` steps, so the kernels are bound by the throughput of
+// the operation they loop over rather than by memory.
+//
+// `WAVE_SIZE`, when defined, forces the lanes per wave (shader model 6.6).
+
+#if defined(WAVE_SIZE)
+#define WAVE_SIZE_ATTRIBUTE [WaveSize(WAVE_SIZE)]
+#else
+#define WAVE_SIZE_ATTRIBUTE
+#endif
+
+cbuffer WaveConstants : register(b0)
+{
+    // Loop iterations per thread.
+    uint iterations;
+    // Changes every dispatch so the loops can't be hoisted.
+    uint seed;
+    uint2 padding;
+};
+
+RWStructuredBuffer<uint4> output : register(u0);
+
+// Keep the results alive without paying for a write per thread: the
+// condition is never true in practice, but the compiler can't prove it.
+void KeepAlive(uint4 value, uint threadId)
+{
+    if (all(value == uint4(seed, seed, seed, seed)))
+    {
+        output[threadId] = value;
+    }
+}
+
+WAVE_SIZE_ATTRIBUTE
+[numthreads(256, 1, 1)]
+void CSActiveSum(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint4 value = uint4(dispatchThreadId.x, seed, dispatchThreadId.x ^ seed, 1);
+
+    for (uint i = 0; i < iterations; ++i)
+    {
+        value = WaveActiveSum(value) ^ (value + i);
+    }
+
+    KeepAlive(value, dispatchThreadId.x);
+}
+
+WAVE_SIZE_ATTRIBUTE
+[numthreads(256, 1, 1)]
+void CSPrefixSum(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint4 value = uint4(dispatchThreadId.x, seed, dispatchThreadId.x ^ seed, 1);
+
+    for (uint i = 0; i < iterations; ++i)
+    {
+        value = WavePrefixSum(value) ^ (value + i);
+    }
+
+    KeepAlive(value, dispatchThreadId.x);
+}
+
+WAVE_SIZE_ATTRIBUTE
+[numthreads(256, 1, 1)]
+void CSReadLaneAt(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint4 value = uint4(dispatchThreadId.x, seed, dispatchThreadId.x ^ seed, 1);
+    const uint laneMask = WaveGetLaneCount() - 1;
+
+    for (uint i = 0; i < iterations; ++i)
+    {
+        // Uniform across the wave, i.e. a broadcast from a different lane
+        // every iteration.
+        uint lane = (seed + i * 7) & laneMask;
+        value = WaveReadLaneAt(value, lane) ^ (value + i);
+    }
+
+    KeepAlive(value, dispatchThreadId.x);
+}
+
+WAVE_SIZE_ATTRIBUTE
+[numthreads(256, 1, 1)]
+void CSFma32(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    // Two independent chains of four so the loop isn't latency bound. Each
+    // converges towards 1, so the values stay finite for any iteration count.
+    float4 a = float4(dispatchThreadId.x, seed, dispatchThreadId.x ^ seed, 1.0f) * 1.0e-6f;
+    float4 b = a.wzyx;
+
+    for (uint i = 0; i < iterations; ++i)
+    {
+        a = mad(a, 0.999f, 0.001f);
+        b = mad(b, 0.999f, 0.001f);
+    }
+
+    KeepAlive(asuint(a + b), dispatchThreadId.x);
+}
+
+#if __HLSL_ENABLE_16_BIT
+// Same chains as CSFma32 in native 16-bit floats, which hardware with packed
+// math runs at twice the 32-bit rate.
+WAVE_SIZE_ATTRIBUTE
+[numthreads(256, 1, 1)]
+void CSFma16(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    float16_t4 a = float16_t4(float4(dispatchThreadId.x & 0xff, seed & 0xff, 1.0f, 0.5f) * 1.0e-3f);
+    float16_t4 b = a.wzyx;
+
+    for (uint i = 0; i < iterations; ++i)
+    {
+        a = mad(a, (float16_t)0.999, (float16_t)0.001);
+        b = mad(b, (float16_t)0.999, (float16_t)0.001);
+    }
+
+    KeepAlive(asuint((float4)(a + b)), dispatchThreadId.x);
+}
+#endif